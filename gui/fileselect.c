@@ -582,7 +582,8 @@ file_selector_process_result (const char *in_fname, int action,
 	if (has_suffix(fname, ".inp")) {
 	    action = OPEN_SCRIPT;
 	} else if (has_suffix(fname, ".gdt") ||
-		   has_suffix(fname, ".gdtb")) {
+		   has_suffix(fname, ".gdtb") ||
+		   has_suffix(fname, ".gdtc")) {
 	    action = OPEN_DATA;
 	} else {
 	    os_open_other(fname);
@@ -846,6 +847,7 @@ static GtkFileFilter *filesel_add_data_filter (GtkWidget *filesel,
     gtk_file_filter_add_pattern(filt, data_filters[i].pat);
     if (i == 0) {
 	gtk_file_filter_add_pattern(filt, "*.gdtb");
+	gtk_file_filter_add_pattern(filt, "*.gdtc");
     } else {
 	maybe_upcase_filter_pattern(filt, data_filters[i].pat);
     }
@@ -749,6 +749,7 @@ struct extmap {
 static struct extmap data_ftype_map[] = {
     { GRETL_XML_DATA,     ".gdt" },
     { GRETL_BINARY_DATA,  ".gdtb" },
+    { GRETL_BINARY_DATA,  ".gdtc" },
     { GRETL_CSV,          ".csv" },
     { GRETL_OCTAVE,       ".m" },
     { GRETL_GNUMERIC,     ".gnumeric" },
@@ -835,7 +836,7 @@ format_from_opt_or_name (gretlopt opt, const char *fname,
 	    *err = E_BADOPT;
 	}
 	return GRETL_FMT_GDT;
-    } else if (has_suffix(fname, ".gdtb")) {
+    } else if (has_suffix(fname, ".gdtb") || has_suffix(fname, ".gdtc")) {
 	if (non_native(opt)) {
 	    *err = E_BADOPT;
 	}
@@ -1079,6 +1080,11 @@ static int real_write_data (const char *fname, int *list,
 	return err;
     }
 
+    if ((opt & OPT_P) && fmt != GRETL_FMT_GDT && fmt != GRETL_FMT_BINARY) {
+	/* --append is specific to native binary data */
+	return E_BADOPT;
+    }
+
     if (list == NULL) {
 	list = full_var_list(dset, &l0);
 	if (l0 == 0) {
@@ -1094,7 +1100,7 @@ static int real_write_data (const char *fname, int *list,
     fname = gretl_maybe_switch_dir(fname);
 
     if (fmt == GRETL_FMT_GDT || fmt == GRETL_FMT_BINARY) {
-	/* write native data file (.gdt or .gdtb) */
+	/* write native data file (.gdt, .gdtb or .gdtc) */
 	err = gretl_write_gdt(fname, list, dset, opt, progress);
 	goto write_exit;
     }
@@ -25,7 +25,7 @@
 
 typedef enum {
     GRETL_XML_DATA,       /* gretl XML data file (.gdt) */
-    GRETL_BINARY_DATA,    /* zip file with binary component (.gdtb) */
+    GRETL_BINARY_DATA,    /* zip file with binary component (.gdtb, .gdtc) */
     GRETL_CSV,            /* comma-separated or other plain text data */
     GRETL_OCTAVE,         /* GNU octave ascii data file */
     GRETL_GNUMERIC,       /* gnumeric workbook data */
@@ -159,27 +159,22 @@ static FILE *open_binfile (const char *dbbase, int code, int offset, int *err)
     return fp;
 }
 
-/**
- * get_native_db_data:
- * @dbbase:
- * @sinfo:
- * @Z: data array.
- *
- * Returns: 0 on success, non-zero code on failure.
- */
+/* Read the data for the series described by @sinfo from the
+   open .bin file @fp, seeking only if we're not already in the
+   right place.
+*/
 
-int get_native_db_data (const char *dbbase, SERIESINFO *sinfo,
-			double **Z)
+static int read_native_series (FILE *fp, SERIESINFO *sinfo,
+			       double **Z)
 {
     char numstr[32];
-    FILE *fp;
     dbnumber x;
     int v = sinfo->v;
     int t, t2, err = 0;
 
-    fp = open_binfile(dbbase, GRETL_NATIVE_DB, sinfo->offset, &err);
-    if (err) {
-	return err;
+    if (ftell(fp) != (long) sinfo->offset &&
+	fseek(fp, (long) sinfo->offset, SEEK_SET)) {
+	return DB_PARSE_ERROR;
     }
 
     t2 = (sinfo->t2 > 0)? sinfo->t2 : sinfo->nobs - 1;
@@ -196,6 +191,30 @@ int get_native_db_data (const char *dbbase, SERIESINFO *sinfo,
 	}
     }
 
+    return err;
+}
+
+/**
+ * get_native_db_data:
+ * @dbbase:
+ * @sinfo:
+ * @Z: data array.
+ *
+ * Returns: 0 on success, non-zero code on failure.
+ */
+
+int get_native_db_data (const char *dbbase, SERIESINFO *sinfo,
+			double **Z)
+{
+    FILE *fp;
+    int err = 0;
+
+    fp = open_binfile(dbbase, GRETL_NATIVE_DB, sinfo->offset, &err);
+    if (err) {
+	return err;
+    }
+
+    err = read_native_series(fp, sinfo, Z);
     fclose(fp);
 
     return err;
@@ -458,134 +477,303 @@ static char *native_db_index_name (void)
     return fname;
 }
 
-static int db_match_glob (FILE *fp,
-			  char *line, int linelen,
-			  GPatternSpec *pspec,
-			  char **S, int *err)
+/* In-memory index for the .idx file of a native database: the
+   series names are hashed, and for each series we record the
+   position of its two-line entry in the .idx file along with the
+   offset of its data in the .bin file. The index is built on first
+   use and kept for the session; it is rebuilt if the .idx file
+   changes on disk, and it's discarded when we modify the database
+   ourselves (see native_db_index_clear()).
+*/
+
+typedef struct {
+    char *name;    /* series name */
+    gint64 ipos;   /* position of entry in .idx file */
+    int offset;    /* byte offset of data in .bin file */
+    int nobs;      /* number of observations */
+} db_idx_entry;
+
+typedef struct {
+    char *fname;      /* name of .idx file */
+    gint64 size;      /* size of .idx file when indexed */
+    gint64 mtime;     /* modification time of same */
+    int n;            /* number of series */
+    db_idx_entry *e;  /* entries, in database order */
+    GHashTable *ht;   /* mapping from name to entry */
+} db_index;
+
+static db_index *native_idx;
+
+static void db_index_destroy (db_index *idx)
 {
-    char vname[VNAMELEN], l2[72];
-    int n = 0;
+    if (idx != NULL) {
+	int i;
 
-    while (fgets(line, linelen, fp) && !*err) {
-	if (*line == '#') {
-	    continue;
+	if (idx->ht != NULL) {
+	    g_hash_table_destroy(idx->ht);
+	}
+	for (i=0; i<idx->n; i++) {
+	    free(idx->e[i].name);
 	}
-	if (gretl_scan_varname(line, vname) != 1) {
+	free(idx->e);
+	free(idx->fname);
+	free(idx);
+    }
+}
+
+/**
+ * native_db_index_clear:
+ * @idxname: name of a native database index file, or NULL.
+ *
+ * Discards the cached series index for @idxname, or for any
+ * database if @idxname is NULL. To be called after a native
+ * database has been modified.
+ */
+
+void native_db_index_clear (const char *idxname)
+{
+    if (native_idx != NULL &&
+	(idxname == NULL || !strcmp(idxname, native_idx->fname))) {
+	db_index_destroy(native_idx);
+	native_idx = NULL;
+    }
+}
+
+static int db_index_add_entry (db_index *idx, const char *vname,
+			       gint64 ipos, int offset, int nobs,
+			       int *nalloc)
+{
+    db_idx_entry *e;
+
+    if (idx->n == *nalloc) {
+	int newn = (*nalloc == 0)? 1024 : 2 * *nalloc;
+
+	e = realloc(idx->e, newn * sizeof *e);
+	if (e == NULL) {
+	    return E_ALLOC;
+	}
+	idx->e = e;
+	*nalloc = newn;
+    }
+
+    e = &idx->e[idx->n];
+    e->name = gretl_strdup(vname);
+    if (e->name == NULL) {
+	return E_ALLOC;
+    }
+    e->ipos = ipos;
+    e->offset = offset;
+    e->nobs = nobs;
+    idx->n += 1;
+
+    return 0;
+}
+
+static db_index *db_index_build (const char *idxname,
+				 const struct stat *sbuf,
+				 int *err)
+{
+    db_index *idx;
+    char vname[VNAMELEN];
+    char s1[1024], s2[72];
+    gint64 ipos;
+    FILE *fp;
+    int offset = 0;
+    int nalloc = 0;
+    int i, n;
+
+    fp = gretl_fopen(idxname, "rb");
+    if (fp == NULL) {
+	*err = E_FOPEN;
+	return NULL;
+    }
+
+    idx = calloc(1, sizeof *idx);
+    if (idx == NULL) {
+	fclose(fp);
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    idx->fname = gretl_strdup(idxname);
+    idx->size = sbuf->st_size;
+    idx->mtime = sbuf->st_mtime;
+
+    while (!*err) {
+	ipos = ftell(fp);
+	if (fgets(s1, sizeof s1, fp) == NULL) {
 	    break;
 	}
-	if (g_pattern_match_string(pspec, vname)) {
-	    if (S != NULL) {
-		S[n] = gretl_strdup(vname);
-	    }
-	    n++;
+	if (*s1 == '#') {
+	    continue;
+	}
+	if (gretl_scan_varname(s1, vname) != 1) {
+	    break;
 	}
-	if (fgets(l2, sizeof l2, fp) == NULL) {
+	if (fgets(s2, sizeof s2, fp) == NULL ||
+	    sscanf(s2, "%*c %*s %*s %*s %*s %*s %d", &n) != 1) {
+	    gretl_errmsg_set(_("Failed to parse series information"));
 	    *err = DB_PARSE_ERROR;
+	} else {
+	    *err = db_index_add_entry(idx, vname, ipos, offset, n, &nalloc);
+	    offset += n * sizeof(dbnumber);
+	}
+    }
+
+    fclose(fp);
+
+    if (!*err) {
+	idx->ht = g_hash_table_new(g_str_hash, g_str_equal);
+	/* in case of duplicated names, the first one wins */
+	for (i=idx->n-1; i>=0; i--) {
+	    g_hash_table_insert(idx->ht, idx->e[i].name, &idx->e[i]);
+	}
+    }
+
+    if (*err) {
+	db_index_destroy(idx);
+	idx = NULL;
+    }
+
+    return idx;
+}
+
+/* Retrieve the series index for @idxname, (re-)building it if
+   need be.
+*/
+
+static db_index *native_db_get_index (const char *idxname, int *err)
+{
+    struct stat sbuf;
+
+    if (gretl_stat(idxname, &sbuf) != 0) {
+	*err = E_FOPEN;
+	return NULL;
+    }
+
+    if (native_idx != NULL) {
+	if (!strcmp(idxname, native_idx->fname) &&
+	    native_idx->size == (gint64) sbuf.st_size &&
+	    native_idx->mtime == (gint64) sbuf.st_mtime) {
+	    return native_idx;
 	}
+	db_index_destroy(native_idx);
     }
 
-    return n;
+    native_idx = db_index_build(idxname, &sbuf, err);
+
+    return native_idx;
 }
 
 static char **native_db_match_series (const char *glob, int *nmatch,
 				      const char *idxname, int *err)
 {
     GPatternSpec *pspec;
+    db_index *idx;
     char **S = NULL;
-    FILE *fp = NULL;
-    char line[256];
+    int i, n = 0;
 
-    fp = gretl_fopen(idxname, "rb");
-    if (fp == NULL) {
-	*err = E_FOPEN;
-	*nmatch = 0;
+    *nmatch = 0;
+
+    idx = native_db_get_index(idxname, err);
+    if (*err) {
 	return NULL;
     }
 
     pspec = g_pattern_spec_new(glob);
 
-    *nmatch = db_match_glob(fp, line, sizeof line, pspec, NULL, err);
-
-    if (!*err && *nmatch > 0) {
-	S = strings_array_new(*nmatch);
-	if (S == NULL) {
-	    *nmatch = 0;
-	    *err = E_ALLOC;
-	} else {
-	    rewind(fp);
-	    db_match_glob(fp, line, sizeof line, pspec, S, err);
+    for (i=0; i<idx->n && !*err; i++) {
+	if (g_pattern_match_string(pspec, idx->e[i].name)) {
+	    *err = strings_array_add(&S, &n, idx->e[i].name);
 	}
     }
 
     g_pattern_spec_free(pspec);
-    fclose(fp);
+
+    if (*err) {
+	strings_array_free(S, n);
+	S = NULL;
+    } else {
+	*nmatch = n;
+    }
 
     return S;
 }
 
-static int get_native_series_info (const char *series,
-				   SERIESINFO *sinfo,
-				   const char *idxname)
+/* Fill out @sinfo for the series indexed by @e, reading its
+   entry from the open .idx file @fp.
+*/
+
+static int native_series_info_at (FILE *fp, const db_idx_entry *e,
+				  SERIESINFO *sinfo)
 {
-    FILE *fp = NULL;
-    char sername[VNAMELEN];
     /* 2019-01-08: enlarge @s1 from 256 to 1024 */
     char s1[1024], s2[72];
     char stobs[OBSLEN], endobs[OBSLEN];
     char pdc;
-    int offset = 0;
-    int gotit = 0, err = 0;
-    int n;
+    int err = 0;
 
-    fp = gretl_fopen(idxname, "rb");
-    if (fp == NULL) {
-	return E_FOPEN;
+    if (fseek(fp, (long) e->ipos, SEEK_SET) ||
+	fgets(s1, sizeof s1, fp) == NULL ||
+	fgets(s2, sizeof s2, fp) == NULL) {
+	return DB_PARSE_ERROR;
     }
 
-    while (fgets(s1, sizeof s1, fp) && !gotit) {
-	if (*s1 == '#') {
-	    continue;
-	}
-	if (gretl_scan_varname(s1, sername) != 1) {
-	    break;
-	}
-	if (!strcmp(series, sername)) {
-	    gotit = 1;
-	    strcpy(sinfo->varname, sername);
-	}
-	if (fgets(s2, sizeof s2, fp) == NULL) {
-	    err = DB_PARSE_ERROR;
-	    break;
-	}
-	if (gotit) {
-	    get_native_series_comment(sinfo, s1);
-	    if (sscanf(s2, "%c %10s %*s %10s %*s %*s %d",
-		       &pdc, stobs, endobs, &sinfo->nobs) != 4) {
-		gretl_errmsg_set(_("Failed to parse series information"));
-		err = DB_PARSE_ERROR;
-	    } else {
-		get_native_series_pd(sinfo, pdc);
-		get_native_series_obs(sinfo, stobs, endobs);
-		sinfo->offset = offset;
-		sinfo->t2 = sinfo->nobs - 1;
-	    }
-	} else {
-	    if (sscanf(s2, "%*c %*s %*s %*s %*s %*s %d", &n) != 1) {
-		gretl_errmsg_set(_("Failed to parse series information"));
-		err = DB_PARSE_ERROR;
-	    } else {
-		offset += n * sizeof(dbnumber);
-	    }
+    strcpy(sinfo->varname, e->name);
+    get_native_series_comment(sinfo, s1);
+    if (sscanf(s2, "%c %10s %*s %10s %*s %*s %d",
+	       &pdc, stobs, endobs, &sinfo->nobs) != 4) {
+	gretl_errmsg_set(_("Failed to parse series information"));
+	err = DB_PARSE_ERROR;
+    } else {
+	get_native_series_pd(sinfo, pdc);
+	get_native_series_obs(sinfo, stobs, endobs);
+	sinfo->offset = e->offset;
+	sinfo->t2 = sinfo->nobs - 1;
+    }
+
+    return err;
+}
+
+static const db_idx_entry *native_db_lookup (const char *series,
+					     const char *idxname,
+					     int *err)
+{
+    db_index *idx = native_db_get_index(idxname, err);
+    db_idx_entry *e = NULL;
+
+    if (!*err) {
+	e = g_hash_table_lookup(idx->ht, series);
+	if (e == NULL) {
+	    gretl_errmsg_sprintf(_("Series not found, '%s'"), series);
+	    *err = DB_NO_SUCH_SERIES;
 	}
     }
 
-    fclose(fp);
+    return e;
+}
 
-    if (!err && !gotit) {
-	gretl_errmsg_sprintf(_("Series not found, '%s'"), series);
-	err = DB_NO_SUCH_SERIES;
+static int get_native_series_info (const char *series,
+				   SERIESINFO *sinfo,
+				   const char *idxname)
+{
+    const db_idx_entry *e;
+    FILE *fp;
+    int err = 0;
+
+    e = native_db_lookup(series, idxname, &err);
+    if (err) {
+	return err;
+    }
+
+    fp = gretl_fopen(idxname, "rb");
+    if (fp == NULL) {
+	return E_FOPEN;
     }
 
+    err = native_series_info_at(fp, e, sinfo);
+    fclose(fp);
+
     return err;
 }
 
@@ -2434,23 +2622,28 @@ static int odbc_get_series (const char *line, DATASET *dset,
 
 #include "dbnread.c"
 
-/* called from loop in db_get_series() */
+static void maybe_fclose (FILE *fp)
+{
+    if (fp != NULL) {
+	fclose(fp);
+    }
+}
 
-static int get_one_db_series (const char *sername,
-			      const char *altname,
-			      DATASET *dset,
-			      CompactMethod cmethod,
-			      int interpolate,
-			      const char *idxname,
-			      PRN *prn)
+/* Add a series retrieved from a database, described by @sinfo
+   and with its data in @dbZ, to @dset. The series was requested
+   as @sername; @altname is non-empty if the user has supplied a
+   name for the imported series.
+*/
+
+static int import_db_series (SERIESINFO *sinfo, double **dbZ,
+			     const char *sername, const char *altname,
+			     DATASET *dset,
+			     CompactMethod cmethod, int interpolate,
+			     PRN *prn)
 {
     CompactMethod this_method = cmethod;
     const char *impname;
-    SERIESINFO sinfo; /* sinfo declared */
-    double **dbZ;
-    int v, err = 0;
-
-    series_info_init(&sinfo);
+    int v;
 
     /* are we using a specified name for importation? */
     impname = (*altname == '\0')? sername : altname;
@@ -2462,11 +2655,41 @@ static int get_one_db_series (const char *sername,
     }
 
 #if DB_DEBUG
-    fprintf(stderr, "get_one_db_series: dset->v=%d, v=%d, name='%s'\n",
+    fprintf(stderr, "import_db_series: dset->v=%d, v=%d, name='%s'\n",
 	    dset->v, v, impname);
-    fprintf(stderr, "this_var_method = %d\n", this_method);
+    fprintf(stderr, "sinfo.varname='%s', this_method=%d, interpolate=%d\n",
+	    sinfo->varname, this_method, interpolate);
 #endif
 
+    if (*altname != '\0') {
+	/* switch the recorded name now */
+	strcpy(sinfo->varname, altname);
+    }
+
+    if (this_method == COMPACT_SPREAD) {
+	return lib_spread_db_data(dbZ, sinfo, dset, prn);
+    } else {
+	return lib_add_db_data(dbZ, sinfo, dset, this_method,
+			       interpolate, v, prn);
+    }
+}
+
+/* called from loop in db_get_series() */
+
+static int get_one_db_series (const char *sername,
+			      const char *altname,
+			      DATASET *dset,
+			      CompactMethod cmethod,
+			      int interpolate,
+			      const char *idxname,
+			      PRN *prn)
+{
+    SERIESINFO sinfo; /* sinfo declared */
+    double **dbZ;
+    int err = 0;
+
+    series_info_init(&sinfo);
+
     /* find the series information in the database */
     if (saved_db_type == GRETL_DBNOMICS) {
 	err = get_dbnomics_series_info(sername, &sinfo);
@@ -2518,22 +2741,9 @@ static int get_one_db_series (const char *sername,
 	err = 0;
     }
 
-#if DB_DEBUG
-    fprintf(stderr, "sinfo.varname='%s', this_method=%d, interpolate=%d\n",
-	    sinfo.varname, this_method, interpolate);
-#endif
-
     if (!err) {
-	if (*altname != '\0') {
-	    /* switch the recorded name now */
-	    strcpy(sinfo.varname, altname);
-	}
-	if (this_method == COMPACT_SPREAD) {
-	    err = lib_spread_db_data(dbZ, &sinfo, dset, prn);
-	} else {
-	    err = lib_add_db_data(dbZ, &sinfo, dset, this_method,
-				  interpolate, v, prn);
-	}
+	err = import_db_series(&sinfo, dbZ, sername, altname, dset,
+			       cmethod, interpolate, prn);
     }
 
     series_info_clear(&sinfo);
@@ -2542,6 +2752,109 @@ static int get_one_db_series (const char *sername,
     return err;
 }
 
+/* Batched retrieval of series from a local native database: the
+   requests are handled in blocks, within which the series info
+   and data are read in database order so that both the .idx and
+   the .bin file are traversed sequentially; the series are then
+   added to the dataset in the order requested.
+*/
+
+#define DB_BATCH_MAX 1024
+
+typedef struct {
+    const db_idx_entry *e;
+    SERIESINFO sinfo;
+    double **dbZ;
+} db_request;
+
+static int db_request_compare (const void *a, const void *b)
+{
+    const db_request *ra = *(const db_request **) a;
+    const db_request *rb = *(const db_request **) b;
+
+    return (ra->e->offset > rb->e->offset) -
+	(ra->e->offset < rb->e->offset);
+}
+
+static int get_native_db_batch (char **snames, int ns,
+				DATASET *dset,
+				CompactMethod cmethod,
+				int interpolate,
+				const char *idxname,
+				PRN *prn)
+{
+    db_request *req;
+    db_request **sorted;
+    FILE *fidx = NULL;
+    FILE *fbin = NULL;
+    int nb = (ns < DB_BATCH_MAX)? ns : DB_BATCH_MAX;
+    int i, j, m, err = 0;
+
+    req = calloc(nb, sizeof *req);
+    sorted = malloc(nb * sizeof *sorted);
+    if (req == NULL || sorted == NULL) {
+	free(req);
+	free(sorted);
+	return E_ALLOC;
+    }
+
+    fidx = gretl_fopen(idxname, "rb");
+    if (fidx == NULL) {
+	err = E_FOPEN;
+    } else {
+	fbin = open_binfile(saved_db_name, GRETL_NATIVE_DB, 0, &err);
+    }
+
+    for (i=0; i<ns && !err; i+=nb) {
+	m = (ns - i < nb)? ns - i : nb;
+	for (j=0; j<m; j++) {
+	    series_info_init(&req[j].sinfo);
+	    req[j].dbZ = NULL;
+	}
+	/* look everything up first */
+	for (j=0; j<m && !err; j++) {
+	    req[j].e = native_db_lookup(snames[i+j], idxname, &err);
+	    sorted[j] = &req[j];
+	}
+	if (!err) {
+	    qsort(sorted, m, sizeof *sorted, db_request_compare);
+	}
+	/* then read in database order */
+	for (j=0; j<m && !err; j++) {
+	    db_request *r = sorted[j];
+
+	    err = native_series_info_at(fidx, r->e, &r->sinfo);
+	    if (!err) {
+		r->dbZ = new_dbZ(r->sinfo.nobs);
+		if (r->dbZ == NULL) {
+		    gretl_errmsg_set(_("Out of memory!"));
+		    err = E_ALLOC;
+		}
+	    }
+	    if (!err) {
+		err = read_native_series(fbin, &r->sinfo, r->dbZ);
+	    }
+	}
+	/* and add to the dataset in the order requested */
+	for (j=0; j<m && !err; j++) {
+	    err = import_db_series(&req[j].sinfo, req[j].dbZ,
+				   snames[i+j], "", dset, cmethod,
+				   interpolate, prn);
+	}
+	for (j=0; j<m; j++) {
+	    series_info_clear(&req[j].sinfo);
+	    free_dbZ(req[j].dbZ);
+	}
+    }
+
+    maybe_fclose(fidx);
+    maybe_fclose(fbin);
+    free(req);
+    free(sorted);
+
+    return err;
+}
+
 static int is_glob (const char *s)
 {
     return strchr(s, '*') || strchr(s, '?');
@@ -2646,34 +2959,60 @@ int db_get_series (const char *line, DATASET *dset,
 	interpolate = 1;
     }
 
-    /* now process the imports individually */
+    if (!err && saved_db_type == GRETL_NATIVE_DB && *altname == '\0') {
+	/* expand any globs and handle the requests as a batch */
+	char **snames = NULL;
+	int ns = 0;
 
-    for (i=0; i<nnames && !err; i++) {
-	if (is_glob(vnames[i])) {
-	    /* globbing works only for native databases */
-	    if (*altname != '\0') {
-		/* can't do it */
-		err = E_BADOPT;
-	    } else if (saved_db_type == GRETL_NATIVE_DB ||
-		       saved_db_type == GRETL_NATIVE_DB_WWW) {
+	for (i=0; i<nnames && !err; i++) {
+	    if (is_glob(vnames[i])) {
 		char **tmp;
 		int j, nmatch;
 
 		tmp = native_db_match_series(vnames[i], &nmatch,
 					     idxname, &err);
 		for (j=0; j<nmatch && !err; j++) {
-		    err = get_one_db_series(tmp[j], altname, dset,
-					    cmethod, interpolate,
-					    idxname, prn);
+		    err = strings_array_add(&snames, &ns, tmp[j]);
 		}
 		strings_array_free(tmp, nmatch);
 	    } else {
-		err = E_INVARG;
+		err = strings_array_add(&snames, &ns, vnames[i]);
+	    }
+	}
+	if (!err && ns > 0) {
+	    err = get_native_db_batch(snames, ns, dset, cmethod,
+				      interpolate, idxname, prn);
+	}
+	strings_array_free(snames, ns);
+    } else if (!err) {
+	/* process the imports individually */
+	for (i=0; i<nnames && !err; i++) {
+	    if (is_glob(vnames[i])) {
+		/* globbing works only for native databases */
+		if (*altname != '\0') {
+		    /* can't do it */
+		    err = E_BADOPT;
+		} else if (saved_db_type == GRETL_NATIVE_DB ||
+			   saved_db_type == GRETL_NATIVE_DB_WWW) {
+		    char **tmp;
+		    int j, nmatch;
+
+		    tmp = native_db_match_series(vnames[i], &nmatch,
+						 idxname, &err);
+		    for (j=0; j<nmatch && !err; j++) {
+			err = get_one_db_series(tmp[j], altname, dset,
+						cmethod, interpolate,
+						idxname, prn);
+		    }
+		    strings_array_free(tmp, nmatch);
+		} else {
+		    err = E_INVARG;
+		}
+	    } else {
+		err = get_one_db_series(vnames[i], altname, dset,
+					cmethod, interpolate,
+					idxname, prn);
 	    }
-	} else {
-	    err = get_one_db_series(vnames[i], altname, dset,
-				    cmethod, interpolate,
-				    idxname, prn);
 	}
     }
 
@@ -2691,6 +3030,7 @@ int db_get_series (const char *line, DATASET *dset,
 	if (saved_db_type == GRETL_NATIVE_DB_WWW) {
 	    /* this file is a temporary download */
 	    gretl_remove(idxname);
+	    native_db_index_clear(idxname);
 	}
 	free(idxname);
     }
@@ -2711,13 +3051,6 @@ static FILE *tempfile_open (char *fname, int *err)
     return fp;
 }
 
-static void maybe_fclose (FILE *fp)
-{
-    if (fp != NULL) {
-	fclose(fp);
-    }
-}
-
 #define DBUFLEN 1024
 
 static int db_delete_series (const char *line, const int *list,
@@ -2861,6 +3194,7 @@ static int db_delete_series (const char *line, const int *list,
     maybe_fclose(f2);
 
     if (!err && ndel > 0) {
+	native_db_index_clear(src1);
 	err = gretl_rename(tmp1, src1);
 	if (!err) {
 	    err = gretl_rename(tmp2, src2);
@@ -116,6 +116,8 @@ int db_set_sample (const char *star, const char *stop, DATASET *dset);
 int db_get_series (const char *line, DATASET *datainfo,
 		   gretlopt opt, PRN *prn);
 
+void native_db_index_clear (const char *idxname);
+
 int db_delete_series_by_name (const char *line, PRN *prn);
 
 int db_delete_series_by_number (const int *list, const char *fname);
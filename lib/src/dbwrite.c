@@ -19,6 +19,7 @@
 
 #include "libgretl.h"
 #include "dbwrite.h"
+#include "dbread.h"
 
 /**
  * SECTION:dbwrite
@@ -625,6 +626,9 @@ int write_db_data (const char *fname, const int *list, gretlopt opt,
 	return 1;
     }
 
+    /* any cached index for this database will be invalid */
+    native_db_index_clear(idxname);
+
     if (append) {
 #if DB_DEBUG
 	fprintf(stderr, "Appending to existing db\n");
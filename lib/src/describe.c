@@ -510,6 +510,27 @@ double gretl_array_quantile (double *a, int n, double p)
     return p;
 }
 
+/**
+ * gretl_array_order_stat:
+ * @a: array on which to operate.
+ * @n: number of elements in @a.
+ * @k: 0-based rank of the element wanted.
+ *
+ * Returns: the element of @a that would be at position @k if
+ * the array were sorted in ascending order, found without a full
+ * sort; @a is re-ordered in the process. The elements of @a must
+ * not be NaN.
+ */
+
+double gretl_array_order_stat (double *a, int n, int k)
+{
+    if (n <= 0 || k < 0 || k >= n) {
+	return NADBL;
+    }
+
+    return find_hoare(a, n, k);
+}
+
 /**
  * gretl_median:
  * @t1: starting observation.
@@ -1820,6 +1820,44 @@ static int get_matrix_size (gretl_matrix *a, gretl_matrix *b,
     return err;
 }
 
+/* Fill @targ with @n values of the bivariate normal CDF, where
+   each of the abscissae is given either by an array, starting at
+   offset @t1, or if the array is NULL by the scalar in @args.
+*/
+
+static int bvnorm_vector_fill (double rho, const double *avec,
+			       const double *bvec, const double *args,
+			       int t1, int n, double *targ)
+{
+    double *tmp = NULL;
+    const double *a, *b;
+    int i;
+
+    if (na(rho) || fabs(rho) > 1) {
+	for (i=0; i<n; i++) {
+	    targ[i] = NADBL;
+	}
+	return 0;
+    }
+
+    if (avec == NULL || bvec == NULL) {
+	tmp = malloc(n * sizeof *tmp);
+	if (tmp == NULL) {
+	    return E_ALLOC;
+	}
+	for (i=0; i<n; i++) {
+	    tmp[i] = (avec == NULL)? args[0] : args[1];
+	}
+    }
+
+    a = (avec != NULL)? avec + t1 : tmp;
+    b = (bvec != NULL)? bvec + t1 : tmp;
+    bvnorm_cdf_array(rho, a, b, NULL, targ, n);
+    free(tmp);
+
+    return 0;
+}
+
 static NODE *bvnorm_node (NODE *n, parser *p)
 {
     NODE *ret = NULL;
@@ -1828,7 +1866,7 @@ static NODE *bvnorm_node (NODE *n, parser *p)
 	NODE *save_aux = p->aux;
 	double *avec = NULL, *bvec = NULL;
 	gretl_matrix *amat = NULL, *bmat = NULL;
-	double a, b, args[2];
+	double args[2];
 	double rho = NADBL;
 	NODE *e;
 	int i, mode = 0;
@@ -1887,17 +1925,11 @@ static NODE *bvnorm_node (NODE *n, parser *p)
 	    ret->v.xval = bvnorm_cdf(rho, args[0], args[1]);
 	} else if (mode == 1) {
 	    /* a and/or b are series */
-	    int t;
+	    int t1 = p->dset->t1;
+	    int n = p->dset->t2 - t1 + 1;
 
-	    for (t=p->dset->t1; t<=p->dset->t2; t++) {
-		a = (avec != NULL)? avec[t] : args[0];
-		b = (bvec != NULL)? bvec[t] : args[1];
-		if (na(a) || na(b)) {
-		    ret->v.xvec[t] = NADBL;
-		} else {
-		    ret->v.xvec[t] = bvnorm_cdf(rho, a, b);
-		}
-	    }
+	    p->err = bvnorm_vector_fill(rho, avec, bvec, args, t1, n,
+					ret->v.xvec + t1);
 	} else if (mode == 2) {
 	    /* a and/or b are matrices */
 	    gretl_matrix *m = NULL;
@@ -1912,10 +1944,11 @@ static NODE *bvnorm_node (NODE *n, parser *p)
 	    if (m != NULL) {
 		int i, n = r * c;
 
+		p->err = bvnorm_vector_fill(rho,
+					    amat != NULL ? amat->val : NULL,
+					    bmat != NULL ? bmat->val : NULL,
+					    args, 0, n, m->val);
 		for (i=0; i<n && !p->err; i++) {
-		    a = (amat != NULL)? amat->val[i] : args[0];
-		    b = (bmat != NULL)? bmat->val[i] : args[1];
-		    m->val[i] = bvnorm_cdf(rho, a, b);
 		    if (na(m->val[i])) {
 			/* matrix: change NAs to NaNs */
 			m->val[i] = 0.0/0.0;
@@ -3246,6 +3279,74 @@ static NODE *BFGS_constrained_max (NODE *t, parser *p)
     return ret;
 }
 
+static NODE *multistart_max (NODE *t, parser *p)
+{
+    NODE *save_aux = p->aux;
+    NODE *n = t->L;
+    NODE *ret = NULL;
+    NODE *e = NULL;
+    gretl_matrix *b = NULL;
+    gretl_matrix *bounds = NULL;
+    gretl_bundle *opts = NULL;
+    const char *sf = NULL;
+    const char *sg = NULL;
+    int nstarts = 0;
+    int i, k = n->v.bn.n_nodes;
+
+    if (k < 3 || k > 6) {
+	n_args_error(k, 6, F_MSMAX, p);
+    }
+
+    for (i=0; i<k && !p->err; i++) {
+	e = n->v.bn.n[i];
+	if (i == 0) {
+	    b = mat_node_get_real_matrix(e, p);
+	} else if (i == 1) {
+	    e = eval(e, p);
+	    if (!p->err) {
+		bounds = mat_node_get_real_matrix(e, p);
+	    }
+	} else if (i == 2) {
+	    sf = node_get_fncall(e, p);
+	} else if (i == 3 && !null_node(e)) {
+	    sg = node_get_fncall(e, p);
+	} else if (i == 4 && !null_node(e)) {
+	    e = eval(e, p);
+	    if (!p->err) {
+		nstarts = node_get_int(e, p);
+	    }
+	} else if (i == 5 && !null_node(e)) {
+	    e = eval(e, p);
+	    if (!p->err) {
+		if (e->t == BUNDLE) {
+		    opts = e->v.b;
+		} else {
+		    p->err = E_TYPES;
+		}
+	    }
+	}
+    }
+
+    if (!p->err && gretl_is_null_matrix(b)) {
+	p->err = E_DATA;
+    }
+
+    if (!p->err) {
+	reset_p_aux(p, save_aux);
+	ret = aux_matrix_node(p);
+    }
+
+    if (!p->err) {
+	int minimize = alias_reversed(t) ? 1 : 0;
+
+	ret->v.m = user_multistart(b, bounds, sf, sg, nstarts, opts,
+				   p->dset, minimize, p->prn,
+				   &p->err);
+    }
+
+    return ret;
+}
+
 static NODE *BFGS_maximize (NODE *l, NODE *m, NODE *r,
 			    parser *p, NODE *t)
 {
@@ -3397,6 +3498,35 @@ static NODE *fzero_node (NODE *l, NODE *m, NODE *r, parser *p)
     return ret;
 }
 
+static NODE *parmap_node (NODE *l, NODE *m, NODE *r, parser *p)
+{
+    NODE *ret = NULL;
+
+    if (starting(p)) {
+	const char *fcall = l->v.str;
+	int n, nproc = 0;
+
+	if (!is_function_call(fcall)) {
+	    p->err = E_TYPES;
+	    return NULL;
+	}
+	n = node_get_int(m, p);
+	if (!p->err && !null_node(r)) {
+	    nproc = node_get_int(r, p);
+	}
+	if (!p->err) {
+	    ret = aux_matrix_node(p);
+	}
+	if (ret != NULL) {
+	    ret->v.m = user_parmap(fcall, n, nproc, p->dset, &p->err);
+	}
+    } else {
+	ret = aux_matrix_node(p);
+    }
+
+    return ret;
+}
+
 static void lag_calc (double *y, const double *x,
 		      int k, int t1, int t2,
 		      int op, double mul,
@@ -13405,6 +13535,51 @@ static NODE *eval_nargs_func (NODE *t, parser *p)
 	    p->err = nadaraya_watson(x, y, h, p->dset, LOO,
 				     trim, ret->v.xvec);
 	}
+    } else if (t->t == F_VARROLL) {
+	gretl_matrix *Y = NULL;
+	gretl_matrix *X = NULL;
+	int order = 0, w = 0;
+	int recursive = 0;
+
+	if (k < 3 || k > 5) {
+	    n_args_error(k, 5, t->t, p);
+	}
+
+	for (i=0; i<k && !p->err; i++) {
+	    e = eval(n->v.bn.n[i], p);
+	    if (p->err) {
+		break;
+	    }
+	    if (i == 0) {
+		Y = node_get_real_matrix(e, p, 0, i+1);
+	    } else if (i == 1) {
+		order = node_get_int(e, p);
+	    } else if (i == 2) {
+		w = node_get_int(e, p);
+	    } else if (i == 3) {
+		/* optional exogenous regressors */
+		if (e->t != EMPTY) {
+		    X = node_get_real_matrix(e, p, 1, i+1);
+		}
+	    } else if (i == 4) {
+		recursive = node_get_bool(e, p, 0);
+	    }
+	}
+
+	if (!p->err) {
+	    gretl_bundle *b;
+
+	    b = VAR_rolling_bundle(Y, X, order, w, recursive, &p->err);
+	    if (!p->err) {
+		reset_p_aux(p, save_aux);
+		ret = aux_bundle_node(p);
+		if (ret != NULL) {
+		    ret->v.b = b;
+		} else {
+		    gretl_bundle_destroy(b);
+		}
+	    }
+	}
     } else if (t->t == F_HYP2F1) {
 	gretl_matrix *x = NULL;
 	double a[3];
@@ -16354,6 +16529,9 @@ static NODE *eval (NODE *t, parser *p)
     case F_BFGSCMAX:
 	ret = BFGS_constrained_max(t, p);
 	break;
+    case F_MSMAX:
+	ret = multistart_max(t, p);
+	break;
     case F_SIMANN:
     case F_NMMAX:
     case F_GSSMAX:
@@ -16371,6 +16549,14 @@ static NODE *eval (NODE *t, parser *p)
 	    p->err = E_TYPES;
 	}
 	break;
+    case F_PARMAP:
+	/* fncall, scalar, optional scalar */
+	if (l->t == STR && scalar_node(m) && null_or_scalar(r)) {
+	    ret = parmap_node(l, m, r, p);
+	} else {
+	    p->err = E_TYPES;
+	}
+	break;
     case F_IMHOF:
 	/* matrix, scalar as second arg */
 	if (l->t == MAT && scalar_node(r)) {
@@ -16527,6 +16713,7 @@ static NODE *eval (NODE *t, parser *p)
     case F_NADARWAT:
     case F_FEVAL:
     case F_HYP2F1:
+    case F_VARROLL:
     case HF_CLOGFI:
 	/* built-in functions taking more than three args */
 	if (t->t == F_FEVAL) {
@@ -16827,9 +17014,13 @@ static NODE *eval (NODE *t, parser *p)
 	}
 	break;
     case F_MPI_RECV:
+    case F_MPI_IRECV:
+    case F_MPI_TEST:
+    case F_MPI_WAIT:
 	ret = mpi_transfer_node(l, NULL, NULL, t->t, p);
 	break;
     case F_MPI_SEND:
+    case F_MPI_ISEND:
     case F_BCAST:
     case F_ALLREDUCE:
 	if (t->t == F_ALLREDUCE && r->t != STR) {
@@ -16848,6 +17039,15 @@ static NODE *eval (NODE *t, parser *p)
 	    ret = mpi_transfer_node(l, m, r, t->t, p);
 	}
 	break;
+    case F_SCATTERV:
+	if (m->t != MAT) {
+	    node_type_error(t->t, 2, MAT, m, p);
+	} else if (!null_or_scalar(r)) {
+	    node_type_error(t->t, 3, NUM, r, p);
+	} else {
+	    ret = mpi_transfer_node(l, m, r, t->t, p);
+	}
+	break;
     case F_GENSERIES:
 	ret = gen_series_node(l, r, p);
 	break;
@@ -373,8 +373,10 @@ struct str_table funcs[] = {
     { F_FDJAC,    "fdjac" },
     { F_BFGSMAX,  "BFGSmax" },
     { F_BFGSCMAX, "BFGScmax" },
+    { F_MSMAX,    "MSmax" },
     { F_NRMAX,    "NRmax" },
     { F_NUMHESS,  "numhess" },
+    { F_PARMAP,   "parmap" },
     { F_OBSNUM,   "obsnum" },
     { F_ISDISCR,  "isdiscrete" },
     { F_ISDUMMY,  "isdummy"},
@@ -465,6 +467,7 @@ struct str_table funcs[] = {
     { F_POLYFIT,  "polyfit" },
     { F_CHOWLIN,  "chowlin" },
     { F_VARSIMUL, "varsimul" },
+    { F_VARROLL,  "varroll" },
     { F_STRSPLIT, "strsplit" },
     { F_INLIST,   "inlist" },
     { F_ERRMSG,   "errmsg" },
@@ -498,10 +501,15 @@ struct str_table funcs[] = {
     { F_SUBSTR,   "substr" },
     { F_MPI_SEND, "mpisend" },
     { F_MPI_RECV, "mpirecv" },
+    { F_MPI_ISEND, "mpiisend" },
+    { F_MPI_IRECV, "mpiirecv" },
+    { F_MPI_TEST, "mpitest" },
+    { F_MPI_WAIT, "mpiwait" },
     { F_BCAST,    "mpibcast" },
     { F_REDUCE,   "mpireduce" },
     { F_ALLREDUCE, "mpiallred" },
     { F_SCATTER,   "mpiscatter" },
+    { F_SCATTERV,  "mpiscatterv" },
     { F_BARRIER,   "mpibarrier" },
     { F_EASTER,    "easterday" },
     { F_GENSERIES, "genseries" },
@@ -571,6 +579,7 @@ struct str_table func_alias[] = {
     { F_NRMAX,    "NRmin" },
     { F_BFGSMAX,  "BFGSmin" },
     { F_BFGSCMAX, "BFGScmin" },
+    { F_MSMAX,    "MSmin" },
     { F_GSSMAX,   "GSSmin" },
     { F_GAMMA,    "gammafunc" },
     { F_GAMMA,    "gamma" },
@@ -150,7 +150,7 @@ static NODE *mpi_transfer_node (NODE *l, NODE *r, NODE *r2,
 	return NULL;
     }
 
-    if (f == F_MPI_SEND) {
+    if (f == F_MPI_SEND || f == F_MPI_ISEND) {
 	/* we support sending a matrix, scalar or bundle; we need
 	   the destination id as second argument
 	*/
@@ -169,11 +169,15 @@ static NODE *mpi_transfer_node (NODE *l, NODE *r, NODE *r2,
 	    /* destination id */
 	    id = node_get_int(r, p);
 	}
-    } else if (f == F_MPI_RECV) {
+    } else if (f == F_MPI_RECV || f == F_MPI_IRECV) {
 	/* the single argument is the source id */
 	id = node_get_int(l, p);
+    } else if (f == F_MPI_TEST || f == F_MPI_WAIT) {
+	/* the single argument is a request handle */
+	id = node_get_int(l, p);
     } else if (f == F_BCAST || f == F_REDUCE ||
-	       f == F_ALLREDUCE || f == F_SCATTER) {
+	       f == F_ALLREDUCE || f == F_SCATTER ||
+	       f == F_SCATTERV) {
 	/* we need a variable's address on the left */
 	if (l->t != U_ADDR) {
 	    p->err = E_TYPES;
@@ -183,13 +187,13 @@ static NODE *mpi_transfer_node (NODE *l, NODE *r, NODE *r2,
 	    if (umatrix_node(l)) {
 		/* matrix: all operations OK */
 		type = GRETL_TYPE_MATRIX;
-	    } else if (ubundle_node(l) && f == F_BCAST) {
-		/* bundle: only broadcast OK */
+	    } else if (ubundle_node(l) && (f == F_BCAST || f == F_ALLREDUCE)) {
+		/* bundle: broadcast and allreduce OK */
 		type = GRETL_TYPE_BUNDLE;
 	    } else if (uarray_node(l) && (f == F_REDUCE || f == F_BCAST)) {
 		/* array: reduce and broadcast OK */
 		type = GRETL_TYPE_ARRAY;
-	    } else if (uscalar_node(l) && f != F_SCATTER) {
+	    } else if (uscalar_node(l) && f != F_SCATTER && f != F_SCATTERV) {
 		/* scalar: all ops OK apart from scatter */
 		type = GRETL_TYPE_DOUBLE;
 	    } else {
@@ -212,7 +216,7 @@ static NODE *mpi_transfer_node (NODE *l, NODE *r, NODE *r2,
 
     if (p->err) {
 	return NULL;
-    } else if (f == F_MPI_SEND) {
+    } else if (f == F_MPI_SEND || f == F_MPI_ISEND) {
 	void *sendp;
 
 	if (type == GRETL_TYPE_MATRIX) {
@@ -225,17 +229,34 @@ static NODE *mpi_transfer_node (NODE *l, NODE *r, NODE *r2,
 	    sendp = &l->v.xval;
 	}
 	ret = aux_scalar_node(p);
-	if (!p->err) {
+	if (!p->err && f == F_MPI_ISEND) {
+	    /* return the request handle */
+	    ret->v.xval = gretl_mpi_isend(sendp, type, id, &p->err);
+	} else if (!p->err) {
 	    p->err = ret->v.xval = gretl_mpi_send(sendp, type, id);
 	}
-    } else if (f == F_MPI_RECV) {
+    } else if (f == F_MPI_IRECV) {
+	ret = aux_scalar_node(p);
+	if (!p->err) {
+	    ret->v.xval = gretl_mpi_irecv(id, &p->err);
+	}
+    } else if (f == F_MPI_TEST) {
+	ret = aux_scalar_node(p);
+	if (!p->err) {
+	    ret->v.xval = gretl_mpi_test(id, &p->err);
+	}
+    } else if (f == F_MPI_RECV || f == F_MPI_WAIT) {
 	gretl_matrix *m = NULL;
 	gretl_bundle *b = NULL;
 	gretl_array *a = NULL;
 	double x = NADBL;
 	int k = 0;
 
-	p->err = gretl_mpi_receive(id, &type, &m, &b, &a, &x, &k);
+	if (f == F_MPI_WAIT) {
+	    p->err = gretl_mpi_wait(id, &type, &m, &b, &a, &x, &k);
+	} else {
+	    p->err = gretl_mpi_receive(id, &type, &m, &b, &a, &x, &k);
+	}
 
 	if (!p->err) {
 	    if (type == GRETL_TYPE_MATRIX) {
@@ -318,7 +339,10 @@ static NODE *mpi_transfer_node (NODE *l, NODE *r, NODE *r2,
 	    gretl_array *a = NULL;
 	    double x = NADBL;
 
-	    if (type == GRETL_TYPE_ARRAY) {
+	    if (type == GRETL_TYPE_BUNDLE) {
+		/* reduced in place */
+		p->err = gretl_bundle_mpi_allreduce(l->v.b, op);
+	    } else if (type == GRETL_TYPE_ARRAY) {
 		p->err = gretl_array_mpi_reduce(l->v.a, &a, op, root);
 	    } else if (type == GRETL_TYPE_MATRIX) {
 		lm = get_transfer_matrix(l, f, p);
@@ -328,7 +352,8 @@ static NODE *mpi_transfer_node (NODE *l, NODE *r, NODE *r2,
 	    } else {
 		p->err = gretl_scalar_mpi_reduce(l->v.xval, &x, op, root, opt);
 	    }
-	    if (!p->err && (id == root || f == F_ALLREDUCE)) {
+	    if (!p->err && type != GRETL_TYPE_BUNDLE &&
+		(id == root || f == F_ALLREDUCE)) {
 		if (type == GRETL_TYPE_ARRAY) {
 		    p->err = node_replace_array(l, a);
 		} else if (type == GRETL_TYPE_MATRIX) {
@@ -354,6 +379,26 @@ static NODE *mpi_transfer_node (NODE *l, NODE *r, NODE *r2,
 		p->err = node_replace_matrix(l, m);
 	    }
 	}
+    } else if (f == F_SCATTERV) {
+	gretl_matrix *lm = NULL;
+	gretl_matrix *sizes = NULL;
+
+	if (id == root) {
+	    /* only root's matrix and row counts are used */
+	    lm = get_transfer_matrix(l, f, p);
+	    sizes = r->v.m;
+	}
+	if (!p->err) {
+	    ret = aux_scalar_node(p);
+	}
+	if (!p->err) {
+	    gretl_matrix *m = NULL;
+
+	    p->err = ret->v.xval = gretl_matrix_mpi_scatterv(lm, sizes, &m, root);
+	    if (!p->err) {
+		p->err = node_replace_matrix(l, m);
+	    }
+	}
     } else {
 	gretl_errmsg_set("MPI function not yet supported");
 	p->err = 1;
@@ -274,6 +274,9 @@ enum {
     F_REMOVE,
     F_ATOF,
     F_MPI_RECV,
+    F_MPI_IRECV,
+    F_MPI_TEST,
+    F_MPI_WAIT,
     F_EASTER,
     F_CURL,
     F_NLINES,
@@ -367,6 +370,7 @@ enum {
     F_PRINTF,
     F_SPRINTF,
     F_MPI_SEND,
+    F_MPI_ISEND,
     F_BCAST,
     F_ALLREDUCE,
     F_GENSERIES,
@@ -436,6 +440,7 @@ enum {
     F_SUBSTR,
     F_REDUCE,
     F_SCATTER,
+    F_SCATTERV,
     F_MWEIGHTS,
     F_MGRADIENT,
     F_MLINCOMB,
@@ -447,6 +452,7 @@ enum {
     F_SMPLSPAN,
     F_FDJAC,
     F_NUMHESS,
+    F_PARMAP,
     F_STRSPLIT,
     F_HPFILT,
     F_XMLGET,
@@ -487,11 +493,13 @@ enum {
     F_DEFLIST,
     F_KSETUP,
     F_BFGSCMAX,
+    F_MSMAX,
     F_SVM,
     F_IRF,
     F_NADARWAT,
     F_FEVAL,
     F_HYP2F1,
+    F_VARROLL,
     HF_CLOGFI,
     FN_MAX,	  /* SEPARATOR: end of n-arg functions */
 };
@@ -564,13 +572,14 @@ enum {
 			s == F_FDJAC || s == F_SIMANN || \
 			s == F_BFGSCMAX || s == F_NMMAX || \
 			s == F_GSSMAX || s == F_NUMHESS || \
-			s == F_FZERO)
+			s == F_FZERO || s == F_PARMAP || \
+			s == F_MSMAX)
 
 /* functions with "reversing" aliases */
 #define als_func(s) (s == F_BFGSMAX || s == F_NRMAX || \
 		     s == F_SIMANN || s == F_BFGSCMAX || \
 		     s == F_NMMAX || s == F_GSSMAX || \
-		     s == F_EXISTS)
+		     s == F_MSMAX || s == F_EXISTS)
 
 /* functions where the right-hand argument is actually a return
    location */
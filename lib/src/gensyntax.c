@@ -1077,6 +1077,8 @@ struct argrecord fncall_argrec[] = {
     {F_GSSMAX,   {0, 1, 0, 0}},
     {F_NUMHESS,  {0, 1, 0, 0}},
     {F_FZERO,    {1, 0, 0, 0}},
+    {F_PARMAP,   {1, 0, 0, 0}},
+    {F_MSMAX,    {0, 0, 1, 1}},
 };
 
 static const int *get_callargs (int f)
@@ -1102,7 +1104,7 @@ static const int *get_callargs (int f)
 static int next_arg_is_string (int i, const int *callargs, int k,
 			       int opt)
 {
-    if (callargs && callargs[i]) {
+    if (i < 4 && callargs && callargs[i]) {
 	return 1;
     }
     if ((opt & MID_STR) && i > 0 && i < k-1) {
@@ -1453,6 +1455,8 @@ static NODE *powterm (parser *p, NODE *l)
 		    sym == F_BFGSCMAX ||
 		    sym == F_MOVAVG) {
 		    k = 4;
+		} else if (sym == F_MSMAX) {
+		    k = 6;
 		}
 		get_args(t->L, p, sym, k, opt, &next);
 	    }
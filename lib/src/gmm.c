@@ -1121,46 +1121,41 @@ static int gmm_jacobian_calc (int m, int n, double *x, double *f,
 static int HAC_prewhiten (gretl_matrix *E, gretl_matrix *A)
 {
     gretl_matrix_block *B;
-    gretl_matrix *y, *X, *XTX;
-    gretl_matrix *b, *e;
+    gretl_matrix *Y, *X, *XTX;
+    gretl_matrix *XTY, *b;
     int T = E->rows;
     int k = E->cols;
-    double xtj, eti;
     int i, j, t;
     int err = 0;
 
-    B = gretl_matrix_block_new(&y, T-1, 1,
+    B = gretl_matrix_block_new(&Y, T-1, k,
 			       &X, T-1, k,
 			       &XTX, k, k,
+			       &XTY, k, k,
 			       &b, k, 1,
-			       &e, k, 1,
 			       NULL);
     if (B == NULL) {
 	return E_ALLOC;
     }
 
-    /* make matrix of RHS vars */
+    /* make matrices of LHS and RHS vars */
     for (j=0; j<k; j++) {
-	for (t=1; t<T; t++) {
-	    xtj = gretl_matrix_get(E, t-1, j);
-	    gretl_matrix_set(X, t-1, j, xtj);
-	}
-    }   
+	memcpy(Y->val + j*(T-1), E->val + j*T + 1, (T-1) * sizeof(double));
+	memcpy(X->val + j*(T-1), E->val + j*T, (T-1) * sizeof(double));
+    }
 
     gretl_matrix_multiply_mod(X, GRETL_MOD_TRANSPOSE,
 			      X, GRETL_MOD_NONE,
 			      XTX, GRETL_MOD_NONE);
+    gretl_matrix_multiply_mod(X, GRETL_MOD_TRANSPOSE,
+			      Y, GRETL_MOD_NONE,
+			      XTY, GRETL_MOD_NONE);
 
     err = gretl_matrix_cholesky_decomp(XTX);
 
     /* loop across LHS vars and compute coeffs */
     for (i=0; i<k && !err; i++) {
-	for (t=1; t<T; t++) {
-	    y->val[t-1] = gretl_matrix_get(E, t, i);
-	}
-	gretl_matrix_multiply_mod(X, GRETL_MOD_TRANSPOSE,
-				  y, GRETL_MOD_NONE,
-				  b, GRETL_MOD_NONE);
+	memcpy(b->val, XTY->val + i*k, k * sizeof(double));
 	err = gretl_cholesky_solve(XTX, b);
 	if (!err) {
 	    for (j=0; j<k; j++) {
@@ -1185,22 +1180,15 @@ static int HAC_prewhiten (gretl_matrix *E, gretl_matrix *A)
 	gretl_matrix_print(A, "A~");
 #endif
 
-	for (i=0; i<k; i++) {
-	    /* get starting E values */
-	    e->val[i] = gretl_matrix_get(E, 0, i);
-	}	
-
-	/* Now "whiten" E using A~ */
-	for (t=1; t<T; t++) {
-	    /* re-use @b for fitted values */
-	    gretl_matrix_multiply(A, e, b);
-	    for (i=0; i<k; i++) {
-		/* retrieve current value */
-		eti = gretl_matrix_get(E, t, i);
-		/* save lagged value for next round */
-		e->val[i] = eti;
-		/* substitute prediction error */
-		gretl_matrix_set(E, t, i, eti - b->val[i]);
+	/* Now "whiten" E using A~: re-use @Y for the fitted
+	   values, X A~', and substitute the prediction errors
+	*/
+	gretl_matrix_multiply_mod(X, GRETL_MOD_NONE,
+				  A, GRETL_MOD_TRANSPOSE,
+				  Y, GRETL_MOD_NONE);
+	for (j=0; j<k; j++) {
+	    for (t=1; t<T; t++) {
+		E->val[j*T + t] -= Y->val[j*(T-1) + t - 1];
 	    }
 	}
     }
@@ -1212,14 +1200,20 @@ static int HAC_prewhiten (gretl_matrix *E, gretl_matrix *A)
     return err;
 }
 
+/* The workspace and the kernel weights are retained across calls
+   (in iterated GMM the weights matrix is recomputed at each round),
+   the weights being recomputed only if the bandwidth changes.
+*/
+
 static int gmm_HAC (gretl_matrix *E, gretl_matrix *V, hac_info *hinfo)
 {
     static gretl_matrix *W;
     static gretl_matrix *Tmp;
     static gretl_matrix *A;
     static gretl_matrix *E2;
+    static double *wts;
+    static hac_info wprev;
     int T, k;
-    double w;
     int i, err = 0;
 
     if (E == NULL) {
@@ -1229,6 +1223,8 @@ static int gmm_HAC (gretl_matrix *E, gretl_matrix *V, hac_info *hinfo)
 	gretl_matrix_free(A);
 	gretl_matrix_free(E2);
 	W = Tmp = A = E2 = NULL;
+	free(wts);
+	wts = NULL;
 	return 0;
     }
 
@@ -1266,23 +1262,19 @@ static int gmm_HAC (gretl_matrix *E, gretl_matrix *V, hac_info *hinfo)
 	}
     }
 
-    gretl_matrix_multiply_mod(E, GRETL_MOD_TRANSPOSE,
-			      E, GRETL_MOD_NONE,
-			      V, GRETL_MOD_NONE);
+    if (wts == NULL || hinfo->kern != wprev.kern ||
+	hinfo->h != wprev.h || hinfo->bt != wprev.bt) {
+	free(wts);
+	wts = HAC_kernel_weights(hinfo->kern, hinfo->h, hinfo->bt, &err);
+	if (err) {
+	    return err;
+	}
+	wprev = *hinfo;
+    }
 
-    for (i=1; i<=hinfo->h; i++) {
-	if (hinfo->kern == KERNEL_QS) {
-	    w = qs_hac_weight(hinfo->bt, i);
-	} else {
-	    w = hac_weight(hinfo->kern, hinfo->h, i);
-	}
-	gretl_matrix_inplace_lag(W, E, i);
-	gretl_matrix_multiply_by_scalar(W, 2*w);
-	gretl_matrix_multiply_mod(E, GRETL_MOD_TRANSPOSE,
-				  W, GRETL_MOD_NONE,
-				  Tmp, GRETL_MOD_NONE);
-	gretl_matrix_xtr_symmetric(Tmp);
-	gretl_matrix_add_to(V, Tmp);
+    err = HAC_kernel_sum(E, wts, hinfo->h, W, V);
+    if (err) {
+	return err;
     }
 
     if (!gretl_matrix_is_symmetric(V)) {
@@ -31,6 +31,10 @@
 #include <float.h>
 #include <errno.h>
 
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
 #define BFGS_DEBUG 0
 
 #define BFGS_MAXITER_DEFAULT 600
@@ -318,6 +322,362 @@ static void hess_h_reduce (double *h, double v, int n)
 */
 #define numhess_d 0.01
 
+/* Apparatus for computing numerical derivatives in parallel. A
+   caller whose criterion function is re-entrant, given a private
+   copy of its @data argument, can say so by passing
+   BFGS_reentrant_crit() as the criterion along with a
+   BFGS_reentrant struct as @data; the perturbed evaluations of the
+   criterion are then shared out among a team of OpenMP threads,
+   each with its own copy of the parameter vector and of the
+   caller's data. Since everything needed travels with @data,
+   nested or concurrent optimizations do not interfere.
+*/
+
+/**
+ * BFGS_reentrant_crit:
+ * @b: parameter vector.
+ * @data: pointer to a #BFGS_reentrant struct.
+ *
+ * Evaluates the criterion function recorded in @data at @b. This
+ * can be passed, together with a #BFGS_reentrant struct as the data
+ * argument, to any of the optimizers or numerical derivative
+ * functions in place of the criterion function proper: it signals
+ * that the criterion may safely be called from several threads at
+ * once provided each thread has its own copy of the criterion's
+ * data, so that numerical gradients and Hessians can be computed
+ * in parallel, if OpenMP is available and enabled.
+ *
+ * Returns: the value of the criterion.
+ */
+
+double BFGS_reentrant_crit (const double *b, void *data)
+{
+    BFGS_reentrant *rt = data;
+
+    return rt->cfunc(b, rt->data);
+}
+
+typedef struct crit_team_ crit_team;
+
+struct crit_team_ {
+    int nt;             /* number of threads */
+    int n;              /* number of parameters */
+    int blas_nt;        /* saved number of OpenBLAS threads */
+    void **data;        /* per-thread criterion data */
+    BFGS_reentrant *rt; /* per-thread criterion info */
+    double *b;          /* per-thread parameter vectors, nt x n */
+    double *h;          /* per-thread step sizes, nt x n */
+};
+
+static void crit_team_destroy (crit_team *team)
+{
+    int i;
+
+    if (team->blas_nt > 1) {
+	blas_set_num_threads(team->blas_nt);
+    }
+    /* note: data[0] belongs to the caller */
+    for (i=1; i<team->nt; i++) {
+	if (team->rt[i].data != NULL) {
+	    team->rt[i].dfree(team->rt[i].data);
+	}
+    }
+    free(team->data);
+    free(team->rt);
+    free(team->b);
+    free(team);
+}
+
+/* Returns a team of threads for evaluating @func at @ntasks
+   perturbations of @b, or NULL if @func is not BFGS_reentrant_crit
+   or threading is not available or worthwhile, in which case the
+   caller should proceed serially.
+*/
+
+static crit_team *crit_team_new (const double *b, int n, int ntasks,
+				 BFGS_CRIT_FUNC func, void *data)
+{
+#if defined(_OPENMP)
+    BFGS_reentrant *rt = data;
+    crit_team *team;
+    int i, nt, err = 0;
+
+    if (func != BFGS_reentrant_crit || rt->dclone == NULL ||
+	rt->dfree == NULL || ntasks < 2 ||
+	!libset_get_bool(USE_OPENMP)) {
+	return NULL;
+    }
+
+    nt = get_omp_n_threads();
+    if (nt > ntasks) {
+	nt = ntasks;
+    }
+    if (nt < 2) {
+	return NULL;
+    }
+
+    team = malloc(sizeof *team);
+    if (team == NULL) {
+	return NULL;
+    }
+
+    team->nt = nt;
+    team->n = n;
+    team->blas_nt = 0;
+    team->data = calloc(nt, sizeof *team->data);
+    team->rt = calloc(nt, sizeof *team->rt);
+    team->b = malloc(2 * nt * n * sizeof *team->b);
+
+    if (team->data == NULL || team->rt == NULL || team->b == NULL) {
+	team->nt = 0;
+	crit_team_destroy(team);
+	return NULL;
+    }
+
+    team->h = team->b + nt * n;
+    team->data[0] = data;
+    for (i=1; i<nt && !err; i++) {
+	team->rt[i] = *rt;
+	team->rt[i].data = rt->dclone(rt->data, &err);
+	if (team->rt[i].data == NULL && !err) {
+	    err = E_ALLOC;
+	}
+	team->data[i] = &team->rt[i];
+    }
+    if (err) {
+	/* fall back to serial operation */
+	crit_team_destroy(team);
+	return NULL;
+    }
+
+    for (i=0; i<nt; i++) {
+	memcpy(team->b + i * n, b, n * sizeof *b);
+    }
+
+    /* don't oversubscribe the cores via threaded BLAS */
+    if (blas_is_openblas()) {
+	team->blas_nt = blas_get_num_threads();
+	if (team->blas_nt > 1) {
+	    blas_set_num_threads(1);
+	}
+    }
+
+    return team;
+#else
+    return NULL;
+#endif
+}
+
+/* Richardson extrapolation over the RSTEPS values in @Dx */
+
+static double richardson_extrap (double *Dx)
+{
+    double p4m = 4.0;
+    int m, k;
+
+    for (m=0; m<RSTEPS-1; m++) {
+	for (k=0; k<RSTEPS-m-1; k++) {
+	    Dx[k] = (Dx[k+1] * p4m - Dx[k]) / (p4m - 1);
+	}
+	p4m *= 4.0;
+    }
+
+    return Dx[0];
+}
+
+/* For numerical_hessian(): compute the first derivative of @func
+   with respect to b[i], and the corresponding diagonal element of
+   the Hessian, writing these into @Di and @Hdi. On return @b is
+   unchanged; @h is workspace.
+*/
+
+static int hess_diag_deriv (double *b, double *h, const double *h0,
+			    int i, int n, double f0, double d,
+			    BFGS_CRIT_FUNC func, void *data,
+			    double *Di, double *Hdi)
+{
+    double Dx[RSTEPS];
+    double Hx[RSTEPS];
+    double dsmall = 0.0001;
+    double bi0 = b[i];
+    double f1, f2;
+    int k;
+
+    hess_h_init(h, (double *) h0, n);
+    for (k=0; k<RSTEPS; k++) {
+	b[i] = bi0 + h[i];
+	f1 = func(b, data);
+	if (na(f1)) {
+	    if (d <= dsmall) {
+		fprintf(stderr, "numerical_hessian: 1st derivative: "
+			"criterion=NA for theta[%d] = %g (d=%g)\n", i, b[i], d);
+	    }
+	    b[i] = bi0;
+	    return E_NAN;
+	}
+	b[i] = bi0 - h[i];
+	f2 = func(b, data);
+	if (na(f2)) {
+	    if (d <= dsmall) {
+		fprintf(stderr, "numerical_hessian: 1st derivative: "
+			"criterion=NA for theta[%d] = %g (d=%g)\n", i, b[i], d);
+	    }
+	    b[i] = bi0;
+	    return E_NAN;
+	}
+	/* F'(i) */
+	Dx[k] = (f1 - f2) / (2 * h[i]);
+	/* F''(i) */
+	Hx[k] = (f1 - 2*f0 + f2) / (h[i] * h[i]);
+	hess_h_reduce(h, 2.0, n);
+    }
+    b[i] = bi0;
+
+    *Di = richardson_extrap(Dx);
+    *Hdi = richardson_extrap(Hx);
+
+    return 0;
+}
+
+/* For numerical_hessian(): compute the cross-partial of @func with
+   respect to b[i] and b[j], given the diagonal elements @Hd, and
+   write it into @Dij. On return @b is unchanged; @h is workspace.
+*/
+
+static int hess_cross_deriv (double *b, double *h, const double *h0,
+			     int i, int j, int n, double f0, double d,
+			     const double *Hd, BFGS_CRIT_FUNC func,
+			     void *data, double *Dij)
+{
+    double Dx[RSTEPS];
+    double dsmall = 0.0001;
+    double bi0 = b[i];
+    double bj0 = b[j];
+    double f1, f2;
+    int k;
+
+    hess_h_init(h, (double *) h0, n);
+    for (k=0; k<RSTEPS; k++) {
+	b[i] = bi0 + h[i];
+	b[j] = bj0 + h[j];
+	f1 = func(b, data);
+	if (na(f1)) {
+	    if (d <= dsmall) {
+		fprintf(stderr, "numerical_hessian: 2nd derivatives (%d,%d): "
+			"objective function gave NA\n", i, j);
+	    }
+	    b[i] = bi0;
+	    b[j] = bj0;
+	    return E_NAN;
+	}
+	b[i] = bi0 - h[i];
+	b[j] = bj0 - h[j];
+	f2 = func(b, data);
+	if (na(f2)) {
+	    if (d <= dsmall) {
+		fprintf(stderr, "numerical_hessian: 2nd derivatives (%d,%d): "
+			"objective function gave NA\n", i, j);
+	    }
+	    b[i] = bi0;
+	    b[j] = bj0;
+	    return E_NAN;
+	}
+	/* cross-partial */
+	Dx[k] = (f1 - 2*f0 + f2 - Hd[i]*h[i]*h[i]
+		 - Hd[j]*h[j]*h[j]) / (2*h[i]*h[j]);
+	hess_h_reduce(h, 2.0, n);
+    }
+    b[i] = bi0;
+    b[j] = bj0;
+
+    *Dij = richardson_extrap(Dx);
+
+    return 0;
+}
+
+/* first derivatives and Hessian diagonal, for all i */
+
+static int hess_diag_all (crit_team *team, double *b, double *h,
+			  const double *h0, int n, double f0, double d,
+			  BFGS_CRIT_FUNC func, void *data,
+			  double *D, double *Hd)
+{
+    int i, err = 0;
+
+#if defined(_OPENMP)
+    if (team != NULL) {
+	int bad = 0;
+
+#pragma omp parallel for num_threads(team->nt) schedule(dynamic, 1) \
+    reduction(+:bad)
+	for (i=0; i<n; i++) {
+	    int t = omp_get_thread_num();
+
+	    bad += hess_diag_deriv(team->b + t * n, team->h + t * n, h0,
+				   i, n, f0, d, func, team->data[t],
+				   &D[i], &Hd[i]) != 0;
+	}
+	return bad ? E_NAN : 0;
+    }
+#endif
+
+    for (i=0; i<n && !err; i++) {
+	err = hess_diag_deriv(b, h, h0, i, n, f0, d, func, data,
+			      &D[i], &Hd[i]);
+    }
+
+    return err;
+}
+
+/* second derivatives: lower half of Hessian only, packed by rows
+   into @D starting at offset n */
+
+static int hess_cross_all (crit_team *team, double *b, double *h,
+			   const double *h0, int n, double f0, double d,
+			   BFGS_CRIT_FUNC func, void *data,
+			   double *D, const double *Hd)
+{
+    int i, j, err = 0;
+
+    for (i=0; i<n; i++) {
+	/* diagonal elements */
+	D[n + i*(i+1)/2 + i] = Hd[i];
+    }
+
+#if defined(_OPENMP)
+    if (team != NULL) {
+	int bad = 0;
+	int ii;
+
+	/* run the longest rows first */
+#pragma omp parallel for private(i, j) num_threads(team->nt) \
+    schedule(dynamic, 1) reduction(+:bad)
+	for (ii=0; ii<n; ii++) {
+	    int t = omp_get_thread_num();
+	    double *bt = team->b + t * n;
+	    double *ht = team->h + t * n;
+
+	    i = n - 1 - ii;
+	    for (j=0; j<i; j++) {
+		bad += hess_cross_deriv(bt, ht, h0, i, j, n, f0, d, Hd,
+					func, team->data[t],
+					&D[n + i*(i+1)/2 + j]) != 0;
+	    }
+	}
+	return bad ? E_NAN : 0;
+    }
+#endif
+
+    for (i=0; i<n && !err; i++) {
+	for (j=0; j<i && !err; j++) {
+	    err = hess_cross_deriv(b, h, h0, i, j, n, f0, d, Hd,
+				   func, data, &D[n + i*(i+1)/2 + j]);
+	}
+    }
+
+    return err;
+}
+
 /* The algorithm below implements the method of Richardson
    Extrapolation.  It is derived from code in the gnu R package
    "numDeriv" by Paul Gilbert, which was in turn derived from code
@@ -331,21 +691,16 @@ int numerical_hessian (double *b, gretl_matrix *H,
 		       BFGS_CRIT_FUNC func, void *data,
 		       int neg, double d)
 {
-    double Dx[RSTEPS];
-    double Hx[RSTEPS];
+    crit_team *team = NULL;
     double *wspace;
     double *h0, *h, *Hd, *D;
-    int r = RSTEPS;
     double dsmall = 0.0001;
     double ztol, eps = 1e-4;
-    double v = 2.0;    /* reduction factor for h */
-    double f0, f1, f2;
-    double p4m, hij;
-    double bi0, bj0;
+    double f0, hij;
     int n = gretl_matrix_rows(H);
     int vn = (n * (n + 1)) / 2;
     int dn = vn + n;
-    int i, j, k, m, u;
+    int i, j, u;
     int err = 0;
 
     if (d == 0.0) {
@@ -368,6 +723,9 @@ int numerical_hessian (double *b, gretl_matrix *H,
     ztol = 0.01;
 #endif
 
+    /* share the work out, if @func allows it */
+    team = crit_team_new(b, n, n, func, data);
+
  try_again:
 
     /* note: numDeriv has
@@ -390,112 +748,11 @@ int numerical_hessian (double *b, gretl_matrix *H,
 
     f0 = func(b, data);
 
-    /* first derivatives and Hessian diagonal */
-
-    for (i=0; i<n; i++) {
-	bi0 = b[i];
-	hess_h_init(h, h0, n);
-	for (k=0; k<r; k++) {
-	    b[i] = bi0 + h[i];
-	    f1 = func(b, data);
-	    if (na(f1)) {
-		if (d <= dsmall) {
-		    fprintf(stderr, "numerical_hessian: 1st derivative: "
-			    "criterion=NA for theta[%d] = %g (d=%g)\n", i, b[i], d);
-		}
-		b[i] = bi0;
-		err = E_NAN;
-		goto end_first_try;
-	    }
-	    b[i] = bi0 - h[i];
-	    f2 = func(b, data);
-	    if (na(f2)) {
-		if (d <= dsmall) {
-		    fprintf(stderr, "numerical_hessian: 1st derivative: "
-			    "criterion=NA for theta[%d] = %g (d=%g)\n", i, b[i], d);
-		}
-		b[i] = bi0;
-		err = E_NAN;
-		goto end_first_try;
-	    }
-	    /* F'(i) */
-	    Dx[k] = (f1 - f2) / (2 * h[i]);
-	    /* F''(i) */
-	    Hx[k] = (f1 - 2*f0 + f2) / (h[i] * h[i]);
-	    hess_h_reduce(h, v, n);
-	}
-	b[i] = bi0;
-	p4m = 4.0;
-	for (m=0; m<r-1; m++) {
-	    for (k=0; k<r-m-1; k++) {
-		Dx[k] = (Dx[k+1] * p4m - Dx[k]) / (p4m - 1);
-		Hx[k] = (Hx[k+1] * p4m - Hx[k]) / (p4m - 1);
-	    }
-	    p4m *= 4.0;
-	}
-	D[i] = Dx[0];
-	Hd[i] = Hx[0];
-    }
-
-    /* second derivatives: lower half of Hessian only */
-
-    u = n;
-    for (i=0; i<n; i++) {
-	bi0 = b[i];
-	for (j=0; j<=i; j++) {
-	    if (i == j) {
-		D[u] = Hd[i];
-	    } else {
-		hess_h_init(h, h0, n);
-		bj0 = b[j];
-		for (k=0; k<r; k++) {
-		    b[i] = bi0 + h[i];
-		    b[j] = bj0 + h[j];
-		    f1 = func(b, data);
-		    if (na(f1)) {
-			if (d <= dsmall) {
-			    fprintf(stderr, "numerical_hessian: 2nd derivatives (%d,%d): "
-				    "objective function gave NA\n", i, j);
-			}
-			b[i] = bi0;
-			b[j] = bj0;
-			err = E_NAN;
-			goto end_first_try;
-		    }
-		    b[i] = bi0 - h[i];
-		    b[j] = bj0 - h[j];
-		    f2 = func(b, data);
-		    if (na(f2)) {
-			if (d <= dsmall) {
-			    fprintf(stderr, "numerical_hessian: 2nd derivatives (%d,%d): "
-				    "objective function gave NA\n", i, j);
-			}
-			b[i] = bi0;
-			b[j] = bj0;
-			err = E_NAN;
-			goto end_first_try;
-		    }
-		    /* cross-partial */
-		    Dx[k] = (f1 - 2*f0 + f2 - Hd[i]*h[i]*h[i]
-			     - Hd[j]*h[j]*h[j]) / (2*h[i]*h[j]);
-		    hess_h_reduce(h, v, n);
-		}
-		p4m = 4.0;
-		for (m=0; m<r-1; m++) {
-		    for (k=0; k<r-m-1; k++) {
-			Dx[k] = (Dx[k+1] * p4m - Dx[k]) / (p4m - 1);
-		    }
-		    p4m *= 4.0;
-		}
-		D[u] = Dx[0];
-		b[j] = bj0;
-	    }
-	    u++;
-	}
-	b[i] = bi0;
+    err = hess_diag_all(team, b, h, h0, n, f0, d, func, data, D, Hd);
+    if (!err) {
+	err = hess_cross_all(team, b, h, h0, n, f0, d, func, data, D, Hd);
     }
 
- end_first_try:
     if (err == E_NAN && d > dsmall) {
 	err = 0;
 	gretl_error_clear();
@@ -503,6 +760,10 @@ int numerical_hessian (double *b, gretl_matrix *H,
 	goto try_again;
     }
 
+    if (team != NULL) {
+	crit_team_destroy(team);
+    }
+
     if (!err) {
 	/* transcribe the (negative of?) the Hessian */
 	u = n;
@@ -657,80 +918,144 @@ gretl_matrix *numerical_score_matrix (double *b, int T, int k,
     return G;
 }
 
-static int richardson_gradient (double *b, double *g, int n,
-				BFGS_CRIT_FUNC func, void *data)
+/* Derivative of @func with respect to b[i] by Richardson
+   extrapolation. On return @b is unchanged.
+*/
+
+static int richardson_deriv (double *b, int i, double *gi,
+			     BFGS_CRIT_FUNC func, void *data)
 {
     double df[RSTEPS];
     double eps = 1.0e-4;
     double d = 0.0001;
-    double h, p4m;
-    double bi0, f1, f2;
-    int r = RSTEPS;
-    int i, k, m;
+    double bi0 = b[i];
+    double h, f1, f2;
+    int k;
 
-    for (i=0; i<n; i++) {
-	bi0 = b[i];
-	h = fabs(d * b[i]) + eps * (floateq(b[i], 0.0));
-	for (k=0; k<r; k++) {
-	    b[i] = bi0 - h;
-	    f1 = func(b, data);
-	    b[i] = bi0 + h;
-	    f2 = func(b, data);
-	    if (na(f1) || na(f2)) {
-		b[i] = bi0;
-		return 1;
-	    }
-	    df[k] = (f2 - f1) / (2 * h);
-	    h /= 2.0;
-	}
-	b[i] = bi0;
-	p4m = 4.0;
-	for (m=0; m<r-1; m++) {
-	    for (k=0; k<r-m-1; k++) {
-		df[k] = (df[k+1] * p4m - df[k]) / (p4m - 1.0);
-	    }
-	    p4m *= 4.0;
+    h = fabs(d * b[i]) + eps * (floateq(b[i], 0.0));
+    for (k=0; k<RSTEPS; k++) {
+	b[i] = bi0 - h;
+	f1 = func(b, data);
+	b[i] = bi0 + h;
+	f2 = func(b, data);
+	if (na(f1) || na(f2)) {
+	    b[i] = bi0;
+	    return 1;
 	}
-	g[i] = df[0];
+	df[k] = (f2 - f1) / (2 * h);
+	h /= 2.0;
     }
+    b[i] = bi0;
+    *gi = richardson_extrap(df);
 
     return 0;
 }
 
+static int richardson_gradient (double *b, double *g, int n,
+				BFGS_CRIT_FUNC func, void *data)
+{
+    int i, err = 0;
+#if defined(_OPENMP)
+    crit_team *team = crit_team_new(b, n, n, func, data);
+
+    if (team != NULL) {
+	int bad = 0;
+
+#pragma omp parallel for num_threads(team->nt) schedule(static) \
+    reduction(+:bad)
+	for (i=0; i<n; i++) {
+	    int t = omp_get_thread_num();
+
+	    bad += richardson_deriv(team->b + t * n, i, &g[i],
+				    func, team->data[t]);
+	}
+	crit_team_destroy(team);
+	return bad > 0;
+    }
+#endif
+
+    for (i=0; i<n && !err; i++) {
+	err = richardson_deriv(b, i, &g[i], func, data);
+    }
+
+    return err;
+}
+
 /* trigger for switch to Richardson gradient */
 #define B_RELMIN 1.0e-14
 
+/* step size for simple gradient */
+#define GRAD_H 1.0e-8
+
+/* Central-difference derivative of @func with respect to b[i].
+   On return @b is unchanged.
+*/
+
+static int simple_deriv (double *b, int i, double *gi,
+			 BFGS_CRIT_FUNC func, void *data)
+{
+    double bi0 = b[i];
+    double f1, f2;
+
+    b[i] = bi0 - GRAD_H;
+    f1 = func(b, data);
+    b[i] = bi0 + GRAD_H;
+    f2 = func(b, data);
+    b[i] = bi0;
+    if (na(f1) || na(f2)) {
+	return 1;
+    }
+    *gi = (f2 - f1) / (2.0 * GRAD_H);
+#if BFGS_DEBUG > 1
+    fprintf(stderr, "g[%d] = (%.16g - %.16g) / (2.0 * %g) = %g\n",
+	    i, f2, f1, GRAD_H, *gi);
+#endif
+
+    return 0;
+}
+
 static int simple_gradient (double *b, double *g, int n,
 			    BFGS_CRIT_FUNC func, void *data,
 			    int *redo)
 {
-    const double h = 1.0e-8;
-    double bi0, f1, f2;
-    int i;
+#if defined(_OPENMP)
+    crit_team *team;
+#endif
+    double bi0;
+    int i, err = 0;
 
     for (i=0; i<n; i++) {
 	bi0 = b[i];
-	b[i] = bi0 - h;
-	if (bi0 != 0.0 && fabs((bi0 - b[i]) / bi0) < B_RELMIN) {
+	if (bi0 != 0.0 && fabs((bi0 - (bi0 - GRAD_H)) / bi0) < B_RELMIN) {
 	    fprintf(stderr, "numerical gradient: switching to Richardson\n");
 	    *redo = 1;
 	    return 0;
 	}
-	f1 = func(b, data);
-	b[i] = bi0 + h;
-	f2 = func(b, data);
-	b[i] = bi0;
-	if (na(f1) || na(f2)) {
-	    return 1;
+    }
+
+#if defined(_OPENMP)
+    team = crit_team_new(b, n, n, func, data);
+    if (team != NULL) {
+	int bad = 0;
+
+#pragma omp parallel for num_threads(team->nt) schedule(static) \
+    reduction(+:bad)
+	for (i=0; i<n; i++) {
+	    int t = omp_get_thread_num();
+
+	    bad += simple_deriv(team->b + t * n, i, &g[i],
+				func, team->data[t]);
 	}
-	g[i] = (f2 - f1) / (2.0 * h);
-#if BFGS_DEBUG > 1
-	fprintf(stderr, "g[%d] = (%.16g - %.16g) / (2.0 * %g) = %g\n",
-		i, f2, f1, h, g[i]);
+	crit_team_destroy(team);
+	return bad > 0;
+    }
 #endif
+
+    for (i=0; i<n && !err; i++) {
+	err = simple_deriv(b, i, &g[i], func, data);
     }
 
-    return 0;
+    return err;
 }
 
 /* default numerical calculation of gradient in context of BFGS */
@@ -2506,6 +2831,957 @@ gretl_matrix *user_numhess (gretl_matrix *b, const char *fncall,
     return H;
 }
 
+/* Below: parmap(), which evaluates a user function call over a
+   range of integer indices using a pool of worker processes on
+   the local machine. Workers are forked from the calling process
+   so that all existing matrices, bundles and the dataset are
+   shared copy-on-write: nothing is copied up front, and a worker
+   touches its own private copy of a page only if it writes to it.
+   Results are written into an anonymous shared mapping which is
+   created before the fork, so they are visible to the parent
+   without any further transfer. On platforms lacking fork() and
+   mmap() the tasks are simply run in sequence.
+*/
+
+#if !defined(WIN32) && defined(HAVE_MMAP)
+# define PARMAP_FORK 1
+#endif
+
+#ifdef PARMAP_FORK
+# include <unistd.h>
+# include <sys/mman.h>
+# if HAVE_SYS_WAIT_H
+#  include <sys/wait.h>
+# endif
+# ifndef WEXITSTATUS
+#  define WEXITSTATUS(stat_val) ((unsigned)(stat_val) >> 8)
+# endif
+# ifndef WIFEXITED
+#  define WIFEXITED(stat_val) (((stat_val) & 255) == 0)
+# endif
+#endif
+
+/* Control block shared by all workers: @next is the index of the
+   next unclaimed task, @err records the first error encountered
+   by any worker, and @x holds the n x k results, stored so that
+   the k values produced by each task are contiguous.
+*/
+
+typedef struct parmap_shared_ parmap_shared;
+
+struct parmap_shared_ {
+    gint next;
+    gint err;
+    double x[1];
+};
+
+static size_t parmap_shared_size (int n, int k)
+{
+    return sizeof(parmap_shared) + (n * (size_t) k - 1) * sizeof(double);
+}
+
+/* The function call must take the task index as its first
+   argument, in the form of a named scalar: set that scalar to 1,
+   creating it if need be, so that the initial evaluation at
+   compile time is for the first task.
+*/
+
+static int parmap_index_init (const char *fncall)
+{
+    const char *s = strchr(fncall, '(');
+    char vname[VNAMELEN];
+    int n = 0, err = 0;
+
+    if (s != NULL) {
+	n = gretl_namechar_spn(s + 1);
+    }
+
+    if (n == 0 || n >= VNAMELEN) {
+	gretl_errmsg_set(_("parmap: the first argument of the function "
+			   "call must be the name of a scalar"));
+	return E_INVARG;
+    }
+
+    *vname = '\0';
+    strncat(vname, s + 1, n);
+
+    if (gretl_is_scalar(vname)) {
+	err = gretl_scalar_set_value(vname, 1);
+    } else {
+	err = gretl_scalar_add(vname, 1);
+    }
+
+    return err;
+}
+
+/* copy the result of the task with 0-based index @i into
+   the results block */
+
+static int parmap_get_result (umax *u, double *x, int i, int k)
+{
+    gretl_matrix *m = genr_get_output_matrix(u->gf);
+
+    if (m == NULL) {
+	return E_TYPES;
+    } else if (m->is_complex) {
+	return E_CMPLX;
+    } else if (m->rows * m->cols != k) {
+	gretl_errmsg_sprintf(_("parmap: task %d gave %d values but "
+			       "task 1 gave %d"), i + 1,
+			     m->rows * m->cols, k);
+	return E_NONCONF;
+    }
+
+    memcpy(x + i * (size_t) k, m->val, k * sizeof(double));
+
+    return 0;
+}
+
+/* what a parmap worker needs to know */
+
+typedef struct parmap_job_ {
+    umax *u;
+    parmap_shared *ps;
+    int n;
+    int k;
+} parmap_job;
+
+/* the work loop: claim tasks until there are none left or some
+   worker has hit an error */
+
+static int parmap_work (void *data)
+{
+    parmap_job *job = data;
+    umax *u = job->u;
+    parmap_shared *ps = job->ps;
+    int n = job->n, k = job->k;
+    int i, err = 0;
+
+    while (!err && g_atomic_int_get(&ps->err) == 0) {
+	i = g_atomic_int_add(&ps->next, 1);
+	if (i >= n) {
+	    break;
+	}
+	err = gretl_scalar_set_value(u->pxname, i + 1);
+	if (!err) {
+	    err = execute_genr(u->gf, u->dset, NULL);
+	}
+	if (!err) {
+	    err = parmap_get_result(u, ps->x, i, k);
+	}
+    }
+
+    if (err) {
+	g_atomic_int_compare_and_exchange(&ps->err, 0, err);
+    }
+
+    return err;
+}
+
+#ifdef PARMAP_FORK
+
+/* Run @work(@data) in the calling process and in @nproc - 1
+   forked children, and wait for the children to finish. The
+   work function must take care of sharing out the tasks, via
+   state held in a shared mapping. @caller is used in messages.
+*/
+
+static int fork_workers (int (*work) (void *), void *data,
+			 int nproc, const char *caller)
+{
+    pid_t *pids;
+    int nw = 0;
+    int i, err = 0;
+
+    pids = malloc((nproc - 1) * sizeof *pids);
+    if (pids == NULL) {
+	return E_ALLOC;
+    }
+
+    /* don't let buffered output be replicated in the children */
+    fflush(NULL);
+
+    for (i=0; i<nproc-1; i++) {
+	pid_t pid = fork();
+
+	if (pid == 0) {
+	    /* child: the workers between them occupy the cores,
+	       so each one should run single-threaded */
+#ifdef _OPENMP
+	    omp_set_num_threads(1);
+#endif
+	    blas_set_num_threads(1);
+	    work(data);
+	    _exit(0);
+	} else if (pid < 0) {
+	    /* carry on with the workers we have */
+	    fprintf(stderr, "%s: fork failed after %d workers\n",
+		    caller, nw);
+	    break;
+	}
+	pids[nw++] = pid;
+    }
+
+    /* the parent takes a share of the tasks too */
+    work(data);
+
+    for (i=0; i<nw; i++) {
+	int status = 0;
+
+	if (waitpid(pids[i], &status, 0) != pids[i] ||
+	    !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+	    if (!err) {
+		gretl_errmsg_sprintf(_("%s: a worker process "
+				       "terminated abnormally"), caller);
+		err = E_EXTERNAL;
+	    }
+	}
+    }
+
+    free(pids);
+
+    return err;
+}
+
+#endif /* PARMAP_FORK */
+
+/**
+ * user_parmap:
+ * @fncall: call to a user function whose first argument is
+ * the name of a scalar, which is set to the task index.
+ * @n: number of tasks.
+ * @nproc: maximum number of processes to use, or 0 to use
+ * one per available processor.
+ * @dset: dataset struct.
+ * @err: location to receive error code.
+ *
+ * Evaluates @fncall for task indices 1 to @n, distributing the
+ * tasks over as many as @nproc worker processes on the local
+ * machine. Each evaluation must yield a scalar or a matrix with
+ * a fixed number of elements, k. Any side effects of the function
+ * call, other than its return value, are not propagated back from
+ * the worker processes.
+ *
+ * Returns: an @n x k matrix, row i of which holds the (vectorized)
+ * result for task i, or NULL on failure.
+ */
+
+gretl_matrix *user_parmap (const char *fncall, int n, int nproc,
+			   DATASET *dset, int *err)
+{
+    parmap_shared *ps = NULL;
+    gretl_matrix *ret = NULL;
+    int shared = 0;
+    size_t psize;
+    umax *u;
+    int i, j, k = 0;
+
+    if (n < 1 || nproc < 0) {
+	*err = E_INVARG;
+	return NULL;
+    }
+
+    *err = parmap_index_init(fncall);
+    if (*err) {
+	return NULL;
+    }
+
+    u = umax_new(GRETL_TYPE_MATRIX);
+    if (u == NULL) {
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    /* this evaluates the call for the first task */
+    *err = user_gen_setup(u, fncall, NULL, NULL, dset);
+    if (*err) {
+	goto bailout;
+    }
+
+    if (u->pxname == NULL || u->fm_out == NULL) {
+	*err = E_TYPES;
+	goto bailout;
+    }
+
+    k = u->fm_out->rows * u->fm_out->cols;
+    if (k == 0) {
+	*err = E_DATA;
+	goto bailout;
+    }
+
+    if (nproc == 0) {
+	nproc = gretl_n_processors();
+    }
+    if (nproc > n) {
+	nproc = n;
+    }
+
+    psize = parmap_shared_size(n, k);
+
+#ifdef PARMAP_FORK
+    if (nproc > 1) {
+	ps = mmap(NULL, psize, PROT_READ | PROT_WRITE,
+		  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (ps == MAP_FAILED) {
+	    /* fall back to running the tasks in sequence */
+	    ps = NULL;
+	} else {
+	    shared = 1;
+	}
+    }
+#endif
+
+    if (ps == NULL) {
+	ps = malloc(psize);
+	if (ps == NULL) {
+	    *err = E_ALLOC;
+	    goto bailout;
+	}
+    }
+
+    ps->next = 1;
+    ps->err = 0;
+    *err = parmap_get_result(u, ps->x, 0, k);
+
+    if (!*err) {
+	parmap_job job = {u, ps, n, k};
+
+#ifdef PARMAP_FORK
+	if (shared) {
+	    *err = fork_workers(parmap_work, &job, nproc, "parmap");
+	} else {
+	    parmap_work(&job);
+	}
+#else
+	parmap_work(&job);
+#endif
+	if (!*err) {
+	    *err = ps->err;
+	}
+    }
+
+    if (!*err) {
+	ret = gretl_matrix_alloc(n, k);
+	if (ret == NULL) {
+	    *err = E_ALLOC;
+	} else {
+	    for (i=0; i<n; i++) {
+		for (j=0; j<k; j++) {
+		    gretl_matrix_set(ret, i, j, ps->x[i * (size_t) k + j]);
+		}
+	    }
+	}
+    }
+
+#ifdef PARMAP_FORK
+    if (shared) {
+	munmap(ps, psize);
+	ps = NULL;
+    }
+#endif
+    free(ps);
+
+ bailout:
+
+    umax_destroy(u);
+
+    return ret;
+}
+
+/* Below: multi-start optimization. The local optimizer (BFGS by
+   default) is run from each of a set of starting points spread
+   over a box via a Halton sequence, the starts being shared out
+   among worker processes in the same way as for parmap(). The
+   optima found are then clustered, so that repeated convergence
+   to the same point counts as a single optimum, and returned in
+   order of merit. Optionally the search stops early once the best
+   criterion value has been reached from a given number of starts.
+*/
+
+#define MSTART_DEFAULT 20
+#define MSTART_OFFSET 10
+#define MSTART_CTOL 1.0e-7
+
+/* Shared control block: @next is the index of the next unclaimed
+   start; @lock guards @best and @hits, the best criterion value
+   found so far and the number of starts that have reached it; and
+   @stop is set when the early-exit condition is met. Each start
+   gets a row of @x holding its status (NA if not run, 0 if OK,
+   else an error code), the criterion value and the parameters.
+*/
+
+typedef struct mstart_shared_ mstart_shared;
+
+struct mstart_shared_ {
+    gint next;
+    gint lock;
+    gint hits;
+    gint stop;
+    double best;
+    double x[1];
+};
+
+static size_t mstart_shared_size (int n, int k)
+{
+    return sizeof(mstart_shared) +
+	(n * (size_t) (k + 2) - 1) * sizeof(double);
+}
+
+typedef struct mstart_job_ {
+    umax *u;               /* criterion apparatus */
+    mstart_shared *ms;     /* shared control block */
+    const gretl_matrix *S; /* starting points, by column */
+    unsigned int *seeds;   /* per-start RNG seeds, for simann */
+    MaxMethod method;      /* local optimizer */
+    int maxit;             /* iteration limit, or 0 for default */
+    int stop;              /* early exit after this many hits, or 0 */
+    gretlopt opt;          /* OPT_I for minimization */
+} mstart_job;
+
+/* run the local optimizer for start @i, starting from and writing
+   to @b */
+
+static int mstart_local (mstart_job *job, int i, double *b, double *crit)
+{
+    umax *u = job->u;
+    int n = u->ncoeff;
+    int err = 0;
+
+    if (job->method == NM_MAX) {
+	err = gretl_amoeba(b, n, job->maxit, user_get_criterion,
+			   u, job->opt, NULL);
+    } else if (job->method == SIMANN_MAX) {
+	/* each start gets its own random stream, whichever
+	   process runs it */
+	gretl_rand_set_seed(job->seeds[i]);
+	err = gretl_simann(b, n, job->maxit, user_get_criterion,
+			   u, job->opt, NULL);
+    } else {
+	int maxit = job->maxit > 0 ? job->maxit : BFGS_MAXITER_DEFAULT;
+	double tol = libset_get_double(BFGS_TOLER);
+	int fcount = 0, gcount = 0;
+
+	err = BFGS_max(b, n, maxit, tol, &fcount, &gcount,
+		       user_get_criterion, C_OTHER,
+		       (u->gg == NULL)? NULL : user_get_gradient,
+		       u, NULL, job->opt, NULL);
+    }
+
+    if (!err) {
+	*crit = user_get_criterion(b, u);
+	if (na(*crit)) {
+	    err = E_NAN;
+	}
+    }
+
+    return err;
+}
+
+/* record a successful start for the purpose of early exit */
+
+static void mstart_tally (mstart_job *job, double crit)
+{
+    mstart_shared *ms = job->ms;
+    double d, ctol;
+
+    while (!g_atomic_int_compare_and_exchange(&ms->lock, 0, 1)) {
+	; /* spin: the critical section is tiny */
+    }
+
+    if (na(ms->best)) {
+	ms->best = crit;
+	ms->hits = 1;
+    } else {
+	d = (job->opt & OPT_I)? ms->best - crit : crit - ms->best;
+	ctol = MSTART_CTOL * (1.0 + fabs(ms->best));
+	if (d > ctol) {
+	    /* a new best */
+	    ms->best = crit;
+	    ms->hits = 1;
+	} else if (d >= -ctol) {
+	    ms->hits += 1;
+	}
+    }
+
+    if (ms->hits >= job->stop) {
+	g_atomic_int_set(&ms->stop, 1);
+    }
+
+    g_atomic_int_set(&ms->lock, 0);
+}
+
+/* the work loop: claim starts until there are none left or the
+   early-exit condition is met */
+
+static int mstart_work (void *data)
+{
+    mstart_job *job = data;
+    mstart_shared *ms = job->ms;
+    int k = job->u->ncoeff;
+    int n = job->S->cols;
+    double crit, *x;
+    int i, err;
+
+    while (g_atomic_int_get(&ms->stop) == 0) {
+	i = g_atomic_int_add(&ms->next, 1);
+	if (i >= n) {
+	    break;
+	}
+	x = ms->x + i * (size_t) (k + 2);
+	memcpy(x + 2, job->S->val + i * k, k * sizeof *x);
+	err = mstart_local(job, i, x + 2, &crit);
+	if (err) {
+	    /* a failed start is not fatal */
+	    gretl_error_clear();
+	    x[1] = NADBL;
+	} else {
+	    x[1] = crit;
+	    if (job->stop > 0) {
+		mstart_tally(job, crit);
+	    }
+	}
+	x[0] = err;
+    }
+
+    return 0;
+}
+
+/* Construct the k x @n matrix of starting points: the first is
+   @b0, the others are spread over the box given by @bounds, via
+   Halton sequences if possible.
+*/
+
+static gretl_matrix *mstart_points (const gretl_matrix *b0,
+				    const gretl_matrix *bounds,
+				    int n, int *err)
+{
+    gretl_matrix *S, *H = NULL;
+    double lo, hi;
+    int k = b0->rows * b0->cols;
+    int i, j;
+
+    S = gretl_matrix_alloc(k, n);
+    if (S == NULL) {
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    if (n > 1) {
+	if (k <= 40) {
+	    H = halton_matrix(k, n - 1, MSTART_OFFSET, err);
+	} else {
+	    /* too many dimensions for our Halton bases */
+	    H = gretl_matrix_alloc(k, n - 1);
+	    if (H == NULL) {
+		*err = E_ALLOC;
+	    } else {
+		gretl_rand_uniform(H->val, 0, k * (n - 1) - 1);
+	    }
+	}
+	if (*err) {
+	    gretl_matrix_free(S);
+	    return NULL;
+	}
+    }
+
+    for (j=0; j<n; j++) {
+	for (i=0; i<k; i++) {
+	    if (j == 0) {
+		gretl_matrix_set(S, i, j, b0->val[i]);
+	    } else {
+		lo = gretl_matrix_get(bounds, i, 0);
+		hi = gretl_matrix_get(bounds, i, 1);
+		gretl_matrix_set(S, i, j, lo + (hi - lo) *
+				 gretl_matrix_get(H, i, j-1));
+	    }
+	}
+    }
+
+    gretl_matrix_free(H);
+
+    return S;
+}
+
+/* Cluster the successful starts in @x and return the distinct
+   optima, best first. Two optima are taken to be the same if
+   none of their parameters differs, relative to 1 + its absolute
+   value, by more than @tol.
+*/
+
+static gretl_matrix *mstart_cluster (const double *x, int n, int k,
+				     double tol, int minimize,
+				     int *nok, int *err)
+{
+    gretl_matrix *ret = NULL;
+    const double *xi, *xj;
+    double *crit = NULL;
+    int *idx = NULL;
+    int *rep = NULL;
+    int *cnt = NULL;
+    int i, j, r, m = 0, nc = 0;
+    int w = k + 2;
+
+    idx = malloc(n * sizeof *idx);
+    rep = malloc(n * sizeof *rep);
+    cnt = malloc(n * sizeof *cnt);
+    crit = malloc(n * sizeof *crit);
+    if (idx == NULL || rep == NULL || cnt == NULL || crit == NULL) {
+	*err = E_ALLOC;
+	goto bailout;
+    }
+
+    /* insertion sort of the successful starts, best first, with
+       ties resolved by index for the sake of reproducibility */
+    for (i=0; i<n; i++) {
+	xi = x + i * (size_t) w;
+	if (xi[0] != 0) {
+	    continue;
+	}
+	for (j=m; j>0; j--) {
+	    r = minimize ? xi[1] < crit[j-1] : xi[1] > crit[j-1];
+	    if (!r) {
+		break;
+	    }
+	    idx[j] = idx[j-1];
+	    crit[j] = crit[j-1];
+	}
+	idx[j] = i;
+	crit[j] = xi[1];
+	m++;
+    }
+
+    *nok = m;
+    if (m == 0) {
+	gretl_errmsg_set(_("None of the local optimizations succeeded"));
+	*err = E_NOCONV;
+	goto bailout;
+    }
+
+    for (i=0; i<m; i++) {
+	xi = x + idx[i] * (size_t) w + 2;
+	for (j=0; j<nc; j++) {
+	    xj = x + rep[j] * (size_t) w + 2;
+	    for (r=0; r<k; r++) {
+		if (fabs(xi[r] - xj[r]) > tol * (1.0 + fabs(xj[r]))) {
+		    break;
+		}
+	    }
+	    if (r == k) {
+		/* matches the optimum represented by @xj */
+		cnt[j] += 1;
+		break;
+	    }
+	}
+	if (j == nc) {
+	    /* a new distinct optimum */
+	    rep[nc] = idx[i];
+	    cnt[nc++] = 1;
+	}
+    }
+
+    ret = gretl_matrix_alloc(nc, w);
+    if (ret == NULL) {
+	*err = E_ALLOC;
+    } else {
+	for (j=0; j<nc; j++) {
+	    xj = x + rep[j] * (size_t) w;
+	    gretl_matrix_set(ret, j, 0, xj[1]);
+	    gretl_matrix_set(ret, j, 1, cnt[j]);
+	    for (r=0; r<k; r++) {
+		gretl_matrix_set(ret, j, r+2, xj[r+2]);
+	    }
+	}
+    }
+
+ bailout:
+
+    free(idx);
+    free(rep);
+    free(cnt);
+    free(crit);
+
+    return ret;
+}
+
+static int mstart_get_options (gretl_bundle *opts,
+			       mstart_job *job, int *nproc,
+			       double *tol)
+{
+    int err = 0;
+
+    if (opts == NULL) {
+	return 0;
+    }
+
+    if (gretl_bundle_has_key(opts, "method")) {
+	const char *s = gretl_bundle_get_string(opts, "method", &err);
+
+	if (err) {
+	    ; /* wrong type */
+	} else if (!g_ascii_strcasecmp(s, "BFGS")) {
+	    job->method = BFGS_MAX;
+	} else if (!g_ascii_strcasecmp(s, "NM")) {
+	    job->method = NM_MAX;
+	} else if (!g_ascii_strcasecmp(s, "simann")) {
+	    job->method = SIMANN_MAX;
+	} else {
+	    gretl_errmsg_sprintf(_("%s: unknown method '%s'"),
+				 "MSmax", s);
+	    err = E_INVARG;
+	}
+    }
+
+    if (!err) {
+	job->maxit = gretl_bundle_get_int_deflt(opts, "maxiter", 0);
+	job->stop = gretl_bundle_get_int_deflt(opts, "stop", 0);
+	*nproc = gretl_bundle_get_int_deflt(opts, "nproc", 0);
+	if (gretl_bundle_has_key(opts, "tol")) {
+	    *tol = gretl_bundle_get_scalar(opts, "tol", &err);
+	}
+    }
+
+    if (!err && (job->maxit < 0 || job->stop < 0 || *nproc < 0 ||
+		 na(*tol) || *tol < 0)) {
+	err = E_INVARG;
+    }
+
+    return err;
+}
+
+/**
+ * user_multistart:
+ * @b: vector of parameters: on input, the first starting point;
+ * on output, the best optimum found.
+ * @bounds: k x 2 matrix holding lower and upper limits for
+ * the starting points, where k is the length of @b.
+ * @fncall: call to function to compute the criterion.
+ * @gradcall: call to function to compute the gradient, or NULL.
+ * @nstarts: number of starting points, or 0 for the default.
+ * @opts: bundle of options, or NULL.
+ * @dset: dataset struct.
+ * @minimize: if non-zero, minimize rather than maximize.
+ * @prn: printing struct.
+ * @err: location to receive error code.
+ *
+ * Runs a local optimization of @fncall from each of @nstarts
+ * points, namely @b itself plus points spread over the box given
+ * by @bounds. The starts are shared out among as many worker
+ * processes as there are processors, or as specified by the
+ * "nproc" member of @opts. Other recognized members of @opts are
+ * "method" (the local optimizer: "BFGS", "NM" or "simann"),
+ * "maxiter" (iteration limit for the local optimizer), "tol"
+ * (tolerance for identifying optima as the same), and "stop"
+ * (if positive, stop once the best criterion value has been
+ * reached from this many starts).
+ *
+ * Returns: a matrix with one row per distinct optimum, best
+ * first, holding the criterion value, the number of starts which
+ * led to the optimum, and the parameter values; or NULL on
+ * failure.
+ */
+
+gretl_matrix *user_multistart (gretl_matrix *b,
+			       const gretl_matrix *bounds,
+			       const char *fncall,
+			       const char *gradcall,
+			       int nstarts,
+			       gretl_bundle *opts,
+			       DATASET *dset,
+			       int minimize,
+			       PRN *prn, int *err)
+{
+    mstart_job job = {0};
+    mstart_shared *ms = NULL;
+    gretl_rand_state *rstate = NULL;
+    gretl_matrix *S = NULL;
+    gretl_matrix *ret = NULL;
+    double tol = 1.0e-4;
+    int nproc = 0, shared = 0;
+    int i, k, nrun, nok = 0;
+    size_t msize;
+    umax *u;
+
+    k = gretl_vector_get_length(b);
+    if (k == 0 || nstarts < 0) {
+	*err = E_INVARG;
+	return NULL;
+    } else if (bounds == NULL || bounds->rows != k || bounds->cols != 2) {
+	*err = E_NONCONF;
+	return NULL;
+    }
+
+    for (i=0; i<k; i++) {
+	if (!(gretl_matrix_get(bounds, i, 0) < gretl_matrix_get(bounds, i, 1))) {
+	    gretl_errmsg_sprintf(_("%s: invalid bounds for parameter %d"),
+				 "MSmax", i + 1);
+	    *err = E_INVARG;
+	    return NULL;
+	}
+    }
+
+    job.method = BFGS_MAX;
+    job.opt = minimize ? OPT_I : OPT_NONE;
+    *err = mstart_get_options(opts, &job, &nproc, &tol);
+    if (!*err && gradcall != NULL && job.method != BFGS_MAX) {
+	gretl_errmsg_set(_("A gradient function can only be used "
+			   "with BFGS"));
+	*err = E_INVARG;
+    }
+    if (*err) {
+	return NULL;
+    }
+
+    if (nstarts == 0) {
+	nstarts = MSTART_DEFAULT;
+    }
+
+    /* the starting points are drawn up front, so the results do
+       not depend on the number of workers */
+    S = mstart_points(b, bounds, nstarts, err);
+    if (*err) {
+	return NULL;
+    }
+
+    if (job.method == SIMANN_MAX) {
+	/* likewise the simann seeds: otherwise forked workers would
+	   all inherit the same random state */
+	job.seeds = malloc(nstarts * sizeof *job.seeds);
+	if (job.seeds == NULL) {
+	    gretl_matrix_free(S);
+	    *err = E_ALLOC;
+	    return NULL;
+	}
+	for (i=0; i<nstarts; i++) {
+	    /* avoid zero, which means "seed from the clock" */
+	    job.seeds[i] = gretl_rand_int();
+	    if (job.seeds[i] == 0) {
+		job.seeds[i] = 1;
+	    }
+	}
+	/* the starts re-seed the RNG, and this process takes part
+	   in them: arrange to put back the caller's stream */
+	rstate = gretl_rand_state_save(err);
+	if (*err) {
+	    gretl_matrix_free(S);
+	    free(job.seeds);
+	    return NULL;
+	}
+    }
+
+    u = umax_new(GRETL_TYPE_DOUBLE);
+    if (u == NULL) {
+	gretl_matrix_free(S);
+	free(job.seeds);
+	gretl_rand_state_restore(rstate);
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    u->ncoeff = k;
+    u->b = b;
+
+    *err = user_gen_setup(u, fncall, gradcall, NULL, dset);
+    if (*err) {
+	goto bailout;
+    }
+
+    if (nproc == 0) {
+	nproc = gretl_n_processors();
+    }
+    if (nproc > nstarts) {
+	nproc = nstarts;
+    }
+
+    msize = mstart_shared_size(nstarts, k);
+
+#ifdef PARMAP_FORK
+    if (nproc > 1) {
+	ms = mmap(NULL, msize, PROT_READ | PROT_WRITE,
+		  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (ms == MAP_FAILED) {
+	    /* fall back to running the starts in sequence */
+	    ms = NULL;
+	} else {
+	    shared = 1;
+	}
+    }
+#endif
+
+    if (ms == NULL) {
+	ms = malloc(msize);
+	if (ms == NULL) {
+	    *err = E_ALLOC;
+	    goto bailout;
+	}
+    }
+
+    ms->next = ms->lock = ms->hits = ms->stop = 0;
+    ms->best = NADBL;
+    for (i=0; i<nstarts; i++) {
+	ms->x[i * (size_t) (k + 2)] = NADBL;
+    }
+
+    job.u = u;
+    job.ms = ms;
+    job.S = S;
+
+#ifdef PARMAP_FORK
+    if (shared) {
+	*err = fork_workers(mstart_work, &job, nproc, "MSmax");
+    } else {
+	mstart_work(&job);
+    }
+#else
+    mstart_work(&job);
+#endif
+
+    gretl_rand_state_restore(rstate);
+    rstate = NULL;
+
+    if (!*err) {
+	ret = mstart_cluster(ms->x, nstarts, k, tol, minimize,
+			     &nok, err);
+    }
+
+    if (!*err) {
+	/* leave @b at the best optimum found */
+	for (i=0; i<k; i++) {
+	    b->val[i] = gretl_matrix_get(ret, 0, i+2);
+	}
+	if (libset_get_bool(MAX_VERBOSE)) {
+	    nrun = 0;
+	    for (i=0; i<nstarts; i++) {
+		nrun += !na(ms->x[i * (size_t) (k + 2)]);
+	    }
+	    pprintf(prn, _("Multi-start: %d of %d starts run, %d succeeded, "
+			   "%d distinct optima\n"), nrun, nstarts, nok,
+		    ret->rows);
+	}
+    }
+
+#ifdef PARMAP_FORK
+    if (shared) {
+	munmap(ms, msize);
+	ms = NULL;
+    }
+#endif
+    free(ms);
+
+ bailout:
+
+    if (*err) {
+	/* put back the initial values */
+	memcpy(b->val, S->val, k * sizeof(double));
+    }
+
+    umax_destroy(u);
+    gretl_matrix_free(S);
+    free(job.seeds);
+    gretl_rand_state_restore(rstate);
+
+    return ret;
+}
+
 /* Below: Newton-Raphson code, starting with a few
    auxiliary functions */
 
@@ -37,6 +37,18 @@ typedef double (*BFGS_COMBO_FUNC) (double *, double *, int, void *);
 typedef const double *(*BFGS_LLT_FUNC) (const double *, int, void *);
 typedef int (*HESS_FUNC) (double *, gretl_matrix *, void *);
 typedef double (*ZFUNC) (double, void *);
+typedef void *(*BFGS_DATA_CLONE) (void *, int *);
+typedef void (*BFGS_DATA_FREE) (void *);
+
+typedef struct BFGS_reentrant_ BFGS_reentrant;
+
+/* see BFGS_reentrant_crit() */
+struct BFGS_reentrant_ {
+    BFGS_CRIT_FUNC cfunc;   /* re-entrant criterion function */
+    void *data;             /* its data argument */
+    BFGS_DATA_CLONE dclone; /* makes a private copy of @data */
+    BFGS_DATA_FREE dfree;   /* frees a copy made by @dclone */
+};
 
 int BFGS_max (double *b, int n, int maxit, double reltol,
 	      int *fncount, int *grcount, BFGS_CRIT_FUNC cfunc, 
@@ -57,6 +69,8 @@ int newton_raphson_max (double *b, int n, int maxit,
 			HESS_FUNC hessfunc,
 			void *data, gretlopt opt, PRN *prn);
 
+double BFGS_reentrant_crit (const double *b, void *data);
+
 int BFGS_numeric_gradient (double *b, double *g, int n,
 			   BFGS_CRIT_FUNC func, void *data);
 
@@ -115,6 +129,19 @@ gretl_matrix *user_fdjac (gretl_matrix *theta, const char *fncall,
 gretl_matrix *user_numhess (gretl_matrix *b, const char *fncall,
 			    double d, DATASET *dset, int *err);
 
+gretl_matrix *user_parmap (const char *fncall, int n, int nproc,
+			   DATASET *dset, int *err);
+
+gretl_matrix *user_multistart (gretl_matrix *b,
+			       const gretl_matrix *bounds,
+			       const char *fncall,
+			       const char *gradcall,
+			       int nstarts,
+			       gretl_bundle *opts,
+			       DATASET *dset,
+			       int minimize,
+			       PRN *prn, int *err);
+
 int gretl_simann (double *theta, int n, int maxit,
 		  BFGS_CRIT_FUNC cfunc, void *data,
 		  gretlopt opt, PRN *prn);
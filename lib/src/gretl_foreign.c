@@ -1042,13 +1042,7 @@ static void write_octave_io_file (FILE *fp, const char *ddir)
     fputs("      fwrite(fd, 'gretl_binar_cmatrix', \"uchar\");\n", fp);
     fputs("      fwrite(fd, 2*rows(X), \"int32\", 0, \"l\");\n", fp);
     fputs("      fwrite(fd, columns(X), \"int32\", 0, \"l\");\n", fp);
-    fputs("      A = real(X);\n", fp);
-    fputs("      B = imag(X);\n", fp);
-    fputs("      N = rows(X) * columns(X);\n", fp);
-    fputs("      for i = 1:N\n", fp);
-    fputs("        fwrite(fd, A(i), \"double\", 0, \"l\");\n", fp);
-    fputs("        fwrite(fd, B(i), \"double\", 0, \"l\");\n", fp);
-    fputs("      endfor\n", fp);
+    fputs("      fwrite(fd, [real(X(:))'; imag(X(:))'], \"double\", 0, \"l\");\n", fp);
     fputs("    else\n", fp);
     fputs("      fwrite(fd, 'gretl_binary_matrix', \"uchar\");\n", fp);
     fputs("      fwrite(fd, rows(X), \"int32\", 0, \"l\");\n", fp);
@@ -1108,7 +1102,7 @@ static void write_python_io_file (FILE *fp, const char *ddir)
     fputs("  binwrite = 0\n", fp);
     fputs("  if fname[-4:] == '.bin':\n", fp);
     fputs("    binwrite = 1\n", fp);
-    fputs("    from numpy import asmatrix, asarray, iscomplexobj, real, imag\n", fp);
+    fputs("    from numpy import asmatrix, asarray, empty, iscomplexobj, real, imag\n", fp);
     fputs("    from struct import pack\n", fp);
     fputs("  else:\n", fp);
     fputs("    from numpy import asmatrix, savetxt\n", fp);
@@ -1117,7 +1111,6 @@ static void write_python_io_file (FILE *fp, const char *ddir)
     fputs("  if autodot and not os.path.isabs(fname):\n", fp);
     fputs("    fname = gretl_dotdir + fname\n", fp);
     fputs("  if binwrite:\n", fp);
-    fputs("    from sys import byteorder\n", fp);
     fputs("    cmplx = iscomplexobj(X)\n", fp);
     fputs("    f = open(fname, 'wb')\n", fp);
     fputs("    if cmplx:\n", fp);
@@ -1128,17 +1121,13 @@ static void write_python_io_file (FILE *fp, const char *ddir)
     fputs("      f.write(pack('<i', r))\n", fp);
     fputs("    f.write(pack('<i', c))\n", fp);
     fputs("    if cmplx:\n", fp);
-    fputs("      for j in range(0, c):\n", fp);
-    fputs("        for i in range(0, r):\n", fp);
-    fputs("          f.write(pack('<d', real(M[i,j])))\n", fp);
-    fputs("          f.write(pack('<d', imag(M[i,j])))\n", fp);
-    fputs("    elif byteorder == 'big':\n", fp);
-    fputs("      for j in range(0, c):\n", fp);
-    fputs("        for i in range(0, r):\n", fp);
-    fputs("          f.write(pack('<d', M[i,j]))\n", fp);
+    fputs("      A = empty((2*r, c))\n", fp);
+    fputs("      A[0::2,:] = real(M)\n", fp);
+    fputs("      A[1::2,:] = imag(M)\n", fp);
     fputs("    else:\n", fp);
-    fputs("      A = asarray(X, dtype=float)\n", fp);
-    fputs("      f.write(A.tobytes('F'))\n", fp);
+    fputs("      A = asarray(M, dtype=float)\n", fp);
+    fputs("    # write as little-endian, column-major\n", fp);
+    fputs("    f.write(A.astype('<f8').tobytes('F'))\n", fp);
     fputs("    f.close()\n", fp);
     fputs("  else:\n", fp);
     fputs("    ghead = repr(r) + ' ' + repr(c)\n", fp);
@@ -1149,7 +1138,7 @@ static void write_python_io_file (FILE *fp, const char *ddir)
     fputs("  if autodot and not os.path.isabs(fname):\n", fp);
     fputs("    fname = gretl_dotdir + fname\n", fp);
     fputs("  if fname[-4:] == '.bin':\n", fp);
-    fputs("    from numpy import ndarray, asmatrix\n", fp);
+    fputs("    from numpy import fromfile, asmatrix\n", fp);
     fputs("    from struct import unpack\n", fp);
     fputs("    f = open(fname, 'rb')\n", fp);
     fputs("    buf = f.read(19)\n", fp);
@@ -1161,14 +1150,14 @@ static void write_python_io_file (FILE *fp, const char *ddir)
     fputs("      raise ValueError('Not a gretl binary matrix')\n", fp);
     fputs("    r = unpack('<i', f.read(4))[0]\n", fp);
     fputs("    c = unpack('<i', f.read(4))[0]\n", fp);
-    fputs("    M = ndarray(shape=(r,c), dtype=float, order='F')\n", fp);
-    fputs("    for j in range(0, c):\n", fp);
-    fputs("      for i in range(0, r):\n", fp);
-    fputs("        M[i,j] = unpack('<d', f.read(8))[0]\n", fp);
+    fputs("    A = fromfile(f, dtype='<f8', count=r*c)\n", fp);
     fputs("    f.close()\n", fp);
+    fputs("    if A.size < r*c:\n", fp);
+    fputs("      raise ValueError('Truncated gretl binary matrix')\n", fp);
+    fputs("    A = A.reshape((r, c), order='F')\n", fp);
     fputs("    if cmplx == 1:\n", fp);
-    fputs("      M.dtype = complex\n", fp);
-    fputs("    M = asmatrix(M)\n", fp);
+    fputs("      A = A[0::2,:] + 1j * A[1::2,:]\n", fp);
+    fputs("    M = asmatrix(A)\n", fp);
     fputs("  else:\n", fp);
     fputs("    from numpy import loadtxt\n", fp);
     fputs("    M = loadtxt(fname, skiprows=1)\n", fp);
@@ -1204,16 +1193,14 @@ static void write_julia_io_file (FILE *fp, const char *ddir)
     fputs("    end\n", fp);
     fputs("    write(f, htol(Int32(rr)))\n", fp);
     fputs("    write(f, htol(Int32(c)))\n", fp);
-    fputs("    for j=1:c\n", fp);
-    fputs("      for i=1:r\n", fp);
-    fputs("        if cmplx\n", fp);
-    fputs("          write(f, htol(Float64(real(M[i,j]))))\n", fp);
-    fputs("          write(f, htol(Float64(imag(M[i,j]))))\n", fp);
-    fputs("        else\n", fp);
-    fputs("          write(f, htol(Float64(M[i,j])))\n", fp);
-    fputs("        end\n", fp);
-    fputs("      end\n", fp);
+    fputs("    if cmplx\n", fp);
+    fputs("      A = Array{Float64, 2}(undef, rr, c)\n", fp);
+    fputs("      A[1:2:end,:] = real(M)\n", fp);
+    fputs("      A[2:2:end,:] = imag(M)\n", fp);
+    fputs("    else\n", fp);
+    fputs("      A = Array{Float64, 2}(M)\n", fp);
     fputs("    end\n", fp);
+    fputs("    write(f, htol.(A))\n", fp);
     fputs("  else\n", fp);
     fputs("    # text mode\n", fp);
     fputs("    @printf(f, \"%d\\t%d\\n\", r, c)\n", fp);
@@ -1249,23 +1236,11 @@ static void write_julia_io_file (FILE *fp, const char *ddir)
     fputs("    end\n", fp);
     fputs("    r = ltoh(read(f, Int32))\n", fp);
     fputs("    c = ltoh(read(f, Int32))\n", fp);
+    fputs("    M = Array{Float64, 2}(undef, r, c)\n", fp);
+    fputs("    read!(f, M)\n", fp);
+    fputs("    M .= ltoh.(M)\n", fp);
     fputs("    if cmplx\n", fp);
-    fputs("      r::Int64 = floor(r/2)\n", fp);
-    fputs("      M = Array{Complex{Float64}, 2}(undef, r, c)\n", fp);
-    fputs("      for j=1:c\n", fp);
-    fputs("        for i=1:r\n", fp);
-    fputs("          x = ltoh(read(f, Float64))\n", fp);
-    fputs("          y = ltoh(read(f, Float64))\n", fp);
-    fputs("          M[i,j] = x + y*im\n", fp);
-    fputs("        end\n", fp);
-    fputs("      end\n", fp);
-    fputs("    else\n", fp);
-    fputs("      M = Array{Float64, 2}(undef, r, c)\n", fp);
-    fputs("      for j=1:c\n", fp);
-    fputs("        for i=1:r\n", fp);
-    fputs("          M[i,j] = ltoh(read(f, Float64))\n", fp);
-    fputs("        end\n", fp);
-    fputs("      end\n", fp);
+    fputs("      M = complex.(M[1:2:end,:], M[2:2:end,:])\n", fp);
     fputs("    end\n", fp);
     fputs("    close(f)\n", fp);
     fputs("  else\n", fp);
@@ -1812,6 +1787,56 @@ static gretl_matrix *make_coded_vec (int *list,
     return coded;
 }
 
+/* If the series in @list are all numeric and there are no
+   observation markers to preserve, we can send the data to R as a
+   gretl binary matrix rather than as text.
+*/
+
+static int R_binary_data_ok (const int *list, const DATASET *dset)
+{
+    int i;
+
+    if (dset->S != NULL) {
+	return 0;
+    }
+
+    for (i=1; i<=list[0]; i++) {
+	if (is_string_valued(dset, list[i])) {
+	    return 0;
+	}
+    }
+
+    return 1;
+}
+
+static int write_binary_data_for_R (const int *list,
+				    const DATASET *dset,
+				    FILE *fp)
+{
+    gretl_matrix *X;
+    int i, err = 0;
+
+    X = gretl_matrix_data_subset(list, dset, dset->t1, dset->t2,
+				 M_MISSING_OK, &err);
+    if (!err) {
+	err = gretl_matrix_write_to_file(X, "Rdata.bin", 1);
+	gretl_matrix_free(X);
+    }
+
+    if (!err) {
+	fputs("gretldata <- gretl.loadmat(\"Rdata.bin\")\n", fp);
+	fputs("gretldata[is.nan(gretldata)] <- NA\n", fp);
+	fputs("gretldata <- as.data.frame(gretldata)\n", fp);
+	fputs("colnames(gretldata) <- c(", fp);
+	for (i=1; i<=list[0]; i++) {
+	    fprintf(fp, "\"%s\"%s", dset->varname[list[i]],
+		    i < list[0] ? ", " : ")\n");
+	}
+    }
+
+    return err;
+}
+
 /* write out current dataset in R format, and, if this succeeds,
    write appropriate R commands to @fp to source the data
 */
@@ -1822,6 +1847,7 @@ static int write_data_for_R (const DATASET *dset,
 {
     gretl_matrix *coded = NULL;
     int *list = NULL;
+    int binary = 0;
     int ts, err;
 
     err = no_data_check(dset);
@@ -1835,9 +1861,13 @@ static int write_data_for_R (const DATASET *dset,
     list = get_send_data_list(FOREIGN, dset, &err);
 
     if (!err) {
+	coded = make_coded_vec(list, dset);
+	binary = R_binary_data_ok(list, dset);
+    }
+
+    if (!err && !binary) {
 	gchar *Rdata = gretl_make_dotpath("Rdata.tmp");
 
-	coded = make_coded_vec(list, dset);
 	err = write_data(Rdata, list, dset, OPT_R, NULL);
 	g_free(Rdata);
     }
@@ -1863,8 +1893,12 @@ static int write_data_for_R (const DATASET *dset,
     }
 
     fputs("# load data from gretl\n", fp);
-    fprintf(fp, "gretldata <- read.table(\"%sRdata.tmp\", header=TRUE)\n",
-	    get_export_dotdir());
+    if (binary) {
+	err = write_binary_data_for_R(list, dset, fp);
+    } else {
+	fprintf(fp, "gretldata <- read.table(\"%sRdata.tmp\", header=TRUE)\n",
+		get_export_dotdir());
+    }
 
     if (ts) {
 	char *p, datestr[OBSLEN];
@@ -1934,6 +1968,21 @@ static void write_R_io_file (FILE *fp, const char *ddir)
 	"    fname <- paste(prefix, sx, \".csv\", sep=\"\")\n"
 	"    write.csv(x, file=fname, row.names=F)\n"
 	"    gretlmsg <- paste(\"wrote CSV data\", fname, \"\\n\")\n"
+	"  } else if (is.matrix(x) && bin) {\n"
+	"    fname <- paste(prefix, sx, \".bin\", sep=\"\")\n"
+	"    con <- file(fname, \"wb\")\n"
+	"    if (is.complex(x)) {\n"
+	"      writeChar(\"gretl_binar_cmatrix\", con, eos=NULL)\n"
+	"      writeBin(as.integer(c(2*nrow(x), ncol(x))), con, size=4, endian=\"little\")\n"
+	"      writeBin(as.vector(rbind(Re(as.vector(x)), Im(as.vector(x)))), con,\n"
+	"               size=8, endian=\"little\")\n"
+	"    } else {\n"
+	"      writeChar(\"gretl_binary_matrix\", con, eos=NULL)\n"
+	"      writeBin(as.integer(dim(x)), con, size=4, endian=\"little\")\n"
+	"      writeBin(as.vector(x, \"double\"), con, size=8, endian=\"little\")\n"
+	"    }\n"
+	"    close(con)\n"
+	"    gretlmsg <- paste(\"wrote matrix\", fname, \"\\n\")\n"
 	"  } else if (is.matrix(x)) {\n"
 	"    fname <- paste(prefix, sx, \".mat\", sep=\"\")\n"
 	"    write(dim(x), fname)\n"
@@ -1956,14 +2005,29 @@ static void write_R_io_file (FILE *fp, const char *ddir)
     fputs("}\n", fp);
 #endif
 
-    fputs("gretl.export <- function(x, sx, quiet=0) {\n", fp);
+    fputs("gretl.export <- function(x, sx, quiet=0, bin=0) {\n", fp);
     fprintf(fp, "  prefix <- \"%s\"\n", ddir);
     fputs(export_body, fp);
 
     fputs("gretl.loadmat <- function(mname) {\n", fp);
     fprintf(fp, "  prefix <- \"%s\"\n", ddir);
     fputs("  fname <- paste(prefix, mname, sep=\"\")\n", fp);
-    fputs("  m <- as.matrix(read.table(fname, skip=1))\n", fp);
+    fputs("  if (grepl(\"\\\\.bin$\", fname)) {\n", fp);
+    fputs("    con <- file(fname, \"rb\")\n", fp);
+    fputs("    hdr <- readChar(con, 19, useBytes=TRUE)\n", fp);
+    fputs("    d <- readBin(con, \"integer\", n=2, size=4, endian=\"little\")\n", fp);
+    fputs("    m <- matrix(readBin(con, \"double\", n=d[1]*d[2], size=8,\n", fp);
+    fputs("                        endian=\"little\"), d[1], d[2])\n", fp);
+    fputs("    close(con)\n", fp);
+    fputs("    if (hdr == \"gretl_binar_cmatrix\") {\n", fp);
+    fputs("      m <- matrix(complex(real=m[c(TRUE,FALSE),], imaginary=m[c(FALSE,TRUE),]),\n", fp);
+    fputs("                  d[1]/2, d[2])\n", fp);
+    fputs("    } else if (hdr != \"gretl_binary_matrix\") {\n", fp);
+    fputs("      stop(\"not a valid gretl binary matrix\")\n", fp);
+    fputs("    }\n", fp);
+    fputs("  } else {\n", fp);
+    fputs("    m <- as.matrix(read.table(fname, skip=1))\n", fp);
+    fputs("  }\n", fp);
     fputs("  return(m)\n", fp);
     fputs("}\n", fp);
 }
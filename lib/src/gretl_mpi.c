@@ -89,7 +89,9 @@ enum {
     TAG_STR_VAL,
     TAG_BMEMB_INFO,
     TAG_ARRAY_INFO,
-    TAG_BUNDLE_SIZE
+    TAG_BUNDLE_SIZE,
+    TAG_PACKED_INFO,
+    TAG_PACKED_DATA
 };
 
 #define MI_LEN 5 /* matrix info length */
@@ -115,6 +117,20 @@ static int (*mpi_recv) (void *, int, MPI_Datatype, int, int, MPI_Comm,
 			MPI_Status *);
 static int (*mpi_barrier) (MPI_Comm);
 static int (*mpi_probe) (int, int, MPI_Comm, MPI_Status *);
+static int (*mpi_iprobe) (int, int, MPI_Comm, int *, MPI_Status *);
+static int (*mpi_isend) (void *, int, MPI_Datatype, int, int, MPI_Comm,
+			 MPI_Request *);
+static int (*mpi_irecv) (void *, int, MPI_Datatype, int, int, MPI_Comm,
+			 MPI_Request *);
+static int (*mpi_wait) (MPI_Request *, MPI_Status *);
+static int (*mpi_test) (MPI_Request *, int *, MPI_Status *);
+static int (*mpi_cancel) (MPI_Request *);
+static int (*mpi_allgather) (void *, int, MPI_Datatype, void *, int,
+			     MPI_Datatype, MPI_Comm);
+static int (*mpi_allgatherv) (void *, int, MPI_Datatype, void *, int *,
+			      int *, MPI_Datatype, MPI_Comm);
+static int (*mpi_scatterv) (void *, int *, int *, MPI_Datatype, void *,
+			    int, MPI_Datatype, int, MPI_Comm);
 static double (*mpi_wtime) (void);
 static int (*mpi_initialized) (int *);
 
@@ -178,6 +194,15 @@ int gretl_MPI_init (void)
     mpi_send         = mpiget(MPIhandle, "MPI_Send", &err);
     mpi_recv         = mpiget(MPIhandle, "MPI_Recv", &err);
     mpi_probe        = mpiget(MPIhandle, "MPI_Probe", &err);
+    mpi_iprobe       = mpiget(MPIhandle, "MPI_Iprobe", &err);
+    mpi_isend        = mpiget(MPIhandle, "MPI_Isend", &err);
+    mpi_irecv        = mpiget(MPIhandle, "MPI_Irecv", &err);
+    mpi_wait         = mpiget(MPIhandle, "MPI_Wait", &err);
+    mpi_test         = mpiget(MPIhandle, "MPI_Test", &err);
+    mpi_cancel       = mpiget(MPIhandle, "MPI_Cancel", &err);
+    mpi_allgather    = mpiget(MPIhandle, "MPI_Allgather", &err);
+    mpi_allgatherv   = mpiget(MPIhandle, "MPI_Allgatherv", &err);
+    mpi_scatterv     = mpiget(MPIhandle, "MPI_Scatterv", &err);
     mpi_barrier      = mpiget(MPIhandle, "MPI_Barrier", &err);
     mpi_wtime        = mpiget(MPIhandle, "MPI_Wtime", &err);
     mpi_initialized  = mpiget(MPIhandle, "MPI_Initialized", &err);
@@ -226,6 +251,26 @@ static void gretl_mpi_error (int *err)
     *err = E_EXTERNAL;
 }
 
+/* Collective check on local error codes, to be called by all
+   processes before a collective operation that some of them may
+   be unable to take part in: returns the largest of the codes,
+   so that all processes agree on whether to proceed.
+*/
+
+static int mpi_error_agree (int err)
+{
+    int gerr = 0;
+    int k;
+
+    k = mpi_allreduce(&err, &gerr, 1, mpi_int, mpi_max, mpi_comm_world);
+    if (k) {
+	gretl_mpi_error(&k);
+	gerr = k;
+    }
+
+    return gerr;
+}
+
 static int dim_error (int *dims, int n)
 {
     int i, d0 = 0;
@@ -447,6 +492,169 @@ static int gretl_comm_check (int root, int *idp, int *npp)
     return 0;
 }
 
+/* Get the dimensions of the matrices @sm on all processes in
+   a single collective call. The arrays @rows and @cols, each of
+   length np + 1, are filled as in gretl_matrix_mpi_reduce()
+   below, and checked for conformability.
+*/
+
+static int matrix_allgather_dims (const gretl_matrix *sm,
+				  int np, Gretl_MPI_Op op,
+				  int *rows, int *cols)
+{
+    int myrc[2] = {0, 0};
+    int *rc;
+    int i, err;
+
+    rc = malloc(2 * np * sizeof *rc);
+    if (rc == NULL) {
+	return E_ALLOC;
+    }
+
+    if (sm != NULL) {
+	myrc[0] = sm->rows;
+	myrc[1] = sm->cols;
+    }
+
+    err = mpi_allgather(myrc, 2, mpi_int, rc, 2, mpi_int,
+			mpi_comm_world);
+
+    if (err) {
+	gretl_mpi_error(&err);
+    } else {
+	rows[np] = cols[np] = 0;
+	for (i=0; i<np; i++) {
+	    rows[i] = rc[2*i];
+	    cols[i] = rc[2*i+1];
+	}
+	err = matrix_dims_check(rows, cols, np, op);
+    }
+
+    free(rc);
+
+    return err;
+}
+
+/* The "allreduce" variant of gretl_matrix_mpi_reduce(): rather
+   than reducing to root and then broadcasting, we use a single
+   MPI_Allreduce for sum and product, or MPI_Allgatherv for
+   concatenation.
+*/
+
+static int matrix_allreduce (gretl_matrix *sm,
+			     gretl_matrix **pm,
+			     Gretl_MPI_Op op,
+			     int np)
+{
+    gretl_matrix *rm = NULL;
+    double *tmp = NULL;
+    int *rows, *cols;
+    int *counts = NULL;
+    int *displs = NULL;
+    int mycount = 0;
+    int i, err = 0;
+
+    rows = malloc(4 * (np + 1) * sizeof *rows);
+    if (rows == NULL) {
+	return E_ALLOC;
+    }
+
+    cols = rows + np + 1;
+    counts = cols + np + 1;
+    displs = counts + np + 1;
+
+    err = matrix_allgather_dims(sm, np, op, rows, cols);
+    if (err) {
+	free(rows);
+	return err;
+    }
+
+    if (sm != NULL) {
+	mycount = sm->rows * sm->cols;
+    }
+
+    if (op == GRETL_MPI_SUM || op == GRETL_MPI_PROD) {
+	int n = rows[np] * cols[np];
+	double *sendbuf = mycount > 0 ? sm->val : NULL;
+
+	if (op == GRETL_MPI_PROD) {
+	    rm = gretl_unit_matrix_new(rows[np], cols[np]);
+	} else {
+	    rm = gretl_zero_matrix_new(rows[np], cols[np]);
+	}
+	if (rm == NULL) {
+	    err = E_ALLOC;
+	} else if (sendbuf == NULL) {
+	    /* a null matrix contributes the identity element */
+	    sendbuf = tmp = malloc(n * sizeof *tmp);
+	    if (tmp == NULL) {
+		err = E_ALLOC;
+	    } else {
+		memcpy(tmp, rm->val, n * sizeof *tmp);
+	    }
+	}
+	if (!err) {
+	    err = mpi_allreduce(sendbuf, rm->val, n, mpi_double,
+				op == GRETL_MPI_SUM ? mpi_sum : mpi_prod,
+				mpi_comm_world);
+	    if (err) {
+		gretl_mpi_error(&err);
+	    }
+	}
+    } else {
+	/* concatenation */
+	double *val = NULL;
+	int ntotal = 0;
+
+	for (i=0; i<np; i++) {
+	    counts[i] = rows[i] * cols[i];
+	    displs[i] = ntotal;
+	    ntotal += counts[i];
+	}
+	if (op == GRETL_MPI_HCAT) {
+	    rm = gretl_matrix_alloc(rows[np], ntotal / rows[np]);
+	} else {
+	    rm = gretl_matrix_alloc(ntotal / cols[np], cols[np]);
+	    tmp = malloc(ntotal * sizeof *tmp);
+	}
+	if (rm == NULL || (op == GRETL_MPI_VCAT && tmp == NULL)) {
+	    err = E_ALLOC;
+	} else {
+	    /* column-major storage means that horizontal
+	       concatenation can be done in place
+	    */
+	    val = (op == GRETL_MPI_HCAT)? rm->val : tmp;
+	    err = mpi_allgatherv(mycount > 0 ? sm->val : NULL, mycount,
+				 mpi_double, val, counts, displs,
+				 mpi_double, mpi_comm_world);
+	    if (err) {
+		gretl_mpi_error(&err);
+	    }
+	}
+	if (!err && op == GRETL_MPI_VCAT) {
+	    int offset = 0;
+
+	    for (i=0; i<np; i++) {
+		if (counts[i] > 0) {
+		    matrix_reduce_step(rm, tmp + displs[i], counts[i],
+				       op, &offset);
+		}
+	    }
+	}
+    }
+
+    if (err) {
+	gretl_matrix_free(rm);
+    } else {
+	*pm = rm;
+    }
+
+    free(rows);
+    free(tmp);
+
+    return err;
+}
+
 int gretl_matrix_mpi_reduce (gretl_matrix *sm,
 			     gretl_matrix **pm,
 			     Gretl_MPI_Op op,
@@ -473,6 +681,10 @@ int gretl_matrix_mpi_reduce (gretl_matrix *sm,
 	return err;
     }
 
+    if (opt & OPT_A) {
+	return matrix_allreduce(sm, pm, op, np);
+    }
+
     if (id != root) {
 	/* send matrix dimensions to root */
 	fill_matrix_info(rc, sm);
@@ -571,10 +783,6 @@ int gretl_matrix_mpi_reduce (gretl_matrix *sm,
 	}
     }
 
-    if (!err && (opt & OPT_A)) {
-	err = gretl_matrix_bcast(pm, id, root);
-    }
-
     return err;
 }
 
@@ -928,19 +1136,47 @@ static int gretl_unsigned_bcast (unsigned int *pu, int root)
     return err;
 }
 
-#define NEW_BUNPASS 2 /* still somewhat experimental */
+/* Packed transfer of bundles and arrays. The entire container is
+   serialized into one contiguous buffer, which can then be passed
+   in a single message rather than member by member. A container
+   is written as a pair of 32-bit ints (the number of elements and,
+   for an array, its type; zero for a bundle) followed by a table
+   of pack_entry records and then the element data. For bundle
+   members the key precedes the data. Offsets are absolute within
+   the buffer and all data start on an 8-byte boundary. Nested
+   bundles and arrays are written as containers in the same way.
+*/
 
-#if NEW_BUNPASS
+typedef struct pack_entry_ pack_entry;
 
-/* Compose a message indicating the type (and size, if
-   applicable) of a bundle member to be passed via MPI.
+struct pack_entry_ {
+    gint32 type;   /* type of the element */
+    gint32 klen;   /* length of key including NUL, or 0 */
+    gint64 offset; /* offset of the element's data */
+    gint64 size;   /* size of the data in bytes */
+};
+
+#define PACK_HDR 8 /* count plus array type */
+#define PACK_ALIGN(n) (((n) + 7) & ~((gint64) 7))
+#define PACK_MINFO PACK_ALIGN(MI_LEN * sizeof(int))
+
+static gint64 pack_container (char *buf, gint64 pos,
+			      gretl_bundle *b, gretl_array *a,
+			      int *err);
+
+/* Write the data for a single element at offset @pos in @buf,
+   or just compute its size if @buf is NULL. Returns the size
+   in bytes.
 */
 
-static int compose_msgbuf (char *buf, GretlType type,
-			   const char *key, int *size,
-			   void *data)
+static gint64 pack_element (char *buf, gint64 pos, GretlType type,
+			    void *data, int size, int *err)
 {
-    int n = 0;
+    gint64 n = 0;
+
+    if (data == NULL) {
+	return 0;
+    }
 
     if (type == GRETL_TYPE_DOUBLE) {
 	n = sizeof(double);
@@ -948,297 +1184,478 @@ static int compose_msgbuf (char *buf, GretlType type,
 	n = sizeof(int);
     } else if (type == GRETL_TYPE_UNSIGNED) {
 	n = sizeof(unsigned int);
-    } else if (type == GRETL_TYPE_SERIES) {
-	n = *size;
     } else if (type == GRETL_TYPE_STRING) {
-	char *s = data;
-	n = strlen(s) + 1;
+	n = strlen((char *) data) + 1;
     } else if (type == GRETL_TYPE_LIST) {
-	int *list = data;
-	n = (list[0] + 1) * sizeof(int);
-    } else if (type == GRETL_TYPE_MATRIX ||
-	       type == GRETL_TYPE_BUNDLE ||
-	       type == GRETL_TYPE_ARRAY) {
-	n = 0;
+	n = (((int *) data)[0] + 1) * sizeof(int);
+    } else if (type == GRETL_TYPE_SERIES) {
+	n = (gint64) size * sizeof(double);
+    } else if (type == GRETL_TYPE_MATRIX) {
+	gretl_matrix *m = data;
+	int rc[MI_LEN];
+
+	fill_matrix_info(rc, m);
+	n = (gint64) rc[0] * rc[1] * (rc[2] ? 2 : 1) * sizeof(double);
+	if (buf != NULL) {
+	    memcpy(buf + pos, rc, sizeof rc);
+	    if (n > 0) {
+		memcpy(buf + pos + PACK_MINFO, m->val, n);
+	    }
+	}
+	return PACK_MINFO + n;
+    } else if (type == GRETL_TYPE_BUNDLE) {
+	return pack_container(buf, pos, data, NULL, err) - pos;
+    } else if (type == GRETL_TYPE_ARRAY) {
+	return pack_container(buf, pos, NULL, data, err) - pos;
     } else {
-	return E_DATA;
+	/* not handled */
+	*err = E_TYPES;
+	return 0;
     }
 
-    sprintf(buf, "%d %s %d", type, key, n);
-    *size = n;
+    if (buf != NULL) {
+	memcpy(buf + pos, data, n);
+    }
 
-    return 0;
+    return n;
 }
 
-/* Parse the information sent in @buf by root, regarding a
-   bundle member.
+/* Write bundle @b or array @a into @buf starting at @pos, or if
+   @buf is NULL just work out how much space is needed. Returns
+   the offset just beyond the end of the container.
 */
 
-static int parse_msgbuf (const char *buf, char *key,
-			 GretlType *type, int *size)
+static gint64 pack_container (char *buf, gint64 pos,
+			      gretl_bundle *b, gretl_array *a,
+			      int *err)
 {
-    int t;
+    gretl_array *keys = NULL;
+    GretlType atype = 0;
+    GretlType etype = 0;
+    pack_entry *tab = NULL;
+    gint32 hdr[2];
+    gint64 p;
+    int i, n = 0;
+
+    if (b != NULL) {
+	n = gretl_bundle_get_n_keys(b);
+	if (n > 0) {
+	    keys = gretl_bundle_get_keys(b, err);
+	    if (*err) {
+		return pos;
+	    }
+	}
+    } else {
+	n = gretl_array_get_length(a);
+	atype = gretl_array_get_type(a);
+	etype = gretl_type_get_singular(atype);
+    }
 
-    if (sscanf(buf, "%d %s %d", &t, key, size) != 3) {
-	return E_DATA;
+    if (buf != NULL) {
+	hdr[0] = n;
+	hdr[1] = atype;
+	memcpy(buf + pos, hdr, sizeof hdr);
+	tab = (pack_entry *) (buf + pos + PACK_HDR);
+    }
+
+    p = PACK_ALIGN(pos + PACK_HDR + (gint64) n * sizeof(pack_entry));
+
+    for (i=0; i<n && !*err; i++) {
+	const char *key = NULL;
+	GretlType type = etype;
+	int size = 0;
+	gint32 klen = 0;
+	gint64 nb;
+	void *data;
+
+	if (b != NULL) {
+	    key = gretl_array_get_data(keys, i);
+	    data = gretl_bundle_get_data(b, key, &type, &size, err);
+	    if (*err) {
+		break;
+	    }
+	    klen = strlen(key) + 1;
+	    if (buf != NULL) {
+		memcpy(buf + p, key, klen);
+	    }
+	    p = PACK_ALIGN(p + klen);
+	} else {
+	    data = gretl_array_get_data(a, i);
+	}
+	nb = pack_element(buf, p, type, data, size, err);
+	if (buf != NULL) {
+	    tab[i].type = data == NULL ? 0 : type;
+	    tab[i].klen = klen;
+	    tab[i].offset = p;
+	    tab[i].size = nb;
+	}
+	p = PACK_ALIGN(p + nb);
+    }
+
+    gretl_array_destroy(keys);
+
+    return p;
+}
+
+/* Serialize the object @data, of type @type, into a newly
+   allocated buffer; on success its length is written to @len.
+*/
+
+static char *pack_for_mpi (GretlType type, void *data,
+			   gint64 *len, int *err)
+{
+    char *buf = NULL;
+    gint64 n;
+
+    n = pack_element(NULL, 0, type, data, 0, err);
+
+    if (!*err) {
+	buf = calloc(n, 1);
+	if (buf == NULL) {
+	    *err = E_ALLOC;
+	} else {
+	    pack_element(buf, 0, type, data, 0, err);
+	}
+    }
+
+    if (*err) {
+	free(buf);
+	buf = NULL;
     } else {
-	*type = t;
-	return 0;
+	*len = n;
     }
+
+    return buf;
 }
 
-static int gretl_bundle_bcast (gretl_bundle **pb,
-			       int id, int root)
+static gretl_matrix *unpack_matrix (const char *src, gint64 size,
+				    int *err)
 {
-    gretl_bundle *b = NULL;
     gretl_matrix *m = NULL;
-    gretl_array *a = NULL;
-    gretl_bundle *bsub = NULL;
-    gretl_array *keys = NULL;
-    double *x = NULL;
-    GretlType type;
-    char key[32];
-    void *data;
-    char msgbuf[64];
-    int msglen;
-    int size;
-    int i, nk;
-    int err = 0;
+    int rc[MI_LEN];
+    gint64 n;
 
-    if (id == root) {
-	b = *pb;
-	nk = gretl_bundle_get_n_keys(b);
-	keys = gretl_bundle_get_keys(b, &err);
-	if (err) {
-	    return err;
-	}
+    if (size < PACK_MINFO) {
+	*err = E_DATA;
+	return NULL;
     }
 
-    /* broadcast the number of keys first */
-    err = mpi_bcast(&nk, 1, mpi_int, root, mpi_comm_world);
+    memcpy(rc, src, sizeof rc);
+    if (rc[0] < 0 || rc[1] < 0) {
+	*err = E_DATA;
+	return NULL;
+    }
 
-    if (!err && id != root) {
-	/* everyone but root needs to start a bundle */
-	b = gretl_bundle_new();
-	if (b == NULL) {
-	    return E_ALLOC;
+    n = (gint64) rc[0] * rc[1] * (rc[2] ? 2 : 1) * sizeof(double);
+    if (PACK_MINFO + n != size) {
+	*err = E_DATA;
+	return NULL;
+    }
+
+    if (rc[2]) {
+	m = gretl_cmatrix_new(rc[0], rc[1]);
+    } else {
+	m = gretl_matrix_alloc(rc[0], rc[1]);
+    }
+
+    if (m == NULL) {
+	*err = E_ALLOC;
+    } else {
+	if (n > 0) {
+	    memcpy(m->val, src + PACK_MINFO, n);
 	}
+	maybe_date_matrix(m, rc);
     }
 
-    msglen = sizeof msgbuf;
+    return m;
+}
 
-    for (i=0; i<nk && !err; i++) {
-	/* loop across bundle keys */
-	memset(msgbuf, 0, msglen);
-	size = 0;
-	data = NULL;
-	m = NULL;
-	a = NULL;
-	bsub = NULL;
-	x = NULL;
+static void *unpack_container (const char *buf, gint64 len,
+			       gint64 pos, GretlType *type,
+			       int *err);
 
-	if (id == root) {
-	    const char *rkey = gretl_array_get_data(keys, i);
+/* Reconstruct the element described by @e; for a series, its
+   length is written to @size.
+*/
 
-	    data = gretl_bundle_get_data(b, rkey, &type, &size, &err);
-	    if (!err) {
-		compose_msgbuf(msgbuf, type, rkey, &size, data);
-		if (type == GRETL_TYPE_MATRIX) {
-		    m = (gretl_matrix *) data;
-		} else if (type == GRETL_TYPE_ARRAY) {
-		    a = (gretl_array *) data;
-		} else if (type == GRETL_TYPE_BUNDLE) {
-		    bsub = (gretl_bundle *) data;
-		} else if (type == GRETL_TYPE_SERIES) {
-		    x = (double *) data;
-		}
+static void *unpack_element (const char *buf, gint64 len,
+			     const pack_entry *e, int *size,
+			     int *err)
+{
+    const char *src = buf + e->offset;
+    void *data = NULL;
+    GretlType t = e->type;
+
+    if (t == GRETL_TYPE_DOUBLE || t == GRETL_TYPE_INT ||
+	t == GRETL_TYPE_UNSIGNED) {
+	gint64 n = t == GRETL_TYPE_DOUBLE ? sizeof(double) : sizeof(int);
+
+	if (e->size != n) {
+	    *err = E_DATA;
+	} else {
+	    data = malloc(n);
+	    if (data == NULL) {
+		*err = E_ALLOC;
+	    } else {
+		memcpy(data, src, n);
 	    }
 	}
-	if (!err) {
-	    /* broadcast info on the bundle member */
-	    err = mpi_bcast(msgbuf, msglen, mpi_byte, root, mpi_comm_world);
+    } else if (t == GRETL_TYPE_STRING) {
+	if (e->size < 1 || src[e->size - 1] != '\0') {
+	    *err = E_DATA;
+	} else {
+	    data = gretl_strdup(src);
 	}
-	if (!err) {
-	    err = parse_msgbuf(msgbuf, key, &type, &size);
-	}
-	if (err) {
-	    break;
-	}
-	if (type == GRETL_TYPE_MATRIX) {
-	    err = gretl_matrix_bcast(&m, id, root);
-	    if (!err && id != root) {
-		err = gretl_bundle_donate_data(b, key, m, type, 0);
-	    }
-	} else if (type == GRETL_TYPE_ARRAY) {
-	    err = gretl_array_bcast(&a, id, root);
-	    if (!err && id != root) {
-		err = gretl_bundle_donate_data(b, key, a, type, 0);
-	    }
-	} else if (type == GRETL_TYPE_BUNDLE) {
-	    err = gretl_bundle_bcast(&bsub, id, root);
-	    if (!err && id != root) {
-		err = gretl_bundle_donate_data(b, key, bsub, type, 0);
-	    }
-	} else if (type == GRETL_TYPE_SERIES) {
-	    err = gretl_series_bcast(&x, size, id, root);
-	    if (!err && id != root) {
-		err = gretl_bundle_donate_data(b, key, x, type, size);
-	    }
+    } else if (t == GRETL_TYPE_LIST) {
+	int n0;
+
+	if (e->size < (gint64) sizeof(int)) {
+	    *err = E_DATA;
 	} else {
-	    /* scalar, string or list */
-	    if (id != root) {
-		data = calloc(size, 1);
-		if (data == NULL) {
-		    err = E_ALLOC;
+	    memcpy(&n0, src, sizeof n0);
+	    if (n0 < 0 || (n0 + 1) * (gint64) sizeof(int) != e->size) {
+		*err = E_DATA;
+	    } else {
+		data = gretl_list_new(n0);
+		if (data != NULL) {
+		    memcpy(data, src, e->size);
 		}
 	    }
-	    err = mpi_bcast(data, size, mpi_byte, root, mpi_comm_world);
-	    if (!err && id != root && data != NULL) {
-		if (gretl_is_scalar_type(type)) {
-		    err = gretl_bundle_set_data(b, key, data, type, 0);
-		    free(data);
-		} else {
-		    err = gretl_bundle_donate_data(b, key, data, type, 0);
-		}
+	}
+    } else if (t == GRETL_TYPE_SERIES) {
+	if (e->size % sizeof(double) || e->size / sizeof(double) > INT_MAX) {
+	    *err = E_DATA;
+	} else {
+	    *size = e->size / sizeof(double);
+	    data = malloc(e->size);
+	    if (data != NULL) {
+		memcpy(data, src, e->size);
 	    }
 	}
+    } else if (t == GRETL_TYPE_MATRIX) {
+	return unpack_matrix(src, e->size, err);
+    } else if (t == GRETL_TYPE_BUNDLE || t == GRETL_TYPE_ARRAY) {
+	GretlType ct = 0;
+
+	data = unpack_container(buf, e->offset + e->size,
+				e->offset, &ct, err);
+	if (!*err && ct != t) {
+	    *err = E_DATA;
+	}
+	return data;
+    } else {
+	*err = E_DATA;
+	return NULL;
     }
 
-    gretl_array_destroy(keys);
-
-    mpi_barrier(mpi_comm_world);
-
-    if (err) {
-	gretl_mpi_error(&err);
-    } else if (id != root) {
-	*pb = b;
+    if (!*err && data == NULL) {
+	*err = E_ALLOC;
     }
 
-    return err;
+    return data;
 }
 
-#else /* !NEW_BUNPASS */
+/* Rebuild a bundle or array from the container starting at
+   @pos in @buf, checking that nothing reaches beyond @len.
+*/
 
-static int gretl_bundle_bcast (gretl_bundle **pb, int id, int root)
+static void *unpack_container (const char *buf, gint64 len,
+			       gint64 pos, GretlType *type,
+			       int *err)
 {
     gretl_bundle *b = NULL;
-    char *buf = NULL;
-    int bytes = 0;
-    int err = 0;
+    gretl_array *a = NULL;
+    GretlType etype = 0;
+    gint64 tend;
+    gint32 hdr[2];
+    int i, n;
 
-    if (id == root) {
-	b = *pb;
-	buf = gretl_bundle_write_to_buffer(b, id, &bytes, &err);
-	if (err) {
-	    return err;
+    if (pos + PACK_HDR > len) {
+	*err = E_DATA;
+	return NULL;
+    }
+
+    memcpy(hdr, buf + pos, sizeof hdr);
+    n = hdr[0];
+    tend = pos + PACK_HDR + (gint64) n * sizeof(pack_entry);
+    if (n < 0 || tend > len) {
+	*err = E_DATA;
+	return NULL;
+    }
+
+    if (hdr[1] == 0) {
+	*type = GRETL_TYPE_BUNDLE;
+	b = gretl_bundle_new();
+	if (b == NULL) {
+	    *err = E_ALLOC;
 	}
+    } else {
+	*type = GRETL_TYPE_ARRAY;
+	a = gretl_array_new(hdr[1], n, err);
+	etype = gretl_type_get_singular(hdr[1]);
     }
 
-    /* broadcast the buffer size first */
-    err = mpi_bcast(&bytes, 1, mpi_int, root, mpi_comm_world);
+    for (i=0; i<n && !*err; i++) {
+	const char *key = NULL;
+	void *data = NULL;
+	pack_entry e;
+	int size = 0;
 
-    if (!err && id != root) {
-	/* everyone but root needs to allocate space */
-	buf = malloc(bytes);
-	if (buf == NULL) {
-	    return E_ALLOC;
+	memcpy(&e, buf + pos + PACK_HDR + i * sizeof e, sizeof e);
+	if (e.offset < tend || e.size < 0 || e.offset + e.size > len) {
+	    *err = E_DATA;
+	    break;
+	}
+	if (b != NULL) {
+	    gint64 koff = e.offset - PACK_ALIGN(e.klen);
+
+	    if (e.klen < 2 || koff < tend || buf[koff + e.klen - 1]) {
+		*err = E_DATA;
+		break;
+	    }
+	    key = buf + koff;
+	} else if (e.type != 0 && e.type != etype) {
+	    *err = E_DATA;
+	    break;
+	}
+	if (e.type != 0) {
+	    data = unpack_element(buf, len, &e, &size, err);
+	}
+	if (*err) {
+	    break;
+	}
+	if (b != NULL) {
+	    *err = gretl_bundle_donate_data(b, key, data, e.type, size);
+	} else {
+	    /* the array takes ownership of @data */
+	    gretl_array_set_data(a, i, data);
 	}
     }
 
-    if (!err) {
-	/* broadcast the bundle content */
-	err = mpi_bcast(buf, bytes, mpi_byte, root, mpi_comm_world);
+    if (*err) {
+	gretl_bundle_destroy(b);
+	gretl_array_destroy(a);
+	return NULL;
+    } else if (b != NULL) {
+	return b;
+    } else {
+	return a;
     }
+}
 
-    if (!err && id != root) {
-	/* everyone but root needs to reconstitute the bundle */
-	*pb = gretl_bundle_read_from_buffer(buf, bytes, &err);
-	if (err) {
-	    /* note: not an MPI error */
-	    free(buf);
-	    return err;
-	}
+/* Reconstruct an object of type @type from the packed buffer
+   @buf of length @len.
+*/
+
+static void *unpack_object (const char *buf, gint64 len,
+			    GretlType type, int *err)
+{
+    pack_entry e = {type, 0, 0, len};
+    int size = 0;
+
+    return unpack_element(buf, len, &e, &size, err);
+}
+
+static void destroy_unpacked (void *ptr, GretlType type)
+{
+    if (ptr == NULL) {
+	return;
+    } else if (type == GRETL_TYPE_BUNDLE) {
+	gretl_bundle_destroy(ptr);
+    } else if (type == GRETL_TYPE_ARRAY) {
+	gretl_array_destroy(ptr);
+    } else if (type == GRETL_TYPE_MATRIX) {
+	gretl_matrix_free(ptr);
+    } else {
+	free(ptr);
     }
+}
 
-    mpi_barrier(mpi_comm_world);
+/* Broadcast a bundle or array as a single packed message. If
+   root is unable to pack the object (on account of a member
+   type that's not handled, or a size that exceeds the capacity
+   of a single MPI message) @done is set to 0 on all processes
+   and the caller should fall back to member-wise transfer.
+*/
 
-    free(buf);
+static int gretl_packed_bcast (void *p, GretlType type, int id,
+			       int root, int *done)
+{
+    char *buf = NULL;
+    gint64 n = 0;
+    int len = -1;
+    int err = 0;
 
-    if (err) {
+    *done = 0;
+
+    if (id == root) {
+	buf = pack_for_mpi(type, *(void **) p, &n, &err);
+	if (!err && n <= INT_MAX) {
+	    len = n;
+	}
+    }
+
+    err = mpi_bcast(&len, 1, mpi_int, root, mpi_comm_world);
+
+    if (!err && len >= 0) {
+	if (id != root) {
+	    buf = malloc(len);
+	    err = (buf == NULL)? E_ALLOC : 0;
+	}
+	/* don't leave anyone waiting in the broadcast below */
+	err = mpi_error_agree(err);
+	if (!err) {
+	    *done = 1;
+	    err = mpi_bcast(buf, len, mpi_byte, root, mpi_comm_world);
+	    if (err) {
+		gretl_mpi_error(&err);
+	    } else if (id != root) {
+		*(void **) p = unpack_object(buf, len, type, &err);
+	    }
+	}
+    } else if (err) {
 	gretl_mpi_error(&err);
     }
 
+    free(buf);
+
     return err;
 }
 
-#endif /* NEW_BUNPASS or not */
+/* Send a bundle or array to @dest as a single packed message,
+   preceded by a short message giving its type and length. As
+   with broadcasting, @done is set to 0 if the object cannot
+   be packed.
+*/
 
-static int gretl_array_bcast (gretl_array **pa, int id, int root)
+static int gretl_packed_send (void *p, GretlType type, int dest,
+			      int *done)
 {
-    gretl_array *a = NULL;
-    GretlType type = 0;
-    int nelem = 0;
-    int st[2];
-    int i, err = 0;
-
-    if (id == root) {
-	a = *pa;
-	st[0] = nelem = gretl_array_get_length(a);
-	st[1] = type = gretl_array_get_type(a);
-    }
+    char *buf;
+    gint64 n = 0;
+    int info[2];
+    int err = 0;
 
-    /* broadcast the array size and type */
-    err = mpi_bcast(st, 2, mpi_int, root, mpi_comm_world);
+    *done = 0;
 
-    if (!err && id != root) {
-	/* everyone but root needs to allocate an array */
-	nelem = st[0];
-	type = st[1];
-	*pa = a = gretl_array_new(type, nelem, &err);
+    buf = pack_for_mpi(type, p, &n, &err);
+    if (err || n > INT_MAX) {
+	free(buf);
+	return 0;
     }
 
-    for (i=0; i<nelem && !err; i++) {
-	void *ptr, *data = NULL;
+    *done = 1;
+    info[0] = type;
+    info[1] = n;
 
-	if (id == root) {
-	    data = gretl_array_get_data(a, i);
-	}
-	ptr = &data;
-	if (type == GRETL_TYPE_MATRICES) {
-	    err = gretl_matrix_bcast(ptr, id, root);
-	    if (id != root) {
-		data = *(gretl_matrix **) ptr;
-	    }
-	} else if (type == GRETL_TYPE_STRINGS) {
-	    err = gretl_string_bcast(ptr, id, root);
-	    if (id != root) {
-		data = *(char **) ptr;
-	    }
-	} else if (type == GRETL_TYPE_BUNDLES) {
-	    err = gretl_bundle_bcast(ptr, id, root);
-	    if (id != root) {
-		data = *(gretl_bundle **) ptr;
-	    }
-	} else if (type == GRETL_TYPE_LISTS) {
-	    err = gretl_list_bcast(ptr, id, root);
-	    if (id != root) {
-		data = *(int **) ptr;
-	    }
-	} else if (type == GRETL_TYPE_ARRAYS) {
-	    err = gretl_array_bcast(ptr, id, root);
-	    if (id != root) {
-		data = *(gretl_array **) ptr;
-	    }
-	} else {
-	    /* ?? */
-	    err = E_TYPES;
-	}
-	if (!err && id != root) {
-	    gretl_array_set_data(a, i, data);
-	}
+    err = mpi_send(info, 2, mpi_int, dest, TAG_PACKED_INFO,
+		   mpi_comm_world);
+    if (!err) {
+	err = mpi_send(buf, n, mpi_byte, dest, TAG_PACKED_DATA,
+		       mpi_comm_world);
     }
 
-    mpi_barrier(mpi_comm_world);
+    free(buf);
 
     if (err) {
 	gretl_mpi_error(&err);
@@ -1247,81 +1664,1023 @@ static int gretl_array_bcast (gretl_array **pa, int id, int root)
     return err;
 }
 
-int gretl_mpi_barrier (void)
+static char *packed_buffer_new (int *info, int *err)
 {
-    return mpi_barrier(mpi_comm_world) != MPI_SUCCESS;
-}
+    char *buf = NULL;
 
-/**
- * gretl_mpi_bcast:
- * @p: the location of the object to be broadcast.
- * @type: the type of the object to which @p points.
- * @root: the rank of the root process.
- *
- * Broadcasts the value referenced by @p to MPI_COMM_WORLD.
- * @type must be GRETL_TYPE_MATRIX, in which case
- * @p should be a (**gretl_matrix) pointer; GRETL_TYPE_BUNDLE,
- * in which case @p should be a (**gretl_bundle) pointer;
- * or GRETL_TYPE_DOUBLE, in which case @p should be a (*double)
- * pointer.
- *
- * Returns: 0 on successful completion, non-zero code otherwise.
- **/
+    if (info[1] < 0) {
+	*err = E_DATA;
+    } else {
+	buf = malloc(info[1] > 0 ? info[1] : 1);
+	if (buf == NULL) {
+	    *err = E_ALLOC;
+	}
+    }
 
-int gretl_mpi_bcast (void *p, GretlType type, int root)
+    return buf;
+}
+
+static void *gretl_packed_receive (int source, GretlType *type,
+				   int *err)
 {
-    int id, err;
+    void *ptr = NULL;
+    char *buf;
+    int info[2];
 
-    err = gretl_comm_check(root, &id, NULL);
-    if (err) {
-	return err;
+    *err = mpi_recv(info, 2, mpi_int, source, TAG_PACKED_INFO,
+		    mpi_comm_world, MPI_STATUS_IGNORE);
+    if (*err) {
+	gretl_mpi_error(err);
+	return NULL;
     }
 
-    if (type == GRETL_TYPE_DOUBLE) {
-	return gretl_scalar_bcast((double *) p, root);
-    } else if (type == GRETL_TYPE_INT) {
-	return gretl_int_bcast((int *) p, root);
-    } else if (type == GRETL_TYPE_UNSIGNED) {
-	return gretl_unsigned_bcast((unsigned int *) p, root);
-    } else if (type == GRETL_TYPE_MATRIX) {
-	return gretl_matrix_bcast((gretl_matrix **) p, id, root);
-    } else if (type == GRETL_TYPE_BUNDLE) {
-	return gretl_bundle_bcast((gretl_bundle **) p, id, root);
-    } else if (type == GRETL_TYPE_ARRAY) {
-	return gretl_array_bcast((gretl_array **) p, id, root);
+    buf = packed_buffer_new(info, err);
+    if (buf == NULL) {
+	return NULL;
+    }
+
+    *err = mpi_recv(buf, info[1], mpi_byte, source, TAG_PACKED_DATA,
+		    mpi_comm_world, MPI_STATUS_IGNORE);
+    if (*err) {
+	gretl_mpi_error(err);
+    } else {
+	*type = info[0];
+	ptr = unpack_object(buf, info[1], *type, err);
+    }
+
+    free(buf);
+
+    return ptr;
+}
+
+/* Hand over an object obtained via gretl_packed_receive() to
+   the appropriate pointer argument, as in gretl_mpi_receive().
+*/
+
+static void packed_result (void *ptr, GretlType type,
+			   gretl_matrix **pm,
+			   gretl_bundle **pb,
+			   gretl_array **pa,
+			   double *px,
+			   int *pk)
+{
+    if (type == GRETL_TYPE_MATRIX) {
+	*pm = ptr;
+    } else if (type == GRETL_TYPE_BUNDLE) {
+	*pb = ptr;
+    } else if (type == GRETL_TYPE_ARRAY) {
+	*pa = ptr;
+    } else if (type == GRETL_TYPE_DOUBLE) {
+	*px = *(double *) ptr;
+	free(ptr);
+    } else if (type == GRETL_TYPE_INT) {
+	*pk = *(int *) ptr;
+	free(ptr);
+    } else {
+	destroy_unpacked(ptr, type);
+    }
+}
+
+#define NEW_BUNPASS 2 /* still somewhat experimental */
+
+#if NEW_BUNPASS
+
+/* Compose a message indicating the type (and size, if
+   applicable) of a bundle member to be passed via MPI.
+*/
+
+static int compose_msgbuf (char *buf, GretlType type,
+			   const char *key, int *size,
+			   void *data)
+{
+    int n = 0;
+
+    if (type == GRETL_TYPE_DOUBLE) {
+	n = sizeof(double);
+    } else if (type == GRETL_TYPE_INT) {
+	n = sizeof(int);
+    } else if (type == GRETL_TYPE_UNSIGNED) {
+	n = sizeof(unsigned int);
+    } else if (type == GRETL_TYPE_SERIES) {
+	n = *size;
     } else if (type == GRETL_TYPE_STRING) {
-	return gretl_string_bcast((char **) p, id, root);
+	char *s = data;
+	n = strlen(s) + 1;
     } else if (type == GRETL_TYPE_LIST) {
-	return gretl_list_bcast((int **) p, id, root);
+	int *list = data;
+	n = (list[0] + 1) * sizeof(int);
+    } else if (type == GRETL_TYPE_MATRIX ||
+	       type == GRETL_TYPE_BUNDLE ||
+	       type == GRETL_TYPE_ARRAY) {
+	n = 0;
     } else {
 	return E_DATA;
     }
+
+    sprintf(buf, "%d %s %d", type, key, n);
+    *size = n;
+
+    return 0;
 }
 
-/* this "send" function is public, for convenience of callers
-   such as the svm plugin
+/* Parse the information sent in @buf by root, regarding a
+   bundle member.
 */
 
-int gretl_matrix_mpi_send (const gretl_matrix *m, int dest)
+static int parse_msgbuf (const char *buf, char *key,
+			 GretlType *type, int *size)
 {
-    int rc[MI_LEN];
-    int err;
+    int t;
 
-    fill_matrix_info(rc, m);
+    if (sscanf(buf, "%d %s %d", &t, key, size) != 3) {
+	return E_DATA;
+    } else {
+	*type = t;
+	return 0;
+    }
+}
 
-    err = mpi_send(rc, MI_LEN, mpi_int, dest, TAG_MATRIX_INFO,
+static int gretl_bundle_bcast (gretl_bundle **pb,
+			       int id, int root)
+{
+    gretl_bundle *b = NULL;
+    gretl_matrix *m = NULL;
+    gretl_array *a = NULL;
+    gretl_bundle *bsub = NULL;
+    gretl_array *keys = NULL;
+    double *x = NULL;
+    GretlType type;
+    char key[32];
+    void *data;
+    char msgbuf[64];
+    int msglen;
+    int size;
+    int i, nk;
+    int err = 0;
+
+    if (id == root) {
+	b = *pb;
+	nk = gretl_bundle_get_n_keys(b);
+	keys = gretl_bundle_get_keys(b, &err);
+	if (err) {
+	    return err;
+	}
+    }
+
+    /* broadcast the number of keys first */
+    err = mpi_bcast(&nk, 1, mpi_int, root, mpi_comm_world);
+
+    if (!err && id != root) {
+	/* everyone but root needs to start a bundle */
+	b = gretl_bundle_new();
+	if (b == NULL) {
+	    return E_ALLOC;
+	}
+    }
+
+    msglen = sizeof msgbuf;
+
+    for (i=0; i<nk && !err; i++) {
+	/* loop across bundle keys */
+	memset(msgbuf, 0, msglen);
+	size = 0;
+	data = NULL;
+	m = NULL;
+	a = NULL;
+	bsub = NULL;
+	x = NULL;
+
+	if (id == root) {
+	    const char *rkey = gretl_array_get_data(keys, i);
+
+	    data = gretl_bundle_get_data(b, rkey, &type, &size, &err);
+	    if (!err) {
+		compose_msgbuf(msgbuf, type, rkey, &size, data);
+		if (type == GRETL_TYPE_MATRIX) {
+		    m = (gretl_matrix *) data;
+		} else if (type == GRETL_TYPE_ARRAY) {
+		    a = (gretl_array *) data;
+		} else if (type == GRETL_TYPE_BUNDLE) {
+		    bsub = (gretl_bundle *) data;
+		} else if (type == GRETL_TYPE_SERIES) {
+		    x = (double *) data;
+		}
+	    }
+	}
+	if (!err) {
+	    /* broadcast info on the bundle member */
+	    err = mpi_bcast(msgbuf, msglen, mpi_byte, root, mpi_comm_world);
+	}
+	if (!err) {
+	    err = parse_msgbuf(msgbuf, key, &type, &size);
+	}
+	if (err) {
+	    break;
+	}
+	if (type == GRETL_TYPE_MATRIX) {
+	    err = gretl_matrix_bcast(&m, id, root);
+	    if (!err && id != root) {
+		err = gretl_bundle_donate_data(b, key, m, type, 0);
+	    }
+	} else if (type == GRETL_TYPE_ARRAY) {
+	    err = gretl_array_bcast(&a, id, root);
+	    if (!err && id != root) {
+		err = gretl_bundle_donate_data(b, key, a, type, 0);
+	    }
+	} else if (type == GRETL_TYPE_BUNDLE) {
+	    err = gretl_bundle_bcast(&bsub, id, root);
+	    if (!err && id != root) {
+		err = gretl_bundle_donate_data(b, key, bsub, type, 0);
+	    }
+	} else if (type == GRETL_TYPE_SERIES) {
+	    err = gretl_series_bcast(&x, size, id, root);
+	    if (!err && id != root) {
+		err = gretl_bundle_donate_data(b, key, x, type, size);
+	    }
+	} else {
+	    /* scalar, string or list */
+	    if (id != root) {
+		data = calloc(size, 1);
+		if (data == NULL) {
+		    err = E_ALLOC;
+		}
+	    }
+	    err = mpi_bcast(data, size, mpi_byte, root, mpi_comm_world);
+	    if (!err && id != root && data != NULL) {
+		if (gretl_is_scalar_type(type)) {
+		    err = gretl_bundle_set_data(b, key, data, type, 0);
+		    free(data);
+		} else {
+		    err = gretl_bundle_donate_data(b, key, data, type, 0);
+		}
+	    }
+	}
+    }
+
+    gretl_array_destroy(keys);
+
+    mpi_barrier(mpi_comm_world);
+
+    if (err) {
+	gretl_mpi_error(&err);
+    } else if (id != root) {
+	*pb = b;
+    }
+
+    return err;
+}
+
+#else /* !NEW_BUNPASS */
+
+static int gretl_bundle_bcast (gretl_bundle **pb, int id, int root)
+{
+    gretl_bundle *b = NULL;
+    char *buf = NULL;
+    int bytes = 0;
+    int err = 0;
+
+    if (id == root) {
+	b = *pb;
+	buf = gretl_bundle_write_to_buffer(b, id, &bytes, &err);
+	if (err) {
+	    return err;
+	}
+    }
+
+    /* broadcast the buffer size first */
+    err = mpi_bcast(&bytes, 1, mpi_int, root, mpi_comm_world);
+
+    if (!err && id != root) {
+	/* everyone but root needs to allocate space */
+	buf = malloc(bytes);
+	if (buf == NULL) {
+	    return E_ALLOC;
+	}
+    }
+
+    if (!err) {
+	/* broadcast the bundle content */
+	err = mpi_bcast(buf, bytes, mpi_byte, root, mpi_comm_world);
+    }
+
+    if (!err && id != root) {
+	/* everyone but root needs to reconstitute the bundle */
+	*pb = gretl_bundle_read_from_buffer(buf, bytes, &err);
+	if (err) {
+	    /* note: not an MPI error */
+	    free(buf);
+	    return err;
+	}
+    }
+
+    mpi_barrier(mpi_comm_world);
+
+    free(buf);
+
+    if (err) {
+	gretl_mpi_error(&err);
+    }
+
+    return err;
+}
+
+#endif /* NEW_BUNPASS or not */
+
+static int gretl_array_bcast (gretl_array **pa, int id, int root)
+{
+    gretl_array *a = NULL;
+    GretlType type = 0;
+    int nelem = 0;
+    int st[2];
+    int i, err = 0;
+
+    if (id == root) {
+	a = *pa;
+	st[0] = nelem = gretl_array_get_length(a);
+	st[1] = type = gretl_array_get_type(a);
+    }
+
+    /* broadcast the array size and type */
+    err = mpi_bcast(st, 2, mpi_int, root, mpi_comm_world);
+
+    if (!err && id != root) {
+	/* everyone but root needs to allocate an array */
+	nelem = st[0];
+	type = st[1];
+	*pa = a = gretl_array_new(type, nelem, &err);
+    }
+
+    for (i=0; i<nelem && !err; i++) {
+	void *ptr, *data = NULL;
+
+	if (id == root) {
+	    data = gretl_array_get_data(a, i);
+	}
+	ptr = &data;
+	if (type == GRETL_TYPE_MATRICES) {
+	    err = gretl_matrix_bcast(ptr, id, root);
+	    if (id != root) {
+		data = *(gretl_matrix **) ptr;
+	    }
+	} else if (type == GRETL_TYPE_STRINGS) {
+	    err = gretl_string_bcast(ptr, id, root);
+	    if (id != root) {
+		data = *(char **) ptr;
+	    }
+	} else if (type == GRETL_TYPE_BUNDLES) {
+	    err = gretl_bundle_bcast(ptr, id, root);
+	    if (id != root) {
+		data = *(gretl_bundle **) ptr;
+	    }
+	} else if (type == GRETL_TYPE_LISTS) {
+	    err = gretl_list_bcast(ptr, id, root);
+	    if (id != root) {
+		data = *(int **) ptr;
+	    }
+	} else if (type == GRETL_TYPE_ARRAYS) {
+	    err = gretl_array_bcast(ptr, id, root);
+	    if (id != root) {
+		data = *(gretl_array **) ptr;
+	    }
+	} else {
+	    /* ?? */
+	    err = E_TYPES;
+	}
+	if (!err && id != root) {
+	    gretl_array_set_data(a, i, data);
+	}
+    }
+
+    mpi_barrier(mpi_comm_world);
+
+    if (err) {
+	gretl_mpi_error(&err);
+    }
+
+    return err;
+}
+
+int gretl_mpi_barrier (void)
+{
+    return mpi_barrier(mpi_comm_world) != MPI_SUCCESS;
+}
+
+/**
+ * gretl_mpi_bcast:
+ * @p: the location of the object to be broadcast.
+ * @type: the type of the object to which @p points.
+ * @root: the rank of the root process.
+ *
+ * Broadcasts the value referenced by @p to MPI_COMM_WORLD.
+ * @type must be GRETL_TYPE_MATRIX, in which case
+ * @p should be a (**gretl_matrix) pointer; GRETL_TYPE_BUNDLE,
+ * in which case @p should be a (**gretl_bundle) pointer;
+ * or GRETL_TYPE_DOUBLE, in which case @p should be a (*double)
+ * pointer.
+ *
+ * Returns: 0 on successful completion, non-zero code otherwise.
+ **/
+
+int gretl_mpi_bcast (void *p, GretlType type, int root)
+{
+    int id, err;
+
+    err = gretl_comm_check(root, &id, NULL);
+    if (err) {
+	return err;
+    }
+
+    if (type == GRETL_TYPE_BUNDLE || type == GRETL_TYPE_ARRAY) {
+	int done = 0;
+
+	err = gretl_packed_bcast(p, type, id, root, &done);
+	if (err || done) {
+	    return err;
+	}
+    }
+
+    if (type == GRETL_TYPE_DOUBLE) {
+	return gretl_scalar_bcast((double *) p, root);
+    } else if (type == GRETL_TYPE_INT) {
+	return gretl_int_bcast((int *) p, root);
+    } else if (type == GRETL_TYPE_UNSIGNED) {
+	return gretl_unsigned_bcast((unsigned int *) p, root);
+    } else if (type == GRETL_TYPE_MATRIX) {
+	return gretl_matrix_bcast((gretl_matrix **) p, id, root);
+    } else if (type == GRETL_TYPE_BUNDLE) {
+	return gretl_bundle_bcast((gretl_bundle **) p, id, root);
+    } else if (type == GRETL_TYPE_ARRAY) {
+	return gretl_array_bcast((gretl_array **) p, id, root);
+    } else if (type == GRETL_TYPE_STRING) {
+	return gretl_string_bcast((char **) p, id, root);
+    } else if (type == GRETL_TYPE_LIST) {
+	return gretl_list_bcast((int **) p, id, root);
+    } else {
+	return E_DATA;
+    }
+}
+
+/* this "send" function is public, for convenience of callers
+   such as the svm plugin
+*/
+
+int gretl_matrix_mpi_send (const gretl_matrix *m, int dest)
+{
+    int rc[MI_LEN];
+    int err;
+
+    fill_matrix_info(rc, m);
+
+    err = mpi_send(rc, MI_LEN, mpi_int, dest, TAG_MATRIX_INFO,
+		   mpi_comm_world);
+
+    if (!err) {
+	int n = m->rows * m->cols;
+
+	if (m->is_complex) {
+	    n *= 2;
+	}
+	err = mpi_send(m->val, n, mpi_double, dest, TAG_MATRIX_VAL,
+		       mpi_comm_world);
+    }
+
+    if (err) {
+	gretl_mpi_error(&err);
+    }
+
+    return err;
+}
+
+static int gretl_string_send (char *s, int dest)
+{
+    int n = strlen(s) + 1;
+    int err;
+
+    err = mpi_send(&n, 1, mpi_int, dest, TAG_STR_LEN,
+		   mpi_comm_world);
+
+    if (!err) {
+	err = mpi_send(s, n, mpi_byte, dest, TAG_STR_VAL,
+		       mpi_comm_world);
+    }
+
+    if (err) {
+	gretl_mpi_error(&err);
+    }
+
+    return err;
+}
+
+static int gretl_list_send (int *list, int dest)
+{
+    int n = list[0];
+    int err;
+
+    err = mpi_send(&n, 1, mpi_int, dest, TAG_LIST_LEN,
+		   mpi_comm_world);
+
+    if (!err) {
+	err = mpi_send(list, n+1, mpi_int, dest, TAG_LIST_VAL,
+		       mpi_comm_world);
+    }
+
+    if (err) {
+	gretl_mpi_error(&err);
+    }
+
+    return err;
+}
+
+static int gretl_scalar_send (double *px, int dest)
+{
+    int err;
+
+    err = mpi_send(px, 1, mpi_double, dest, TAG_SCALAR_VAL,
+		   mpi_comm_world);
+
+    if (err) {
+	gretl_mpi_error(&err);
+    }
+
+    return err;
+}
+
+static int gretl_int_send (int *pi, int dest)
+{
+    int err;
+
+    err = mpi_send(pi, 1, mpi_int, dest, TAG_INT_VAL,
+		   mpi_comm_world);
+
+    if (err) {
+	gretl_mpi_error(&err);
+    }
+
+    return err;
+}
+
+static int gretl_array_send (gretl_array *a, int dest)
+{
+    GretlType type = 0;
+    int nelem = 0;
+    int st[2];
+    int i, err = 0;
+
+    st[0] = nelem = gretl_array_get_length(a);
+    st[1] = type = gretl_array_get_type(a);
+
+    /* send the array size and type */
+    err = mpi_send(st, 2, mpi_int, dest, TAG_ARRAY_INFO,
+		   mpi_comm_world);
+
+    for (i=0; i<nelem && !err; i++) {
+	void *data = gretl_array_get_data(a, i);
+
+	if (type == GRETL_TYPE_MATRICES) {
+	    err = gretl_matrix_mpi_send(data, dest);
+	} else if (type == GRETL_TYPE_STRINGS) {
+	    err = gretl_string_send(data, dest);
+	} else if (type == GRETL_TYPE_BUNDLES) {
+	    err = gretl_bundle_send(data, dest);
+	} else if (type == GRETL_TYPE_LISTS) {
+	    err = gretl_list_send(data, dest);
+	} else if (type == GRETL_TYPE_ARRAYS) {
+	    err = gretl_array_send(data, dest);
+	}
+    }
+
+    if (err) {
+	gretl_mpi_error(&err);
+    }
+
+    return err;
+}
+
+/**
+ * gretl_mpi_send:
+ * @p: pointer to the object to be sent.
+ * @type: the type of the object.
+ * @dest: the MPI rank of the destination.
+ *
+ * Sends the value referenced by @p, of gretl type @type, to the
+ * MPI process with rank @dest.
+ *
+ * Returns: 0 on successful completion, non-zero code otherwise.
+ **/
+
+int gretl_mpi_send (void *p, GretlType type, int dest)
+{
+    int np;
+
+    mpi_comm_size(mpi_comm_world, &np);
+    if (dest < 0 || dest >= np) {
+	return invalid_rank_error(dest);
+    }
+
+    if (type == GRETL_TYPE_BUNDLE || type == GRETL_TYPE_ARRAY) {
+	int done = 0;
+	int err = gretl_packed_send(p, type, dest, &done);
+
+	if (err || done) {
+	    return err;
+	}
+    }
+
+    if (type == GRETL_TYPE_DOUBLE) {
+	return gretl_scalar_send((double *) p, dest);
+    } else if (type == GRETL_TYPE_INT) {
+	return gretl_int_send((int *) p, dest);
+    } else if (type == GRETL_TYPE_MATRIX) {
+	return gretl_matrix_mpi_send((gretl_matrix *) p, dest);
+    } else if (type == GRETL_TYPE_BUNDLE) {
+	return gretl_bundle_send((gretl_bundle *) p, dest);
+    } else if (type == GRETL_TYPE_ARRAY) {
+	return gretl_array_send((gretl_array *) p, dest);
+    } else {
+	return E_DATA;
+    }
+}
+
+gretl_matrix *gretl_matrix_mpi_receive (int source,
+					int *err)
+{
+    gretl_matrix *m = NULL;
+    int rc[MI_LEN];
+
+    *err = mpi_recv(rc, MI_LEN, mpi_int, source, TAG_MATRIX_INFO,
+		    mpi_comm_world, MPI_STATUS_IGNORE);
+
+    if (!*err) {
+	int r = rc[0];
+	int c = rc[1];
+	int cmplx = rc[2];
+	int n = r * c;
+
+	if (cmplx) {
+	    m = gretl_cmatrix_new(r, c);
+	    n *= 2;
+	} else {
+	    m = gretl_matrix_alloc(r, c);
+	}
+
+	if (m == NULL) {
+	    *err = E_ALLOC;
+	    return NULL;
+	} else {
+	    *err = mpi_recv(m->val, n, mpi_double, source,
+			    TAG_MATRIX_VAL, mpi_comm_world,
+			    MPI_STATUS_IGNORE);
+	    if (*err) {
+		maybe_date_matrix(m, rc);
+	    }
+	}
+    }
+
+    if (*err) {
+	gretl_mpi_error(err);
+    }
+
+    return m;
+}
+
+int gretl_matrix_mpi_fill (gretl_matrix **pm, int source)
+{
+    int rc[MI_LEN];
+    int err;
+
+    if (pm == NULL) {
+	return E_DATA;
+    }
+
+    err = mpi_recv(rc, MI_LEN, mpi_int, source, TAG_MATRIX_INFO,
+		   mpi_comm_world, MPI_STATUS_IGNORE);
+
+    if (!err) {
+	gretl_matrix *m = *pm;
+	int r = rc[0];
+	int c = rc[1];
+	int cmplx = rc[2];
+	int n = r * c;
+
+	if (m == NULL) {
+	    if (cmplx) {
+		m = gretl_cmatrix_new(r, c);
+		n *= 2;
+	    } else {
+		m = gretl_matrix_alloc(r, c);
+	    }
+	    if (m == NULL) {
+		err = E_ALLOC;
+	    } else {
+		*pm = m;
+	    }
+	} else if (m->rows != r || m->cols != c ||
+		   m->is_complex != cmplx) {
+	    err = E_NONCONF;
+	}
+
+	if (!err) {
+	    err = mpi_recv(m->val, n, mpi_double, source,
+			   TAG_MATRIX_VAL, mpi_comm_world,
+			   MPI_STATUS_IGNORE);
+	    if (err) {
+		maybe_date_matrix(m, rc);
+	    }
+	}
+    }
+
+    if (err) {
+	gretl_mpi_error(&err);
+    }
+
+    return err;
+}
+
+static int *gretl_list_receive (int source, int *err)
+{
+    int *list = NULL;
+    int n;
+
+    *err = mpi_recv(&n, 1, mpi_int, source, TAG_LIST_LEN,
+		    mpi_comm_world, MPI_STATUS_IGNORE);
+
+    if (!*err) {
+	list = gretl_list_new(n);
+	if (list == NULL) {
+	    *err = E_ALLOC;
+	} else {
+	    *err = mpi_recv(list, n+1, mpi_int, source,
+			    TAG_LIST_VAL, mpi_comm_world,
+			    MPI_STATUS_IGNORE);
+	}
+    }
+
+    return list;
+}
+
+static char *gretl_string_receive (int source, int *err)
+{
+    char *s = NULL;
+    int n;
+
+    *err = mpi_recv(&n, 1, mpi_int, source, TAG_STR_LEN,
+		    mpi_comm_world, MPI_STATUS_IGNORE);
+
+    if (!*err) {
+	s = calloc(n, 1);
+	if (s == NULL) {
+	    *err = E_ALLOC;
+	} else {
+	    *err = mpi_recv(s, n, mpi_byte, source,
+			    TAG_STR_VAL, mpi_comm_world,
+			    MPI_STATUS_IGNORE);
+	}
+    }
+
+    return s;
+}
+
+static double gretl_scalar_receive (int source, int *err)
+{
+    double x = NADBL;
+
+    *err = mpi_recv(&x, 1, mpi_double, source, TAG_SCALAR_VAL,
+		    mpi_comm_world, MPI_STATUS_IGNORE);
+    if (*err) {
+	gretl_mpi_error(err);
+    }
+
+    return x;
+}
+
+static double gretl_int_receive (int source, int *err)
+{
+    int i = 0;
+
+    *err = mpi_recv(&i, 1, mpi_int, source, TAG_INT_VAL,
+		    mpi_comm_world, MPI_STATUS_IGNORE);
+    if (*err) {
+	gretl_mpi_error(err);
+    }
+
+    return i;
+}
+
+static gretl_array *gretl_array_receive (int source, int *err)
+{
+    gretl_array *a = NULL;
+    GretlType type = 0;
+    int nelem = 0;
+    int st[2];
+    int i;
+
+    /* get the array size and type */
+    *err = mpi_recv(st, 2, mpi_int, source, TAG_ARRAY_INFO,
+		    mpi_comm_world, MPI_STATUS_IGNORE);
+
+    if (!*err) {
+	nelem = st[0];
+	type = st[1];
+	a = gretl_array_new(type, nelem, err);
+    }
+
+    for (i=0; i<nelem && !*err; i++) {
+	void *data = NULL;
+
+	if (type == GRETL_TYPE_MATRICES) {
+	    data = gretl_matrix_mpi_receive(source, err);
+	} else if (type == GRETL_TYPE_STRINGS) {
+	    data = gretl_string_receive(source, err);
+	} else if (type == GRETL_TYPE_BUNDLES) {
+	    data = gretl_bundle_receive(source, err);
+	} else if (type == GRETL_TYPE_LISTS) {
+	    data = gretl_list_receive(source, err);
+	} else if (type == GRETL_TYPE_ARRAYS) {
+	    data = gretl_array_receive(source, err);
+	}
+	if (data != NULL) {
+	    gretl_array_set_data(a, i, data);
+	}
+    }
+
+    return a;
+}
+
+static int settle_receives (int source);
+
+int gretl_mpi_receive (int source,
+		       GretlType *ptype,
+		       gretl_matrix **pm,
+		       gretl_bundle **pb,
+		       gretl_array **pa,
+		       double *px,
+		       int *pk)
+{
+    MPI_Status status;
+    int np, err = 0;
+
+    mpi_comm_size(mpi_comm_world, &np);
+    if (source < 0 || source >= np) {
+	return invalid_rank_error(source);
+    }
+
+    /* earlier non-blocking receives from @source come first */
+    err = settle_receives(source);
+    if (err) {
+	return err;
+    }
+
+    /* check for the type of thing of offer from @source */
+    mpi_probe(source, MPI_ANY_TAG, mpi_comm_world, &status);
+
+    if (status.MPI_TAG == TAG_SCALAR_VAL) {
+	*px = gretl_scalar_receive(source, &err);
+	*ptype = GRETL_TYPE_DOUBLE;
+    } else if  (status.MPI_TAG == TAG_INT_VAL) {
+	*pk = gretl_int_receive(source, &err);
+	*ptype = GRETL_TYPE_INT;
+    } else if (status.MPI_TAG == TAG_MATRIX_INFO) {
+	*pm = gretl_matrix_mpi_receive(source, &err);
+	*ptype = GRETL_TYPE_MATRIX;
+    } else if (status.MPI_TAG == TAG_BUNDLE_SIZE) {
+	/* new bundle send/receive form */
+	*pb = gretl_bundle_receive(source, &err);
+	*ptype = GRETL_TYPE_BUNDLE;
+    } else if (status.MPI_TAG == TAG_BUNDLE_BYTES) {
+	/* old bundle send/receive form */
+	*pb = gretl_bundle_receive(source, &err);
+	*ptype = GRETL_TYPE_BUNDLE;
+    } else if (status.MPI_TAG == TAG_ARRAY_INFO) {
+	*pa = gretl_array_receive(source, &err);
+	*ptype = GRETL_TYPE_ARRAY;
+    } else if (status.MPI_TAG == TAG_PACKED_INFO) {
+	/* object in packed form */
+	void *ptr = gretl_packed_receive(source, ptype, &err);
+
+	if (!err) {
+	    packed_result(ptr, *ptype, pm, pb, pa, px, pk);
+	}
+    } else {
+	err = E_DATA;
+    }
+
+    return err;
+}
+
+#if NEW_BUNPASS > 1
+
+/* new-style send/receive for bundles: we do everything
+   in memory */
+
+static int gretl_series_send (double *x, int n, int dest)
+{
+    int err;
+
+    err = mpi_send(&n, 1, mpi_int, dest, TAG_SERIES_LEN,
+		   mpi_comm_world);
+
+    if (!err) {
+	err = mpi_send(x, n, mpi_double, dest, TAG_SERIES_VAL,
+		       mpi_comm_world);
+    }
+
+    if (err) {
+	gretl_mpi_error(&err);
+    }
+
+    return err;
+}
+
+static double *gretl_series_receive (int source, int *err)
+{
+    double *x = NULL;
+    int n;
+
+    *err = mpi_recv(&n, 1, mpi_int, source, TAG_SERIES_LEN,
+		    mpi_comm_world, MPI_STATUS_IGNORE);
+
+    if (!*err) {
+	x = malloc(n * sizeof *x);
+	if (x == NULL) {
+	    *err = E_ALLOC;
+	    return NULL;
+	} else {
+	    *err = mpi_recv(x, n, mpi_double, source,
+			    TAG_SERIES_VAL, mpi_comm_world,
+			    MPI_STATUS_IGNORE);
+	}
+    }
+
+    if (*err) {
+	gretl_mpi_error(err);
+    }
+
+    return x;
+}
+
+static int gretl_bundle_send (gretl_bundle *b, int dest)
+{
+    gretl_array *keys = NULL;
+    GretlType type;
+    void *data;
+    char msgbuf[64];
+    int msglen = sizeof msgbuf;
+    int size;
+    int i, nk;
+    int err = 0;
+
+    nk = gretl_bundle_get_n_keys(b);
+    if (nk > 0) {
+	keys = gretl_bundle_get_keys(b, &err);
+	if (err) {
+	    return err;
+	}
+    }
+
+    /* send the number of keys first */
+    err = mpi_send(&nk, 1, mpi_int, dest, TAG_BUNDLE_SIZE,
 		   mpi_comm_world);
 
-    if (!err) {
-	int n = m->rows * m->cols;
+    if (nk == 0) {
+	/* the bundle is empty */
+	return 0;
+    }
 
-	if (m->is_complex) {
-	    n *= 2;
+    for (i=0; i<nk && !err; i++) {
+	/* loop across bundle keys */
+	const char *key = gretl_array_get_data(keys, i);
+
+	data = gretl_bundle_get_data(b, key, &type, &size, &err);
+	if (!err) {
+	    /* send info on the bundle member */
+	    compose_msgbuf(msgbuf, type, key, &size, data);
+	    err = mpi_send(msgbuf, msglen, mpi_byte, dest,
+			   TAG_BMEMB_INFO, mpi_comm_world);
+	}
+	if (err) {
+	    break;
+	}
+	if (type == GRETL_TYPE_MATRIX) {
+	    err = gretl_matrix_mpi_send(data, dest);
+	} else if (type == GRETL_TYPE_ARRAY) {
+	    err = gretl_array_send(data, dest);
+	} else if (type == GRETL_TYPE_BUNDLE) {
+	    err = gretl_bundle_send(data, dest);
+	} else if (type == GRETL_TYPE_SERIES) {
+	    err = gretl_series_send(data, size, dest);
+	} else if (type == GRETL_TYPE_STRING) {
+	    err = gretl_string_send(data, dest);
+	} else if (type == GRETL_TYPE_LIST) {
+	    err = gretl_list_send(data, dest);
+	} else if (type == GRETL_TYPE_DOUBLE) {
+	    err = gretl_scalar_send(data, dest);
+	} else if (type == GRETL_TYPE_INT) {
+	    err = gretl_int_send(data, dest);
 	}
-	err = mpi_send(m->val, n, mpi_double, dest, TAG_MATRIX_VAL,
-		       mpi_comm_world);
     }
 
+    gretl_array_destroy(keys);
+
     if (err) {
 	gretl_mpi_error(&err);
     }
@@ -1329,104 +2688,112 @@ int gretl_matrix_mpi_send (const gretl_matrix *m, int dest)
     return err;
 }
 
-static int gretl_string_send (char *s, int dest)
+gretl_bundle *gretl_bundle_receive (int source, int *err)
 {
-    int n = strlen(s) + 1;
-    int err;
+    gretl_bundle *b = NULL;
+    char key[32];
+    char msgbuf[64];
+    int msglen = sizeof msgbuf;
+    int size;
+    int i, nk;
 
-    err = mpi_send(&n, 1, mpi_int, dest, TAG_STR_LEN,
-		   mpi_comm_world);
+    /* get the number of keys first */
+    *err = mpi_recv(&nk, 1, mpi_int, source, TAG_BUNDLE_SIZE,
+		    mpi_comm_world, MPI_STATUS_IGNORE);
 
-    if (!err) {
-	err = mpi_send(s, n, mpi_byte, dest, TAG_STR_VAL,
-		       mpi_comm_world);
+    if (!*err) {
+	b = gretl_bundle_new();
+	if (b == NULL) {
+	    *err = E_ALLOC;
+	    return NULL;
+	}
     }
 
-    if (err) {
-	gretl_mpi_error(&err);
+    if (nk == 0) {
+	/* the bundle is empty */
+	return b;
     }
 
-    return err;
-}
-
-static int gretl_list_send (int *list, int dest)
-{
-    int n = list[0];
-    int err;
+    for (i=0; i<nk && !*err; i++) {
+	/* loop across bundle keys */
+	GretlType type = 0;
+	void *data = NULL;
+	double x;
 
-    err = mpi_send(&n, 1, mpi_int, dest, TAG_LIST_LEN,
-		   mpi_comm_world);
+	memset(msgbuf, 0, msglen);
+	size = 0;
 
-    if (!err) {
-	err = mpi_send(list, n+1, mpi_int, dest, TAG_LIST_VAL,
-		       mpi_comm_world);
+	/* get info on bundle member @i */
+	*err = mpi_recv(msgbuf, msglen, mpi_byte, source, TAG_BMEMB_INFO,
+			mpi_comm_world, MPI_STATUS_IGNORE);
+	if (!*err) {
+	    *err = parse_msgbuf(msgbuf, key, &type, &size);
+	}
+	if (*err) {
+	    break;
+	}
+	if (type == GRETL_TYPE_DOUBLE) {
+	    x = gretl_scalar_receive(source, err);
+	    data = &x;
+	} else if (type == GRETL_TYPE_INT) {
+	    x = gretl_int_receive(source, err);
+	    data = &x;
+	} else if (type == GRETL_TYPE_MATRIX) {
+	    data = gretl_matrix_mpi_receive(source, err);
+	} else if (type == GRETL_TYPE_ARRAY) {
+	    data = gretl_array_receive(source, err);
+	} else if (type == GRETL_TYPE_BUNDLE) {
+	    data = gretl_bundle_receive(source, err);
+	} else if (type == GRETL_TYPE_SERIES) {
+	    data = gretl_series_receive(source, err);
+	} else if (type == GRETL_TYPE_LIST) {
+	    data = gretl_list_receive(source, err);
+	} else if (type == GRETL_TYPE_STRING) {
+	    data = gretl_string_receive(source, err);
+	}
+	if (!*err) {
+	    *err = gretl_bundle_donate_data(b, key, data, type, size);
+	}
     }
 
-    if (err) {
-	gretl_mpi_error(&err);
+    if (*err) {
+	gretl_mpi_error(err);
     }
 
-    return err;
+    return b;
 }
 
-static int gretl_scalar_send (double *px, int dest)
-{
-    int err;
-
-    err = mpi_send(px, 1, mpi_double, dest, TAG_SCALAR_VAL,
-		   mpi_comm_world);
-
-    if (err) {
-	gretl_mpi_error(&err);
-    }
+#else
 
-    return err;
-}
+/* old-style send/receive for bundles via XML serialization */
 
-static int gretl_int_send (int *pi, int dest)
+static int gretl_bundle_send (gretl_bundle *b, int dest)
 {
-    int err;
+    char *buf = NULL;
+    int id, bytes = 0;
+    int err = 0;
 
-    err = mpi_send(pi, 1, mpi_int, dest, TAG_INT_VAL,
-		   mpi_comm_world);
+    mpi_comm_rank(mpi_comm_world, &id);
+
+    /* serialize bundle to XML buffer and get size of the
+       buffer in bytes; then send buffer size, followed by
+       the XML bytes if successful */
 
+    buf = gretl_bundle_write_to_buffer(b, id, &bytes, &err);
     if (err) {
-	gretl_mpi_error(&err);
+	return err;
     }
 
-    return err;
-}
-
-static int gretl_array_send (gretl_array *a, int dest)
-{
-    GretlType type = 0;
-    int nelem = 0;
-    int st[2];
-    int i, err = 0;
-
-    st[0] = nelem = gretl_array_get_length(a);
-    st[1] = type = gretl_array_get_type(a);
-
-    /* send the array size and type */
-    err = mpi_send(st, 2, mpi_int, dest, TAG_ARRAY_INFO,
+    err = mpi_send(&bytes, 1, mpi_int, dest, TAG_BUNDLE_BYTES,
 		   mpi_comm_world);
 
-    for (i=0; i<nelem && !err; i++) {
-	void *data = gretl_array_get_data(a, i);
-
-	if (type == GRETL_TYPE_MATRICES) {
-	    err = gretl_matrix_mpi_send(data, dest);
-	} else if (type == GRETL_TYPE_STRINGS) {
-	    err = gretl_string_send(data, dest);
-	} else if (type == GRETL_TYPE_BUNDLES) {
-	    err = gretl_bundle_send(data, dest);
-	} else if (type == GRETL_TYPE_LISTS) {
-	    err = gretl_list_send(data, dest);
-	} else if (type == GRETL_TYPE_ARRAYS) {
-	    err = gretl_array_send(data, dest);
-	}
+    if (!err) {
+	err = mpi_send(buf, bytes, mpi_byte, dest, TAG_BUNDLE_XML,
+		       mpi_comm_world);
     }
 
+    free(buf);
+
     if (err) {
 	gretl_mpi_error(&err);
     }
@@ -1434,685 +2801,873 @@ static int gretl_array_send (gretl_array *a, int dest)
     return err;
 }
 
-/**
- * gretl_mpi_send:
- * @p: pointer to the object to be sent.
- * @type: the type of the object.
- * @dest: the MPI rank of the destination.
- *
- * Sends the value referenced by @p, of gretl type @type, to the
- * MPI process with rank @dest.
- *
- * Returns: 0 on successful completion, non-zero code otherwise.
- **/
-
-int gretl_mpi_send (void *p, GretlType type, int dest)
-{
-    int np;
-
-    mpi_comm_size(mpi_comm_world, &np);
-    if (dest < 0 || dest >= np) {
-	return invalid_rank_error(dest);
-    }
-
-    if (type == GRETL_TYPE_DOUBLE) {
-	return gretl_scalar_send((double *) p, dest);
-    } else if (type == GRETL_TYPE_INT) {
-	return gretl_int_send((int *) p, dest);
-    } else if (type == GRETL_TYPE_MATRIX) {
-	return gretl_matrix_mpi_send((gretl_matrix *) p, dest);
-    } else if (type == GRETL_TYPE_BUNDLE) {
-	return gretl_bundle_send((gretl_bundle *) p, dest);
-    } else if (type == GRETL_TYPE_ARRAY) {
-	return gretl_array_send((gretl_array *) p, dest);
-    } else {
-	return E_DATA;
-    }
-}
-
-gretl_matrix *gretl_matrix_mpi_receive (int source,
-					int *err)
+static gretl_bundle *gretl_bundle_receive (int source,
+					   int *err)
 {
-    gretl_matrix *m = NULL;
-    int rc[MI_LEN];
-
-    *err = mpi_recv(rc, MI_LEN, mpi_int, source, TAG_MATRIX_INFO,
-		    mpi_comm_world, MPI_STATUS_IGNORE);
+    gretl_bundle *b = NULL;
+    int myerr = 0;
+    int bytes = 0;
 
-    if (!*err) {
-	int r = rc[0];
-	int c = rc[1];
-	int cmplx = rc[2];
-	int n = r * c;
+    myerr = mpi_recv(&bytes, 1, mpi_int, source, TAG_BUNDLE_BYTES,
+		     mpi_comm_world, MPI_STATUS_IGNORE);
 
-	if (cmplx) {
-	    m = gretl_cmatrix_new(r, c);
-	    n *= 2;
-	} else {
-	    m = gretl_matrix_alloc(r, c);
-	}
+    if (!myerr && bytes > 0) {
+	char *buf = malloc(bytes);
 
-	if (m == NULL) {
+	if (buf == NULL) {
 	    *err = E_ALLOC;
 	    return NULL;
 	} else {
-	    *err = mpi_recv(m->val, n, mpi_double, source,
-			    TAG_MATRIX_VAL, mpi_comm_world,
-			    MPI_STATUS_IGNORE);
-	    if (*err) {
-		maybe_date_matrix(m, rc);
+	    myerr = mpi_recv(buf, bytes, mpi_byte, source,
+			     TAG_BUNDLE_XML, mpi_comm_world,
+			     MPI_STATUS_IGNORE);
+	    if (!myerr) {
+		b = gretl_bundle_read_from_buffer(buf, bytes, err);
 	    }
+	    free(buf);
 	}
     }
 
-    if (*err) {
-	gretl_mpi_error(err);
+    if (myerr) {
+	gretl_mpi_error(&myerr);
+	*err = myerr;
     }
 
-    return m;
+    return b;
 }
 
-int gretl_matrix_mpi_fill (gretl_matrix **pm, int source)
+#endif /* NEW_BUNPASS > 1 or not */
+
+static void fill_tmp (double * restrict tmp,
+		      const gretl_matrix *m,
+		      int nr, int *offset)
 {
-    int rc[MI_LEN];
-    int err;
+    double x;
+    int imin = *offset;
+    int imax = imin + nr;
+    int i, j, k = 0;
 
-    if (pm == NULL) {
-	return E_DATA;
+    for (j=0; j<m->cols; j++) {
+	for (i=imin; i<imax; i++) {
+	    x = gretl_matrix_get(m, i, j);
+	    tmp[k++] = x;
+	}
     }
 
-    err = mpi_recv(rc, MI_LEN, mpi_int, source, TAG_MATRIX_INFO,
-		   mpi_comm_world, MPI_STATUS_IGNORE);
+    *offset += nr;
+}
 
-    if (!err) {
-	gretl_matrix *m = *pm;
-	int r = rc[0];
-	int c = rc[1];
-	int cmplx = rc[2];
-	int n = r * c;
+static int scatter_to_self (int *rc, double *val,
+			    gretl_matrix **pm)
+{
+    int err = 0;
 
-	if (m == NULL) {
-	    if (cmplx) {
-		m = gretl_cmatrix_new(r, c);
-		n *= 2;
-	    } else {
-		m = gretl_matrix_alloc(r, c);
-	    }
-	    if (m == NULL) {
-		err = E_ALLOC;
-	    } else {
-		*pm = m;
-	    }
-	} else if (m->rows != r || m->cols != c ||
-		   m->is_complex != cmplx) {
-	    err = E_NONCONF;
-	}
+    *pm = gretl_matrix_alloc(rc[0], rc[1]);
 
-	if (!err) {
-	    err = mpi_recv(m->val, n, mpi_double, source,
-			   TAG_MATRIX_VAL, mpi_comm_world,
-			   MPI_STATUS_IGNORE);
-	    if (err) {
-		maybe_date_matrix(m, rc);
-	    }
-	}
-    }
+    if (*pm == NULL) {
+	err = E_ALLOC;
+    } else {
+	size_t n = rc[0] * rc[1] * sizeof *val;
 
-    if (err) {
-	gretl_mpi_error(&err);
+	memcpy((*pm)->val, val, n);
     }
 
     return err;
 }
 
-static int *gretl_list_receive (int source, int *err)
+int gretl_matrix_mpi_scatter (const gretl_matrix *m,
+			      gretl_matrix **recvm,
+			      Gretl_MPI_Op op,
+			      int root)
 {
-    int *list = NULL;
-    int n;
+    double *tmp = NULL;
+    int id, np;
+    int rc[MI_LEN] = {0};
+    int err = 0;
 
-    *err = mpi_recv(&n, 1, mpi_int, source, TAG_LIST_LEN,
-		    mpi_comm_world, MPI_STATUS_IGNORE);
+    mpi_comm_rank(mpi_comm_world, &id);
+    mpi_comm_size(mpi_comm_world, &np);
 
-    if (!*err) {
-	list = gretl_list_new(n);
-	if (list == NULL) {
-	    *err = E_ALLOC;
-	} else {
-	    *err = mpi_recv(list, n+1, mpi_int, source,
-			    TAG_LIST_VAL, mpi_comm_world,
-			    MPI_STATUS_IGNORE);
-	}
+    if (root < 0 || root >= np) {
+	return invalid_rank_error(root);
     }
 
-    return list;
-}
+    if (id == root) {
+	int i, n;
 
-static char *gretl_string_receive (int source, int *err)
-{
-    char *s = NULL;
-    int n;
+	if (op == GRETL_MPI_VSPLIT) {
+	    /* scatter by rows */
+	    int nr = m->rows / np;
+	    int rem = m->rows % np;
+	    int offset = 0;
 
-    *err = mpi_recv(&n, 1, mpi_int, source, TAG_STR_LEN,
-		    mpi_comm_world, MPI_STATUS_IGNORE);
+	    /* we'll need a working buffer */
+	    tmp = malloc(m->cols * (nr + rem) * sizeof *tmp);
+	    if (tmp == NULL) {
+		err = E_ALLOC;
+	    }
 
-    if (!*err) {
-	s = calloc(n, 1);
-	if (s == NULL) {
-	    *err = E_ALLOC;
+	    n = nr * m->cols;
+	    rc[0] = nr;
+	    rc[1] = m->cols;
+
+	    for (i=0; i<np; i++) {
+		if (i == np - 1 && rem > 0) {
+		    rc[0] += rem;
+		    n += m->cols * rem;
+		}
+		fill_tmp(tmp, m, rc[0], &offset);
+		if (i == root) {
+		    err = scatter_to_self(rc, tmp, recvm);
+		} else {
+		    err = mpi_send(rc, MI_LEN, mpi_int, i, TAG_MATRIX_INFO,
+				   mpi_comm_world);
+		    err = mpi_send(tmp, n, mpi_double, i, TAG_MATRIX_VAL,
+				   mpi_comm_world);
+		}
+	    }
 	} else {
-	    *err = mpi_recv(s, n, mpi_byte, source,
-			    TAG_STR_VAL, mpi_comm_world,
-			    MPI_STATUS_IGNORE);
-	}
-    }
+	    /* scatter by columns */
+	    int nc = m->cols / np;
+	    int rem = m->cols % np;
+	    double *val = m->val;
 
-    return s;
-}
+	    n = m->rows * nc;
+	    fill_matrix_info(rc, m);
 
-static double gretl_scalar_receive (int source, int *err)
-{
-    double x = NADBL;
+	    for (i=0; i<np; i++) {
+		if (i == np - 1 && rem > 0) {
+		    rc[1] += rem;
+		    n += m->rows * rem;
+		}
+		if (i == root) {
+		    err = scatter_to_self(rc, val, recvm);
+		} else {
+		    err = mpi_send(rc, MI_LEN, mpi_int, i, TAG_MATRIX_INFO,
+				   mpi_comm_world);
+		    err = mpi_send(val, n, mpi_double, i, TAG_MATRIX_VAL,
+				   mpi_comm_world);
+		}
+		val += n;
+	    }
+	}
+    } else {
+	/* non-root processes get their share-out */
+	*recvm = gretl_matrix_mpi_receive(root, &err);
+    }
 
-    *err = mpi_recv(&x, 1, mpi_double, source, TAG_SCALAR_VAL,
-		    mpi_comm_world, MPI_STATUS_IGNORE);
-    if (*err) {
-	gretl_mpi_error(err);
+    if (id == root) {
+	free(tmp);
     }
 
-    return x;
+    return err;
 }
 
-static double gretl_int_receive (int source, int *err)
+/* Scatter the rows of @m at @root in blocks of uneven size:
+   process i gets the number of rows given by element i of
+   @sizes, which must be a vector of length equal to the number
+   of processes, with elements summing to the number of rows in
+   @m. Only root's @m and @sizes are referenced.
+*/
+
+int gretl_matrix_mpi_scatterv (const gretl_matrix *m,
+			       const gretl_matrix *sizes,
+			       gretl_matrix **recvm,
+			       int root)
 {
-    int i = 0;
+    double *tmp = NULL;
+    int *counts = NULL;
+    int *displs = NULL;
+    int *spec = NULL;
+    int id, np, i, k;
+    int err = 0;
 
-    *err = mpi_recv(&i, 1, mpi_int, source, TAG_INT_VAL,
-		    mpi_comm_world, MPI_STATUS_IGNORE);
-    if (*err) {
-	gretl_mpi_error(err);
-    }
+    *recvm = NULL;
 
-    return i;
-}
+    err = gretl_comm_check(root, &id, &np);
+    if (err) {
+	return err;
+    }
 
-static gretl_array *gretl_array_receive (int source, int *err)
-{
-    gretl_array *a = NULL;
-    GretlType type = 0;
-    int nelem = 0;
-    int st[2];
-    int i;
+    /* @spec holds the row counts, plus the number of columns
+       (or -1 on error at root) in the last place
+    */
+    spec = malloc((3 * np + 1) * sizeof *spec);
+    err = mpi_error_agree(spec == NULL ? E_ALLOC : 0);
+    if (err) {
+	free(spec);
+	return err;
+    }
 
-    /* get the array size and type */
-    *err = mpi_recv(st, 2, mpi_int, source, TAG_ARRAY_INFO,
-		    mpi_comm_world, MPI_STATUS_IGNORE);
+    counts = spec + np + 1;
+    displs = counts + np;
 
-    if (!*err) {
-	nelem = st[0];
-	type = st[1];
-	a = gretl_array_new(type, nelem, err);
-    }
+    if (id == root) {
+	int ntot = 0;
 
-    for (i=0; i<nelem && !*err; i++) {
-	void *data = NULL;
+	if (m == NULL || gretl_vector_get_length(sizes) != np) {
+	    err = E_NONCONF;
+	}
+	for (i=0; i<np && !err; i++) {
+	    double x = sizes->val[i];
 
-	if (type == GRETL_TYPE_MATRICES) {
-	    data = gretl_matrix_mpi_receive(source, err);
-	} else if (type == GRETL_TYPE_STRINGS) {
-	    data = gretl_string_receive(source, err);
-	} else if (type == GRETL_TYPE_BUNDLES) {
-	    data = gretl_bundle_receive(source, err);
-	} else if (type == GRETL_TYPE_LISTS) {
-	    data = gretl_list_receive(source, err);
-	} else if (type == GRETL_TYPE_ARRAYS) {
-	    data = gretl_array_receive(source, err);
+	    if (x < 0 || x != floor(x) || x > m->rows) {
+		err = E_INVARG;
+	    } else {
+		spec[i] = (int) x;
+		ntot += spec[i];
+	    }
 	}
-	if (data != NULL) {
-	    gretl_array_set_data(a, i, data);
+	if (!err && ntot != m->rows) {
+	    err = E_NONCONF;
 	}
+	spec[np] = err ? -1 : m->cols;
     }
 
-    return a;
-}
+    /* let everyone know the row allotments */
+    k = mpi_bcast(spec, np + 1, mpi_int, root, mpi_comm_world);
+    if (k) {
+	gretl_mpi_error(&k);
+	err = k;
+    } else if (spec[np] < 0 && !err) {
+	/* bad input at root */
+	err = E_DATA;
+    }
 
-int gretl_mpi_receive (int source,
-		       GretlType *ptype,
-		       gretl_matrix **pm,
-		       gretl_bundle **pb,
-		       gretl_array **pa,
-		       double *px,
-		       int *pk)
-{
-    MPI_Status status;
-    int np, err = 0;
+    if (err) {
+	free(spec);
+	return err;
+    }
 
-    mpi_comm_size(mpi_comm_world, &np);
-    if (source < 0 || source >= np) {
-	return invalid_rank_error(source);
+    if (id == root) {
+	/* arrange root's matrix as contiguous row blocks */
+	int offset = 0;
+
+	k = 0;
+
+	tmp = malloc(m->rows * m->cols * sizeof *tmp);
+	if (tmp == NULL) {
+	    err = E_ALLOC;
+	}
+	for (i=0; i<np && !err; i++) {
+	    counts[i] = spec[i] * m->cols;
+	    displs[i] = k;
+	    fill_tmp(tmp + k, m, spec[i], &offset);
+	    k += counts[i];
+	}
     }
 
-    /* check for the type of thing of offer from @source */
-    mpi_probe(source, MPI_ANY_TAG, mpi_comm_world, &status);
+    if (!err) {
+	*recvm = gretl_matrix_alloc(spec[id], spec[np]);
+	if (*recvm == NULL) {
+	    err = E_ALLOC;
+	}
+    }
 
-    if (status.MPI_TAG == TAG_SCALAR_VAL) {
-	*px = gretl_scalar_receive(source, &err);
-	*ptype = GRETL_TYPE_DOUBLE;
-    } else if  (status.MPI_TAG == TAG_INT_VAL) {
-	*pk = gretl_int_receive(source, &err);
-	*ptype = GRETL_TYPE_INT;
-    } else if (status.MPI_TAG == TAG_MATRIX_INFO) {
-	*pm = gretl_matrix_mpi_receive(source, &err);
-	*ptype = GRETL_TYPE_MATRIX;
-    } else if (status.MPI_TAG == TAG_BUNDLE_SIZE) {
-	/* new bundle send/receive form */
-	*pb = gretl_bundle_receive(source, &err);
-	*ptype = GRETL_TYPE_BUNDLE;
-    } else if (status.MPI_TAG == TAG_BUNDLE_BYTES) {
-	/* old bundle send/receive form */
-	*pb = gretl_bundle_receive(source, &err);
-	*ptype = GRETL_TYPE_BUNDLE;
-    } else if (status.MPI_TAG == TAG_ARRAY_INFO) {
-	*pa = gretl_array_receive(source, &err);
-	*ptype = GRETL_TYPE_ARRAY;
+    /* make sure that everyone is ready for the scatter */
+    err = mpi_error_agree(err);
+    if (err) {
+	gretl_matrix_free(*recvm);
+	*recvm = NULL;
     } else {
-	err = E_DATA;
+	err = mpi_scatterv(tmp, counts, displs, mpi_double,
+			   (*recvm)->val, spec[id] * spec[np],
+			   mpi_double, root, mpi_comm_world);
+	if (err) {
+	    gretl_mpi_error(&err);
+	}
     }
 
+    free(tmp);
+    free(spec);
+
     return err;
 }
 
-#if NEW_BUNPASS > 1
-
-/* new-style send/receive for bundles: we do everything
-   in memory */
+/* Compute a checksum of the keys, types and dimensions of the
+   members of bundle @b, for comparison across processes.
+*/
 
-static int gretl_series_send (double *x, int n, int dest)
+static guint bundle_signature (gretl_bundle *b, char **S, int n)
 {
-    int err;
+    guint h = n;
+    int i;
 
-    err = mpi_send(&n, 1, mpi_int, dest, TAG_SERIES_LEN,
-		   mpi_comm_world);
+    for (i=0; i<n; i++) {
+	GretlType type = 0;
+	void *data;
 
-    if (!err) {
-	err = mpi_send(x, n, mpi_double, dest, TAG_SERIES_VAL,
-		       mpi_comm_world);
-    }
+	data = gretl_bundle_get_data(b, S[i], &type, NULL, NULL);
+	h = h * 33 + g_str_hash(S[i]);
+	h = h * 33 + type;
+	if (type == GRETL_TYPE_MATRIX) {
+	    gretl_matrix *m = data;
 
-    if (err) {
-	gretl_mpi_error(&err);
+	    h = h * 33 + m->rows;
+	    h = h * 33 + m->cols;
+	}
     }
 
-    return err;
+    return h;
 }
 
-static double *gretl_series_receive (int source, int *err)
+/**
+ * gretl_bundle_mpi_allreduce:
+ * @b: bundle containing matrices and/or scalars.
+ * @op: the reduction operation.
+ *
+ * Reduces each member of @b element-wise over all processes
+ * and replaces its value with the result, in every process.
+ * All members must be real matrices or scalars, and the bundles
+ * must have the same keys and dimensions across processes.
+ * Everything is passed in a single call to MPI_Allreduce.
+ *
+ * Returns: 0 on successful completion, non-zero code otherwise.
+ **/
+
+int gretl_bundle_mpi_allreduce (gretl_bundle *b, Gretl_MPI_Op op)
 {
+    gretl_array *keys = NULL;
+    gretl_array *sorted = NULL;
+    char **S = NULL;
     double *x = NULL;
-    int n;
+    double *y = NULL;
+    int chk[8], cmax[8];
+    MPI_Op mpi_op;
+    int i, k, nk = 0;
+    int n = 0;
+    int err = 0;
 
-    *err = mpi_recv(&n, 1, mpi_int, source, TAG_SERIES_LEN,
-		    mpi_comm_world, MPI_STATUS_IGNORE);
+    if (op == GRETL_MPI_SUM) {
+	mpi_op = mpi_sum;
+    } else if (op == GRETL_MPI_PROD) {
+	mpi_op = mpi_prod;
+    } else if (op == GRETL_MPI_MAX) {
+	mpi_op = mpi_max;
+    } else if (op == GRETL_MPI_MIN) {
+	mpi_op = mpi_min;
+    } else {
+	return E_DATA;
+    }
 
-    if (!*err) {
-	x = malloc(n * sizeof *x);
-	if (x == NULL) {
-	    *err = E_ALLOC;
-	    return NULL;
+    /* we need the keys in the same order everywhere */
+    keys = gretl_bundle_get_keys(b, &err);
+    if (!err) {
+	sorted = gretl_strings_sort(keys, 0, &err);
+    }
+    if (!err) {
+	S = gretl_array_get_strings(sorted, &nk);
+    }
+
+    for (i=0; i<nk && !err; i++) {
+	GretlType type = 0;
+	void *data;
+
+	data = gretl_bundle_get_data(b, S[i], &type, NULL, &err);
+	if (err) {
+	    break;
+	} else if (type == GRETL_TYPE_DOUBLE) {
+	    n++;
+	} else if (type == GRETL_TYPE_MATRIX) {
+	    gretl_matrix *m = data;
+
+	    if (m->is_complex) {
+		err = E_CMPLX;
+	    } else {
+		n += m->rows * m->cols;
+	    }
 	} else {
-	    *err = mpi_recv(x, n, mpi_double, source,
-			    TAG_SERIES_VAL, mpi_comm_world,
-			    MPI_STATUS_IGNORE);
+	    err = E_TYPES;
 	}
     }
 
-    if (*err) {
-	gretl_mpi_error(err);
+    /* Check that the bundles agree across processes: we take
+       the max of each value and its negative, so as to get the
+       max and min in a single call.
+    */
+    chk[0] = nk;
+    chk[1] = n;
+    chk[2] = err ? 0 : (int) (bundle_signature(b, S, nk) & INT_MAX);
+    chk[3] = err ? 1 : 0;
+    for (i=0; i<4; i++) {
+	chk[i+4] = -chk[i];
+    }
+
+    k = mpi_allreduce(chk, cmax, 8, mpi_int, mpi_max, mpi_comm_world);
+    if (k) {
+	gretl_mpi_error(&k);
+	err = k;
+    } else if (!err) {
+	if (cmax[3] > 0) {
+	    /* error on some other process */
+	    err = E_DATA;
+	}
+	for (i=0; i<3 && !err; i++) {
+	    if (cmax[i] != -cmax[i+4]) {
+		err = E_NONCONF;
+	    }
+	}
     }
 
-    return x;
-}
+    if (!err && n > 0) {
+	x = malloc(2 * n * sizeof *x);
+	if (x == NULL) {
+	    err = E_ALLOC;
+	} else {
+	    y = x + n;
+	}
+    }
 
-static int gretl_bundle_send (gretl_bundle *b, int dest)
-{
-    gretl_array *keys = NULL;
-    GretlType type;
-    void *data;
-    char msgbuf[64];
-    int msglen = sizeof msgbuf;
-    int size;
-    int i, nk;
-    int err = 0;
+    if (!err && n > 0) {
+	for (i=0, k=0; i<nk; i++) {
+	    GretlType type = 0;
+	    void *data = gretl_bundle_get_data(b, S[i], &type, NULL, NULL);
 
-    nk = gretl_bundle_get_n_keys(b);
-    if (nk > 0) {
-	keys = gretl_bundle_get_keys(b, &err);
+	    if (type == GRETL_TYPE_DOUBLE) {
+		x[k++] = *(double *) data;
+	    } else {
+		gretl_matrix *m = data;
+		int mn = m->rows * m->cols;
+
+		memcpy(x + k, m->val, mn * sizeof *x);
+		k += mn;
+	    }
+	}
+	err = mpi_allreduce(x, y, n, mpi_double, mpi_op, mpi_comm_world);
 	if (err) {
-	    return err;
+	    gretl_mpi_error(&err);
 	}
     }
 
-    /* send the number of keys first */
-    err = mpi_send(&nk, 1, mpi_int, dest, TAG_BUNDLE_SIZE,
-		   mpi_comm_world);
+    if (!err && n > 0) {
+	for (i=0, k=0; i<nk && !err; i++) {
+	    GretlType type = 0;
+	    void *data = gretl_bundle_get_data(b, S[i], &type, NULL, NULL);
 
-    if (nk == 0) {
-	/* the bundle is empty */
-	return 0;
+	    if (type == GRETL_TYPE_DOUBLE) {
+		err = gretl_bundle_set_scalar(b, S[i], y[k++]);
+	    } else {
+		gretl_matrix *m = data;
+		int mn = m->rows * m->cols;
+
+		memcpy(m->val, y + k, mn * sizeof *y);
+		k += mn;
+	    }
+	}
     }
 
-    for (i=0; i<nk && !err; i++) {
-	/* loop across bundle keys */
-	const char *key = gretl_array_get_data(keys, i);
+    gretl_array_destroy(keys);
+    gretl_array_destroy(sorted);
+    free(x);
 
-	data = gretl_bundle_get_data(b, key, &type, &size, &err);
-	if (!err) {
-	    /* send info on the bundle member */
-	    compose_msgbuf(msgbuf, type, key, &size, data);
-	    err = mpi_send(msgbuf, msglen, mpi_byte, dest,
-			   TAG_BMEMB_INFO, mpi_comm_world);
-	}
-	if (err) {
+    return err;
+}
+
+/* Non-blocking point-to-point transfers. Objects are sent in the
+   packed form used by gretl_packed_send(), so that a call to
+   gretl_mpi_isend() may be matched either by gretl_mpi_irecv()
+   or by a regular gretl_mpi_receive(). Each pending transfer is
+   identified by a positive integer handle, which is released
+   by gretl_mpi_wait().
+*/
+
+typedef struct mpi_pending_ mpi_pending;
+
+struct mpi_pending_ {
+    int recv;          /* receiving (1) or sending (0) */
+    int peer;          /* rank of source or destination */
+    int seq;           /* sequence number, for ordering receives */
+    int stage;         /* 0: awaiting info; 1: data posted; 2: done */
+    int info[2];       /* type and length of packed data */
+    char *buf;         /* packed data */
+    MPI_Request req[2];
+};
+
+static mpi_pending **pending;
+static int n_pending;
+static int pending_seq;
+
+static int invalid_handle_error (int h)
+{
+    gretl_errmsg_sprintf(_("Invalid MPI request handle %d"), h);
+    return E_DATA;
+}
+
+/* Add a pending-transfer record; its handle is the index of
+   the record plus 1.
+*/
+
+static mpi_pending *pending_new (int recv, int peer, int *handle,
+				 int *err)
+{
+    mpi_pending *mp;
+    int i;
+
+    mp = calloc(1, sizeof *mp);
+    if (mp == NULL) {
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    for (i=0; i<n_pending; i++) {
+	if (pending[i] == NULL) {
 	    break;
 	}
-	if (type == GRETL_TYPE_MATRIX) {
-	    err = gretl_matrix_mpi_send(data, dest);
-	} else if (type == GRETL_TYPE_ARRAY) {
-	    err = gretl_array_send(data, dest);
-	} else if (type == GRETL_TYPE_BUNDLE) {
-	    err = gretl_bundle_send(data, dest);
-	} else if (type == GRETL_TYPE_SERIES) {
-	    err = gretl_series_send(data, size, dest);
-	} else if (type == GRETL_TYPE_STRING) {
-	    err = gretl_string_send(data, dest);
-	} else if (type == GRETL_TYPE_LIST) {
-	    err = gretl_list_send(data, dest);
-	} else if (type == GRETL_TYPE_DOUBLE) {
-	    err = gretl_scalar_send(data, dest);
-	} else if (type == GRETL_TYPE_INT) {
-	    err = gretl_int_send(data, dest);
+    }
+
+    if (i == n_pending) {
+	mpi_pending **pp = realloc(pending, (i + 1) * sizeof *pp);
+
+	if (pp == NULL) {
+	    free(mp);
+	    *err = E_ALLOC;
+	    return NULL;
 	}
+	pending = pp;
+	n_pending++;
     }
 
-    gretl_array_destroy(keys);
+    mp->recv = recv;
+    mp->peer = peer;
+    mp->seq = ++pending_seq;
+    pending[i] = mp;
+    *handle = i + 1;
 
-    if (err) {
-	gretl_mpi_error(&err);
+    return mp;
+}
+
+static mpi_pending *pending_get (int h, int *err)
+{
+    if (h < 1 || h > n_pending || pending[h-1] == NULL) {
+	*err = invalid_handle_error(h);
+	return NULL;
+    } else {
+	return pending[h-1];
     }
+}
 
-    return err;
+static void pending_free (int h)
+{
+    mpi_pending *mp = pending[h-1];
+
+    free(mp->buf);
+    free(mp);
+    pending[h-1] = NULL;
 }
 
-gretl_bundle *gretl_bundle_receive (int source, int *err)
+/**
+ * gretl_mpi_isend:
+ * @p: pointer to the object to be sent.
+ * @type: the type of the object.
+ * @dest: the MPI rank of the destination.
+ * @err: location to receive error code.
+ *
+ * Starts sending the value referenced by @p, of gretl type @type,
+ * to the MPI process with rank @dest, without waiting for the
+ * transfer to complete. The type may be %GRETL_TYPE_MATRIX,
+ * %GRETL_TYPE_BUNDLE, %GRETL_TYPE_ARRAY or %GRETL_TYPE_DOUBLE.
+ * The value is copied, so the caller may go on to modify it.
+ *
+ * Returns: a handle to be passed to gretl_mpi_test() or
+ * gretl_mpi_wait(), or 0 on failure.
+ **/
+
+int gretl_mpi_isend (void *p, GretlType type, int dest, int *err)
 {
-    gretl_bundle *b = NULL;
-    char key[32];
-    char msgbuf[64];
-    int msglen = sizeof msgbuf;
-    int size;
-    int i, nk;
+    mpi_pending *mp = NULL;
+    char *buf = NULL;
+    gint64 n = 0;
+    int np, h = 0;
 
-    /* get the number of keys first */
-    *err = mpi_recv(&nk, 1, mpi_int, source, TAG_BUNDLE_SIZE,
-		    mpi_comm_world, MPI_STATUS_IGNORE);
+    mpi_comm_size(mpi_comm_world, &np);
+    if (dest < 0 || dest >= np) {
+	*err = invalid_rank_error(dest);
+	return 0;
+    }
 
-    if (!*err) {
-	b = gretl_bundle_new();
-	if (b == NULL) {
-	    *err = E_ALLOC;
-	    return NULL;
-	}
+    buf = pack_for_mpi(type, p, &n, err);
+    if (!*err && n > INT_MAX) {
+	gretl_errmsg_set(_("Object is too large for MPI transfer"));
+	*err = E_DATA;
     }
 
-    if (nk == 0) {
-	/* the bundle is empty */
-	return b;
+    if (!*err) {
+	mp = pending_new(0, dest, &h, err);
     }
 
-    for (i=0; i<nk && !*err; i++) {
-	/* loop across bundle keys */
-	GretlType type = 0;
-	void *data = NULL;
-	double x;
+    if (*err) {
+	free(buf);
+	return 0;
+    }
 
-	memset(msgbuf, 0, msglen);
-	size = 0;
+    mp->info[0] = type;
+    mp->info[1] = n;
+    mp->buf = buf;
 
-	/* get info on bundle member @i */
-	*err = mpi_recv(msgbuf, msglen, mpi_byte, source, TAG_BMEMB_INFO,
-			mpi_comm_world, MPI_STATUS_IGNORE);
-	if (!*err) {
-	    *err = parse_msgbuf(msgbuf, key, &type, &size);
-	}
+    *err = mpi_isend(mp->info, 2, mpi_int, dest, TAG_PACKED_INFO,
+		     mpi_comm_world, &mp->req[0]);
+    if (!*err) {
+	*err = mpi_isend(mp->buf, n, mpi_byte, dest, TAG_PACKED_DATA,
+			 mpi_comm_world, &mp->req[1]);
 	if (*err) {
-	    break;
-	}
-	if (type == GRETL_TYPE_DOUBLE) {
-	    x = gretl_scalar_receive(source, err);
-	    data = &x;
-	} else if (type == GRETL_TYPE_INT) {
-	    x = gretl_int_receive(source, err);
-	    data = &x;
-	} else if (type == GRETL_TYPE_MATRIX) {
-	    data = gretl_matrix_mpi_receive(source, err);
-	} else if (type == GRETL_TYPE_ARRAY) {
-	    data = gretl_array_receive(source, err);
-	} else if (type == GRETL_TYPE_BUNDLE) {
-	    data = gretl_bundle_receive(source, err);
-	} else if (type == GRETL_TYPE_SERIES) {
-	    data = gretl_series_receive(source, err);
-	} else if (type == GRETL_TYPE_LIST) {
-	    data = gretl_list_receive(source, err);
-	} else if (type == GRETL_TYPE_STRING) {
-	    data = gretl_string_receive(source, err);
-	}
-	if (!*err) {
-	    *err = gretl_bundle_donate_data(b, key, data, type, size);
+	    /* the info message is in flight, referencing mp->info:
+	       withdraw it (or let it complete) before freeing */
+	    mpi_cancel(&mp->req[0]);
+	    mpi_wait(&mp->req[0], MPI_STATUS_IGNORE);
 	}
     }
 
     if (*err) {
 	gretl_mpi_error(err);
+	pending_free(h);
+	h = 0;
+    } else {
+	mp->stage = 1;
     }
 
-    return b;
+    return h;
 }
 
-#else
-
-/* old-style send/receive for bundles via XML serialization */
+/**
+ * gretl_mpi_irecv:
+ * @source: the MPI rank of the source.
+ * @err: location to receive error code.
+ *
+ * Registers a request to receive an object sent by the process
+ * with rank @source via gretl_mpi_isend(). Receives from a given
+ * source are matched to messages in the order in which they
+ * were requested. A subsequent blocking receive from @source,
+ * via gretl_mpi_receive(), gets the message following those
+ * claimed by any such receives that are still outstanding.
+ *
+ * Returns: a handle to be passed to gretl_mpi_test() or
+ * gretl_mpi_wait(), or 0 on failure.
+ **/
 
-static int gretl_bundle_send (gretl_bundle *b, int dest)
+int gretl_mpi_irecv (int source, int *err)
 {
-    char *buf = NULL;
-    int id, bytes = 0;
-    int err = 0;
+    int np, h = 0;
 
-    mpi_comm_rank(mpi_comm_world, &id);
+    mpi_comm_size(mpi_comm_world, &np);
+    if (source < 0 || source >= np) {
+	*err = invalid_rank_error(source);
+    } else {
+	pending_new(1, source, &h, err);
+    }
 
-    /* serialize bundle to XML buffer and get size of the
-       buffer in bytes; then send buffer size, followed by
-       the XML bytes if successful */
+    return h;
+}
 
-    buf = gretl_bundle_write_to_buffer(b, id, &bytes, &err);
-    if (err) {
-	return err;
-    }
+/* Once the info message for receive @mp is available, read it
+   and post a non-blocking receive for the data. If @block is
+   non-zero we wait for the info message, otherwise we just
+   check whether it has arrived. Returns 1 if the data receive
+   has been posted.
+*/
 
-    err = mpi_send(&bytes, 1, mpi_int, dest, TAG_BUNDLE_BYTES,
-		   mpi_comm_world);
+static int recv_post_data (mpi_pending *mp, int block, int *err)
+{
+    int flag = block;
 
-    if (!err) {
-	err = mpi_send(buf, bytes, mpi_byte, dest, TAG_BUNDLE_XML,
-		       mpi_comm_world);
+    if (mp->stage > 0) {
+	return 1;
     }
 
-    free(buf);
+    if (!block) {
+	*err = mpi_iprobe(mp->peer, TAG_PACKED_INFO, mpi_comm_world,
+			  &flag, MPI_STATUS_IGNORE);
+    }
 
-    if (err) {
-	gretl_mpi_error(&err);
+    if (!*err && flag) {
+	*err = mpi_recv(mp->info, 2, mpi_int, mp->peer, TAG_PACKED_INFO,
+			mpi_comm_world, MPI_STATUS_IGNORE);
+	if (*err) {
+	    gretl_mpi_error(err);
+	} else {
+	    mp->buf = packed_buffer_new(mp->info, err);
+	}
+	if (!*err) {
+	    *err = mpi_irecv(mp->buf, mp->info[1], mpi_byte, mp->peer,
+			     TAG_PACKED_DATA, mpi_comm_world, &mp->req[1]);
+	    if (*err) {
+		gretl_mpi_error(err);
+	    } else {
+		mp->stage = 1;
+	    }
+	}
+    } else if (*err) {
+	gretl_mpi_error(err);
     }
 
-    return err;
+    return mp->stage > 0;
 }
 
-static gretl_bundle *gretl_bundle_receive (int source,
-					   int *err)
-{
-    gretl_bundle *b = NULL;
-    int myerr = 0;
-    int bytes = 0;
+/* Advance all receives from the source of @targ, up to and
+   including @targ itself, in the order in which they were
+   requested. Since MPI does not allow messages from a given
+   source to overtake one another, this ensures that each
+   receive gets the message intended for it.
+*/
 
-    myerr = mpi_recv(&bytes, 1, mpi_int, source, TAG_BUNDLE_BYTES,
-		     mpi_comm_world, MPI_STATUS_IGNORE);
+static int advance_receives (mpi_pending *targ, int block, int *err)
+{
+    while (!*err && targ->stage == 0) {
+	mpi_pending *mp = NULL;
+	int i;
 
-    if (!myerr && bytes > 0) {
-	char *buf = malloc(bytes);
+	for (i=0; i<n_pending; i++) {
+	    mpi_pending *pi = pending[i];
 
-	if (buf == NULL) {
-	    *err = E_ALLOC;
-	    return NULL;
-	} else {
-	    myerr = mpi_recv(buf, bytes, mpi_byte, source,
-			     TAG_BUNDLE_XML, mpi_comm_world,
-			     MPI_STATUS_IGNORE);
-	    if (!myerr) {
-		b = gretl_bundle_read_from_buffer(buf, bytes, err);
+	    if (pi != NULL && pi->recv && pi->stage == 0 &&
+		pi->peer == targ->peer && pi->seq <= targ->seq &&
+		(mp == NULL || pi->seq < mp->seq)) {
+		mp = pi;
 	    }
-	    free(buf);
+	}
+	if (!recv_post_data(mp, block, err)) {
+	    break;
 	}
     }
 
-    if (myerr) {
-	gretl_mpi_error(&myerr);
-	*err = myerr;
-    }
-
-    return b;
+    return targ->stage > 0;
 }
 
-#endif /* NEW_BUNPASS > 1 or not */
+/* Called before a blocking receive from @source: wait for the
+   info messages for any outstanding non-blocking receives from
+   @source and post their data receives, so that the blocking
+   receive cannot pick up a message that was intended for one of
+   them.
+*/
 
-static void fill_tmp (double * restrict tmp,
-		      const gretl_matrix *m,
-		      int nr, int *offset)
+static int settle_receives (int source)
 {
-    double x;
-    int imin = *offset;
-    int imax = imin + nr;
-    int i, j, k = 0;
+    mpi_pending *last = NULL;
+    int i, err = 0;
 
-    for (j=0; j<m->cols; j++) {
-	for (i=imin; i<imax; i++) {
-	    x = gretl_matrix_get(m, i, j);
-	    tmp[k++] = x;
+    for (i=0; i<n_pending; i++) {
+	mpi_pending *pi = pending[i];
+
+	if (pi != NULL && pi->recv && pi->stage == 0 &&
+	    pi->peer == source && (last == NULL || pi->seq > last->seq)) {
+	    last = pi;
 	}
     }
 
-    *offset += nr;
+    if (last != NULL) {
+	advance_receives(last, 1, &err);
+    }
+
+    return err;
 }
 
-static int scatter_to_self (int *rc, double *val,
-			    gretl_matrix **pm)
+/**
+ * gretl_mpi_test:
+ * @handle: handle obtained via gretl_mpi_isend() or
+ * gretl_mpi_irecv().
+ * @err: location to receive error code.
+ *
+ * Checks, without blocking, whether the transfer identified by
+ * @handle is complete.
+ *
+ * Returns: 1 if the transfer is complete, otherwise 0.
+ **/
+
+int gretl_mpi_test (int handle, int *err)
 {
-    int err = 0;
+    mpi_pending *mp = pending_get(handle, err);
+    int flag = 0;
 
-    *pm = gretl_matrix_alloc(rc[0], rc[1]);
+    if (mp == NULL || mp->stage == 2) {
+	return mp != NULL;
+    }
 
-    if (*pm == NULL) {
-	err = E_ALLOC;
+    if (mp->recv) {
+	if (!advance_receives(mp, 0, err)) {
+	    return 0;
+	}
+	*err = mpi_test(&mp->req[1], &flag, MPI_STATUS_IGNORE);
     } else {
-	size_t n = rc[0] * rc[1] * sizeof *val;
+	*err = mpi_test(&mp->req[0], &flag, MPI_STATUS_IGNORE);
+	if (!*err && flag) {
+	    *err = mpi_test(&mp->req[1], &flag, MPI_STATUS_IGNORE);
+	}
+    }
 
-	memcpy((*pm)->val, val, n);
+    if (*err) {
+	gretl_mpi_error(err);
+	flag = 0;
+    } else if (flag) {
+	mp->stage = 2;
     }
 
-    return err;
+    return flag;
 }
 
-int gretl_matrix_mpi_scatter (const gretl_matrix *m,
-			      gretl_matrix **recvm,
-			      Gretl_MPI_Op op,
-			      int root)
+/**
+ * gretl_mpi_wait:
+ * @handle: handle obtained via gretl_mpi_isend() or
+ * gretl_mpi_irecv().
+ * @type: location to receive the type of the object received.
+ * @pm: location to receive matrix.
+ * @pb: location to receive bundle.
+ * @pa: location to receive array.
+ * @px: location to receive scalar.
+ * @pk: location to receive integer.
+ *
+ * Waits for the transfer identified by @handle to complete, then
+ * releases the handle. In the case of a receive the object is
+ * handed over as in gretl_mpi_receive(); in the case of a send
+ * @type is set to %GRETL_TYPE_NONE.
+ *
+ * Returns: 0 on successful completion, non-zero code otherwise.
+ **/
+
+int gretl_mpi_wait (int handle,
+		    GretlType *type,
+		    gretl_matrix **pm,
+		    gretl_bundle **pb,
+		    gretl_array **pa,
+		    double *px,
+		    int *pk)
 {
-    double *tmp = NULL;
-    int id, np;
-    int rc[MI_LEN] = {0};
+    mpi_pending *mp;
     int err = 0;
 
-    mpi_comm_rank(mpi_comm_world, &id);
-    mpi_comm_size(mpi_comm_world, &np);
-
-    if (root < 0 || root >= np) {
-	return invalid_rank_error(root);
+    mp = pending_get(handle, &err);
+    if (mp == NULL) {
+	return err;
     }
 
-    if (id == root) {
-	int i, n;
-
-	if (op == GRETL_MPI_VSPLIT) {
-	    /* scatter by rows */
-	    int nr = m->rows / np;
-	    int rem = m->rows % np;
-	    int offset = 0;
-
-	    /* we'll need a working buffer */
-	    tmp = malloc(m->cols * (nr + rem) * sizeof *tmp);
-	    if (tmp == NULL) {
-		err = E_ALLOC;
-	    }
-
-	    n = nr * m->cols;
-	    rc[0] = nr;
-	    rc[1] = m->cols;
+    *type = GRETL_TYPE_NONE;
 
-	    for (i=0; i<np; i++) {
-		if (i == np - 1 && rem > 0) {
-		    rc[0] += rem;
-		    n += m->cols * rem;
-		}
-		fill_tmp(tmp, m, rc[0], &offset);
-		if (i == root) {
-		    err = scatter_to_self(rc, tmp, recvm);
-		} else {
-		    err = mpi_send(rc, MI_LEN, mpi_int, i, TAG_MATRIX_INFO,
-				   mpi_comm_world);
-		    err = mpi_send(tmp, n, mpi_double, i, TAG_MATRIX_VAL,
-				   mpi_comm_world);
-		}
+    if (mp->recv) {
+	advance_receives(mp, 1, &err);
+	if (!err && mp->stage < 2) {
+	    err = mpi_wait(&mp->req[1], MPI_STATUS_IGNORE);
+	    if (err) {
+		gretl_mpi_error(&err);
 	    }
-	} else {
-	    /* scatter by columns */
-	    int nc = m->cols / np;
-	    int rem = m->cols % np;
-	    double *val = m->val;
-
-	    n = m->rows * nc;
-	    fill_matrix_info(rc, m);
+	}
+	if (!err) {
+	    void *ptr;
 
-	    for (i=0; i<np; i++) {
-		if (i == np - 1 && rem > 0) {
-		    rc[1] += rem;
-		    n += m->rows * rem;
-		}
-		if (i == root) {
-		    err = scatter_to_self(rc, val, recvm);
-		} else {
-		    err = mpi_send(rc, MI_LEN, mpi_int, i, TAG_MATRIX_INFO,
-				   mpi_comm_world);
-		    err = mpi_send(val, n, mpi_double, i, TAG_MATRIX_VAL,
-				   mpi_comm_world);
-		}
-		val += n;
+	    ptr = unpack_object(mp->buf, mp->info[1], mp->info[0], &err);
+	    if (!err) {
+		*type = mp->info[0];
+		packed_result(ptr, *type, pm, pb, pa, px, pk);
 	    }
 	}
-    } else {
-	/* non-root processes get their share-out */
-	*recvm = gretl_matrix_mpi_receive(root, &err);
+    } else if (mp->stage < 2) {
+	err = mpi_wait(&mp->req[0], MPI_STATUS_IGNORE);
+	if (!err) {
+	    err = mpi_wait(&mp->req[1], MPI_STATUS_IGNORE);
+	}
+	if (err) {
+	    gretl_mpi_error(&err);
+	}
     }
 
-    if (id == root) {
-	free(tmp);
-    }
+    pending_free(handle);
 
     return err;
 }
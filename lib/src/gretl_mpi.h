@@ -69,11 +69,18 @@ int gretl_matrix_mpi_scatter (const gretl_matrix *m,
 			      Gretl_MPI_Op op,
 			      int root);
 
+int gretl_matrix_mpi_scatterv (const gretl_matrix *m,
+			       const gretl_matrix *sizes,
+			       gretl_matrix **recvm,
+			       int root);
+
 int gretl_array_mpi_reduce (gretl_array *sa,
 			    gretl_array **pa,
 			    Gretl_MPI_Op op,
 			    int root);
 
+int gretl_bundle_mpi_allreduce (gretl_bundle *b, Gretl_MPI_Op op);
+
 int gretl_mpi_receive (int source,
 		       GretlType *type,
 		       gretl_matrix **pm,
@@ -82,6 +89,20 @@ int gretl_mpi_receive (int source,
 		       double *px,
 		       int *pk);
 
+int gretl_mpi_isend (void *p, GretlType type, int dest, int *err);
+
+int gretl_mpi_irecv (int source, int *err);
+
+int gretl_mpi_test (int handle, int *err);
+
+int gretl_mpi_wait (int handle,
+		    GretlType *type,
+		    gretl_matrix **pm,
+		    gretl_bundle **pb,
+		    gretl_array **pa,
+		    double *px,
+		    int *pk);
+
 void gretl_mpi_stopwatch_init (void);
 
 double gretl_mpi_stopwatch (void);
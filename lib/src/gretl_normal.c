@@ -119,55 +119,50 @@ double invmills (double x)
 
 #if GENZ_BVN
 
-/**
- * genz04:
- * @rho: correlation coefficient.
- * @limx: abscissa value, first Gaussian r.v.
- * @limy: abscissa value, second Gaussian r.v.
- *
- * Based on FORTRAN code by Alan Genz, with minor adaptations.
- * Original source at 
- * http://www.math.wsu.edu/faculty/genz/software/fort77/tvpack.f
- * No apparent license.
- *
- * The algorithm is from Drezner and Wesolowsky (1989), 'On the
- * Computation of the Bivariate Normal Integral', Journal of
- * Statist. Comput. Simul. 35 pp. 101-107, with major modifications
- * for double precision, and for |R| close to 1.
- *
- * Returns: for (x, y) a bivariate standard Normal rv with correlation
- * coefficient @rho, the joint probability that (x < @limx) and (y < @limy),
- * or #NADBL on failure.
- */
+/* Quantities used by genz04() that depend only on the correlation
+   coefficient: these are computed once, so that the cost of
+   evaluating the CDF at many points for a given correlation is
+   mostly down to calls to exp().
+*/
 
-static double genz04 (double rho, double limx, double limy)
+typedef struct bvn_consts_ {
+    double rho;     /* correlation coefficient */
+    int lg;         /* number of Gauss-Legendre points */
+    double w[10];   /* Gauss-Legendre weights */
+    double asr;     /* asin(rho) */
+    double sn[20];  /* sines at the nodes, for |rho| < 0.925 */
+    double as;      /* 1 - rho^2 */
+    double a;       /* sqrt(1 - rho^2) */
+    double xs[20];  /* squared nodes, for |rho| >= 0.925 */
+    double rs[20];  /* sqrt(1 - xs) */
+} bvn_consts;
+
+static void genz04_setup (bvn_consts *c, double rho)
 {
-    double w[10], x[10];
+    double x[10];
     double absrho = fabs(rho);
-    double h, k, hk, bvn, hs, asr;
-    double a, b, as, d1, bs, c, d, tmp;
-    double sn, xs, rs;
-    int i, lg, j;
+    double d1;
+    int i, j, k;
 
     if (absrho < 0.3) {
 
-	w[0] = .1713244923791705;
-	w[1] = .3607615730481384;
-	w[2] = .4679139345726904;
+	c->w[0] = .1713244923791705;
+	c->w[1] = .3607615730481384;
+	c->w[2] = .4679139345726904;
 
 	x[0] = -.9324695142031522;
 	x[1] = -.6612093864662647;
 	x[2] = -.238619186083197;
 
-	lg = 3;
+	c->lg = 3;
     } else if (absrho < 0.75) {
 
-	w[0] = .04717533638651177;
-	w[1] = .1069393259953183;
-	w[2] = .1600783285433464;
-	w[3] = .2031674267230659;
-	w[4] = .2334925365383547;
-	w[5] = .2491470458134029;
+	c->w[0] = .04717533638651177;
+	c->w[1] = .1069393259953183;
+	c->w[2] = .1600783285433464;
+	c->w[3] = .2031674267230659;
+	c->w[4] = .2334925365383547;
+	c->w[5] = .2491470458134029;
 
 	x[0] = -.9815606342467191;
 	x[1] = -.904117256370475;
@@ -176,19 +171,19 @@ static double genz04 (double rho, double limx, double limy)
 	x[4] = -.3678314989981802;
 	x[5] = -.1252334085114692;
 
-	lg = 6;
+	c->lg = 6;
     } else {
 
-	w[0] = .01761400713915212;
-	w[1] = .04060142980038694;
-	w[2] = .06267204833410906;
-	w[3] = .08327674157670475;
-	w[4] = .1019301198172404;
-	w[5] = .1181945319615184;
-	w[6] = .1316886384491766;
-	w[7] = .1420961093183821;
-	w[8] = .1491729864726037;
-	w[9] = .1527533871307259;
+	c->w[0] = .01761400713915212;
+	c->w[1] = .04060142980038694;
+	c->w[2] = .06267204833410906;
+	c->w[3] = .08327674157670475;
+	c->w[4] = .1019301198172404;
+	c->w[5] = .1181945319615184;
+	c->w[6] = .1316886384491766;
+	c->w[7] = .1420961093183821;
+	c->w[8] = .1491729864726037;
+	c->w[9] = .1527533871307259;
 
 	x[0] = -.9931285991850949;
 	x[1] = -.9639719272779138;
@@ -201,24 +196,59 @@ static double genz04 (double rho, double limx, double limy)
 	x[8] = -.2277858511416451;
 	x[9] = -.07652652113349733;
 
-	lg = 10;
+	c->lg = 10;
     }
 
+    c->rho = rho;
+    c->as = (1 - rho) * (1 + rho);
+    c->a = sqrt(c->as);
+
+    k = 0;
+    if (absrho < 0.925) {
+	c->asr = asin(rho);
+	for (i=0; i<c->lg; i++) {
+	    for (j=0; j<=1; j++) {
+		c->sn[k++] = sin(c->asr * (1 + (2*j-1)*x[i]) / 2);
+	    }
+	}
+    } else {
+	for (i=0; i<c->lg; i++) {
+	    for (j=0; j<=1; j++) {
+		d1 = c->a / 2 * (1 + (2*j-1)*x[i]);
+		c->xs[k] = d1 * d1;
+		c->rs[k] = sqrt(1 - c->xs[k]);
+		k++;
+	    }
+	}
+    }
+}
+
+/* Evaluate the CDF at (@limx, @limy) given the constants in @c,
+   or for the negative of the correlation in @c if @neg is
+   non-zero.
+*/
+
+static double genz04_eval (const bvn_consts *c, int neg,
+			   double limx, double limy)
+{
+    double rho = neg ? -c->rho : c->rho;
+    double h, k, hk, bvn, hs, asr, sn;
+    double a, b, as, d1, bs, cc, d, tmp;
+    int i, lg = c->lg;
+
     h = -limx;
     k = -limy;
     hk = h * k;
     bvn = 0.0;
 
-    if (absrho < 0.925) {
+    if (fabs(rho) < 0.925) {
 	hs = (h * h + k * k) / 2;
-	asr = asin(rho);
-	for (i=0; i<lg; i++) {
-	    for (j=0; j<=1; j++) {
-		sn = sin(asr * (1 + (2*j-1)*x[i]) / 2);
-		bvn += w[i] * exp((sn * hk - hs) / (1 - sn * sn));
-	    }
+	asr = neg ? -c->asr : c->asr;
+	for (i=0; i<2*lg; i++) {
+	    sn = neg ? -c->sn[i] : c->sn[i];
+	    bvn += c->w[i/2] * exp((sn * hk - hs) / (1 - sn * sn));
 	}
-	bvn = bvn * asr / (2 * M_2PI); 
+	bvn = bvn * asr / (2 * M_2PI);
 
 	d1 = -h;
 	bvn += normal_cdf(d1) * normal_cdf(-k);
@@ -228,15 +258,15 @@ static double genz04 (double rho, double limx, double limy)
 	    hk = -hk;
 	}
 
-	as = (1 - rho) * (1 + rho);
-	a = sqrt(as);
+	as = c->as;
+	a = c->a;
 	bs = (h - k) * (h - k);
-	c = (4 - hk) / 8;
+	cc = (4 - hk) / 8;
 	d = (12 - hk) / 16;
 	asr = -(bs / as + hk) / 2;
 	if (asr > -100.0) {
-	    bvn = a * exp(asr) * (1 - c * (bs - as) * (1 - d * bs / 5)
-				  / 3 + c * d * as * as / 5);
+	    bvn = a * exp(asr) * (1 - cc * (bs - as) * (1 - d * bs / 5)
+				  / 3 + cc * d * as * as / 5);
 	}
 
 	if (-hk < 100.0) {
@@ -250,27 +280,22 @@ static double genz04 (double rho, double limx, double limy)
 	      normal_cdf in the left tail?
 	    */
 	    if (d1 > -12.0) {
-		bvn -= exp(-hk / 2) * SQRT_2_PI * normal_cdf(d1) * b * 
-		    (1 - c * bs * (1 - d * bs / 5) / 3);
+		bvn -= exp(-hk / 2) * SQRT_2_PI * normal_cdf(d1) * b *
+		    (1 - cc * bs * (1 - d * bs / 5) / 3);
 	    }
 	}
 
 	a /= 2;
 
-	for (i=0; i<lg; i++) {
-	    for (j=0; j<=1; j++) {
-		d1 = a * (1 + (2*j-1)*x[i]);
-		xs = d1 * d1;
-		rs = sqrt(1 - xs);
-		asr = -(bs / xs + hk) / 2;
-		if (asr > -100.0) {
-		    tmp = exp(-hk * (1 - rs) / ((rs + 1) * 2)) / 
-			rs - (c * xs * (d * xs + 1) + 1);
-		    bvn += a * w[i] * exp(asr) * tmp;
-		}
+	for (i=0; i<2*lg; i++) {
+	    asr = -(bs / c->xs[i] + hk) / 2;
+	    if (asr > -100.0) {
+		tmp = exp(-hk * (1 - c->rs[i]) / ((c->rs[i] + 1) * 2)) /
+		    c->rs[i] - (cc * c->xs[i] * (d * c->xs[i] + 1) + 1);
+		bvn += a * c->w[i/2] * exp(asr) * tmp;
 	    }
 	}
-	
+
 	bvn = -bvn / M_2PI;
 
 	if (rho > 0.0) {
@@ -287,6 +312,36 @@ static double genz04 (double rho, double limx, double limy)
     return (bvn < 0) ? 0 : bvn;
 }
 
+/**
+ * genz04:
+ * @rho: correlation coefficient.
+ * @limx: abscissa value, first Gaussian r.v.
+ * @limy: abscissa value, second Gaussian r.v.
+ *
+ * Based on FORTRAN code by Alan Genz, with minor adaptations.
+ * Original source at 
+ * http://www.math.wsu.edu/faculty/genz/software/fort77/tvpack.f
+ * No apparent license.
+ *
+ * The algorithm is from Drezner and Wesolowsky (1989), 'On the
+ * Computation of the Bivariate Normal Integral', Journal of
+ * Statist. Comput. Simul. 35 pp. 101-107, with major modifications
+ * for double precision, and for |R| close to 1.
+ *
+ * Returns: for (x, y) a bivariate standard Normal rv with correlation
+ * coefficient @rho, the joint probability that (x < @limx) and (y < @limy),
+ * or #NADBL on failure.
+ */
+
+static double genz04 (double rho, double limx, double limy)
+{
+    bvn_consts c;
+
+    genz04_setup(&c, rho);
+
+    return genz04_eval(&c, 0, limx, limy);
+}
+
 #else
 
 /**
@@ -358,6 +413,27 @@ static double drezner78 (double rho, double a, double b)
 
 #endif /* bvnorm variants */
 
+/* If @a and/or @b is infinite, write the joint probability to
+   @P and return 1; the algorithms above are not designed to
+   cope with such values. Otherwise return 0.
+*/
+
+static int bvnorm_infinite (double a, double b, double *P)
+{
+    if ((isinf(a) && a < 0) || (isinf(b) && b < 0)) {
+	*P = 0.0;
+    } else if (isinf(a)) {
+	/* just the marginal for b (which may be +inf too) */
+	*P = normal_cdf(b);
+    } else if (isinf(b)) {
+	*P = normal_cdf(a);
+    } else {
+	return 0;
+    }
+
+    return 1;
+}
+
 /**
  * bvnorm_cdf:
  * @rho: correlation coefficient.
@@ -371,10 +447,16 @@ static double drezner78 (double rho, double a, double b)
 
 double bvnorm_cdf (double rho, double a, double b)
 {
+    double P;
+
     if (fabs(rho) > 1) {
 	return NADBL;
     }	
 
+    if (bvnorm_infinite(a, b, &P)) {
+	return P;
+    }
+
     if (rho == 0.0) {
 	/* joint prob is just the product of the marginals */
 	return normal_cdf(a) * normal_cdf(b);
@@ -399,6 +481,72 @@ double bvnorm_cdf (double rho, double a, double b)
 #endif
 }
 
+/* rough cost of a bivariate normal CDF evaluation, in units
+   comparable with the OpenMP threshold */
+#define BVN_COST 40
+
+/**
+ * bvnorm_cdf_array:
+ * @rho: correlation coefficient.
+ * @a: array of abscissa values, first Gaussian r.v.
+ * @b: array of abscissa values, second Gaussian r.v.
+ * @neg: array of flags, or NULL.
+ * @P: array to receive the probabilities.
+ * @n: number of elements in the arrays.
+ *
+ * Computes bvnorm_cdf() for @n pairs of abscissae. The work that
+ * depends only on the correlation is done just once, and if the
+ * problem is large enough the evaluations are shared out among
+ * OpenMP threads. If @neg is non-NULL the correlation for the
+ * i-th pair is taken to be -@rho wherever @neg[i] is non-zero.
+ * Where @a[i] or @b[i] is NaN (missing), @P[i] is set to #NADBL;
+ * infinite values are valid, as in bvnorm_cdf().
+ *
+ * Returns: 0 on success, or E_INVARG if @rho is out of bounds.
+ */
+
+int bvnorm_cdf_array (double rho, const double *a, const double *b,
+		      const char *neg, double *P, int n)
+{
+    int i;
+
+    if (fabs(rho) > 1) {
+	return E_INVARG;
+    }
+
+#if GENZ_BVN
+    if (rho != 0.0 && fabs(rho) < 1.0) {
+	bvn_consts c;
+
+	genz04_setup(&c, rho);
+
+#if defined(_OPENMP) && !defined(OS_OSX)
+#pragma omp parallel for if (libset_use_openmp((guint64) n * BVN_COST))
+#endif
+	for (i=0; i<n; i++) {
+	    if (isnan(a[i]) || isnan(b[i])) {
+		P[i] = NADBL;
+	    } else if (!bvnorm_infinite(a[i], b[i], &P[i])) {
+		P[i] = genz04_eval(&c, neg != NULL && neg[i], a[i], b[i]);
+	    }
+	}
+	return 0;
+    }
+#endif
+
+    for (i=0; i<n; i++) {
+	if (isnan(a[i]) || isnan(b[i])) {
+	    P[i] = NADBL;
+	} else if (neg != NULL && neg[i]) {
+	    P[i] = bvnorm_cdf(-rho, a[i], b[i]);
+	} else {
+	    P[i] = bvnorm_cdf(rho, a[i], b[i]);
+	}
+    }
+
+    return 0;
+}
+
 /* next: GHK apparatus with various helper functions */
 
 #define GHK_DEBUG 0
@@ -699,304 +847,282 @@ gretl_matrix *gretl_GHK (const gretl_matrix *C,
     return P;
 }
 
-/* below: revised version of GHK (plus score) */
+/* below: revised version of GHK (plus score)
 
-static void scaled_convex_combo (gretl_matrix *targ, double w,
-				 const gretl_matrix *m1,
-				 const gretl_matrix *m2,
-				 double scale)
-{
-    int i, n = gretl_vector_get_length(targ);
-    double x1, x2;
+   For the derivatives we work with the parameters ordered by
+   row of the problem: a[0], b[0], C[0,0], then a[1], b[1],
+   C[1,0], C[1,1], and so on. In that ordering the simulated
+   draw for dimension j, and the weight accumulated up to that
+   point, depend only on a leading block of the parameters, of
+   length (j+1)(j+6)/2, so the derivative calculations can be
+   confined to that block. The results are transcribed into the
+   ordering of the output matrix at the end.
+*/
 
-    for (i=0; i<n; i++) {
-	x1 = m1->val[i] * scale;
-	x2 = m2->val[i] * scale;
-	targ->val[i] = x2 - w * (x2 - x1);
-    }
-}
+/* offset of the parameters for row @j in the working order */
+#define ghk_row_offset(j) ((j) * ((j) + 5) / 2)
+
+/* Fill @map, which gives the column of the output matrix
+   corresponding to each parameter in the working order: the
+   output order is a, then b, then the column-wise vech of C.
+*/
 
-static void combo_2 (gretl_matrix *targ,
-		     double w1, const gretl_matrix *m1,
-		     double w2, const gretl_matrix *m2)
+static void ghk_param_map (int *map, int m)
 {
-    int i, n = gretl_vector_get_length(targ);
+    int i, j, k = 0;
 
-    for (i=0; i<n; i++) {
-	targ->val[i] = w1 * m1->val[i] + w2 * m2->val[i];
+    for (j=0; j<m; j++) {
+	map[k++] = j;
+	map[k++] = m + j;
+	for (i=0; i<=j; i++) {
+	    /* C[j,i], lower triangle, column-major */
+	    map[k++] = 2*m + i*m - i*(i+1)/2 + j;
+	}
     }
 }
 
-static void vector_copy_mul (gretl_matrix *targ,
-			     const gretl_matrix *src,
-			     double w)
+/* Workspace for a single thread: the bounds at the current
+   observation, the simulated draws and their derivatives, plus
+   derivative vectors for the conditional mean, the two bounds
+   and the weight, and an accumulator.
+*/
+
+typedef struct ghk_work_ {
+    double *a, *b;   /* bounds, m each */
+    double *TT;      /* draws, m */
+    double *dTT;     /* derivatives of draws, m x npar */
+    double *dm;      /* derivative of conditional mean, npar */
+    double *dTA;     /* derivative of lower probability, npar */
+    double *dTB;     /* derivative of upper probability, npar */
+    double *dWT;     /* derivative of weight, npar */
+    double *g;       /* sum of dWT over draws, npar */
+} ghk_work;
+
+static size_t ghk_work_size (int m, int npar)
 {
-    int i, n = gretl_vector_get_length(targ);
+    return 3 * m + (m + 5) * (size_t) npar;
+}
 
-    for (i=0; i<n; i++) {
-	targ->val[i] = w * src->val[i];
-    }
+static void ghk_work_init (ghk_work *w, double *x, int m, int npar)
+{
+    w->a = x;
+    w->b = w->a + m;
+    w->TT = w->b + m;
+    w->dTT = w->TT + m;
+    w->dm = w->dTT + m * npar;
+    w->dTA = w->dm + npar;
+    w->dTB = w->dTA + npar;
+    w->dWT = w->dTB + npar;
+    w->g = w->dWT + npar;
 }
 
-/* New-style GHK computation for observation t, iteration j,
-   including the derivatives.
+/* GHK computation for a single draw @u at the observation whose
+   bounds are in @w, including the derivatives of the weight,
+   which are written into w->dWT in the working order.
 */
 
-static double ghk_tj (const gretl_matrix *C,
-		      const gretl_matrix *a,
-		      const gretl_matrix *b,
-		      const double *u,
-		      gretl_matrix *dWT,
-		      gretl_matrix_block *Bk,
-		      double huge,
-		      int *err)
+static double ghk_draw (const gretl_matrix *C, const double *u,
+			ghk_work *w, int npar, double huge)
 {
     double phi_min = 1.0e-300;
-    gretl_matrix *dTA = NULL;
-    gretl_matrix *dTB = NULL;
-    gretl_matrix *dm = NULL;
-    gretl_matrix *dx = NULL;
-    gretl_matrix *tmp = NULL;
-    gretl_matrix *cj = NULL;
-    gretl_matrix *TT = NULL;
-    gretl_matrix *dTT = NULL;
+    const double *a = w->a;
+    const double *b = w->b;
+    double *TT = w->TT;
+    double *dm = w->dm;
+    double *dTA = w->dTA;
+    double *dTB = w->dTB;
+    double *dWT = w->dWT;
+    double *dTj, *dTi;
     double TA, TB, Tdiff, WT;
-    double z, x, fx, den;
+    double z, x, fx, den, mj, cji;
     int m = C->rows;
-    int npar = m + m + m*(m+1)/2;
-    int inicol, j, i;
-
-    dTA = gretl_matrix_block_get_matrix(Bk, 0);
-    dTB = gretl_matrix_block_get_matrix(Bk, 1);
-    dm  = gretl_matrix_block_get_matrix(Bk, 2);
-    dx  = gretl_matrix_block_get_matrix(Bk, 3);
-    tmp = gretl_matrix_block_get_matrix(Bk, 4);
-    cj  = gretl_matrix_block_get_matrix(Bk, 5);
-    TT  = gretl_matrix_block_get_matrix(Bk, 6);
-    dTT = gretl_matrix_block_get_matrix(Bk, 7);
-
-    gretl_matrix_block_zero(Bk);
+    int i, j, p, nj, off;
+
+    /* row 0: parameters a[0], b[0], C[0,0] */
     den = C->val[0];
-    gretl_matrix_reuse(dTT, npar, 1);
+    dTA[0] = dTA[1] = dTA[2] = 0.0;
+    dTB[0] = dTB[1] = dTB[2] = 0.0;
 
-    if (a->val[0] == -huge) {
+    if (a[0] == -huge) {
 	TA = 0.0;
     } else {
-	z = a->val[0] / den;
+	z = a[0] / den;
 	TA = normal_cdf(z);
-	dTA->val[0] = normal_pdf(z) / den;
-	dTA->val[2*m] = -normal_pdf(z) * z/den;
+	dTA[0] = normal_pdf(z) / den;
+	dTA[2] = -normal_pdf(z) * z/den;
     }
 
-    if (b->val[0] == huge) {
+    if (b[0] == huge) {
 	TB = 1.0;
     } else {
-	z = b->val[0] / den;
+	z = b[0] / den;
 	TB = normal_cdf(z);
-	dTB->val[m] = normal_pdf(z) / den;
-	dTB->val[2*m] = -normal_pdf(z) * z/den;
+	dTB[1] = normal_pdf(z) / den;
+	dTB[2] = -normal_pdf(z) * z/den;
     }
 
     WT = TB - TA;
     x = TB - u[0] * WT;
-    TT->val[0] = normal_cdf_inverse(x);
-
-    fx = normal_pdf(TT->val[0]);
-    scaled_convex_combo(dTT, u[0], dTA, dTB, 1/fx);
-    vector_diff(dWT, dTB, dTA);
+    TT[0] = normal_cdf_inverse(x);
+    fx = normal_pdf(TT[0]);
 
-    /* first column of the gradient which refers to C */
-    inicol = 2*m + 1;
+    for (p=0; p<3; p++) {
+	w->dTT[p] = (dTB[p] - u[0] * (dTB[p] - dTA[p])) / fx;
+	dWT[p] = dTB[p] - dTA[p];
+    }
 
     for (j=1; j<m; j++) {
-	double mj = 0.0;
-	int k = 0, flip = 0;
-
-	/* the "flip" switch implements a numerical trick
-	   that's needed to achieve acceptable precision when a[i]
-	   is large: in that case, we flip the signs of a and b
-	   so to exploit the greater accuracy of ndtr in the left-hand
-	   tail than in the right-hand one.
-	*/
+	int flip = 0;
 
-	gretl_matrix_reuse(TT, j, 1);
-	gretl_matrix_reuse(cj, 1, j);
+	off = ghk_row_offset(j);
+	nj = ghk_row_offset(j+1);
+	dTj = w->dTT + j * npar;
 
+	/* conditional mean and its derivative */
+	mj = 0.0;
+	for (p=0; p<nj; p++) {
+	    dm[p] = 0.0;
+	}
 	for (i=0; i<j; i++) {
-	    cj->val[i] = gretl_matrix_get(C, j, i);
-	    mj += cj->val[i] * TT->val[i];
+	    cji = gretl_matrix_get(C, j, i);
+	    mj += cji * TT[i];
+	    dTi = w->dTT + i * npar;
+	    for (p=0; p<ghk_row_offset(i+1); p++) {
+		dm[p] += cji * dTi[p];
+	    }
+	    dm[off+2+i] += TT[i];
 	}
 
-	gretl_matrix_zero(dx);
-	gretl_matrix_zero(dm);
-
-	for (i=inicol; i<=inicol+j-1; i++) {
-	    dm->val[i] = TT->val[k++];
-	}
-	/* don't do threaded multiplication under an OMP thread */
-	gretl_matrix_multiply_mod_single(cj, GRETL_MOD_NONE,
-					 dTT, GRETL_MOD_TRANSPOSE,
-					 tmp, GRETL_MOD_NONE);
-	gretl_matrix_add_to(dm, tmp);
+	den = gretl_matrix_get(C, j, j);
 
-        den = gretl_matrix_get(C, j, j);
+	/* the "flip" switch implements a numerical trick that's
+	   needed to achieve acceptable precision when a[j] is
+	   large: in that case, we flip the signs of a and b so as
+	   to exploit the greater accuracy of ndtr in the left-hand
+	   tail than in the right-hand one.
+	*/
 
-	x = (a->val[j] - mj) / den;
+	x = (a[j] - mj) / den;
 	if (x <= -huge) {
-            TA = 0.0;
-	    gretl_matrix_zero(dTA);
-	} else {	    
+	    TA = 0.0;
+	    for (p=0; p<nj; p++) {
+		dTA[p] = 0.0;
+	    }
+	} else {
 	    if (x > 8.0) {
-#if GHK_DEBUG
-		fprintf(stderr, "x=%.3f, flipping!\n", x);
-#endif
 		flip = 1;
 		TA = normal_cdf(-x);
 	    } else {
 		TA = normal_cdf(x);
 	    }
-	    fx = normal_pdf(x);
-	    dx->val[j] = 1;
-	    vector_subtract(dx, dm);
-	    dx->val[inicol+j] -= x;
-	    vector_copy_mul(dTA, dx, fx/den);
+	    fx = normal_pdf(x) / den;
+	    for (p=0; p<nj; p++) {
+		dTA[p] = -fx * dm[p];
+	    }
+	    dTA[off] += fx;
+	    dTA[off+2+j] -= fx * x;
 	}
-	
-	gretl_matrix_zero(dx);
-
-	x = (b->val[j] - mj) / den;
- 	if (x >= huge) {
-            TB = flip ? 0.0 : 1.0;
-	    gretl_matrix_zero(dTB);
-	} else {	    
+
+	x = (b[j] - mj) / den;
+	if (x >= huge) {
+	    TB = flip ? 0.0 : 1.0;
+	    for (p=0; p<nj; p++) {
+		dTB[p] = 0.0;
+	    }
+	} else {
 	    TB = normal_cdf(flip ? -x : x);
-	    fx = normal_pdf(x);
-	    dx->val[m+j] = 1;
-	    vector_subtract(dx, dm);
-	    dx->val[inicol+j] -= x;
-	    vector_copy_mul(dTB, dx, fx/den);
+	    fx = normal_pdf(x) / den;
+	    for (p=0; p<nj; p++) {
+		dTB[p] = -fx * dm[p];
+	    }
+	    dTB[off+1] += fx;
+	    dTB[off+2+j] -= fx * x;
 	}
 
 	if (flip) {
 	    Tdiff = TA - TB;
 	    x = TA - u[j] * Tdiff;
-	    TT->val[j] = -normal_cdf_inverse(x);
+	    TT[j] = -normal_cdf_inverse(x);
 	} else {
 	    Tdiff = TB - TA;
 	    x = TB - u[j] * Tdiff;
-	    TT->val[j] = normal_cdf_inverse(x);
+	    TT[j] = normal_cdf_inverse(x);
 	}
 
-	if (na(TT->val[j])) {
+	if (na(TT[j])) {
+#if GHK_DEBUG
 	    fprintf(stderr, "TT is NA at j=%d (x=%g)\n", j, x);
-	    fprintf(stderr, " (TA=%.16g, TB=%.16g, u[j]=%g)\n", TA, TB, u[j]);
+#endif
 	    fx = 0.0;
 	} else {
-	    fx = normal_pdf(TT->val[j]);
+	    fx = normal_pdf(TT[j]);
 	}
 
+	/* derivative of the draw: note that when flipping, the
+	   draw is in effect based on 1 - u[j] rather than u[j]
+	*/
 	if (fx < phi_min) {
-	    fprintf(stderr, "uh-oh, phi=%g\n", fx);
-	    gretl_matrix_zero(tmp);	    
+	    for (p=0; p<nj; p++) {
+		dTj[p] = 0.0;
+	    }
+	} else if (flip) {
+	    for (p=0; p<nj; p++) {
+		dTj[p] = (dTA[p] + u[j] * (dTB[p] - dTA[p])) / fx;
+	    }
 	} else {
-	    scaled_convex_combo(tmp, u[j], dTA, dTB, 1/fx);
+	    for (p=0; p<nj; p++) {
+		dTj[p] = (dTB[p] - u[j] * (dTB[p] - dTA[p])) / fx;
+	    }
+	}
+
+	/* derivative of the product of the weights */
+	for (p=0; p<off; p++) {
+	    dWT[p] = WT * (dTB[p] - dTA[p]) + Tdiff * dWT[p];
+	}
+	for (p=off; p<nj; p++) {
+	    dWT[p] = WT * (dTB[p] - dTA[p]);
 	}
-	gretl_matrix_reuse(dTT, npar, j+1);
-	gretl_matrix_inscribe_matrix(dTT, tmp, 0, j, GRETL_MOD_TRANSPOSE);
-	vector_diff(tmp, dTB, dTA);
-	combo_2(dWT, WT, tmp, Tdiff, dWT);
 
 	if (WT > 0) {
 	    WT *= Tdiff; /* accumulate weight */
 	}
-
-        inicol += j+1;
     }
 
     return WT;
 }
 
-/* This function translates column positions
-   for the derivatives of elements of C from the
-   "horizontal vech" into the "proper vech"
-*/
+/* GHK probability for observation @t, averaging over the columns
+   of @U, with the derivatives written into row @t of @dP */
 
-static int *column_indices (int m)
+static double ghk_obs (const gretl_matrix *C,
+		       const gretl_matrix *U,
+		       ghk_work *w, const int *map,
+		       gretl_matrix *dP, int t,
+		       double huge)
 {
-    int i, j, k = 0;
-    int *ndx;
+    int m = C->rows;
+    int r = U->cols;
+    int npar = dP->cols;
+    double P = 0.0;
+    int j, p;
 
-    ndx = malloc((m * (m+1))/2 * sizeof *ndx);
-    if (ndx == NULL) {
-	return ndx;
+    for (p=0; p<npar; p++) {
+	w->g[p] = 0.0;
     }
 
-    for (i=0; i<m; i++) {
-	for (j=0; j<=i; j++) {
-	    ndx[k++] = j*(j+1)/2 + j*(m-j-1) + i;
+    for (j=0; j<r; j++) {
+	/* Monte Carlo iterations, using successive columns of U */
+	P += ghk_draw(C, U->val + j * m, w, npar, huge);
+	for (p=0; p<npar; p++) {
+	    w->g[p] += w->dWT[p];
 	}
     }
 
-    return ndx;
-}
-
-static int reorder_dP (gretl_matrix *dP, int m)
-{
-    int nc = dP->cols - 2*m;
-    gretl_matrix *tmp;
-    int *ndx;
-    double xij;
-    int i, j, k;
-
-    ndx = column_indices(m);
-    if (ndx == NULL) {
-	return E_ALLOC;
+    for (p=0; p<npar; p++) {
+	gretl_matrix_set(dP, t, map[p], w->g[p] / r);
     }
 
-    tmp = gretl_matrix_alloc(dP->rows, nc);
-    if (tmp == NULL) {
-	free(ndx);
-	return E_ALLOC;
-    }
-
-    gretl_matrix_extract_matrix(tmp, dP, 0, 2*m, GRETL_MOD_NONE);
-
-    /* the first and last two elements of the
-       vech never have to be moved */
-
-    for (j=2; j<nc-2; j++) {
-	if (ndx[j] != j) {
-	    k = ndx[j] + 2*m;
-	    for (i=0; i<dP->rows; i++) {
-		xij = gretl_matrix_get(tmp, i, j);
-		gretl_matrix_set(dP, i, k, xij);
-	    }
-	}
-    }
-
-    gretl_matrix_free(tmp);
-    free(ndx);
-
-    return 0;
-}
-
-/* workspace for ghk_tj */
-
-static gretl_matrix_block *ghk_block_alloc (int m, int npar)
-{
-    gretl_matrix_block *B = NULL;
-    gretl_matrix *M[8] = {NULL};
-
-    B = gretl_matrix_block_new(&M[0], 1, npar, /* dTA */
-			       &M[1], 1, npar, /* dTB */
-			       &M[2], 1, npar, /* dm */
-			       &M[3], 1, npar, /* dx */
-			       &M[4], 1, npar, /* tmp */
-			       &M[5], 1, m,    /* cj */
-			       &M[6], m, 1,    /* TT */
-			       &M[7], npar, m, /* dTT */
-			       NULL);
-    return B;
+    return P / r;
 }
 
 /* GHK including calculation of derivative */
@@ -1008,18 +1134,14 @@ gretl_matrix *gretl_GHK2 (const gretl_matrix *C,
 			  gretl_matrix *dP,
 			  int *err)
 {
-#ifdef GHK_OMP
-    unsigned sz = 0;
-#endif
-    gretl_matrix_block *Bk;
-    gretl_matrix_block *Bk2;
-    gretl_matrix *a, *b;
     gretl_matrix *P = NULL;
-    gretl_matrix *dpj = NULL;
-    const double *uj;
+    double *wspace = NULL;
+    int *map = NULL;
+    size_t wsize;
     int r, n, m, npar;
+    int nt = 1, badt;
     double huge;
-    int t, i, j;
+    int t, i;
 
     if (gretl_is_null_matrix(dP)) {
 	*err = E_DATA;
@@ -1036,110 +1158,94 @@ gretl_matrix *gretl_GHK2 (const gretl_matrix *C,
     m = C->rows;
     npar = m + m + m*(m+1)/2;
 
+#ifdef GHK_OMP
+    if (n >= 2 && (double) n * m * r > OMP_GHK_MIN) {
+	nt = get_omp_n_threads();
+	if (nt > n) {
+	    nt = n;
+	}
+    }
+#endif
+
     P = gretl_zero_matrix_new(n, 1);
-    if (P == NULL) {
+    wsize = ghk_work_size(m, npar);
+    wspace = malloc(nt * wsize * sizeof *wspace);
+    map = malloc(npar * sizeof *map);
+
+    if (P == NULL || wspace == NULL || map == NULL) {
+	gretl_matrix_free(P);
+	free(wspace);
+	free(map);
 	*err = E_ALLOC;
 	return NULL;
     }
 
+    ghk_param_map(map, m);
     gretl_matrix_zero(dP);
-
-#ifdef GHK_OMP
-    if (n >= 2) {
-	sz = n * m * r;
-    }
-#endif
-
     huge = libset_get_double(CONV_HUGE);
+    badt = n;
+
     set_cephes_hush(1);
 
 #ifdef GHK_OMP
-#pragma omp parallel if (sz>OMP_GHK_MIN) private(i,j,t,a,b,uj,Bk,Bk2,dpj)
+#pragma omp parallel for private(i) num_threads(nt) reduction(min:badt)
 #endif
-    {
-	Bk = gretl_matrix_block_new(&a, 1, m,
-				    &b, 1, m,
-				    NULL);
-	if (Bk == NULL) {
-	    *err = E_ALLOC;
-	}
-	Bk2 = ghk_block_alloc(m, npar);
-	if (Bk2 == NULL) {
-	    *err = E_ALLOC;
-	}
-	dpj = gretl_matrix_alloc(1, npar);
-	if (dpj == NULL) {
-	    *err = E_ALLOC;
-	}
-	if (*err) {
-	    goto calc_end;
-	}
+    for (t=0; t<n; t++) {
+	/* loop across observations */
+	ghk_work w;
+	int tid = 0;
+	int err_t = 0;
 
 #ifdef GHK_OMP
-#pragma omp for
+	tid = omp_get_thread_num();
 #endif
-	for (t=0; t<n; t++) {
-	    /* loop across observations */
-	    int err_t = 0;
-
-	    for (i=0; i<m; i++) {
-		/* transcribe and check bounds at current obs */
-		a->val[i] = gretl_matrix_get(A, t, i);
-		b->val[i] = gretl_matrix_get(B, t, i);
-		if (isnan(a->val[i]) || isnan(b->val[i])) {
-		    err_t = E_MISSDATA;
-		    break;
-		} else if (b->val[i] < a->val[i]) {
-		    *err = err_t = E_DATA;
-		    break;
-		}
+	ghk_work_init(&w, wspace + tid * wsize, m, npar);
+
+	for (i=0; i<m; i++) {
+	    /* transcribe and check bounds at current obs */
+	    w.a[i] = gretl_matrix_get(A, t, i);
+	    w.b[i] = gretl_matrix_get(B, t, i);
+	    if (isnan(w.a[i]) || isnan(w.b[i])) {
+		err_t = E_MISSDATA;
+		break;
+	    } else if (w.b[i] < w.a[i]) {
+		err_t = E_DATA;
+		break;
 	    }
+	}
 
-	    if (err_t == E_DATA) {
-		gretl_errmsg_sprintf("ghk: inconsistent bounds: B[%d,%d] < A[%d,%d]",
-				     t+1, i+1, t+1, i+1);
-	    } else if (err_t == E_MISSDATA) {
-		P->val[t] = 0.0/0.0; /* NaN */
-		for (i=0; i<npar; i++) {
-		    gretl_matrix_set(dP, t, i, 0.0/0.0);
-		}
+	if (err_t == E_DATA) {
+	    if (t < badt) {
+		badt = t;
 	    }
-
-	    if (!err_t) {
-		for (j=0; j<r && !*err; j++) {
-		    /* Monte Carlo iterations, using successive columns of U */
-		    uj = U->val + j * m;
-		    P->val[t] += ghk_tj(C, a, b, uj, dpj, Bk2, huge, err);
-		    gretl_matrix_inscribe_matrix(dP, dpj, t, 0, GRETL_MOD_CUMULATE);
-		}
+	} else if (err_t == E_MISSDATA) {
+	    P->val[t] = 0.0/0.0; /* NaN */
+	    for (i=0; i<npar; i++) {
+		gretl_matrix_set(dP, t, i, 0.0/0.0);
 	    }
+	} else {
+	    P->val[t] = ghk_obs(C, U, &w, map, dP, t, huge);
 	}
-
-    calc_end:
-	gretl_matrix_block_destroy(Bk);
-	gretl_matrix_block_destroy(Bk2);
-	gretl_matrix_free(dpj);
-    } /* end (possibly) parallel section */
+    }
 
     set_cephes_hush(0);
 
-    if (*err) {
-	gretl_matrix_free(P);
-	P = NULL;
-    } else {
-	double x;
-
-	for (t=0; t<n; t++) {
-	    P->val[t] /= r;
-	    for (i=0; i<npar; i++) {
-		x = gretl_matrix_get(dP, t, i);
-		gretl_matrix_set(dP, t, i, x / r);
+    if (badt < n) {
+	/* report the first observation with inconsistent bounds */
+	for (i=0; i<m; i++) {
+	    if (gretl_matrix_get(B, badt, i) < gretl_matrix_get(A, badt, i)) {
+		break;
 	    }
 	}
-	if (m > 2) {
-	    reorder_dP(dP, m);
-	}
+	gretl_errmsg_sprintf("ghk: inconsistent bounds: B[%d,%d] < A[%d,%d]",
+			     badt+1, i+1, badt+1, i+1);
+	*err = E_DATA;
+	gretl_matrix_free(P);
+	P = NULL;
     }
 
+    free(wspace);
+    free(map);
+
     return P;
 }
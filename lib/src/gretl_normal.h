@@ -24,6 +24,9 @@ double invmills (double x);
 
 double bvnorm_cdf (double rho, double a, double b);
 
+int bvnorm_cdf_array (double rho, const double *a, const double *b,
+		      const char *neg, double *P, int n);
+
 gretl_matrix *gretl_GHK (const gretl_matrix *C,
 			 const gretl_matrix *A,
 			 const gretl_matrix *B,
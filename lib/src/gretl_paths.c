@@ -204,12 +204,15 @@ int using_translated_helpfile (int id)
 /* If @fname does not already have suffix @sfx, add it.
    With the qualification that if the @fname bears either of
    the standard gretl data-file suffixes, ".gdt" or ".gdtb",
-   we won't stick the other one onto the end.
+   we won't stick the other one onto the end (and similarly
+   for ".gdtc").
 */
 
 static int maybe_add_suffix (char *fname, const char *sfx)
 {
-    if (has_suffix(fname, ".gdtb") && !strcmp(sfx, ".gdt")) {
+    if (has_suffix(fname, ".gdtc") && !strcmp(sfx, ".gdt")) {
+	return 0;
+    } else if (has_suffix(fname, ".gdtb") && !strcmp(sfx, ".gdt")) {
 	return 0;
     } else if (has_suffix(fname, ".gdt") && !strcmp(sfx, ".gdtb")) {
 	return 0;
@@ -3091,6 +3091,11 @@ void rset_add_results (gretl_restriction *rset,
     rset->lnl = lnl;
 }
 
+void rset_set_pvalue (gretl_restriction *rset, double pval)
+{
+    rset->pval = pval;
+}
+
 void rset_record_LR_result (gretl_restriction *rset)
 {
     record_LR_test_result(rset->test, rset->pval, rset->lnl);
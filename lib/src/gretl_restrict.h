@@ -95,6 +95,8 @@ void rset_add_results (gretl_restriction *rset,
 		       double test, double pval,
 		       double lnl);
 
+void rset_set_pvalue (gretl_restriction *rset, double pval);
+
 void rset_record_LR_result (gretl_restriction *rset);
 
 #endif /* GRETL_RESTRICT_H */
@@ -28,6 +28,7 @@
 #include "dbread.h"
 #include "swap_bytes.h"
 #include "gretl_zip.h"
+#include "libset.h"
 
 #ifdef HAVE_MPI
 # include "gretl_mpi.h"
@@ -38,6 +39,8 @@
 # include <glib/gstdio.h>
 #endif
 
+#include <libxml/xmlreader.h>
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -1948,6 +1951,15 @@ static PRN *open_gdt_write_stream (const char *fname,
     return prn;
 }
 
+/* Is @fname a zipfile holding XML plus binary data? That is,
+   either the .gdtb format or its chunked successor, .gdtc.
+*/
+
+static int is_zipped_gdt (const char *fname)
+{
+    return has_suffix(fname, ".gdtb") || has_suffix(fname, ".gdtc");
+}
+
 #define BIN_HDRLEN 24
 
 static int write_binary_header (FILE *fp)
@@ -2085,268 +2097,1072 @@ static int write_binary_data (const char *fname, const DATASET *dset,
     return err;
 }
 
-static void gdt_swap_endianness (DATASET *dset)
+/* Apparatus for the chunked, compressed binary payload used in
+   .gdtc files. Each series is divided into chunks of at most
+   GDTC_CHUNK_ROWS observations; each chunk is encoded as narrowly
+   as its values allow, byte-shuffled (so that bytes of equal
+   significance are adjacent) and deflated. A directory recording
+   the offset, size, encoding and summary statistics of every chunk
+   follows the header, so that a reader can seek straight to the
+   series it wants; the reader also checks each decoded chunk against
+   its recorded NA count, minimum and maximum. All data are written
+   in native byte order, as recorded in the header, and byte-swapped
+   on reading if need be.
+*/
+
+#define GDTC_CHUNK_ROWS 65536
+
+enum {
+    GDTC_DOUBLE, /* 8-byte doubles */
+    GDTC_INT32,  /* integer values, NA as INT32_MIN */
+    GDTC_UINT8,  /* integers in [0, 254], NA as 255 */
+    GDTC_CONST   /* no payload: all NA, or all equal to min */
+};
+
+#define GDTC_DEFLATED 0x80 /* flag: payload is zlib-compressed */
+
+#define GDTC_NA8  255
+#define GDTC_NA32 G_MININT
+
+typedef struct gdtc_chunk_ gdtc_chunk;
+
+struct gdtc_chunk_ {
+    guint64 offset; /* offset of payload from start of file */
+    guint32 size;   /* bytes of payload as stored */
+    gint32 n_na;    /* number of NAs in chunk */
+    double min;     /* minimum of non-missing values */
+    double max;     /* maximum of non-missing values */
+    guint8 enc;     /* encoding, possibly with GDTC_DEFLATED */
+    guint8 pad[7];
+};
+
+static const int gdtc_width[] = {8, 4, 1, 0};
+
+static void byte_shuffle (guint8 *targ, const guint8 *src,
+			  int n, int size)
 {
-    int i, t;
+    int i, j;
 
-    for (i=1; i<dset->v; i++) {
-	for (t=0; t<dset->n; t++) {
-	    reverse_double(dset->Z[i][t]);
+    for (i=0; i<n; i++) {
+	for (j=0; j<size; j++) {
+	    targ[j*n + i] = src[i*size + j];
 	}
     }
 }
 
-static int read_binary_header (FILE *fp, int order)
+/* the inverse of byte_shuffle(), optionally reversing the byte
+   order of each element as it goes
+*/
+
+static void byte_unshuffle (guint8 *targ, const guint8 *src,
+			    int n, int size, int swap)
 {
-    char hdr[BIN_HDRLEN] = {0};
-    unsigned chk;
-    int err = 0;
+    int i, j, k;
 
-    chk = fread(hdr, 1, BIN_HDRLEN, fp);
+    for (j=0; j<size; j++) {
+	k = swap ? size - 1 - j : j;
+	for (i=0; i<n; i++) {
+	    targ[i*size + k] = src[j*n + i];
+	}
+    }
+}
 
-    if (chk != BIN_HDRLEN) {
-	err = E_DATA;
-    } else {
-	int bin_order = 0;
+/* Get summary statistics for chunk @x of length @n and choose the
+   narrowest encoding that represents it exactly */
 
-	if (strncmp(hdr, "gretl-bin:", 10)) {
-	    err = E_DATA;
-	} else if (!strcmp(hdr + 10, "little-endian")) {
-	    bin_order = G_LITTLE_ENDIAN;
-	} else if (!strcmp(hdr + 10, "big-endian")) {
-	    bin_order = G_BIG_ENDIAN;
-	} else {
-	    err = E_DATA;
-	}
-	if (!err && bin_order != order) {
-	    err = E_DATA;
+static void gdtc_chunk_stats (const double *x, int n, gdtc_chunk *ck)
+{
+    int intok = 1;
+    int t;
+
+    ck->n_na = 0;
+    ck->min = ck->max = NADBL;
+
+    for (t=0; t<n; t++) {
+	if (na(x[t])) {
+	    ck->n_na += 1;
+	    continue;
 	}
+	if (na(ck->min)) {
+	    ck->min = ck->max = x[t];
+	} else if (x[t] < ck->min) {
+	    ck->min = x[t];
+	} else if (x[t] > ck->max) {
+	    ck->max = x[t];
+	}
+	if (intok && (x[t] != floor(x[t]) || x[t] <= GDTC_NA32 ||
+		      x[t] > G_MAXINT || (x[t] == 0 && signbit(x[t])))) {
+	    intok = 0;
+	}
+    }
+
+    if (ck->n_na == n) {
+	ck->enc = GDTC_CONST;
+    } else if (ck->n_na == 0 && ck->min == ck->max &&
+	       (ck->min != 0 || intok)) {
+	/* (but don't lose the sign of a negative zero) */
+	ck->enc = GDTC_CONST;
+    } else if (intok && ck->min >= 0 && ck->max < GDTC_NA8) {
+	ck->enc = GDTC_UINT8;
+    } else if (intok) {
+	ck->enc = GDTC_INT32;
+    } else {
+	ck->enc = GDTC_DOUBLE;
     }
+}
 
-    if (err) {
-	gretl_errmsg_set("Error reading binary data file");
+/* Write the values in @x to @buf using the encoding recorded in
+   @ck, byte-shuffled via @tmp. Returns the number of bytes written.
+*/
+
+static int gdtc_encode_chunk (const double *x, int n, gdtc_chunk *ck,
+			      guint8 *buf, guint8 *tmp)
+{
+    int w = gdtc_width[ck->enc];
+    int t;
+
+    if (ck->enc == GDTC_UINT8) {
+	for (t=0; t<n; t++) {
+	    buf[t] = na(x[t]) ? GDTC_NA8 : (guint8) x[t];
+	}
+	return n;
+    } else if (ck->enc == GDTC_INT32) {
+	gint32 *ix = (gint32 *) tmp;
+
+	for (t=0; t<n; t++) {
+	    ix[t] = na(x[t]) ? GDTC_NA32 : (gint32) x[t];
+	}
+	byte_shuffle(buf, tmp, n, w);
+    } else if (ck->enc == GDTC_DOUBLE) {
+	byte_shuffle(buf, (const guint8 *) x, n, w);
     }
 
-    return err;
+    return n * w;
 }
 
-static void na_convert (double *x, int n)
+static int write_chunked_header (FILE *fp, gint32 *dims)
 {
-    int i;
+    char header[BIN_HDRLEN] = {0};
+    int err = 0;
 
-    for (i=0; i<n; i++) {
-	if (x[i] == DBL_MAX) {
-	    x[i] = NADBL;
-	}
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    strcpy(header, "gretl-bcz:little-endian");
+#else
+    strcpy(header, "gretl-bcz:big-endian");
+#endif
+
+    if (fwrite(header, 1, BIN_HDRLEN, fp) != BIN_HDRLEN ||
+	fwrite(dims, sizeof *dims, 4, fp) != 4) {
+	err = E_DATA;
     }
+
+    return err;
 }
 
-static int read_binary_data (const char *fname,
-			     DATASET *dset,
-			     int order,
-			     double gdtversion,
-			     int fullv,
-			     const int *vlist)
+static int write_chunked_data (const char *fname, const DATASET *dset,
+			       const int *list, int nvars)
 {
+    gdtc_chunk *dir = NULL;
+    guint8 *buf = NULL, *tmp = NULL, *zbuf = NULL;
+    int T = dset->t2 - dset->t1 + 1;
+    int level = get_compression_option(STORE);
+    int nchunks = (T + GDTC_CHUNK_ROWS - 1) / GDTC_CHUNK_ROWS;
+    uLong bufsize = GDTC_CHUNK_ROWS * sizeof(double);
+    uLong zsize = compressBound(bufsize);
+    gint32 dims[4];
+    guint64 offset;
     char *bname;
     FILE *fp;
-    int err = 0;
+    int i, c, v, err = 0;
 
     bname = switch_ext_new(fname, "bin");
-    fp = gretl_fopen(bname, "rb");
+    fp = gretl_fopen(bname, "wb");
+    free(bname);
 
     if (fp == NULL) {
-	err = E_FOPEN;
-    } else {
-	int T = dset->n;
-	long offset = T * sizeof(double);
-	size_t got;
-	int i, k = 1;
+	return E_FOPEN;
+    }
 
-	err = read_binary_header(fp, order);
+    dir = calloc(nvars * nchunks, sizeof *dir);
+    buf = malloc(bufsize);
+    tmp = malloc(bufsize);
+    zbuf = malloc(zsize);
+    if (dir == NULL || buf == NULL || tmp == NULL || zbuf == NULL) {
+	err = E_ALLOC;
+	goto bailout;
+    }
 
-	for (i=1; i<fullv && !err; i++) {
-	    if (vlist == NULL || in_gretl_list(vlist, i)) {
-		got = fread(dset->Z[k], sizeof(double), T, fp);
-		if (got != T) {
-		    err = E_DATA;
-		}
-		if (!err && gdtversion < 1.4) {
-		    /* we need to convert old-style NAs */
-		    na_convert(dset->Z[k], dset->n);
-		}
-		k++;
+    dims[0] = nvars;
+    dims[1] = T;
+    dims[2] = GDTC_CHUNK_ROWS;
+    dims[3] = nchunks;
+
+    /* write the header and a placeholder for the directory */
+    err = write_chunked_header(fp, dims);
+    if (!err && fwrite(dir, sizeof *dir, nvars * nchunks, fp) !=
+	nvars * nchunks) {
+	err = E_DATA;
+    }
+
+    offset = BIN_HDRLEN + sizeof dims + nvars * nchunks * sizeof *dir;
+
+    for (i=0; i<nvars && !err; i++) {
+	const double *x;
+	gdtc_chunk *ck;
+	uLongf zlen;
+	int n, len;
+
+	v = savenum(list, i+1);
+	for (c=0; c<nchunks && !err; c++) {
+	    x = dset->Z[v] + dset->t1 + c * GDTC_CHUNK_ROWS;
+	    n = MIN(GDTC_CHUNK_ROWS, T - c * GDTC_CHUNK_ROWS);
+	    ck = &dir[i * nchunks + c];
+	    gdtc_chunk_stats(x, n, ck);
+	    len = gdtc_encode_chunk(x, n, ck, buf, tmp);
+	    ck->offset = offset;
+	    if (len == 0) {
+		continue;
+	    }
+	    zlen = zsize;
+	    if (level > 0 && compress2(zbuf, &zlen, buf, len, level) == Z_OK &&
+		zlen < len) {
+		ck->enc |= GDTC_DEFLATED;
+		ck->size = zlen;
+		err = fwrite(zbuf, 1, zlen, fp) != zlen;
 	    } else {
-		fseek(fp, offset, SEEK_CUR);
+		ck->size = len;
+		err = fwrite(buf, 1, len, fp) != len;
 	    }
+	    offset += ck->size;
 	}
-	fclose(fp);
     }
 
-    free(bname);
-
-    if (!err && order != G_BYTE_ORDER) {
-	gdt_swap_endianness(dset);
+    if (!err) {
+	/* go back and fill in the directory */
+	fseek(fp, BIN_HDRLEN + sizeof dims, SEEK_SET);
+	if (fwrite(dir, sizeof *dir, nvars * nchunks, fp) != nvars * nchunks) {
+	    err = E_DATA;
+	}
+    } else if (err != E_ALLOC) {
+	err = E_DATA;
     }
 
+ bailout:
+
+    fclose(fp);
+    free(dir);
+    free(buf);
+    free(tmp);
+    free(zbuf);
+
     return err;
 }
 
-static void write_binary_order (PRN *prn)
+static void gdtc_swap_chunk (gdtc_chunk *ck)
 {
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-    pputs(prn, " binary=\"little-endian\" ");
-#else
-    pputs(prn, " binary=\"big-endian\" ");
-#endif
+    guint32 u;
+
+    ck->offset = GUINT64_SWAP_LE_BE(ck->offset);
+    ck->size = GUINT32_SWAP_LE_BE(ck->size);
+    u = GUINT32_SWAP_LE_BE((guint32) ck->n_na);
+    ck->n_na = (gint32) u;
+    reverse_double(ck->min);
+    reverse_double(ck->max);
 }
 
-/* Here we're testing a series to see if it can be represented in full
-   precision (discarding any artifacts) using the format "%.15g". The
-   criterion is that each value must have a least one trailing zero
-   when printed using "% .14e". We don't necessarily check every
-   element in the series; assuming a reasonable degree of homogeneity
-   in the data it ought to be enough if 100 members pass the test.
+/* Record of the blocks of binary data in a .gdtb file that has been
+   extended via "store --append": each block holds the values of
+   series @v1 to @v2 (1-based, in file order) for observations @t1
+   to @t2 (0-based), in the zip member named @member.
 */
 
-static int p15_OK (const DATASET *dset, int v)
+typedef struct gdt_segment_ {
+    char member[32];
+    int v1, v2;
+    int t1, t2;
+} gdt_segment;
+
+typedef struct gdt_seglist_ {
+    int n;
+    gdt_segment *seg;
+} gdt_seglist;
+
+/* Source for the binary payload of a native dataset: either the
+   data.bin member of a .gdtb or .gdtc zipfile, which is read in
+   place without unpacking the archive, or a plain data.bin file.
+*/
+
+typedef struct gdt_binsrc_ {
+    FILE *fp;
+    gretl_zipmember *zm;
+} gdt_binsrc;
+
+static int binsrc_open (gdt_binsrc *src, const char *fname)
 {
-    const double *x = dset->Z[v];
-    char s[32];
-    int t, i, n_ok = 0;
-    int ret = 1;
+    int err = 0;
 
-    for (t=dset->t1; t<=dset->t2; t++) {
-	if (!na(x[t])) {
-	    sprintf(s, "% .14e", x[t]);
-	    for (i=16; i>13; i--) {
-		if (s[i] != '0') {
-		    break;
-		}
-	    }
-	    if (i == 16) {
-		ret = 0;
-		break;
-	    }
-	    n_ok++;
-	}
-	if (n_ok > 100) {
-	    break;
+    src->fp = NULL;
+    src->zm = NULL;
+
+    if (is_zipped_gdt(fname)) {
+	src->zm = gretl_zipmember_open(fname, "data.bin", &err);
+    } else {
+	char *bname = switch_ext_new(fname, "bin");
+
+	src->fp = gretl_fopen(bname, "rb");
+	if (src->fp == NULL) {
+	    err = E_FOPEN;
 	}
+	free(bname);
     }
 
-    return ret;
+    return err;
 }
 
-static int real_write_gdt (const char *fname, const int *inlist,
-			   const DATASET *dset, gretlopt opt,
-			   int progress)
+static int binsrc_read (gdt_binsrc *src, void *buf, guint64 len)
 {
-    PRN *prn = NULL;
-    int tsamp = dset->t2 - dset->t1 + 1;
-    int *list = NULL;
-    char *p15 = NULL;
-    char startdate[OBSLEN], enddate[OBSLEN];
-    char datname[MAXLEN], freqstr[32];
-    char numstr[128], xmlbuf[1024];
-    const char *gdtver;
-    int (*show_progress) (double, double, int) = NULL;
-    double dsize = 0;
-    int i, t, v, ntabs, nvars = 0;
-    int have_markers, in_c_locale = 0;
-    int binary = 0, skip_padding = 0;
-    int gdt_digits = 17;
-    int uerr = 0;
-    int err = 0;
-
-    /* what are we supposed to be saving? */
-    if (inlist != NULL) {
-	int lzero[] = {1, 0};
+    int ok;
 
-	list = gretl_list_drop(inlist, lzero, &err);
-	if (err) {
-	    return err;
-	}
-	nvars = list[0];
+    if (src->zm != NULL) {
+	ok = gretl_zipmember_read(src->zm, buf, len) == (gint64) len;
     } else {
-	nvars = dset->v - 1;
+	ok = fread(buf, 1, len, src->fp) == len;
     }
 
-    if (nvars <= 0) {
-	gretl_errmsg_sprintf("No data to save!");
-	free(list);
-	return E_DATA;
-    }
+    return ok ? 0 : E_DATA;
+}
 
-    if (opt & OPT_B) {
-	binary = G_BYTE_ORDER;
-	progress = 0;
-	prn = open_gdt_write_stream(fname, OPT_NONE);
+static int binsrc_skip (gdt_binsrc *src, guint64 len)
+{
+    if (src->zm != NULL) {
+	return gretl_zipmember_skip(src->zm, len);
     } else {
-	const char *path = fname;
-	gchar *fullname = NULL;
+#ifdef G_OS_WIN32
+	/* long is 32 bits here, even on win64 */
+	return _fseeki64(src->fp, (gint64) len, SEEK_CUR) == 0 ? 0 : E_DATA;
+#else
+	long step;
 
-	if (!has_suffix(fname, ".gdt")) {
-	    /* force use of .gdt extension for native XML data */
-	    path = fullname = g_strdup_printf("%s.gdt", fname);
+	/* step in pieces that fit a long, which may be 32 bits */
+	while (len > 0) {
+	    step = (len > LONG_MAX)? LONG_MAX : (long) len;
+	    if (fseek(src->fp, step, SEEK_CUR) != 0) {
+		return E_DATA;
+	    }
+	    len -= step;
 	}
-	prn = open_gdt_write_stream(path, opt);
-	g_free(fullname);
+	return 0;
+#endif
     }
+}
 
-    if (prn == NULL) {
-	fprintf(stderr, "HERE 2 NULL prn\n");
-	free(list);
-	return E_FOPEN;
+static void binsrc_close (gdt_binsrc *src)
+{
+    if (src->zm != NULL) {
+	gretl_zipmember_close(src->zm);
+    } else if (src->fp != NULL) {
+	fclose(src->fp);
     }
+}
 
-    dsize = tsamp * nvars * sizeof(double);
+/* Check decoded chunk @x of length @n against the summary
+   statistics recorded for it in the directory, as a guard
+   against a corrupted or inconsistent file */
 
-    if (dsize > 100000) {
-	fprintf(stderr, I_("Writing %.0f Kbytes of data\n"), dsize / 1024);
-    } else if (progress) {
-	/* suppress progress bar for smaller data */
-	progress = 0;
-    }
+static int gdtc_check_chunk (const gdtc_chunk *ck, const double *x,
+			     int n)
+{
+    double xmin = NADBL, xmax = NADBL;
+    int t, n_na = 0;
 
-    if (!binary) {
-	p15 = calloc(nvars, 1);
-	if (p15 != NULL) {
-	    for (i=0; i<nvars; i++) {
-		v = savenum(list, i+1);
-		p15[i] = p15_OK(dset, v);
-	    }
+    for (t=0; t<n; t++) {
+	if (na(x[t])) {
+	    n_na++;
+	} else if (na(xmin)) {
+	    xmin = xmax = x[t];
+	} else if (x[t] < xmin) {
+	    xmin = x[t];
+	} else if (x[t] > xmax) {
+	    xmax = x[t];
 	}
     }
 
-    if (progress) {
-	show_progress = get_plugin_function("show_progress");
-	if (show_progress == NULL) {
-	    progress = 0;
-	} else {
-	    (*show_progress)(0, dsize, SP_SAVE_INIT);
-	}
+    if (n_na != ck->n_na || (n_na < n && (xmin != ck->min ||
+					  xmax != ck->max))) {
+	return E_DATA;
     }
 
-    ntodate(startdate, dset->t1, dset);
-    ntodate(enddate, dset->t2, dset);
+    return 0;
+}
 
-    simple_fname(datname, fname);
-    uerr = gretl_xml_encode_to_buf(xmlbuf, datname, sizeof xmlbuf);
-    if (uerr) {
-	strcpy(xmlbuf, "unknown");
-    }
+/* Decode one chunk of length @n into @x, given its stored payload
+   in @zsrc and using @buf and @tmp, each of GDTC_CHUNK_ROWS doubles,
+   as workspace.
+*/
 
-    if (custom_time_series(dset)) {
-	sprintf(freqstr, "special:%d", dset->pd);
-    } else {
-	sprintf(freqstr, "%d", dset->pd);
+static int gdtc_read_chunk (const gdtc_chunk *ck, const guint8 *zsrc,
+			    double *x, int n, int swap,
+			    guint8 *buf, guint8 *tmp)
+{
+    int enc = ck->enc & ~GDTC_DEFLATED;
+    const guint8 *src;
+    int w, t;
+
+    if (enc == GDTC_CONST || ck->n_na == n) {
+	double xc = (ck->n_na == n)? NADBL : ck->min;
+
+	for (t=0; t<n; t++) {
+	    x[t] = xc;
+	}
+	return 0;
+    } else if (enc > GDTC_CONST) {
+	return E_DATA;
     }
 
-    gdtver = GRETLDATA_VERSION;
+    w = gdtc_width[enc];
+
+    if (ck->enc & GDTC_DEFLATED) {
+	uLongf len = n * w;
+
+	if (uncompress(buf, &len, zsrc, ck->size) != Z_OK ||
+	    len != n * w) {
+	    return E_DATA;
+	}
+	src = buf;
+    } else if (ck->size != n * w) {
+	return E_DATA;
+    } else {
+	src = zsrc;
+    }
+
+    if (enc == GDTC_DOUBLE) {
+	byte_unshuffle((guint8 *) x, src, n, w, swap);
+    } else if (enc == GDTC_INT32) {
+	gint32 *ix = (gint32 *) (src == buf ? tmp : buf);
+
+	byte_unshuffle((guint8 *) ix, src, n, w, swap);
+	for (t=0; t<n; t++) {
+	    x[t] = (ix[t] == GDTC_NA32)? NADBL : (double) ix[t];
+	}
+    } else {
+	for (t=0; t<n; t++) {
+	    x[t] = (src[t] == GDTC_NA8)? NADBL : (double) src[t];
+	}
+    }
+
+    return gdtc_check_chunk(ck, x, n);
+}
+
+/* Upper limit on the amount of compressed data we hold in memory
+   at once when reading a chunked payload */
+#define GDTC_BATCH_BYTES (64 * 1024 * 1024)
+
+/* Decode the @nb columns whose stored chunks are in @zmem, at the
+   offsets given by @boff, into the series indexed by @targ. The
+   columns are independent, so this is done in parallel if OpenMP
+   is available and the job is big enough to warrant it.
+*/
+
+static int gdtc_decode_batch (DATASET *dset, const gdtc_chunk *dir,
+			      const gint32 *dims, const guint8 *zmem,
+			      const guint64 *boff, const int *cols,
+			      const int *targ, int nb, int swap)
+{
+    size_t bsize = (size_t) dims[2] * sizeof(double);
+    guint8 *buf, *tmp;
+    int b, c, berr;
+    int err = 0;
+
+    /* Note: @err is shared; once it's set, each thread skips
+       its remaining blocks */
+
+#if defined(_OPENMP)
+    int par = nb > 1 && libset_use_openmp((guint64) nb * dims[1]);
+#pragma omp parallel if (par) private(b, c, buf, tmp, berr)
+#endif
+    {
+	buf = malloc(bsize);
+	tmp = malloc(bsize);
+	berr = (buf == NULL || tmp == NULL)? E_ALLOC : 0;
+
+	if (berr) {
+#if defined(_OPENMP)
+#pragma omp atomic write
+#endif
+	    err = berr;
+	}
+
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic)
+#endif
+	for (b=0; b<nb; b++) {
+	    const gdtc_chunk *ck = dir + (size_t) cols[b] * dims[3];
+	    guint64 start = ck->offset;
+	    double *x = dset->Z[targ[b]];
+	    int t0, n, failed;
+
+#if defined(_OPENMP)
+#pragma omp atomic read
+#endif
+	    failed = err;
+
+	    if (failed) {
+		continue;
+	    }
+
+	    for (c=0; c<dims[3] && !berr; c++, ck++) {
+		t0 = c * dims[2];
+		n = MIN(dims[2], dims[1] - t0);
+		berr = gdtc_read_chunk(ck, zmem + boff[b] + (ck->offset - start),
+				       x + t0, n, swap, buf, tmp);
+	    }
+
+	    if (berr) {
+#if defined(_OPENMP)
+#pragma omp atomic write
+#endif
+		err = berr;
+	    }
+	}
+
+	free(buf);
+	free(tmp);
+    } /* end (possibly) parallel section */
+
+    return err;
+}
+
+/* Read the chunked payload from @src, which is positioned just after
+   the header. Only the series in @vlist (if non-NULL) are decoded:
+   the chunks of the others are skipped over, which amounts to a seek
+   when the zip member is stored uncompressed, as gretl writes it.
+   The stored chunks are read in sequence, in batches of columns, and
+   each batch is then decoded column-wise.
+*/
+
+static int read_chunked_data (gdt_binsrc *src, DATASET *dset, int swap,
+			      int fullv, const int *vlist)
+{
+    gdtc_chunk *dir = NULL;
+    guint8 *zmem = NULL;
+    guint64 *boff = NULL;
+    int *cols = NULL, *targ = NULL;
+    guint64 pos, used = 0, zcap = 0;
+    gint32 dims[4];
+    size_t nck;
+    int i, j, k = 1, nb = 0;
+    int err = 0;
+
+    if (binsrc_read(src, dims, sizeof dims)) {
+	gretl_errmsg_set("Error reading binary data file");
+	return E_DATA;
+    }
+
+    if (swap) {
+	for (j=0; j<4; j++) {
+	    reverse_int(dims[j]);
+	}
+    }
+
+    if (dims[0] != fullv - 1 || dims[1] != dset->n || dims[2] <= 0 ||
+	dims[3] != (dims[1] + dims[2] - 1) / dims[2]) {
+	gretl_errmsg_set("Error reading binary data file");
+	return E_DATA;
+    }
+
+    nck = (size_t) dims[0] * dims[3];
+    dir = malloc(nck * sizeof *dir);
+    boff = malloc(fullv * sizeof *boff);
+    cols = malloc(fullv * sizeof *cols);
+    targ = malloc(fullv * sizeof *targ);
+    if (dir == NULL || boff == NULL || cols == NULL || targ == NULL) {
+	err = E_ALLOC;
+	goto bailout;
+    }
+
+    if (binsrc_read(src, dir, nck * sizeof *dir)) {
+	err = E_DATA;
+    } else if (swap) {
+	for (j=0; j<nck; j++) {
+	    gdtc_swap_chunk(&dir[j]);
+	}
+    }
+
+    pos = BIN_HDRLEN + sizeof dims + nck * sizeof *dir;
+
+    for (i=1; i<fullv && !err; i++) {
+	const gdtc_chunk *c0, *c1, *ck;
+	guint64 len;
+
+	if (vlist != NULL && !in_gretl_list(vlist, i)) {
+	    continue;
+	}
+
+	/* the chunks for each series are contiguous: check that
+	   every one of them lies within the span that we read */
+	c0 = dir + (size_t) (i-1) * dims[3];
+	c1 = c0 + dims[3] - 1;
+	if (c0->offset < pos || c1->offset < c0->offset ||
+	    c1->offset > G_MAXINT64 - c1->size) {
+	    err = E_DATA;
+	    break;
+	}
+	len = c1->offset + c1->size - c0->offset;
+	for (ck=c0; ck<c1 && !err; ck++) {
+	    if (ck->offset < c0->offset || ck->size > len ||
+		ck->offset - c0->offset > len - ck->size) {
+		err = E_DATA;
+	    }
+	}
+	if (err) {
+	    break;
+	}
+
+	if (nb > 0 && used + len > GDTC_BATCH_BYTES) {
+	    /* decode the columns we have so far */
+	    err = gdtc_decode_batch(dset, dir, dims, zmem, boff,
+				    cols, targ, nb, swap);
+	    nb = 0;
+	    used = 0;
+	}
+	if (!err && used + len > zcap) {
+	    guint8 *tmp = realloc(zmem, used + len);
+
+	    if (tmp == NULL) {
+		err = E_ALLOC;
+	    } else {
+		zmem = tmp;
+		zcap = used + len;
+	    }
+	}
+	if (!err) {
+	    err = binsrc_skip(src, c0->offset - pos);
+	}
+	if (!err && len > 0) {
+	    err = binsrc_read(src, zmem + used, len);
+	}
+	if (!err) {
+	    pos = c0->offset + len;
+	    cols[nb] = i - 1;
+	    targ[nb] = k++;
+	    boff[nb++] = used;
+	    used += len;
+	}
+    }
+
+    if (!err && nb > 0) {
+	err = gdtc_decode_batch(dset, dir, dims, zmem, boff,
+				cols, targ, nb, swap);
+    }
+
+ bailout:
+
+    if (err == E_DATA) {
+	gretl_errmsg_set("Error reading binary data file");
+    }
+
+    free(dir);
+    free(zmem);
+    free(boff);
+    free(cols);
+    free(targ);
+
+    return err;
+}
+
+/* Reverse the byte order of the @n values in @x: working on a 64-bit
+   integer copy of each value allows the compiler to vectorize this
+*/
+
+static void swap_doubles (double *x, int n)
+{
+    guint64 u;
+    int t;
+
+    for (t=0; t<n; t++) {
+	memcpy(&u, x + t, sizeof u);
+	u = GUINT64_SWAP_LE_BE(u);
+	memcpy(x + t, &u, sizeof u);
+    }
+}
+
+static void na_convert (double *x, int n)
+{
+    int i;
+
+    for (i=0; i<n; i++) {
+	if (x[i] == DBL_MAX) {
+	    x[i] = NADBL;
+	}
+    }
+}
+
+/* Post-process plain binary data read into series 1 to @nv - 1
+   of @dset, by reversing the byte order and/or converting old-style
+   NAs as required. The series are handled in parallel if OpenMP is
+   available and the dataset is big enough.
+*/
+
+static void gdt_fixup_series (DATASET *dset, int nv, int swap,
+			      int old_na)
+{
+    int i;
+#if defined(_OPENMP)
+    int par = libset_use_openmp((guint64) nv * dset->n);
+#endif
+
+    if (!swap && !old_na) {
+	return;
+    }
+
+#if defined(_OPENMP)
+#pragma omp parallel for private(i) if (par)
+#endif
+    for (i=1; i<nv; i++) {
+	if (swap) {
+	    swap_doubles(dset->Z[i], dset->n);
+	}
+	if (old_na) {
+	    na_convert(dset->Z[i], dset->n);
+	}
+    }
+}
+
+/* Note: on successful return @chunked is set to 1 if the data
+   are in the chunked format used by .gdtc files, else 0 */
+
+static int read_binary_header (gdt_binsrc *src, int order, int *chunked)
+{
+    char hdr[BIN_HDRLEN] = {0};
+    int err = 0;
+
+    if (binsrc_read(src, hdr, BIN_HDRLEN)) {
+	err = E_DATA;
+    } else {
+	int bin_order = 0;
+
+	if (!strncmp(hdr, "gretl-bcz:", 10)) {
+	    *chunked = 1;
+	} else if (strncmp(hdr, "gretl-bin:", 10)) {
+	    err = E_DATA;
+	}
+	if (!err) {
+	    if (!strcmp(hdr + 10, "little-endian")) {
+		bin_order = G_LITTLE_ENDIAN;
+	    } else if (!strcmp(hdr + 10, "big-endian")) {
+		bin_order = G_BIG_ENDIAN;
+	    } else {
+		err = E_DATA;
+	    }
+	}
+	if (!err && bin_order != order) {
+	    err = E_DATA;
+	}
+    }
+
+    if (err) {
+	gretl_errmsg_set("Error reading binary data file");
+    }
+
+    return err;
+}
+
+/* Assemble the binary data for a .gdtb file that has been added to
+   via "store --append", as described by @sl. The segments are read in
+   turn, and each series in @vlist (or all series if @vlist is NULL)
+   picks up the blocks of rows that pertain to it.
+*/
+
+static int read_binary_segments (const char *fname,
+				 DATASET *dset,
+				 int order,
+				 const gdt_seglist *sl,
+				 int fullv,
+				 const int *vlist)
+{
+    gretl_zipfile *zf = NULL;
+    gdt_binsrc src = {NULL, NULL};
+    int swap = (order != G_BYTE_ORDER);
+    int *vmap;
+    int i, j, t, k = 1;
+    int err = 0;
+
+    if (!is_zipped_gdt(fname)) {
+	return E_DATA;
+    }
+
+    /* map from position in file to position in @dset */
+    vmap = calloc(fullv, sizeof *vmap);
+    if (vmap == NULL) {
+	return E_ALLOC;
+    }
+
+    for (i=1; i<fullv; i++) {
+	if (vlist == NULL || in_gretl_list(vlist, i)) {
+	    for (t=0; t<dset->n; t++) {
+		dset->Z[k][t] = NADBL;
+	    }
+	    vmap[i] = k++;
+	}
+    }
+
+    zf = gretl_zipfile_open(fname, &err);
+
+    for (j=0; j<sl->n && !err; j++) {
+	const gdt_segment *seg = &sl->seg[j];
+	int chunked = 0, nt = seg->t2 - seg->t1 + 1;
+	guint64 sz = (guint64) nt * sizeof(double);
+
+	if (seg->v1 < 1 || seg->v2 >= fullv || seg->v1 > seg->v2 ||
+	    seg->t1 < 0 || seg->t2 >= dset->n || nt < 1) {
+	    gretl_errmsg_set("Error reading binary data file");
+	    err = E_DATA;
+	    break;
+	}
+	src.zm = gretl_zipfile_get_member(zf, seg->member, &err);
+	if (!err) {
+	    err = read_binary_header(&src, order, &chunked);
+	    if (!err && chunked) {
+		err = E_DATA;
+	    }
+	}
+	for (i=seg->v1; i<=seg->v2 && !err; i++) {
+	    if (vmap[i] > 0) {
+		double *x = dset->Z[vmap[i]] + seg->t1;
+
+		err = binsrc_read(&src, x, sz);
+		if (!err && swap) {
+		    swap_doubles(x, nt);
+		}
+	    } else {
+		err = binsrc_skip(&src, sz);
+	    }
+	}
+	binsrc_close(&src);
+	src.zm = NULL;
+    }
+
+    gretl_zipfile_close(zf);
+    free(vmap);
+
+    return err;
+}
+
+/* Read the binary values associated with @fname, which will usually
+   be the name of a .gdtb or .gdtc file, in which case the payload is
+   decompressed directly into @dset. If @sl is non-NULL it describes
+   the segments of a .gdtb file that has been appended to.
+*/
+
+static int read_binary_data (const char *fname,
+			     DATASET *dset,
+			     int order,
+			     double gdtversion,
+			     int fullv,
+			     const int *vlist,
+			     const gdt_seglist *sl)
+{
+    gdt_binsrc src;
+    int swap = (order != G_BYTE_ORDER);
+    int chunked = 0;
+    int err;
+
+    if (sl != NULL && sl->n > 0) {
+	return read_binary_segments(fname, dset, order, sl,
+				    fullv, vlist);
+    }
+
+    err = binsrc_open(&src, fname);
+
+    if (!err) {
+	err = read_binary_header(&src, order, &chunked);
+    }
+
+    if (!err && chunked) {
+	err = read_chunked_data(&src, dset, swap, fullv, vlist);
+    } else if (!err) {
+	guint64 sz = (guint64) dset->n * sizeof(double);
+	int i, k = 1;
+
+	for (i=1; i<fullv && !err; i++) {
+	    if (vlist == NULL || in_gretl_list(vlist, i)) {
+		err = binsrc_read(&src, dset->Z[k++], sz);
+	    } else {
+		err = binsrc_skip(&src, sz);
+	    }
+	}
+	if (!err) {
+	    gdt_fixup_series(dset, k, swap, gdtversion < 1.4);
+	}
+    }
+
+    binsrc_close(&src);
+
+    return err;
+}
+
+static void write_binary_order (PRN *prn)
+{
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    pputs(prn, " binary=\"little-endian\" ");
+#else
+    pputs(prn, " binary=\"big-endian\" ");
+#endif
+}
+
+/* Here we're testing a series to see if it can be represented in full
+   precision (discarding any artifacts) using the format "%.15g". The
+   criterion is that each value must have a least one trailing zero
+   when printed using "% .14e". We don't necessarily check every
+   element in the series; assuming a reasonable degree of homogeneity
+   in the data it ought to be enough if 100 members pass the test.
+*/
+
+static int p15_OK (const DATASET *dset, int v)
+{
+    const double *x = dset->Z[v];
+    char s[32];
+    int t, i, n_ok = 0;
+    int ret = 1;
+
+    for (t=dset->t1; t<=dset->t2; t++) {
+	if (!na(x[t])) {
+	    sprintf(s, "% .14e", x[t]);
+	    for (i=16; i>13; i--) {
+		if (s[i] != '0') {
+		    break;
+		}
+	    }
+	    if (i == 16) {
+		ret = 0;
+		break;
+	    }
+	    n_ok++;
+	}
+	if (n_ok > 100) {
+	    break;
+	}
+    }
+
+    return ret;
+}
+
+/* Note: @chunked is non-zero only when writing the XML component
+   of a .gdtc file, and implies OPT_B. If @sl is non-NULL we're
+   writing just the XML component of a .gdtb file for "store
+   --append": the binary data are handled by the caller.
+*/
+
+static int real_write_gdt (const char *fname, const int *inlist,
+			   const DATASET *dset, gretlopt opt,
+			   int chunked, const gdt_seglist *sl,
+			   int progress)
+{
+    PRN *prn = NULL;
+    int tsamp = dset->t2 - dset->t1 + 1;
+    int *list = NULL;
+    char *p15 = NULL;
+    char startdate[OBSLEN], enddate[OBSLEN];
+    char datname[MAXLEN], freqstr[32];
+    char numstr[128], xmlbuf[1024];
+    const char *gdtver;
+    int (*show_progress) (double, double, int) = NULL;
+    double dsize = 0;
+    int i, t, v, ntabs, nvars = 0;
+    int have_markers, in_c_locale = 0;
+    int binary = 0, skip_padding = 0;
+    int gdt_digits = 17;
+    int uerr = 0;
+    int err = 0;
+
+    /* what are we supposed to be saving? */
+    if (inlist != NULL) {
+	int lzero[] = {1, 0};
+
+	list = gretl_list_drop(inlist, lzero, &err);
+	if (err) {
+	    return err;
+	}
+	nvars = list[0];
+    } else {
+	nvars = dset->v - 1;
+    }
+
+    if (nvars <= 0) {
+	gretl_errmsg_sprintf("No data to save!");
+	free(list);
+	return E_DATA;
+    }
+
+    if (opt & OPT_B) {
+	binary = G_BYTE_ORDER;
+	progress = 0;
+	prn = open_gdt_write_stream(fname, OPT_NONE);
+    } else {
+	const char *path = fname;
+	gchar *fullname = NULL;
+
+	if (!has_suffix(fname, ".gdt")) {
+	    /* force use of .gdt extension for native XML data */
+	    path = fullname = g_strdup_printf("%s.gdt", fname);
+	}
+	prn = open_gdt_write_stream(path, opt);
+	g_free(fullname);
+    }
+
+    if (prn == NULL) {
+	fprintf(stderr, "HERE 2 NULL prn\n");
+	free(list);
+	return E_FOPEN;
+    }
+
+    dsize = tsamp * nvars * sizeof(double);
+
+    if (dsize > 100000) {
+	fprintf(stderr, I_("Writing %.0f Kbytes of data\n"), dsize / 1024);
+    } else if (progress) {
+	/* suppress progress bar for smaller data */
+	progress = 0;
+    }
+
+    if (!binary) {
+	p15 = calloc(nvars, 1);
+	if (p15 != NULL) {
+	    for (i=0; i<nvars; i++) {
+		v = savenum(list, i+1);
+		p15[i] = p15_OK(dset, v);
+	    }
+	}
+    }
+
+    if (progress) {
+	show_progress = get_plugin_function("show_progress");
+	if (show_progress == NULL) {
+	    progress = 0;
+	} else {
+	    (*show_progress)(0, dsize, SP_SAVE_INIT);
+	}
+    }
+
+    ntodate(startdate, dset->t1, dset);
+    ntodate(enddate, dset->t2, dset);
+
+    simple_fname(datname, fname);
+    uerr = gretl_xml_encode_to_buf(xmlbuf, datname, sizeof xmlbuf);
+    if (uerr) {
+	strcpy(xmlbuf, "unknown");
+    }
+
+    if (custom_time_series(dset)) {
+	sprintf(freqstr, "special:%d", dset->pd);
+    } else {
+	sprintf(freqstr, "%d", dset->pd);
+    }
+
+    gdtver = GRETLDATA_VERSION;
 
     /* support --oldbinary option */
-    if (binary && (opt & OPT_O)) {
+    if (binary && !chunked && sl == NULL && (opt & OPT_O)) {
 	gdtver = GRETLDATA_COMPAT;
     }
 
@@ -2371,8 +3187,9 @@ static int real_write_gdt (const char *fname, const int *inlist,
 
     have_markers = dataset_has_markers(dset);
 
-    if (dataset_is_panel(dset) && !have_markers &&
-	nvars == dset->v - 1 && dsize > 1024 * 1024 * 10) {
+    if (dataset_is_panel(dset) && !have_markers && !chunked &&
+	sl == NULL && nvars == dset->v - 1 && dsize > 1024 * 1024 * 10) {
+	/* (in the chunked case padding rows just compress away) */
 	/* we have more than 10 MB of panel data */
 	int padrows = panel_padding_rows(dset);
 
@@ -2489,13 +3306,34 @@ static int real_write_gdt (const char *fname, const int *inlist,
 
     pputs(prn, "</variables>\n");
 
+    if (sl != NULL) {
+	/* record the blocks making up the binary data */
+	pprintf(prn, "<segments count=\"%d\">\n", sl->n);
+	for (i=0; i<sl->n; i++) {
+	    pprintf(prn, "<segment member=\"%s\" v1=\"%d\" v2=\"%d\" "
+		    "t1=\"%d\" t2=\"%d\"/>\n", sl->seg[i].member,
+		    sl->seg[i].v1, sl->seg[i].v2, sl->seg[i].t1,
+		    sl->seg[i].t2);
+	}
+	pputs(prn, "</segments>\n");
+    }
+
     /* then listing of observations */
     pputs(prn, "<observations ");
     pprintf(prn, "count=\"%d\" labels=\"%s\"",
 		      tsamp, (have_markers)? "true" : "false");
     pputs(prn, ">\n");
 
-    if (binary) {
+    if (sl != NULL) {
+	if (!have_markers) {
+	    goto binary_done;
+	}
+    } else if (chunked) {
+	err = write_chunked_data(fname, dset, list, nvars);
+	if (!have_markers) {
+	    goto binary_done;
+	}
+    } else if (binary) {
 	err = write_binary_data(fname, dset, list, nvars, tsamp, opt);
 	if (!have_markers) {
 	    goto binary_done;
@@ -2604,6 +3442,9 @@ static int real_write_gdt (const char *fname, const int *inlist,
     return err;
 }
 
+static int append_gdtb (const char *fname, const int *list,
+			const DATASET *dset, gretlopt opt);
+
 /**
  * gretl_write_gdt:
  * @fname: name of file to write.
@@ -2614,7 +3455,9 @@ static int real_write_gdt (const char *fname, const int *inlist,
  * bar in case of a large data write; generally should be 0.
  *
  * Write out in xml a data file containing the values of the given set
- * of variables.
+ * of variables. If @fname has suffix .gdtb the data are written as
+ * a zipfile containing XML metadata plus binary values; with suffix
+ * .gdtc the binary values are written in compressed chunks.
  *
  * Returns: 0 on successful completion, non-zero on error.
  */
@@ -2625,8 +3468,20 @@ int gretl_write_gdt (const char *fname, const int *list,
 {
     int err = 0;
 
-    if (has_suffix(fname, ".gdtb")) {
+    if (opt & OPT_P) {
+	/* --append */
+	if (!has_suffix(fname, ".gdtb")) {
+	    gretl_errmsg_set(_("The --append option is supported only "
+			       "for .gdtb files"));
+	    return E_BADOPT;
+	} else if (gretl_file_exists(fname)) {
+	    return append_gdtb(fname, list, dset, opt);
+	}
+    }
+
+    if (is_zipped_gdt(fname)) {
 	/* zipfile with gdt + binary */
+	int chunked = has_suffix(fname, ".gdtc");
 	gchar *zdir;
 
 	zdir = g_strdup_printf("%stmp-zip", gretl_dotdir());
@@ -2636,10 +3491,12 @@ int gretl_write_gdt (const char *fname, const int *list,
 	    char xmlfile[FILENAME_MAX];
 
 	    gretl_build_path(xmlfile, zdir, "data.xml", NULL);
-	    err = real_write_gdt(xmlfile, list, dset, opt | OPT_B, 0);
+	    err = real_write_gdt(xmlfile, list, dset, opt | OPT_B,
+				 chunked, NULL, 0);
 
 	    if (!err) {
-		int level = get_compression_option(STORE);
+		/* the chunks are already compressed */
+		int level = chunked ? 0 : get_compression_option(STORE);
 
 		err = gretl_zip_datafile(fname, zdir, level);
 		if (err) {
@@ -2652,7 +3509,7 @@ int gretl_write_gdt (const char *fname, const int *list,
 	g_free(zdir);
     } else {
 	/* plain XML file */
-	err = real_write_gdt(fname, list, dset, opt, progress);
+	err = real_write_gdt(fname, list, dset, opt, 0, NULL, progress);
     }
 
     return err;
@@ -3054,18 +3911,181 @@ static int process_values (DATASET *dset,
     return err;
 }
 
-static int read_observations (xmlDocPtr doc, xmlNodePtr node,
-			      DATASET *dset, double dsize,
-			      int binary, double gdtversion,
-			      const char *fname)
+/* Callbacks for feeding libxml2's text reader from a gzFile: this
+   means that gzipped data files are decompressed incrementally as
+   the reader consumes them, while plain files pass straight through
+   zlib.
+*/
+
+static int gdt_gz_read (void *context, char *buf, int len)
+{
+    return gzread((gzFile) context, buf, len);
+}
+
+static int gdt_gz_close (void *context)
+{
+    return gzclose((gzFile) context) == Z_OK ? 0 : -1;
+}
+
+/* Likewise for the data.xml member of a .gdtb or .gdtc zipfile,
+   which is decompressed on the fly, straight from the archive */
+
+static int gdt_zip_read (void *context, char *buf, int len)
+{
+    return (int) gretl_zipmember_read((gretl_zipmember *) context,
+				      buf, len);
+}
+
+static int gdt_zip_close (void *context)
+{
+    gretl_zipmember_close((gretl_zipmember *) context);
+    return 0;
+}
+
+static xmlTextReaderPtr gdt_reader_open (const char *fname, int *err)
+{
+    xmlTextReaderPtr reader = NULL;
+    gzFile fz;
+
+    LIBXML_TEST_VERSION;
+
+    if (is_zipped_gdt(fname)) {
+	gretl_zipmember *zm;
+
+	zm = gretl_zipmember_open(fname, "data.xml", err);
+	if (zm != NULL) {
+	    reader = xmlReaderForIO(gdt_zip_read, gdt_zip_close, zm,
+				    fname, NULL, XML_PARSE_NOBLANKS |
+				    XML_PARSE_HUGE);
+	    if (reader == NULL) {
+		gretl_errmsg_sprintf(_("xmlParseFile failed on %s"), fname);
+		*err = E_DATA;
+	    }
+	}
+	return reader;
+    }
+
+    fz = gretl_gzopen(fname, "rb");
+
+    if (fz == NULL) {
+	*err = E_FOPEN;
+    } else {
+	gzbuffer(fz, 131072);
+	/* note: on failure @fz is closed by libxml2 */
+	reader = xmlReaderForIO(gdt_gz_read, gdt_gz_close, fz,
+				fname, NULL, XML_PARSE_NOBLANKS |
+				XML_PARSE_HUGE);
+	if (reader == NULL) {
+	    gretl_errmsg_sprintf(_("xmlParseFile failed on %s"), fname);
+	    *err = E_DATA;
+	}
+    }
+
+    return reader;
+}
+
+/* Advance @reader to the root element of the document and check
+   that it has the expected name. The node returned is valid only
+   until the reader is moved on, but it carries the root element's
+   attributes.
+*/
+
+static xmlNodePtr gdt_reader_root (xmlTextReaderPtr reader,
+				   const char *fname,
+				   const char *rootname,
+				   int *err)
+{
+    xmlNodePtr node = NULL;
+    int ret;
+
+    while ((ret = xmlTextReaderRead(reader)) == 1) {
+	if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT) {
+	    node = xmlTextReaderCurrentNode(reader);
+	    break;
+	}
+    }
+
+    if (ret < 0) {
+	gretl_errmsg_sprintf(_("xmlParseFile failed on %s"), fname);
+	*err = E_DATA;
+    } else if (node == NULL) {
+	gretl_errmsg_sprintf(_("%s: empty document"), fname);
+	*err = E_DATA;
+    } else if (xmlStrcmp(node->name, (XUC) rootname)) {
+	gretl_errmsg_sprintf(_("File of the wrong type, root node not %s"),
+			     rootname);
+	fprintf(stderr, "Unexpected root node '%s'\n", (char *) node->name);
+	*err = E_DATA;
+	node = NULL;
+    }
+
+    return node;
+}
+
+/* Counterpart to gretl_xml_open_doc_root() for native data files,
+   which parses the data.xml member of a .gdtb or .gdtc zipfile in
+   place, without unpacking the archive.
+*/
+
+static int gdt_open_doc_root (const char *fname,
+			      xmlDocPtr *pdoc,
+			      xmlNodePtr *pnode)
+{
+    gretl_zipmember *zm;
+    xmlDocPtr doc;
+    xmlNodePtr node;
+    int err = 0;
+
+    if (!is_zipped_gdt(fname)) {
+	return gretl_xml_open_doc_root(fname, "gretldata", pdoc, pnode);
+    }
+
+    LIBXML_TEST_VERSION;
+
+    *pdoc = NULL;
+    *pnode = NULL;
+
+    zm = gretl_zipmember_open(fname, "data.xml", &err);
+    if (err) {
+	return err;
+    }
+
+    /* note: @zm is closed by libxml2 */
+    doc = xmlReadIO(gdt_zip_read, gdt_zip_close, zm, fname, NULL,
+		    XML_PARSE_NOBLANKS | XML_PARSE_HUGE);
+    if (doc == NULL) {
+	gretl_errmsg_sprintf(_("xmlParseFile failed on %s"), fname);
+	return E_DATA;
+    }
+
+    node = xmlDocGetRootElement(doc);
+    if (node == NULL) {
+	gretl_errmsg_sprintf(_("%s: empty document"), fname);
+	err = E_DATA;
+    } else if (xmlStrcmp(node->name, (XUC) "gretldata")) {
+	gretl_errmsg_sprintf(_("File of the wrong type, root node not %s"),
+			     "gretldata");
+	err = E_DATA;
+    }
+
+    if (err) {
+	xmlFreeDoc(doc);
+    } else {
+	*pdoc = doc;
+	*pnode = node;
+    }
+
+    return err;
+}
+
+/* Given the <observations> node, read the number of observations
+   and set up @dset to receive the data
+*/
+
+static int allocate_observations (xmlNodePtr node, DATASET *dset)
 {
-    xmlNodePtr cur;
     xmlChar *tmp;
     int n, i, t;
-    int (*show_progress) (double, double, int) = NULL;
-    int progbar = 0;
-    int n_uflow = 0;
-    int err = 0;
 
     tmp = xmlGetProp(node, (XUC) "count");
     if (tmp == NULL) {
@@ -3081,17 +4101,11 @@ static int read_observations (xmlDocPtr doc, xmlNodePtr node,
 	return E_DATA;
     }
 
-    if (dsize > 100000 && !binary) {
-	show_progress = get_plugin_function("show_progress");
-	if (show_progress != NULL) {
-	    progbar = 1;
-	}
-    }
-
     tmp = xmlGetProp(node, (XUC) "labels");
     if (tmp) {
 	if (!strcmp((char *) tmp, "true")) {
 	    if (dataset_allocate_obs_markers(dset)) {
+		free(tmp);
 		return E_ALLOC;
 	    }
 	}
@@ -3117,21 +4131,104 @@ static int read_observations (xmlDocPtr doc, xmlNodePtr node,
 	dset->Z[0][t] = 1.0;
     }
 
-    if (binary) {
-	err = read_binary_data(fname, dset, binary, gdtversion,
-			       dset->v, NULL);
-	if (!dset->markers) {
-	    goto bailout;
-	}
+    return 0;
+}
+
+/* Parse the <segments> element written by "store --append" */
+
+static int process_segments (xmlNodePtr node, gdt_seglist *sl)
+{
+    xmlNodePtr cur;
+    xmlChar *tmp;
+    int n = 0, i = 0;
+    int err = 0;
+
+    if (!gretl_xml_get_prop_as_int(node, "count", &n) || n <= 0) {
+	return E_DATA;
+    }
+
+    sl->seg = calloc(n, sizeof *sl->seg);
+    if (sl->seg == NULL) {
+	return E_ALLOC;
     }
 
-    /* now get individual obs info: labels and values */
     cur = node->xmlChildrenNode;
-    while (cur && xmlIsBlankNode(cur)) {
+    while (cur != NULL && !err) {
+	if (!xmlStrcmp(cur->name, (XUC) "segment")) {
+	    gdt_segment *seg = &sl->seg[i];
+
+	    tmp = xmlGetProp(cur, (XUC) "member");
+	    if (i == n || tmp == NULL || strlen((char *) tmp) >= 32 ||
+		!gretl_xml_get_prop_as_int(cur, "v1", &seg->v1) ||
+		!gretl_xml_get_prop_as_int(cur, "v2", &seg->v2) ||
+		!gretl_xml_get_prop_as_int(cur, "t1", &seg->t1) ||
+		!gretl_xml_get_prop_as_int(cur, "t2", &seg->t2)) {
+		err = E_DATA;
+	    } else {
+		strcpy(seg->member, (char *) tmp);
+		i++;
+	    }
+	    free(tmp);
+	}
 	cur = cur->next;
     }
 
-    if (cur == NULL) {
+    if (!err && i < n) {
+	err = E_DATA;
+    }
+
+    if (err) {
+	gretl_errmsg_set("Error reading binary data file");
+    } else {
+	sl->n = n;
+    }
+
+    return err;
+}
+
+/* Read the <observations> element via @reader, which should be
+   positioned on its start tag. The values for each <obs> are
+   decoded straight into the columns of dset->Z as they arrive,
+   so that no DOM tree is built for the bulk of the data. On
+   successful return the reader is positioned on the end tag.
+*/
+
+static int read_observations (xmlTextReaderPtr reader,
+			      DATASET *dset, double dsize,
+			      int binary, double gdtversion,
+			      const char *fname,
+			      const gdt_seglist *sl)
+{
+    xmlChar *tmp;
+    int (*show_progress) (double, double, int) = NULL;
+    int progbar = 0;
+    int n_uflow = 0;
+    int depth, ret;
+    int t = 0;
+    int err = 0;
+
+    err = allocate_observations(xmlTextReaderCurrentNode(reader), dset);
+    if (err) {
+	return err;
+    }
+
+    if (dsize > 100000 && !binary) {
+	show_progress = get_plugin_function("show_progress");
+	if (show_progress != NULL) {
+	    progbar = 1;
+	}
+    }
+
+    if (binary) {
+	err = read_binary_data(fname, dset, binary, gdtversion,
+			       dset->v, NULL, sl);
+	if (err || !dset->markers) {
+	    /* leave the reader to skip the <obs> elements */
+	    return err;
+	}
+    }
+
+    if (xmlTextReaderIsEmptyElement(reader)) {
 	gretl_errmsg_set(_("Got no observations\n"));
 	return E_DATA;
     }
@@ -3144,50 +4241,72 @@ static int read_observations (xmlDocPtr doc, xmlNodePtr node,
 #endif
     }
 
-    t = 0;
-    while (cur != NULL) {
-        if (!xmlStrcmp(cur->name, (XUC) "obs")) {
-	    if (dset->markers) {
-		tmp = xmlGetProp(cur, (XUC) "label");
-		if (tmp) {
-		    transcribe_string(dset->S[t], (char *) tmp, OBSLEN);
-		    free(tmp);
-		} else {
-		    gretl_errmsg_sprintf(_("Case marker missing at obs %d"), t+1);
-		    return E_DATA;
-		}
-	    }
-	    if (!binary) {
-		tmp = xmlNodeListGetRawString(doc, cur->xmlChildrenNode, 1);
-		if (tmp) {
-		    err = process_values(dset, t, (char *) tmp, dset->v, NULL, &n_uflow);
-		    free(tmp);
-		} else if (dset->v > 1) {
-		    gretl_errmsg_sprintf(_("Values missing at observation %d"), t+1);
-		    err = E_DATA;
-		}
-	    }
-	    t++;
-	}
+    depth = xmlTextReaderDepth(reader);
+    ret = xmlTextReaderRead(reader);
 
-	if (err) {
+    while (ret == 1) {
+	int type = xmlTextReaderNodeType(reader);
+	int d = xmlTextReaderDepth(reader);
+
+	if (type == XML_READER_TYPE_END_ELEMENT && d == depth) {
+	    /* reached </observations> */
 	    break;
+	} else if (type != XML_READER_TYPE_ELEMENT || d != depth + 1 ||
+		   xmlStrcmp(xmlTextReaderConstName(reader), (XUC) "obs")) {
+	    ret = xmlTextReaderRead(reader);
+	    continue;
 	}
 
-	cur = cur->next;
-
-	if (cur != NULL && t == dset->n) {
+	if (t == dset->n) {
 	    /* got too many observations */
 	    t = dset->n + 1;
 	    break;
 	}
 
-	if (progbar && t > 0 && t % 50 == 0) {
+	if (dset->markers) {
+	    tmp = xmlTextReaderGetAttribute(reader, (XUC) "label");
+	    if (tmp) {
+		transcribe_string(dset->S[t], (char *) tmp, OBSLEN);
+		free(tmp);
+	    } else {
+		gretl_errmsg_sprintf(_("Case marker missing at obs %d"), t+1);
+		err = E_DATA;
+		break;
+	    }
+	}
+
+	if (!binary) {
+	    tmp = NULL;
+	    if (!xmlTextReaderIsEmptyElement(reader)) {
+		tmp = xmlTextReaderReadString(reader);
+	    }
+	    if (tmp) {
+		err = process_values(dset, t, (char *) tmp, dset->v, NULL, &n_uflow);
+		free(tmp);
+	    } else if (dset->v > 1) {
+		gretl_errmsg_sprintf(_("Values missing at observation %d"), t+1);
+		err = E_DATA;
+	    }
+	}
+
+	if (err) {
+	    break;
+	}
+
+	t++;
+
+	if (progbar && t % 50 == 0) {
 	    (*show_progress) (50, dset->n, SP_NONE);
 	}
+
+	/* skip to the next sibling, freeing the current <obs> */
+	ret = xmlTextReaderNext(reader);
     }
 
- bailout:
+    if (ret < 0 && !err) {
+	gretl_errmsg_sprintf(_("Failed to parse data values at obs %d"), t+1);
+	err = E_DATA;
+    }
 
     if (progbar) {
 #if GDT_DEBUG
@@ -3216,6 +4335,7 @@ static int read_observations_subset (xmlDocPtr doc,
 				     const char *fname,
 				     int fullv,
 				     const int *vlist,
+				     const gdt_seglist *sl,
 				     gretlopt opt)
 {
     xmlNodePtr cur;
@@ -3271,7 +4391,7 @@ static int read_observations_subset (xmlDocPtr doc,
 
     if (binary) {
 	err = read_binary_data(fname, dset, binary, gdtversion,
-			       fullv, vlist);
+			       fullv, vlist, sl);
 	if (!dset->markers) {
 	    goto bailout;
 	}
@@ -3814,18 +4934,21 @@ static void future_datafile_warning (double v1, double v2)
     gretl_warnmsg_sprintf(fmt, v1, v2);
 }
 
-static int real_read_gdt (const char *fname, const char *srcname,
-			  DATASET *dset, gretlopt opt, PRN *prn)
+static int real_read_gdt (const char *fname, DATASET *dset,
+			  gretlopt opt, PRN *prn)
 {
     DATASET *tmpset;
-    xmlDocPtr doc = NULL;
+    gdt_seglist segs = {0, NULL};
+    xmlTextReaderPtr reader = NULL;
     xmlNodePtr cur;
+    const xmlChar *name;
     int gotvars = 0, gotobs = 0, err = 0;
     int caldata = 0, repad = 0;
     double gdtversion = 1.0;
     double myversion;
     int in_c_locale = 0;
     int gz, binary = 0;
+    int ret = 1;
     long fsz;
 
     gretl_error_clear();
@@ -3848,8 +4971,10 @@ static int real_read_gdt (const char *fname, const char *srcname,
 	goto bailout;
     }
 
-    err = gretl_xml_open_doc_root(fname, "gretldata",
-				  &doc, &cur);
+    reader = gdt_reader_open(fname, &err);
+    if (!err) {
+	cur = gdt_reader_root(reader, fname, "gretldata", &err);
+    }
     if (err) {
 	goto bailout;
     }
@@ -3897,51 +5022,66 @@ static int real_read_gdt (const char *fname, const char *srcname,
     binary = gdt_binary_order(cur);
 
 #if GDT_DEBUG
-    fprintf(stderr, "starting to walk XML tree...\n");
+    fprintf(stderr, "starting to read XML stream...\n");
 #endif
 
-    /* Now walk the tree */
-    cur = cur->xmlChildrenNode;
-    while (cur != NULL && !err) {
-        if (!xmlStrcmp(cur->name, (XUC) "description")) {
-	    tmpset->descrip = (char *)
-		xmlNodeListGetString(doc, cur->xmlChildrenNode, 1);
-        } else if (!xmlStrcmp(cur->name, (XUC) "variables")) {
-	    err = process_varlist(cur, tmpset, 0);
-	    if (err) {
-		fprintf(stderr, "error processing varlist\n");
-	    } else {
-		gotvars = 1;
-	    }
-	} else if (!xmlStrcmp(cur->name, (XUC) "observations")) {
+    /* Now stream through the children of the root node: the
+       (relatively small) metadata elements are expanded into
+       subtrees for processing, but the observations are decoded
+       on the fly.
+    */
+    ret = xmlTextReaderRead(reader);
+    while (ret == 1 && !err) {
+	if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT ||
+	    xmlTextReaderDepth(reader) != 1) {
+	    ret = xmlTextReaderRead(reader);
+	    continue;
+	}
+	name = xmlTextReaderConstName(reader);
+	if (!xmlStrcmp(name, (XUC) "observations")) {
 	    if (!gotvars) {
 		gretl_errmsg_set(_("Variables information is missing"));
 		err = 1;
 	    } else {
 		double dsize = (opt & OPT_B)? (double) fsz : 0;
 
-		err = read_observations(doc, cur, tmpset, dsize,
-					binary, gdtversion, fname);
+		err = read_observations(reader, tmpset, dsize,
+					binary, gdtversion, fname,
+					&segs);
 		if (err) {
 		    fprintf(stderr, "error %d in read_observations\n", err);
 		} else {
 		    gotobs = 1;
 		}
 	    }
-	} else if (!xmlStrcmp(cur->name, (XUC) "string-tables")) {
-	    if (!gotvars) {
+	} else if (!xmlStrcmp(name, (XUC) "description") ||
+		   !xmlStrcmp(name, (XUC) "variables") ||
+		   !xmlStrcmp(name, (XUC) "string-tables") ||
+		   !xmlStrcmp(name, (XUC) "segments") ||
+		   !xmlStrcmp(name, (XUC) "panel-info")) {
+	    cur = xmlTextReaderExpand(reader);
+	    if (cur == NULL) {
+		err = E_DATA;
+	    } else if (!xmlStrcmp(name, (XUC) "description")) {
+		tmpset->descrip = (char *)
+		    xmlNodeListGetString(cur->doc, cur->xmlChildrenNode, 1);
+	    } else if (!xmlStrcmp(name, (XUC) "variables")) {
+		err = process_varlist(cur, tmpset, 0);
+		if (err) {
+		    fprintf(stderr, "error processing varlist\n");
+		} else {
+		    gotvars = 1;
+		}
+	    } else if (!gotvars) {
 		gretl_errmsg_set(_("Variables information is missing"));
 		err = E_DATA;
-	    } else {
-		err = process_string_tables(doc, cur, tmpset, 0);
+	    } else if (!xmlStrcmp(name, (XUC) "string-tables")) {
+		err = process_string_tables(cur->doc, cur, tmpset, 0);
 		if (err) {
 		    fprintf(stderr, "error %d processing string tables\n", err);
 		}
-	    }
-	} else if (!xmlStrcmp(cur->name, (XUC) "panel-info")) {
-	    if (!gotvars) {
-		gretl_errmsg_set(_("Variables information is missing"));
-		err = E_DATA;
+	    } else if (!xmlStrcmp(name, (XUC) "segments")) {
+		err = process_segments(cur, &segs);
 	    } else {
 		err = process_panel_info(cur, tmpset, &repad);
 		if (err) {
@@ -3950,12 +5090,18 @@ static int real_read_gdt (const char *fname, const char *srcname,
 	    }
 	}
 	if (!err) {
-	    cur = cur->next;
+	    /* move past the current element */
+	    ret = xmlTextReaderNext(reader);
 	}
     }
 
+    if (!err && ret < 0) {
+	gretl_errmsg_sprintf(_("xmlParseFile failed on %s"), fname);
+	err = E_DATA;
+    }
+
 #if GDT_DEBUG
-    fprintf(stderr, "done walking XML tree, err = %d\n", err);
+    fprintf(stderr, "done reading XML stream, err = %d\n", err);
 #endif
 
     if (!err && !gotvars) {
@@ -3977,10 +5123,7 @@ static int real_read_gdt (const char *fname, const char *srcname,
     }
 
     if (!err) {
-	if (srcname == NULL) {
-	    srcname = fname;
-	}
-	data_read_message(srcname, tmpset, prn);
+	data_read_message(fname, tmpset, prn);
 	err = merge_or_replace_data(dset, &tmpset,
 				    get_merge_opts(opt), prn);
     }
@@ -3991,10 +5134,12 @@ static int real_read_gdt (const char *fname, const char *srcname,
 	gretl_pop_c_numeric_locale();
     }
 
-    if (doc != NULL) {
-	xmlFreeDoc(doc);
+    if (reader != NULL) {
+	xmlFreeTextReader(reader);
     }
 
+    free(segs.seg);
+
     /* pre-process stacked cross-sectional panels: put into canonical
        stacked time series form
     */
@@ -4041,6 +5186,7 @@ static int real_read_gdt_subset (const char *fname,
 				 gretlopt opt)
 {
     DATASET *tmpset;
+    gdt_seglist segs = {0, NULL};
     xmlDocPtr doc = NULL;
     xmlNodePtr cur;
     double gdtversion = 1.0;
@@ -4059,7 +5205,7 @@ static int real_read_gdt_subset (const char *fname,
 	goto bailout;
     }
 
-    err = gretl_xml_open_doc_root(fname, "gretldata", &doc, &cur);
+    err = gdt_open_doc_root(fname, &doc, &cur);
     if (err) {
 	goto bailout;
     }
@@ -4119,7 +5265,7 @@ static int real_read_gdt_subset (const char *fname,
 		err = read_observations_subset(doc, cur, tmpset,
 					       binary, gdtversion,
 					       fname, fullv, vlist,
-					       opt);
+					       &segs, opt);
 	    }
 	    if (!err) {
 		gotobs = 1;
@@ -4131,6 +5277,8 @@ static int real_read_gdt_subset (const char *fname,
 	    } else {
 		err = process_string_tables(doc, cur, tmpset, 1);
 	    }
+	} else if (!xmlStrcmp(cur->name, (XUC) "segments")) {
+	    err = process_segments(cur, &segs);
 	}
 	if (!err) {
 	    cur = cur->next;
@@ -4165,6 +5313,8 @@ static int real_read_gdt_subset (const char *fname,
 	xmlFreeDoc(doc);
     }
 
+    free(segs.seg);
+
     if (!err) {
 	*dset = *tmpset;
 	free(tmpset);
@@ -4199,7 +5349,7 @@ static int real_read_gdt_varnames (const char *fname,
 	goto bailout;
     }
 
-    err = gretl_xml_open_doc_root(fname, "gretldata", &doc, &cur);
+    err = gdt_open_doc_root(fname, &doc, &cur);
     if (err) {
 	goto bailout;
     }
@@ -4274,6 +5424,357 @@ static int real_read_gdt_varnames (const char *fname,
     return err;
 }
 
+/* Convert the "--cols" specification for reading from a native
+   data file into a list of series IDs in the file. As with CSV
+   import this may be a list of 1-based column numbers, but we
+   also accept a list of series names.
+*/
+
+static int *gdt_cols_list (const char *fname, const char *cols,
+			   int *err)
+{
+    int *list = NULL;
+
+    if (strspn(cols, "0123456789,- ") == strlen(cols)) {
+	list = gretl_list_from_string(cols, err);
+    } else {
+	char **vnames = NULL;
+	int nv = 0;
+
+	*err = gretl_read_gdt_varnames(fname, &vnames, &nv);
+
+	if (!*err) {
+	    gchar **S = g_strsplit_set(cols, " ,", -1);
+	    int i, j;
+
+	    list = gretl_null_list();
+	    for (j=0; S[j] != NULL && !*err; j++) {
+		if (*S[j] == '\0') {
+		    continue;
+		}
+		for (i=1; i<nv; i++) {
+		    if (!strcmp(S[j], vnames[i])) {
+			break;
+		    }
+		}
+		if (i == nv) {
+		    gretl_errmsg_sprintf(_("Unknown variable '%s'"), S[j]);
+		    *err = E_UNKVAR;
+		} else if (!in_gretl_list(list, i)) {
+		    gretl_list_append_term(&list, i);
+		}
+	    }
+	    g_strfreev(S);
+	    strings_array_free(vnames, nv);
+	}
+    }
+
+    if (!*err && (list == NULL || list[0] == 0)) {
+	*err = E_DATA;
+    }
+
+    if (*err) {
+	free(list);
+	list = NULL;
+    }
+
+    return list;
+}
+
+static int read_gdt_columns (const char *fname, DATASET *dset,
+			     gretlopt opt, PRN *prn)
+{
+    DATASET *tmpset = NULL;
+    const char *cols;
+    int *vlist = NULL;
+    int ci, err = 0;
+
+    ci = (dset != NULL && dset->v > 0)? APPEND : OPEN;
+    cols = get_optval_string(ci, OPT_L);
+    if (cols == NULL || *cols == '\0') {
+	return E_PARSE;
+    }
+
+    vlist = gdt_cols_list(fname, cols, &err);
+
+    if (!err) {
+	tmpset = datainfo_new();
+	if (tmpset == NULL) {
+	    err = E_ALLOC;
+	}
+    }
+
+    if (!err) {
+	err = gretl_read_gdt_subset(fname, tmpset, vlist, OPT_M);
+    }
+
+    if (!err) {
+	data_read_message(fname, tmpset, prn);
+	err = merge_or_replace_data(dset, &tmpset,
+				    get_merge_opts(opt), prn);
+    } else if (tmpset != NULL) {
+	destroy_dataset(tmpset);
+    }
+
+    free(vlist);
+
+    return err;
+}
+
+/* Support for "store --append" with .gdtb files: rather than
+   rewriting the whole file we add zip members holding just the new
+   rows of the series already present and the full length of any
+   new series, plus a revised data.xml that records how the blocks
+   fit together (see read_binary_segments).
+*/
+
+static int write_binary_segment (const char *path, const DATASET *dset,
+				 const int *list, const gdt_segment *seg)
+{
+    int nt = seg->t2 - seg->t1 + 1;
+    int i, err;
+    FILE *fp;
+
+    fp = gretl_fopen(path, "wb");
+    if (fp == NULL) {
+	return E_FOPEN;
+    }
+
+    err = write_binary_header(fp);
+
+    for (i=seg->v1; i<=seg->v2 && !err; i++) {
+	if (fwrite(dset->Z[list[i]] + seg->t1, sizeof(double),
+		   nt, fp) != nt) {
+	    err = E_DATA;
+	}
+    }
+
+    if (fclose(fp) != 0 && !err) {
+	err = E_DATA;
+    }
+
+    return err;
+}
+
+/* Get what we need to know about the existing file @fname in order
+   to append to it: the names of its series, its number of
+   observations and its segments, if any. We also check that the
+   file is compatible with @dset.
+*/
+
+static int gdt_append_info (const char *fname, const DATASET *dset,
+			    char ***pnames, int *pnv, int *pnobs,
+			    gdt_seglist *sl)
+{
+    char stobs[OBSLEN];
+    xmlDocPtr doc = NULL;
+    xmlNodePtr root, cur, vn;
+    xmlChar *tmp;
+    int structure = 0, pd = 1;
+    int err;
+
+    err = gdt_open_doc_root(fname, &doc, &root);
+    if (err) {
+	return err;
+    }
+
+    if (get_gdt_version(root) < 1.4 ||
+	gdt_binary_order(root) != G_BYTE_ORDER) {
+	gretl_errmsg_sprintf(_("%s: can't append to this file; please "
+			       "save it afresh"), fname);
+	err = E_DATA;
+    }
+
+    if (!err) {
+	err = xml_get_data_structure(root, &structure);
+    }
+
+    if (!err) {
+	err = xml_get_data_frequency(root, &pd, &structure);
+    }
+
+    if (!err) {
+	tmp = xmlGetProp(root, (XUC) "startobs");
+	ntodate(stobs, 0, dset);
+	if (structure != dset->structure || pd != dset->pd ||
+	    tmp == NULL || strcmp((char *) tmp, stobs)) {
+	    gretl_errmsg_sprintf(_("%s: the data structure does not "
+				   "match the current dataset"), fname);
+	    err = E_DATA;
+	}
+	free(tmp);
+    }
+
+    cur = (err)? NULL : root->xmlChildrenNode;
+
+    while (cur != NULL && !err) {
+	if (!xmlStrcmp(cur->name, (XUC) "variables")) {
+	    vn = cur->xmlChildrenNode;
+	    while (vn != NULL && !err) {
+		if (!xmlStrcmp(vn->name, (XUC) "variable")) {
+		    tmp = xmlGetProp(vn, (XUC) "name");
+		    if (tmp == NULL) {
+			err = E_DATA;
+		    } else {
+			err = strings_array_add(pnames, pnv, (char *) tmp);
+			free(tmp);
+		    }
+		}
+		vn = vn->next;
+	    }
+	} else if (!xmlStrcmp(cur->name, (XUC) "observations")) {
+	    gretl_xml_get_prop_as_int(cur, "count", pnobs);
+	} else if (!xmlStrcmp(cur->name, (XUC) "segments")) {
+	    err = process_segments(cur, sl);
+	}
+	cur = cur->next;
+    }
+
+    if (!err && (*pnv == 0 || *pnobs <= 0)) {
+	err = E_DATA;
+    }
+
+    xmlFreeDoc(doc);
+
+    return err;
+}
+
+static gdt_segment *add_segment (gdt_seglist *sl, int v1, int v2,
+				 int t1, int t2)
+{
+    gdt_segment *seg = &sl->seg[sl->n];
+
+    if (sl->n == 0) {
+	strcpy(seg->member, "data.bin");
+    } else {
+	sprintf(seg->member, "data%d.bin", sl->n);
+    }
+    seg->v1 = v1;
+    seg->v2 = v2;
+    seg->t1 = t1;
+    seg->t2 = t2;
+    sl->n += 1;
+
+    return seg;
+}
+
+static int append_gdtb (const char *fname, const int *list,
+			const DATASET *dset, gretlopt opt)
+{
+    gdt_seglist sl = {0, NULL};
+    const char *members[4] = {NULL};
+    char **vnames = NULL;
+    char path[FILENAME_MAX];
+    gchar *zdir = NULL;
+    gdt_segment *seg;
+    int *wlist = NULL;
+    int T = dset->t2 + 1;
+    int nv0 = 0, T0 = 0;
+    int i, v, n, nm = 0, nnew = 0;
+    int err = 0;
+
+    if (dset->t1 > 0) {
+	gretl_errmsg_set(_("store --append: the sample must start at "
+			   "the first observation"));
+	return E_DATA;
+    }
+
+    err = gdt_append_info(fname, dset, &vnames, &nv0, &T0, &sl);
+
+    if (!err && (T0 > T || strings_array_position(vnames, nv0,
+						   "unit__") >= 0)) {
+	gretl_errmsg_sprintf(_("%s: can't append to this file; please "
+			       "save it afresh"), fname);
+	err = E_DATA;
+    }
+
+    if (!err) {
+	n = (list != NULL)? list[0] : dset->v - 1;
+	wlist = gretl_list_new(nv0 + n);
+	if (wlist == NULL) {
+	    err = E_ALLOC;
+	} else {
+	    wlist[0] = 0;
+	}
+    }
+
+    /* the series already in the file come first, in file order */
+    for (i=0; i<nv0 && !err; i++) {
+	v = current_series_index(dset, vnames[i]);
+	if (v < 1) {
+	    gretl_errmsg_sprintf(_("%s: series '%s' is not present in "
+				   "the current dataset"), fname, vnames[i]);
+	    err = E_DATA;
+	} else {
+	    wlist[++wlist[0]] = v;
+	}
+    }
+
+    /* followed by any new ones */
+    for (i=1; i<=n && !err; i++) {
+	v = (list != NULL)? list[i] : i;
+	if (v > 0 && !in_gretl_list(wlist, v)) {
+	    wlist[++wlist[0]] = v;
+	    nnew++;
+	}
+    }
+
+    if (err || (T == T0 && nnew == 0)) {
+	/* error, or nothing to add */
+	goto bailout;
+    }
+
+    seg = realloc(sl.seg, (sl.n + 3) * sizeof *seg);
+    if (seg == NULL) {
+	err = E_ALLOC;
+	goto bailout;
+    }
+    sl.seg = seg;
+
+    if (sl.n == 0) {
+	/* the original payload becomes the first segment */
+	add_segment(&sl, 1, nv0, 0, T0 - 1);
+    }
+
+    zdir = g_strdup_printf("%stmp-zip", gretl_dotdir());
+    err = gretl_mkdir(zdir);
+
+    if (!err && T > T0) {
+	seg = add_segment(&sl, 1, nv0, T0, T - 1);
+	gretl_build_path(path, zdir, seg->member, NULL);
+	err = write_binary_segment(path, dset, wlist, seg);
+	members[nm++] = seg->member;
+    }
+
+    if (!err && nnew > 0) {
+	seg = add_segment(&sl, nv0 + 1, nv0 + nnew, 0, T - 1);
+	gretl_build_path(path, zdir, seg->member, NULL);
+	err = write_binary_segment(path, dset, wlist, seg);
+	members[nm++] = seg->member;
+    }
+
+    if (!err) {
+	gretl_build_path(path, zdir, "data.xml", NULL);
+	err = real_write_gdt(path, wlist, dset, opt | OPT_B, 0, &sl, 0);
+	members[nm++] = "data.xml";
+    }
+
+    if (!err) {
+	err = gretl_zip_append_datafiles(fname, zdir, members);
+    }
+
+    gretl_deltree(zdir);
+    g_free(zdir);
+
+ bailout:
+
+    strings_array_free(vnames, nv0);
+    free(sl.seg);
+    free(wlist);
+
+    return err;
+}
+
 /**
  * gretl_read_gdt:
  * @fname: name of file to open for reading.
@@ -4291,43 +5792,14 @@ static int real_read_gdt_varnames (const char *fname,
 int gretl_read_gdt (const char *fname, DATASET *dset,
 		    gretlopt opt, PRN *prn)
 {
-    if (has_suffix(fname, ".gdtb")) {
-	/* zipfile with gdt + binary */
-	gchar *zdir;
-	int id = -1;
-	int err;
-
-#ifdef HAVE_MPI
-	if (gretl_mpi_initialized()) {
-	    id = gretl_mpi_rank();
-	}
-#endif
-	if (id >= 0) {
-	    zdir = g_strdup_printf("%stmp%d-unzip", gretl_dotdir(), id);
-	} else {
-	    zdir = g_strdup_printf("%stmp-unzip", gretl_dotdir());
-	}
-	err = gretl_mkdir(zdir);
-
-	if (!err) {
-	    err = gretl_unzip_into(fname, zdir);
-	    if (err) {
-		gretl_errmsg_ensure("Problem opening data file");
-	    } else {
-		char xmlfile[FILENAME_MAX];
-
-		gretl_build_path(xmlfile, zdir, "data.xml", NULL);
-		err = real_read_gdt(xmlfile, fname, dset, opt, prn);
-	    }
-	    gretl_deltree(zdir);
-	}
-
-	g_free(zdir);
-	return err;
-    } else {
-	/* plain XML file */
-	return real_read_gdt(fname, NULL, dset, opt, prn);
+    if (opt & OPT_L) {
+	/* --cols: read selected series only */
+	return read_gdt_columns(fname, dset, opt, prn);
     }
+
+    /* note: in the case of a .gdtb or .gdtc zipfile the XML and
+       binary components are read directly from the archive */
+    return real_read_gdt(fname, dset, opt, prn);
 }
 
 /**
@@ -4347,34 +5819,7 @@ int gretl_read_gdt (const char *fname, DATASET *dset,
 int gretl_read_gdt_subset (const char *fname, DATASET *dset,
 			   int *vlist, gretlopt opt)
 {
-    int err = 0;
-
-    if (has_suffix(fname, ".gdtb")) {
-	/* zipfile with gdt + binary */
-	gchar *zdir;
-	int err;
-
-	zdir = g_strdup_printf("%stmp-unzip", gretl_dotdir());
-	err = gretl_mkdir(zdir);
-
-	if (!err) {
-	    err = gretl_unzip_into(fname, zdir);
-	    if (err) {
-		gretl_errmsg_ensure("Problem opening data file");
-	    } else {
-		char xmlfile[FILENAME_MAX];
-
-		gretl_build_path(xmlfile, zdir, "data.xml", NULL);
-		err = real_read_gdt_subset(xmlfile, dset, vlist, opt);
-	    }
-	    gretl_deltree(zdir);
-	}
-
-	g_free(zdir);
-    } else {
-	/* plain XML file */
-	err = real_read_gdt_subset(fname, dset, vlist, opt);
-    }
+    int err = real_read_gdt_subset(fname, dset, vlist, opt);
 
 #if GDT_DEBUG
     fprintf(stderr, "gretl_read_gdt_subset: returning %d\n", err);
@@ -4398,37 +5843,7 @@ int gretl_read_gdt_varnames (const char *fname,
 			     char ***vnames,
 			     int *nvars)
 {
-    int err = 0;
-
-    if (has_suffix(fname, ".gdtb")) {
-	/* zipfile with gdt + binary */
-	gchar *zdir;
-	int err;
-
-	zdir = g_strdup_printf("%stmp-unzip", gretl_dotdir());
-	err = gretl_mkdir(zdir);
-
-	if (!err) {
-	    err = gretl_unzip_into(fname, zdir);
-	    if (err) {
-		gretl_errmsg_ensure("Problem opening data file");
-	    } else {
-		char xmlfile[FILENAME_MAX];
-
-		gretl_build_path(xmlfile, zdir, "data.xml", NULL);
-		err = real_read_gdt_varnames(xmlfile, vnames,
-					     nvars);
-	    }
-	    gretl_deltree(zdir);
-	}
-
-	g_free(zdir);
-    } else {
-	/* plain XML file */
-	err = real_read_gdt_varnames(fname, vnames, nvars);
-    }
-
-    return err;
+    return real_read_gdt_varnames(fname, vnames, nvars);
 }
 
 /**
@@ -4449,13 +5864,7 @@ char *gretl_get_gdt_description (const char *fname, int *err)
 
     gretl_error_clear();
 
-    if (has_suffix(fname, ".gdtb")) {
-	gretl_errmsg_set("Binary data file, cannot access description");
-	*err = E_DATA;
-	return NULL;
-    }
-
-    *err = gretl_xml_open_doc_root(fname, "gretldata", &doc, &cur);
+    *err = gdt_open_doc_root(fname, &doc, &cur);
     if (*err) {
 	return NULL;
     }
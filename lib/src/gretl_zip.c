@@ -24,6 +24,12 @@
 #include "libgretl.h"
 #include "gretl_zip.h"
 
+#ifdef G_OS_WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
 static int handle_zip_error (const char *fname,
 			     GError *gerr, int err,
 			     const char *action)
@@ -476,11 +482,24 @@ int gretl_unzip_session_file (const char *fname, gchar **zdirname)
 int gretl_zip_datafile (const char *fname, const char *path,
 			int level)
 {
+    gchar *jname;
+    int err;
+
 #if USE_GSF
-    return gretl_gsf_zip_datafile(fname, path, level);
+    err = gretl_gsf_zip_datafile(fname, path, level);
 #else
-    return gretl_plugin_zip_datafile(fname, path, level);
+    err = gretl_plugin_zip_datafile(fname, path, level);
 #endif
+
+    if (!err) {
+	/* a full rewrite supersedes any interrupted append: see
+	   gretl_zip_append_datafiles() below */
+	jname = g_strdup_printf("%s.undo", fname);
+	gretl_remove(jname);
+	g_free(jname);
+    }
+
+    return err;
 }
 
 /* below: apparatus for making a zipfile for a function
@@ -749,3 +768,1031 @@ int package_make_zipfile (const char *gfnname,
 
     return err;
 }
+
+/* Direct access to the content of a single member of a zipfile,
+   using zlib. This avoids the round trip of unzipping into a
+   temporary directory when the caller just wants to consume the
+   member's data, as when reading a .gdtb or .gdtc file. Only the
+   "stored" and "deflated" methods are supported (which covers
+   anything written by gretl), along with the zip64 extensions
+   for large archives.
+*/
+
+#define ZIP_BUFSIZE 131072
+#define ZIP_MAXCOMMENT 65535
+
+#define ZIP_STORED   0
+#define ZIP_DEFLATED 8
+
+struct gretl_zipmember_ {
+    FILE *fp;         /* the zipfile */
+    int method;       /* ZIP_STORED or ZIP_DEFLATED */
+    guint64 csize;    /* compressed size of member */
+    guint64 usize;    /* uncompressed size of member */
+    guint64 cpos;     /* compressed bytes consumed so far */
+    guint64 upos;     /* uncompressed bytes delivered so far */
+    guint8 *zbuf;     /* input buffer for inflation */
+    z_stream zs;
+};
+
+static guint32 zget16 (const guint8 *b)
+{
+    return (guint32) b[0] | ((guint32) b[1] << 8);
+}
+
+static guint32 zget32 (const guint8 *b)
+{
+    return zget16(b) | (zget16(b + 2) << 16);
+}
+
+static guint64 zget64 (const guint8 *b)
+{
+    return (guint64) zget32(b) | ((guint64) zget32(b + 4) << 32);
+}
+
+static int zip_seek (FILE *fp, gint64 offset, int whence)
+{
+#ifdef G_OS_WIN32
+    return _fseeki64(fp, offset, whence);
+#else
+    return fseeko(fp, (off_t) offset, whence);
+#endif
+}
+
+static gint64 zip_tell (FILE *fp)
+{
+#ifdef G_OS_WIN32
+    return _ftelli64(fp);
+#else
+    return (gint64) ftello(fp);
+#endif
+}
+
+static int zip_read_at (FILE *fp, gint64 offset, guint8 *buf,
+			size_t len)
+{
+    if (zip_seek(fp, offset, SEEK_SET) != 0 ||
+	fread(buf, 1, len, fp) != len) {
+	return E_DATA;
+    } else {
+	return 0;
+    }
+}
+
+/* Find the offset and size of the central directory of the zipfile
+   attached to @fp, via the end-of-central-directory record (and
+   its zip64 counterpart if present).
+*/
+
+static int zip_find_directory (FILE *fp, gint64 *cdoff, gint64 *cdsize)
+{
+    guint8 *buf = NULL, *p = NULL;
+    gint64 fsize, start, eocd;
+    size_t len;
+    int err = 0;
+
+    if (zip_seek(fp, 0, SEEK_END) != 0 || (fsize = zip_tell(fp)) < 22) {
+	return E_DATA;
+    }
+
+    len = MIN(fsize, 22 + ZIP_MAXCOMMENT);
+    start = fsize - len;
+    buf = malloc(len);
+    if (buf == NULL) {
+	return E_ALLOC;
+    }
+
+    err = zip_read_at(fp, start, buf, len);
+
+    if (!err) {
+	/* scan backward for the signature "PK\5\6" */
+	for (p = buf + len - 22; p >= buf; p--) {
+	    if (zget32(p) == 0x06054b50) {
+		break;
+	    }
+	}
+	if (p < buf) {
+	    err = E_DATA;
+	}
+    }
+
+    if (!err) {
+	eocd = start + (p - buf);
+	*cdsize = zget32(p + 12);
+	*cdoff = zget32(p + 16);
+	if ((*cdsize == 0xffffffff || *cdoff == 0xffffffff ||
+	     zget16(p + 10) == 0xffff) && eocd >= 20) {
+	    /* look for the zip64 locator, then the zip64 record */
+	    guint8 z64[56];
+
+	    err = zip_read_at(fp, eocd - 20, z64, 20);
+	    if (!err && zget32(z64) == 0x07064b50) {
+		err = zip_read_at(fp, (gint64) zget64(z64 + 8), z64, 56);
+		if (!err && zget32(z64) == 0x06064b50) {
+		    *cdsize = zget64(z64 + 40);
+		    *cdoff = zget64(z64 + 48);
+		} else {
+		    err = E_DATA;
+		}
+	    }
+	}
+    }
+
+    if (!err && (*cdoff < 0 || *cdsize <= 0 || *cdoff + *cdsize > fsize)) {
+	err = E_DATA;
+    }
+
+    free(buf);
+
+    return err;
+}
+
+/* Pick out the 64-bit values that stand in for any saturated 32-bit
+   fields in a central directory entry, from the zip64 "extra" field
+   @x of length @xlen.
+*/
+
+static void zip64_extra_info (const guint8 *x, int xlen,
+			      guint64 *usize, guint64 *csize,
+			      guint64 *loff)
+{
+    const guint8 *q, *stop = x + xlen;
+    int id, sz;
+
+    while (x + 4 <= stop) {
+	id = zget16(x);
+	sz = zget16(x + 2);
+	q = x + 4;
+	if (id == 0x0001) {
+	    if (*usize == 0xffffffff && q + 8 <= stop) {
+		*usize = zget64(q);
+		q += 8;
+	    }
+	    if (*csize == 0xffffffff && q + 8 <= stop) {
+		*csize = zget64(q);
+		q += 8;
+	    }
+	    if (*loff == 0xffffffff && q + 8 <= stop) {
+		*loff = zget64(q);
+	    }
+	    break;
+	}
+	x += 4 + sz;
+    }
+}
+
+/* Find the entry named @name in the central directory, @cd, of
+   length @cdsize, and fill out @zm accordingly. On success the
+   return value is the offset of the local header for @name.
+*/
+
+static gint64 zip_find_member (const guint8 *cd, gint64 cdsize,
+			       const char *name, gretl_zipmember *zm)
+{
+    const guint8 *p = cd, *stop = cd + cdsize;
+    int namelen = strlen(name);
+    int nlen, xlen, clen;
+
+    while (p + 46 <= stop && zget32(p) == 0x02014b50) {
+	nlen = zget16(p + 28);
+	xlen = zget16(p + 30);
+	clen = zget16(p + 32);
+	if (p + 46 + nlen + xlen > stop) {
+	    break;
+	}
+	if (nlen == namelen && !strncmp((const char *) p + 46, name, nlen)) {
+	    guint64 loff = zget32(p + 42);
+
+	    if (zget16(p + 8) & 1) {
+		/* encrypted: not supported */
+		return -1;
+	    }
+	    zm->method = zget16(p + 10);
+	    zm->csize = zget32(p + 20);
+	    zm->usize = zget32(p + 24);
+	    zip64_extra_info(p + 46 + nlen, xlen, &zm->usize,
+			     &zm->csize, &loff);
+	    return (gint64) loff;
+	}
+	p += 46 + nlen + xlen + clen;
+    }
+
+    return -1;
+}
+
+static int zip_undo_append (const char *fname);
+
+struct gretl_zipfile_ {
+    gchar *fname;     /* name of the zipfile */
+    guint8 *cd;       /* copy of its central directory */
+    gint64 cdoff;     /* offset of the central directory */
+    gint64 cdsize;    /* size of the central directory */
+};
+
+/**
+ * gretl_zipfile_open:
+ * @fname: name of zipfile.
+ * @err: location to receive error code.
+ *
+ * Reads the central directory of the zipfile @fname, in
+ * preparation for accessing one or more of its members via
+ * gretl_zipfile_get_member().
+ *
+ * Returns: allocated handle, or NULL on failure. The handle
+ * should be freed by calling gretl_zipfile_close().
+ */
+
+gretl_zipfile *gretl_zipfile_open (const char *fname, int *err)
+{
+    gretl_zipfile *zf;
+    FILE *fp;
+
+    /* repair the effect of any interrupted append; if this fails
+       (e.g. the file is read-only) we go ahead regardless */
+    zip_undo_append(fname);
+
+    fp = gretl_fopen(fname, "rb");
+    if (fp == NULL) {
+	*err = E_FOPEN;
+	return NULL;
+    }
+
+    zf = calloc(1, sizeof *zf);
+    if (zf == NULL) {
+	*err = E_ALLOC;
+    } else {
+	*err = zip_find_directory(fp, &zf->cdoff, &zf->cdsize);
+    }
+
+    if (!*err) {
+	zf->fname = g_strdup(fname);
+	zf->cd = malloc(zf->cdsize);
+	if (zf->cd == NULL) {
+	    *err = E_ALLOC;
+	} else {
+	    *err = zip_read_at(fp, zf->cdoff, zf->cd, zf->cdsize);
+	}
+    }
+
+    fclose(fp);
+
+    if (*err) {
+	gretl_errmsg_ensure("Problem opening data file");
+	gretl_zipfile_close(zf);
+	zf = NULL;
+    }
+
+    return zf;
+}
+
+/**
+ * gretl_zipfile_close:
+ * @zf: zipfile handle.
+ *
+ * Frees the handle @zf. Note that this does not affect any
+ * members obtained via @zf, which must be closed separately.
+ */
+
+void gretl_zipfile_close (gretl_zipfile *zf)
+{
+    if (zf != NULL) {
+	g_free(zf->fname);
+	free(zf->cd);
+	free(zf);
+    }
+}
+
+/**
+ * gretl_zipfile_get_member:
+ * @zf: zipfile handle.
+ * @name: name of the member of @zf to be read.
+ * @err: location to receive error code.
+ *
+ * Opens the member @name of @zf for reading. Its content can
+ * then be obtained, in sequence, via gretl_zipmember_read() and
+ * gretl_zipmember_skip().
+ *
+ * Returns: allocated handle, or NULL on failure. The handle
+ * should be freed by calling gretl_zipmember_close().
+ */
+
+gretl_zipmember *gretl_zipfile_get_member (gretl_zipfile *zf,
+					   const char *name,
+					   int *err)
+{
+    gretl_zipmember *zm;
+    guint8 lhdr[30];
+    gint64 loff;
+
+    zm = calloc(1, sizeof *zm);
+    if (zm == NULL) {
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    loff = zip_find_member(zf->cd, zf->cdsize, name, zm);
+    if (loff < 0) {
+	gretl_errmsg_sprintf("%s: couldn't find '%s'", zf->fname, name);
+	*err = E_DATA;
+    } else if (zm->method != ZIP_STORED && zm->method != ZIP_DEFLATED) {
+	gretl_errmsg_sprintf("%s: unsupported compression method",
+			     zf->fname);
+	*err = E_DATA;
+    } else {
+	zm->fp = gretl_fopen(zf->fname, "rb");
+	if (zm->fp == NULL) {
+	    *err = E_FOPEN;
+	}
+    }
+
+    if (!*err) {
+	/* skip the local header to position @fp at the data */
+	*err = zip_read_at(zm->fp, loff, lhdr, 30);
+	if (!*err && zget32(lhdr) != 0x04034b50) {
+	    *err = E_DATA;
+	}
+	if (!*err) {
+	    loff += 30 + zget16(lhdr + 26) + zget16(lhdr + 28);
+	    if (zip_seek(zm->fp, loff, SEEK_SET) != 0) {
+		*err = E_DATA;
+	    }
+	}
+    }
+
+    if (!*err && zm->method == ZIP_DEFLATED) {
+	zm->zbuf = malloc(ZIP_BUFSIZE);
+	if (zm->zbuf == NULL) {
+	    *err = E_ALLOC;
+	} else if (inflateInit2(&zm->zs, -MAX_WBITS) != Z_OK) {
+	    free(zm->zbuf);
+	    zm->zbuf = NULL;
+	    *err = E_ALLOC;
+	}
+    }
+
+    if (*err) {
+	gretl_errmsg_ensure("Problem opening data file");
+	if (zm->fp != NULL) {
+	    fclose(zm->fp);
+	}
+	free(zm);
+	zm = NULL;
+    }
+
+    return zm;
+}
+
+/**
+ * gretl_zipmember_open:
+ * @fname: name of zipfile.
+ * @name: name of the member of @fname to be read.
+ * @err: location to receive error code.
+ *
+ * Shortcut for opening the single member @name of the zipfile
+ * @fname; see gretl_zipfile_get_member().
+ *
+ * Returns: allocated handle, or NULL on failure. The handle
+ * should be freed by calling gretl_zipmember_close().
+ */
+
+gretl_zipmember *gretl_zipmember_open (const char *fname,
+				       const char *name,
+				       int *err)
+{
+    gretl_zipmember *zm = NULL;
+    gretl_zipfile *zf;
+
+    zf = gretl_zipfile_open(fname, err);
+    if (zf != NULL) {
+	zm = gretl_zipfile_get_member(zf, name, err);
+	gretl_zipfile_close(zf);
+    }
+
+    return zm;
+}
+
+static gint64 zip_inflate_into (gretl_zipmember *zm, guint8 *buf,
+				guint64 len)
+{
+    z_stream *zs = &zm->zs;
+    guint64 done = 0;
+    int ret = Z_OK;
+
+    while (done < len && ret != Z_STREAM_END) {
+	uInt chunk = (uInt) MIN(len - done, 1 << 30);
+
+	if (zs->avail_in == 0 && zm->cpos < zm->csize) {
+	    size_t want = MIN(ZIP_BUFSIZE, zm->csize - zm->cpos);
+
+	    if (fread(zm->zbuf, 1, want, zm->fp) != want) {
+		return -1;
+	    }
+	    zm->cpos += want;
+	    zs->next_in = zm->zbuf;
+	    zs->avail_in = want;
+	}
+	zs->next_out = buf + done;
+	zs->avail_out = chunk;
+	ret = inflate(zs, Z_NO_FLUSH);
+	if (ret != Z_OK && ret != Z_STREAM_END) {
+	    /* includes truncation of the compressed data */
+	    return -1;
+	}
+	done += chunk - zs->avail_out;
+    }
+
+    return (gint64) done;
+}
+
+/**
+ * gretl_zipmember_read:
+ * @zm: zip member handle.
+ * @buf: location to receive data.
+ * @len: the number of bytes wanted.
+ *
+ * Reads up to @len bytes of the uncompressed content of @zm,
+ * continuing from the point reached by any previous calls.
+ *
+ * Returns: the number of bytes read, which will be less than
+ * @len only at the end of the member's content, or -1 on error.
+ */
+
+gint64 gretl_zipmember_read (gretl_zipmember *zm, void *buf,
+			     guint64 len)
+{
+    gint64 got;
+
+    len = MIN(len, zm->usize - zm->upos);
+    if (len == 0) {
+	return 0;
+    }
+
+    if (zm->method == ZIP_STORED) {
+	got = fread(buf, 1, len, zm->fp);
+    } else {
+	got = zip_inflate_into(zm, buf, len);
+    }
+
+    if (got >= 0) {
+	zm->upos += got;
+    }
+
+    return got;
+}
+
+/**
+ * gretl_zipmember_skip:
+ * @zm: zip member handle.
+ * @len: the number of bytes to skip.
+ *
+ * Advances past @len bytes of the content of @zm. In the case of
+ * a member that is stored uncompressed this is just a seek.
+ *
+ * Returns: 0 on success, non-zero on error.
+ */
+
+int gretl_zipmember_skip (gretl_zipmember *zm, guint64 len)
+{
+    if (len > zm->usize - zm->upos) {
+	return E_DATA;
+    }
+
+    if (zm->method == ZIP_STORED) {
+	if (zip_seek(zm->fp, (gint64) len, SEEK_CUR) != 0) {
+	    return E_DATA;
+	}
+	zm->upos += len;
+    } else {
+	guint8 *tmp = malloc(ZIP_BUFSIZE);
+	gint64 got;
+
+	if (tmp == NULL) {
+	    return E_ALLOC;
+	}
+	while (len > 0) {
+	    got = gretl_zipmember_read(zm, tmp, MIN(len, ZIP_BUFSIZE));
+	    if (got <= 0) {
+		break;
+	    }
+	    len -= got;
+	}
+	free(tmp);
+	if (len > 0) {
+	    return E_DATA;
+	}
+    }
+
+    return 0;
+}
+
+/**
+ * gretl_zipmember_close:
+ * @zm: zip member handle.
+ *
+ * Closes the zipfile associated with @zm and frees the handle.
+ */
+
+void gretl_zipmember_close (gretl_zipmember *zm)
+{
+    if (zm != NULL) {
+	if (zm->zbuf != NULL) {
+	    inflateEnd(&zm->zs);
+	    free(zm->zbuf);
+	}
+	fclose(zm->fp);
+	free(zm);
+    }
+}
+
+/* Support for adding members to an existing zipfile in place */
+
+static void zput16 (guint8 *b, guint32 x)
+{
+    b[0] = x & 0xff;
+    b[1] = (x >> 8) & 0xff;
+}
+
+static void zput32 (guint8 *b, guint32 x)
+{
+    zput16(b, x & 0xffff);
+    zput16(b + 2, x >> 16);
+}
+
+static void zput64 (guint8 *b, guint64 x)
+{
+    zput32(b, (guint32) (x & 0xffffffff));
+    zput32(b + 4, (guint32) (x >> 32));
+}
+
+static void zip_dos_time (guint32 *dtime, guint32 *ddate)
+{
+    time_t now = time(NULL);
+    struct tm *lt = localtime(&now);
+
+    *dtime = (lt->tm_hour << 11) | (lt->tm_min << 5) | (lt->tm_sec / 2);
+    *ddate = ((lt->tm_year - 80) << 9) | ((lt->tm_mon + 1) << 5) |
+	lt->tm_mday;
+}
+
+static int zip_sync_file (FILE *fp)
+{
+    if (fflush(fp) != 0) {
+	return E_FOPEN;
+    }
+#ifdef G_OS_WIN32
+    _commit(_fileno(fp));
+#else
+    fsync(fileno(fp));
+#endif
+    return 0;
+}
+
+static int zip_truncate (FILE *fp, gint64 len)
+{
+    if (fflush(fp) != 0) {
+	return E_FOPEN;
+    }
+#ifdef G_OS_WIN32
+    if (_chsize_s(_fileno(fp), len) != 0) {
+	return E_FOPEN;
+    }
+#else
+    if (ftruncate(fileno(fp), (off_t) len) != 0) {
+	return E_FOPEN;
+    }
+#endif
+    return 0;
+}
+
+/* The "undo" journal for an append to the zipfile @fname: this
+   records the offset of the central directory along with the
+   original bytes from there to the end of the file (the directory
+   plus end-of-directory records). It is synced to disk before
+   @fname is touched and removed once the append is complete. So
+   if it exists and is intact, an append was interrupted and
+   @fname can be restored by truncating it at the recorded offset
+   and writing back the original tail.
+
+   Layout: offset (8 bytes), tail length (8), tail, CRC of tail (4).
+*/
+
+static int zip_write_journal (const char *jname, gint64 cdoff,
+			      const guint8 *tail, gint64 len)
+{
+    guint8 b[16];
+    FILE *fj;
+    int err = 0;
+
+    fj = gretl_fopen(jname, "wb");
+    if (fj == NULL) {
+	return E_FOPEN;
+    }
+
+    zput64(b, cdoff);
+    zput64(b + 8, len);
+    if (fwrite(b, 1, 16, fj) != 16 ||
+	fwrite(tail, 1, len, fj) != len) {
+	err = E_FOPEN;
+    } else {
+	zput32(b, crc32(crc32(0L, Z_NULL, 0), tail, len));
+	if (fwrite(b, 1, 4, fj) != 4) {
+	    err = E_FOPEN;
+	}
+    }
+
+    if (!err) {
+	err = zip_sync_file(fj);
+    }
+    if (fclose(fj) != 0 && !err) {
+	err = E_FOPEN;
+    }
+
+    return err;
+}
+
+/* If there's an intact journal for @fname, roll back the append
+   it records; then remove the journal. A journal that is
+   incomplete means the append never got as far as modifying
+   @fname, so it is simply removed.
+*/
+
+static int zip_undo_append (const char *fname)
+{
+    gchar *jname = g_strdup_printf("%s.undo", fname);
+    guint8 b[16], *tail = NULL;
+    gint64 cdoff = 0, len = 0;
+    int intact = 0;
+    FILE *fj, *fp;
+    int err = 0;
+
+    fj = gretl_fopen(jname, "rb");
+    if (fj == NULL) {
+	/* the usual case */
+	g_free(jname);
+	return 0;
+    }
+
+    if (fread(b, 1, 16, fj) == 16) {
+	cdoff = zget64(b);
+	len = zget64(b + 8);
+	if (cdoff >= 0 && len > 0 && len <= G_MAXINT32) {
+	    tail = malloc(len);
+	}
+    }
+    if (tail != NULL && fread(tail, 1, len, fj) == len &&
+	fread(b, 1, 4, fj) == 4 &&
+	zget32(b) == crc32(crc32(0L, Z_NULL, 0), tail, len)) {
+	intact = 1;
+    }
+    fclose(fj);
+
+    if (intact) {
+	fp = gretl_fopen(fname, "r+b");
+	if (fp == NULL) {
+	    err = E_FOPEN;
+	} else {
+	    err = zip_truncate(fp, cdoff);
+	    if (!err && (zip_seek(fp, cdoff, SEEK_SET) != 0 ||
+			 fwrite(tail, 1, len, fp) != len)) {
+		err = E_FOPEN;
+	    }
+	    if (!err) {
+		err = zip_sync_file(fp);
+	    }
+	    if (fclose(fp) != 0 && !err) {
+		err = E_FOPEN;
+	    }
+	}
+    }
+
+    if (!err) {
+	gretl_remove(jname);
+    }
+
+    free(tail);
+    g_free(jname);
+
+    return err;
+}
+
+/* Copy the file @src into @fp as a stored (uncompressed) member
+   named @name, starting at the current position, @loff, and append
+   the corresponding central directory entry to @cd.
+*/
+
+static int zip_add_stored_member (FILE *fp, gint64 loff,
+				  const char *src, const char *name,
+				  GByteArray *cd)
+{
+    guint8 hdr[46 + 28], *buf;
+    guint32 dtime, ddate;
+    guint32 crc = crc32(0L, Z_NULL, 0);
+    gint64 size;
+    size_t got;
+    int nlen = strlen(name);
+    int big, xlen;
+    FILE *fin;
+    int err = 0;
+
+    fin = gretl_fopen(src, "rb");
+    if (fin == NULL) {
+	return E_FOPEN;
+    }
+
+    if (zip_seek(fin, 0, SEEK_END) != 0 || (size = zip_tell(fin)) < 0 ||
+	zip_seek(fin, 0, SEEK_SET) != 0) {
+	fclose(fin);
+	return E_FOPEN;
+    }
+
+    buf = malloc(ZIP_BUFSIZE);
+    if (buf == NULL) {
+	fclose(fin);
+	return E_ALLOC;
+    }
+
+    /* write the local header, with zip64 sizes if needed */
+    big = size >= 0xffffffff;
+    xlen = big ? 20 : 0;
+    zip_dos_time(&dtime, &ddate);
+    memset(hdr, 0, sizeof hdr);
+    zput32(hdr, 0x04034b50);
+    zput16(hdr + 4, big ? 45 : 20);
+    zput16(hdr + 10, dtime);
+    zput16(hdr + 12, ddate);
+    zput32(hdr + 18, big ? 0xffffffff : (guint32) size);
+    zput32(hdr + 22, big ? 0xffffffff : (guint32) size);
+    zput16(hdr + 26, nlen);
+    zput16(hdr + 28, xlen);
+    if (big) {
+	zput16(hdr + 30, 0x0001);
+	zput16(hdr + 32, 16);
+	zput64(hdr + 34, size);
+	zput64(hdr + 42, size);
+    }
+    if (fwrite(hdr, 1, 30, fp) != 30 ||
+	fwrite(name, 1, nlen, fp) != nlen ||
+	fwrite(hdr + 30, 1, xlen, fp) != xlen) {
+	err = E_FOPEN;
+    }
+
+    /* copy the data, computing the CRC */
+    while (!err && (got = fread(buf, 1, ZIP_BUFSIZE, fin)) > 0) {
+	crc = crc32(crc, buf, got);
+	if (fwrite(buf, 1, got, fp) != got) {
+	    err = E_FOPEN;
+	}
+    }
+
+    if (!err && ferror(fin)) {
+	err = E_FOPEN;
+    }
+
+    if (!err) {
+	/* go back and fill in the CRC */
+	guint8 b4[4];
+
+	zput32(b4, crc);
+	if (zip_seek(fp, loff + 14, SEEK_SET) != 0 ||
+	    fwrite(b4, 1, 4, fp) != 4 ||
+	    zip_seek(fp, 0, SEEK_END) != 0) {
+	    err = E_FOPEN;
+	}
+    }
+
+    if (!err) {
+	/* compose the central directory entry */
+	int cbig = big || loff >= 0xffffffff;
+
+	xlen = (big ? 16 : 0) + (loff >= 0xffffffff ? 8 : 0);
+	xlen += (xlen > 0) ? 4 : 0;
+	memset(hdr, 0, sizeof hdr);
+	zput32(hdr, 0x02014b50);
+	zput16(hdr + 4, cbig ? 45 : 20);
+	zput16(hdr + 6, cbig ? 45 : 20);
+	zput16(hdr + 12, dtime);
+	zput16(hdr + 14, ddate);
+	zput32(hdr + 16, crc);
+	zput32(hdr + 20, big ? 0xffffffff : (guint32) size);
+	zput32(hdr + 24, big ? 0xffffffff : (guint32) size);
+	zput16(hdr + 28, nlen);
+	zput16(hdr + 30, xlen);
+	zput32(hdr + 42, loff >= 0xffffffff ? 0xffffffff : (guint32) loff);
+	g_byte_array_append(cd, hdr, 46);
+	g_byte_array_append(cd, (const guint8 *) name, nlen);
+	if (xlen > 0) {
+	    guint8 *x = hdr + 46;
+
+	    zput16(x, 0x0001);
+	    zput16(x + 2, xlen - 4);
+	    x += 4;
+	    if (big) {
+		zput64(x, size);
+		zput64(x + 8, size);
+		x += 16;
+	    }
+	    if (loff >= 0xffffffff) {
+		zput64(x, loff);
+	    }
+	    g_byte_array_append(cd, hdr + 46, xlen);
+	}
+    }
+
+    free(buf);
+    fclose(fin);
+
+    return err;
+}
+
+/* Write the central directory @cd, holding @n entries, at the
+   current position in @fp, followed by the end-of-directory
+   record(s).
+*/
+
+static int zip_write_directory (FILE *fp, GByteArray *cd, guint64 n)
+{
+    gint64 cdoff = zip_tell(fp);
+    guint8 rec[56 + 20 + 22];
+    guint8 *eocd = rec;
+    int z64, len = 22;
+
+    z64 = n >= 0xffff || cdoff >= 0xffffffff || cd->len >= 0xffffffff;
+
+    memset(rec, 0, sizeof rec);
+
+    if (z64) {
+	/* zip64 end of central directory record, plus locator */
+	zput32(rec, 0x06064b50);
+	zput64(rec + 4, 44);
+	zput16(rec + 12, 45);
+	zput16(rec + 14, 45);
+	zput64(rec + 24, n);
+	zput64(rec + 32, n);
+	zput64(rec + 40, cd->len);
+	zput64(rec + 48, cdoff);
+	zput32(rec + 56, 0x07064b50);
+	zput64(rec + 64, cdoff + cd->len);
+	zput32(rec + 72, 1);
+	eocd = rec + 76;
+	len += 76;
+    }
+
+    zput32(eocd, 0x06054b50);
+    zput16(eocd + 8, z64 ? 0xffff : n);
+    zput16(eocd + 10, z64 ? 0xffff : n);
+    zput32(eocd + 12, z64 ? 0xffffffff : cd->len);
+    zput32(eocd + 16, z64 ? 0xffffffff : (guint32) cdoff);
+
+    if (fwrite(cd->data, 1, cd->len, fp) != cd->len ||
+	fwrite(rec, 1, len, fp) != len) {
+	return E_FOPEN;
+    }
+
+    return 0;
+}
+
+/**
+ * gretl_zip_append_datafiles:
+ * @fname: name of existing zipfile.
+ * @path: directory holding the files to add.
+ * @names: %NULL-terminated array of names of files to add.
+ *
+ * Adds the specified files to @fname as stored members, in place:
+ * the new members overwrite the old central directory, following
+ * the last existing member, and a new directory is written after
+ * them. The existing members are not rewritten. Any existing members
+ * with the same names are superseded, but their data remain in the
+ * archive as dead space, so the file grows with each append until
+ * it is written afresh via gretl_zip_datafile().
+ *
+ * The original directory is first saved to a journal alongside
+ * @fname and the new members are synced to disk before the
+ * directory is written. If the append fails, or is interrupted,
+ * the journal is used to restore @fname to its prior state, at the
+ * latest when it is next opened via gretl_zipfile_open().
+ *
+ * Returns: 0 on success, non-zero code on error.
+ */
+
+int gretl_zip_append_datafiles (const char *fname, const char *path,
+				const char **names)
+{
+    char fullname[FILENAME_MAX];
+    GByteArray *cd = NULL;
+    guint8 *tail = NULL;
+    gchar *jname = NULL;
+    gint64 cdoff, cdsize, fsize = 0;
+    guint64 n = 0;
+    int journal = 0;
+    FILE *fp;
+    int i, err = 0;
+
+    /* first clean up after any earlier interrupted append */
+    err = zip_undo_append(fname);
+    if (err) {
+	gretl_errmsg_ensure("Problem writing data file");
+	return err;
+    }
+
+    fp = gretl_fopen(fname, "r+b");
+    if (fp == NULL) {
+	return E_FOPEN;
+    }
+
+    err = zip_find_directory(fp, &cdoff, &cdsize);
+    if (!err && (zip_seek(fp, 0, SEEK_END) != 0 ||
+		 (fsize = zip_tell(fp)) < cdoff + cdsize)) {
+	err = E_DATA;
+    }
+    if (!err) {
+	/* the directory plus end-of-directory record(s) */
+	tail = malloc(fsize - cdoff);
+	cd = g_byte_array_sized_new(cdsize + 512);
+	if (tail == NULL || cd == NULL) {
+	    err = E_ALLOC;
+	} else {
+	    err = zip_read_at(fp, cdoff, tail, fsize - cdoff);
+	}
+    }
+
+    if (!err) {
+	/* carry forward the entries for the retained members */
+	const guint8 *p = tail, *stop = tail + cdsize;
+	int nlen, elen, keep;
+
+	while (p + 46 <= stop && zget32(p) == 0x02014b50) {
+	    nlen = zget16(p + 28);
+	    elen = 46 + nlen + zget16(p + 30) + zget16(p + 32);
+	    keep = 1;
+	    for (i=0; names[i] != NULL && keep; i++) {
+		if (nlen == strlen(names[i]) &&
+		    !strncmp((const char *) p + 46, names[i], nlen)) {
+		    keep = 0;
+		}
+	    }
+	    if (keep) {
+		g_byte_array_append(cd, p, elen);
+		n++;
+	    }
+	    p += elen;
+	}
+    }
+
+    if (!err) {
+	jname = g_strdup_printf("%s.undo", fname);
+	err = zip_write_journal(jname, cdoff, tail, fsize - cdoff);
+	journal = 1;
+    }
+
+    if (!err) {
+	/* drop the old directory: the new members go in its place */
+	err = zip_truncate(fp, cdoff);
+	if (!err && zip_seek(fp, cdoff, SEEK_SET) != 0) {
+	    err = E_FOPEN;
+	}
+    }
+
+    for (i=0; names[i] != NULL && !err; i++) {
+	gretl_build_path(fullname, path, names[i], NULL);
+	err = zip_add_stored_member(fp, zip_tell(fp), fullname,
+				    names[i], cd);
+	n++;
+    }
+
+    if (!err) {
+	/* make sure the members are on disk before the directory
+	   that refers to them */
+	err = zip_sync_file(fp);
+    }
+    if (!err) {
+	err = zip_write_directory(fp, cd, n);
+    }
+    if (!err) {
+	err = zip_sync_file(fp);
+    }
+
+    if (fclose(fp) != 0 && !err) {
+	err = E_FOPEN;
+    }
+
+    if (journal) {
+	if (err) {
+	    /* put back the original directory */
+	    zip_undo_append(fname);
+	} else {
+	    gretl_remove(jname);
+	}
+    }
+
+    free(tail);
+    g_free(jname);
+    if (cd != NULL) {
+	g_byte_array_free(cd, TRUE);
+    }
+
+    if (err) {
+	gretl_errmsg_ensure("Problem writing data file");
+    }
+
+    return err;
+}
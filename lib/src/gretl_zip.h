@@ -31,6 +31,9 @@ int gretl_make_zipfile (const char *fname, const char *path);
 int gretl_zip_datafile (const char *fname, const char *path,
 			int level);
 
+int gretl_zip_append_datafiles (const char *fname, const char *path,
+				const char **names);
+
 int package_make_zipfile (const char *gfnname,
 			  int pdfdoc,
 			  char **datafiles,
@@ -40,4 +43,26 @@ int package_make_zipfile (const char *gfnname,
 			  gretlopt opt,
 			  PRN *prn);
 
+typedef struct gretl_zipfile_ gretl_zipfile;
+typedef struct gretl_zipmember_ gretl_zipmember;
+
+gretl_zipfile *gretl_zipfile_open (const char *fname, int *err);
+
+gretl_zipmember *gretl_zipfile_get_member (gretl_zipfile *zf,
+					   const char *name,
+					   int *err);
+
+void gretl_zipfile_close (gretl_zipfile *zf);
+
+gretl_zipmember *gretl_zipmember_open (const char *fname,
+				       const char *name,
+				       int *err);
+
+gint64 gretl_zipmember_read (gretl_zipmember *zm, void *buf,
+			     guint64 len);
+
+int gretl_zipmember_skip (gretl_zipmember *zm, guint64 len);
+
+void gretl_zipmember_close (gretl_zipmember *zm);
+
 #endif /* GRETL_ZIP_H */
@@ -26,6 +26,10 @@
 #include "matrix_extra.h"
 #include "libset.h"
 
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
 #define BDEBUG 0
 
 #if BDEBUG
@@ -59,6 +63,7 @@ static void irf_boot_free (irfboot *b)
 
     gretl_matrix_block_destroy(b->MB);
 
+    gretl_matrix_free(b->resp);
     gretl_matrix_free(b->Xt);
     gretl_matrix_free(b->Yt);
     gretl_matrix_free(b->Et);
@@ -79,7 +84,6 @@ static int boot_allocate (irfboot *b, const GRETL_VAR *v)
     b->MB = gretl_matrix_block_new(&b->rtmp, n, v->neqns,
 				   &b->ctmp, n, v->neqns,
 				   &b->rE, v->T, v->neqns,
-				   &b->resp, b->horizon, b->iters,
 				   NULL);
     if (b->MB == NULL) {
 	return E_ALLOC;
@@ -115,6 +119,7 @@ static irfboot *irf_boot_new (const GRETL_VAR *var, int periods)
     }
 
     b->MB = NULL;
+    b->resp = NULL;
     b->Xt = NULL;
     b->Yt = NULL;
     b->Et = NULL;
@@ -143,7 +148,12 @@ static irfboot *irf_boot_new (const GRETL_VAR *var, int periods)
 	    var->T, var->neqns, var->order, jrank(var), var->ifc);
 #endif
 
-    err = boot_allocate(b, var);
+    b->resp = gretl_matrix_alloc(b->horizon, b->iters);
+    if (b->resp == NULL) {
+	err = E_ALLOC;
+    } else {
+	err = boot_allocate(b, var);
+    }
 
     if (err) {
 	irf_boot_free(b);
@@ -153,6 +163,46 @@ static irfboot *irf_boot_new (const GRETL_VAR *var, int periods)
     return b;
 }
 
+/* workspace for a thread in the parallel bootstrap: this shares
+   the response matrix of the "master" @b, each iteration writing
+   its own column
+*/
+
+static irfboot *irf_boot_worker (const irfboot *b, const GRETL_VAR *var)
+{
+    irfboot *w;
+
+    w = malloc(sizeof *w);
+    if (w == NULL) {
+	return NULL;
+    }
+
+    *w = *b;
+    w->MB = NULL;
+    w->Xt = NULL;
+    w->Yt = NULL;
+    w->Et = NULL;
+    w->C0 = NULL;
+    w->sample = NULL;
+    w->dset = NULL;
+
+    if (boot_allocate(w, var)) {
+	w->resp = NULL;
+	irf_boot_free(w);
+	w = NULL;
+    }
+
+    return w;
+}
+
+static void irf_boot_worker_free (irfboot *w)
+{
+    if (w != NULL) {
+	w->resp = NULL;
+	irf_boot_free(w);
+    }
+}
+
 static int
 recalculate_impulse_responses (irfboot *b, GRETL_VAR *var,
 			       int targ, int shock, int iter)
@@ -691,40 +741,93 @@ static void compute_VAR_dataset (irfboot *b, GRETL_VAR *var,
    VAR/VECM.
 */
 
-static void irf_resample_resids (irfboot *b, const GRETL_VAR *vbak)
+static void irf_fill_resids (irfboot *b, const GRETL_VAR *vbak)
 {
     double eti;
     int i, t;
 
-    /* construct sampling array */
-
     for (t=0; t<vbak->T; t++) {
+	for (i=0; i<vbak->neqns; i++) {
+	    eti = gretl_matrix_get(vbak->E, b->sample[t], i);
+	    gretl_matrix_set(b->rE, t, i, eti);
+	}
+    }
+}
+
+/* Construct a sampling array of length @T. Each iteration draws
+   from its own substream of the alternate RNG, seeded via
+   irf_boot_seeds(): successive calls give the samples for the
+   first attempt at the iteration and for any retries.
+*/
+
+static void irf_draw_sample (int *sample, int T)
+{
 #if BDEBUG > 1
-	b->sample[t] = t; /* fake it */
+    int t;
+
+    for (t=0; t<T; t++) {
+	sample[t] = t; /* fake it */
+    }
 #else
-	b->sample[t] = gretl_rand_int_max(vbak->T);
-#endif
-#if 0
-	fprintf(stderr, "boot->sample[%d] = %d\n", t, b->sample[t]);
+    gretl_alt_rand_int_minmax(sample, T, 0, T - 1);
 #endif
-    }
+}
+
+static void irf_resample_resids (irfboot *b, const GRETL_VAR *vbak)
+{
+    irf_draw_sample(b->sample, vbak->T);
 
     /* draw from the original residuals */
+    irf_fill_resids(b, vbak);
+}
 
-    for (t=0; t<vbak->T; t++) {
-	for (i=0; i<vbak->neqns; i++) {
-	    eti = gretl_matrix_get(vbak->E, b->sample[t], i);
-	    gretl_matrix_set(b->rE, t, i, eti);
+/* Draw a seed for each iteration from the main RNG, up front, so
+   that the samples do not depend on the order in which the
+   iterations are run or on how many of them have to be retried.
+*/
+
+static unsigned int *irf_boot_seeds (int iters)
+{
+    unsigned int *seeds = malloc(iters * sizeof *seeds);
+    int i;
+
+    if (seeds != NULL) {
+	for (i=0; i<iters; i++) {
+	    /* avoid zero, which means "seed from the clock" */
+	    seeds[i] = gretl_rand_int();
+	    if (seeds[i] == 0) {
+		seeds[i] = 1;
+	    }
 	}
     }
+
+    return seeds;
 }
 
+/* For each period, find the alpha/2 and 1 - alpha/2 order
+   statistics of the bootstrap responses by selection rather than
+   sorting; the periods are shared out among threads if that seems
+   worthwhile.
+*/
+
 static int irf_boot_quantiles (irfboot *b, gretl_matrix *R, double alpha)
 {
     double *rk;
     int k, ilo, ihi;
+    int nt = 1;
+
+#if defined(_OPENMP)
+    if (b->horizon > 1 &&
+	libset_use_openmp((guint64) b->horizon * b->iters)) {
+	nt = get_omp_n_threads();
+	if (nt > b->horizon) {
+	    nt = b->horizon;
+	}
+    }
+#endif
 
-    rk = malloc(b->iters * sizeof *rk);
+    /* one work array per thread */
+    rk = malloc(nt * b->iters * sizeof *rk);
     if (rk == NULL) {
 	return E_ALLOC;
     }
@@ -738,11 +841,18 @@ static int irf_boot_quantiles (irfboot *b, gretl_matrix *R, double alpha)
     ihi = (b->iters + 1) * (1.0 - alpha / 2.0);
 #endif
 
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nt) if(nt > 1)
+#endif
     for (k=0; k<b->horizon; k++) {
-	gretl_matrix_row_to_array(b->resp, k, rk);
-	qsort(rk, b->iters, sizeof *rk, gretl_compare_doubles);
-	gretl_matrix_set(R, k, 1, rk[ilo-1]);
-	gretl_matrix_set(R, k, 2, rk[ihi-1]);
+	double *a = rk;
+
+#if defined(_OPENMP)
+	a += omp_get_thread_num() * b->iters;
+#endif
+	gretl_matrix_row_to_array(b->resp, k, a);
+	gretl_matrix_set(R, k, 1, gretl_array_order_stat(a, b->iters, ilo-1));
+	gretl_matrix_set(R, k, 2, gretl_array_order_stat(a, b->iters, ihi-1));
     }
 
 #if BDEBUG
@@ -888,6 +998,162 @@ static GRETL_VAR *back_up_VAR (GRETL_VAR *v)
     return vbak;
 }
 
+static void irf_VAR_clone_free (GRETL_VAR *vc)
+{
+    if (vc != NULL) {
+	gretl_matrix_free(vc->Y);
+	gretl_matrix_free(vc->X);
+	gretl_matrix_free(vc->B);
+	gretl_matrix_free(vc->A);
+	gretl_matrix_free(vc->E);
+	gretl_matrix_free(vc->C);
+	gretl_matrix_free(vc->S);
+	free(vc);
+    }
+}
+
+/* For the parallel bootstrap: a copy of @var which shares the
+   read-only content of the original but has its own copies of the
+   matrices that are rewritten on each iteration.
+*/
+
+static GRETL_VAR *irf_VAR_clone (const GRETL_VAR *var)
+{
+    GRETL_VAR *vc;
+
+    vc = malloc(sizeof *vc);
+    if (vc == NULL) {
+	return NULL;
+    }
+
+    *vc = *var;
+    vc->XTX = NULL;
+
+    clear_gretl_matrix_err();
+    vc->Y = gretl_matrix_copy(var->Y);
+    vc->X = gretl_matrix_copy(var->X);
+    vc->B = gretl_matrix_copy(var->B);
+    vc->A = gretl_matrix_copy(var->A);
+    vc->E = gretl_matrix_copy(var->E);
+    vc->C = gretl_matrix_copy(var->C);
+    vc->S = gretl_matrix_copy(var->S);
+
+    if (get_gretl_matrix_err()) {
+	irf_VAR_clone_free(vc);
+	vc = NULL;
+    }
+
+    return vc;
+}
+
+static int irf_boot_n_threads (const irfboot *b, const GRETL_VAR *var)
+{
+    int nt = 1;
+
+#if defined(_OPENMP)
+    if (var->ci == VAR && var->X != NULL && b->iters > 1 &&
+	libset_use_openmp((guint64) b->iters * var->T * var->X->cols *
+			  var->neqns)) {
+	nt = get_omp_n_threads();
+	if (nt > b->iters) {
+	    nt = b->iters;
+	}
+    }
+#endif
+
+    return nt;
+}
+
+/* Run the first attempt at each iteration of the bootstrap for a
+   plain VAR on @nt threads, each with its own workspace and copy
+   of the VAR. The resampling arrays are drawn up front from the
+   per-iteration @seeds, as in the serial case, so the results do
+   not depend on the number of threads. Any iteration that fails
+   is flagged in @ierr; on return the caller deals with these
+   serially.
+*/
+
+static int irf_boot_parallel (irfboot *b, GRETL_VAR *var,
+			      const GRETL_VAR *vbak,
+			      int targ, int shock, int nt,
+			      const unsigned int *seeds,
+			      int *ierr)
+{
+    irfboot **wb = NULL;
+    GRETL_VAR **wv = NULL;
+    int *S = NULL;
+    int T = vbak->T;
+    int blas_nt = 0;
+    int i, iter;
+    int err = 0;
+
+    S = malloc(b->iters * T * sizeof *S);
+    wb = calloc(nt, sizeof *wb);
+    wv = calloc(nt, sizeof *wv);
+
+    if (S == NULL || wb == NULL || wv == NULL) {
+	err = E_ALLOC;
+	goto bailout;
+    }
+
+    for (iter=0; iter<b->iters; iter++) {
+	gretl_alt_rand_set_seed(seeds[iter]);
+	irf_draw_sample(S + iter * T, T);
+    }
+
+    for (i=0; i<nt && !err; i++) {
+	wb[i] = irf_boot_worker(b, var);
+	wv[i] = irf_VAR_clone(var);
+	if (wb[i] == NULL || wv[i] == NULL) {
+	    err = E_ALLOC;
+	}
+    }
+
+    if (err) {
+	goto bailout;
+    }
+
+    /* don't oversubscribe the cores via threaded BLAS */
+    if (blas_is_openblas()) {
+	blas_nt = blas_get_num_threads();
+	if (blas_nt > 1) {
+	    blas_set_num_threads(1);
+	}
+    }
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nt) private(i) schedule(dynamic)
+#endif
+    for (iter=0; iter<b->iters; iter++) {
+	i = 0;
+#if defined(_OPENMP)
+	i = omp_get_thread_num();
+#endif
+	memcpy(wb[i]->sample, S + iter * T, T * sizeof *S);
+	irf_fill_resids(wb[i], vbak);
+	compute_VAR_dataset(wb[i], wv[i], vbak);
+	ierr[iter] = re_estimate_VAR(wb[i], wv[i], targ, shock, iter);
+    }
+
+    if (blas_nt > 1) {
+	blas_set_num_threads(blas_nt);
+    }
+
+ bailout:
+
+    if (wb != NULL) {
+	for (i=0; i<nt; i++) {
+	    irf_boot_worker_free(wb[i]);
+	    irf_VAR_clone_free(wv[i]);
+	}
+    }
+    free(wb);
+    free(wv);
+    free(S);
+
+    return err;
+}
+
 /* public bootstrapping function, called from var.c */
 
 gretl_matrix *irf_bootstrap (GRETL_VAR *var,
@@ -899,7 +1165,10 @@ gretl_matrix *irf_bootstrap (GRETL_VAR *var,
     gretl_matrix *R = NULL; /* the return value */
     GRETL_VAR *vbak = NULL;
     irfboot *boot = NULL;
+    unsigned int *seeds = NULL;
+    int *ierr = NULL;
     int scount = 0;
+    int nt = 1;
     int iter;
 
     if (0 && (var->X == NULL || var->Y == NULL)) {
@@ -946,30 +1215,73 @@ gretl_matrix *irf_bootstrap (GRETL_VAR *var,
     fprintf(stderr, "boot->iters = %d\n", boot->iters);
 #endif
 
+    if (!*err) {
+	seeds = irf_boot_seeds(boot->iters);
+	if (seeds == NULL) {
+	    *err = E_ALLOC;
+	}
+    }
+
+    if (!*err) {
+	nt = irf_boot_n_threads(boot, var);
+    }
+
+    if (nt > 1) {
+	ierr = calloc(boot->iters, sizeof *ierr);
+	if (ierr == NULL) {
+	    *err = E_ALLOC;
+	} else {
+	    *err = irf_boot_parallel(boot, var, vbak, targ, shock,
+				     nt, seeds, ierr);
+	}
+    }
+
+    /* Serial iterations: all of them, or just those that failed in
+       the parallel run, if applicable. In the latter case the first
+       attempt has already been made, so its sample is skipped and
+       its failure is tallied here, in iteration order, just as the
+       serial loop would tally it.
+    */
+
     for (iter=0; iter<boot->iters && !*err; iter++) {
+	if (ierr != NULL && ierr[iter] == 0) {
+	    continue;
+	}
+	gretl_alt_rand_set_seed(seeds[iter]);
+	if (ierr != NULL) {
+	    irf_draw_sample(boot->sample, vbak->T);
+	    *err = ierr[iter];
+	}
 #if BDEBUG
 	fprintf(stderr, "starting iteration %d\n", iter);
 #endif
-	irf_resample_resids(boot, vbak);
-	if (var->ci == VECM) {
-	    compute_VECM_dataset(boot, var, iter);
-	    *err = re_estimate_VECM(boot, var, targ, shock, iter, scount);
-#if BDEBUG
+	while (1) {
 	    if (*err) {
-		fprintf(stderr, " got err = %d from re_estimate_VECM\n", *err);
+		if (irf_fatal(*err, boot, iter, scount)) {
+		    break;
+		}
+		/* excessive collinearity: try again, unless this is
+		   becoming a serious habit
+		*/
+		scount++;
+		*err = 0;
 	    }
+	    irf_resample_resids(boot, vbak);
+	    if (var->ci == VECM) {
+		compute_VECM_dataset(boot, var, iter);
+		*err = re_estimate_VECM(boot, var, targ, shock, iter, scount);
+#if BDEBUG
+		if (*err) {
+		    fprintf(stderr, " got err = %d from re_estimate_VECM\n", *err);
+		}
 #endif
-	} else {
-	    compute_VAR_dataset(boot, var, vbak);
-	    *err = re_estimate_VAR(boot, var, targ, shock, iter);
-	}
-	if (*err && !irf_fatal(*err, boot, iter, scount)) {
-	    /* excessive collinearity: try again, unless this is
-	       becoming a serious habit
-	    */
-	    scount++;
-	    iter--;
-	    *err = 0;
+	    } else {
+		compute_VAR_dataset(boot, var, vbak);
+		*err = re_estimate_VAR(boot, var, targ, shock, iter);
+	    }
+	    if (!*err) {
+		break;
+	    }
 	}
     }
 
@@ -982,6 +1294,8 @@ gretl_matrix *irf_bootstrap (GRETL_VAR *var,
     }
 
     irf_boot_free(boot);
+    free(seeds);
+    free(ierr);
 
  bailout:
 
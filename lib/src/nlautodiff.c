@@ -0,0 +1,851 @@
+/*
+ *  gretl -- Gnu Regression, Econometrics and Time-series Library
+ *  Copyright (C) 2001 Allin Cottrell and Riccardo "Jack" Lucchetti
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Compiled evaluation and reverse-mode automatic differentiation
+   of the criterion in the "nls" and "mle" commands. The compiled
+   syntax trees of the auxiliary statements and the criterion are
+   flattened into a "tape" of elementwise operations on scalars and
+   series; a forward sweep evaluates the tape at a given parameter
+   vector and a single reverse sweep, seeded with ones across the
+   sample, yields the per-observation score for all parameters at
+   once. Since every operation is elementwise, both sweeps run
+   through the whole tape for one observation at a time, and the
+   sample is shared out among OpenMP threads. Only scalar parameters
+   and the operators and functions listed in ad_node() are
+   supported; anything else makes ad_tape_new() fail with E_NOTIMP,
+   in which case the caller should fall back to genr.
+*/
+
+#include "libgretl.h"
+#include "libset.h"
+#include "uservar.h"
+#include "genparse.h"
+#include "nlautodiff.h"
+
+#define AD_DEBUG 0
+
+/* leaf types, distinct from the genr operator codes */
+
+enum {
+    AD_PARAM = -4, /* model parameter */
+    AD_CONST,      /* numerical constant */
+    AD_SERIES,     /* data series */
+    AD_SCALAR      /* user scalar that is not a parameter */
+};
+
+typedef struct ad_op_ ad_op;
+
+struct ad_op_ {
+    int op;           /* genr operator or function code, or leaf type */
+    int a, b;         /* tape positions of operands (or -1) */
+    int vec;          /* 1 if value is a series, 0 if scalar */
+    int active;       /* 1 if value depends on the parameters */
+    int id;           /* parameter index or series ID, for leaves */
+    double x;         /* value of constant leaf */
+    const char *name; /* name of user scalar leaf */
+    user_var *uv;     /* the same, as user variable */
+    double *val;      /* value(s), length 1 or T */
+    double *adj;      /* per-observation adjoints (active only) */
+};
+
+typedef struct ad_sym_ ad_sym;
+
+/* record of a variable assigned by an earlier statement */
+
+struct ad_sym_ {
+    char name[VNAMELEN];
+    int vnum; /* series ID, or 0 for scalar */
+    int pos;  /* tape position of value */
+};
+
+struct ad_tape_ {
+    ad_op *ops;
+    int n_ops;
+    int n_alloc;
+    ad_sym *syms;
+    int n_syms;
+    const char **parnames;
+    int np;
+    const DATASET *dset;
+    int t1, t2, T;
+    int crit; /* tape position of criterion */
+    int mt;   /* OK to split the sample among threads? */
+};
+
+#define ad_val(o,t) ((o)->vec ? (o)->val[t] : (o)->val[0])
+
+static int ad_push (ad_tape *tape, int op, int a, int b, int *err)
+{
+    ad_op *o;
+
+    if (tape->n_ops == tape->n_alloc) {
+	int n = tape->n_alloc == 0 ? 32 : 2 * tape->n_alloc;
+	ad_op *tmp = realloc(tape->ops, n * sizeof *tmp);
+
+	if (tmp == NULL) {
+	    *err = E_ALLOC;
+	    return -1;
+	}
+	tape->ops = tmp;
+	tape->n_alloc = n;
+    }
+
+    o = &tape->ops[tape->n_ops];
+    memset(o, 0, sizeof *o);
+    o->op = op;
+    o->a = a;
+    o->b = b;
+
+    if (a >= 0) {
+	o->vec = tape->ops[a].vec;
+	o->active = tape->ops[a].active;
+    }
+    if (b >= 0) {
+	o->vec = o->vec || tape->ops[b].vec;
+	o->active = o->active || tape->ops[b].active;
+    }
+
+    return tape->n_ops++;
+}
+
+static int ad_param_index (ad_tape *tape, const char *s)
+{
+    int i;
+
+    for (i=0; i<tape->np; i++) {
+	if (!strcmp(s, tape->parnames[i])) {
+	    return i;
+	}
+    }
+
+    return -1;
+}
+
+static int ad_sym_lookup (ad_tape *tape, const char *s, int vnum)
+{
+    int i;
+
+    for (i=tape->n_syms-1; i>=0; i--) {
+	if (vnum > 0 && tape->syms[i].vnum == vnum) {
+	    return tape->syms[i].pos;
+	} else if (vnum == 0 && tape->syms[i].vnum == 0 &&
+		   !strcmp(s, tape->syms[i].name)) {
+	    return tape->syms[i].pos;
+	}
+    }
+
+    return -1;
+}
+
+/* Register the output of a statement. We refuse the case where the
+   variable in question was already read as data by an earlier
+   statement, since its value would then depend on the previous
+   evaluation of the criterion.
+*/
+
+static int ad_sym_add (ad_tape *tape, const char *s, int vnum, int pos)
+{
+    ad_sym *tmp;
+    int i;
+
+    for (i=0; i<tape->n_ops; i++) {
+	ad_op *o = &tape->ops[i];
+
+	if ((vnum > 0 && o->op == AD_SERIES && o->id == vnum) ||
+	    (vnum == 0 && o->op == AD_SCALAR && !strcmp(s, o->name))) {
+	    return E_NOTIMP;
+	}
+    }
+
+    tmp = realloc(tape->syms, (tape->n_syms + 1) * sizeof *tmp);
+    if (tmp == NULL) {
+	return E_ALLOC;
+    }
+
+    tape->syms = tmp;
+    tmp = &tape->syms[tape->n_syms];
+    strcpy(tmp->name, s);
+    tmp->vnum = vnum;
+    tmp->pos = pos;
+    tape->n_syms += 1;
+
+    return 0;
+}
+
+static int ad_leaf (ad_tape *tape, int type, int *err)
+{
+    int k = ad_push(tape, type, -1, -1, err);
+
+    if (k >= 0) {
+	tape->ops[k].vec = (type == AD_SERIES);
+	tape->ops[k].active = (type == AD_PARAM);
+    }
+
+    return k;
+}
+
+/* Recursively transcribe syntax tree @n onto the tape, returning the
+   position of its value.
+*/
+
+static int ad_node (ad_tape *tape, NODE *n, int *err)
+{
+    int a, b, k = -1;
+
+    if (n == NULL) {
+	*err = E_NOTIMP;
+	return -1;
+    }
+
+    switch (n->t) {
+    case NUM:
+	if (n->vname == NULL) {
+	    /* literal */
+	    k = ad_leaf(tape, AD_CONST, err);
+	    if (k >= 0) {
+		tape->ops[k].x = n->v.xval;
+	    }
+	} else if ((a = ad_param_index(tape, n->vname)) >= 0) {
+	    k = ad_leaf(tape, AD_PARAM, err);
+	    if (k >= 0) {
+		tape->ops[k].id = a;
+	    }
+	} else if ((a = ad_sym_lookup(tape, n->vname, 0)) >= 0) {
+	    k = a;
+	} else if (n->uv != NULL) {
+	    k = ad_leaf(tape, AD_SCALAR, err);
+	    if (k >= 0) {
+		tape->ops[k].name = n->vname;
+		tape->ops[k].uv = n->uv;
+	    }
+	} else {
+	    *err = E_NOTIMP;
+	}
+	break;
+    case SERIES:
+	if (n->vnum < 0 || (n->flags & SVL_NODE)) {
+	    *err = E_NOTIMP;
+	} else if ((a = ad_sym_lookup(tape, NULL, n->vnum)) >= 0) {
+	    k = a;
+	} else {
+	    k = ad_leaf(tape, AD_SERIES, err);
+	    if (k >= 0) {
+		tape->ops[k].id = n->vnum;
+	    }
+	}
+	break;
+    case CON:
+	if (n->v.idnum == CONST_PI) {
+	    k = ad_leaf(tape, AD_CONST, err);
+	    if (k >= 0) {
+		tape->ops[k].x = M_PI;
+	    }
+	} else {
+	    *err = E_NOTIMP;
+	}
+	break;
+    case U_POS:
+	k = ad_node(tape, n->L, err);
+	break;
+    case U_NEG:
+    case F_ABS:
+    case F_SQRT:
+    case F_EXP:
+    case F_LOG:
+    case F_SIN:
+    case F_COS:
+    case F_ATAN:
+    case F_CNORM:
+    case F_DNORM:
+    case F_LOGISTIC:
+    case F_LNGAMMA:
+	a = ad_node(tape, n->L, err);
+	if (!*err) {
+	    k = ad_push(tape, n->t, a, -1, err);
+	}
+	break;
+    case B_ADD:
+    case B_SUB:
+    case B_MUL:
+    case B_DIV:
+    case B_POW:
+	a = ad_node(tape, n->L, err);
+	if (!*err) {
+	    b = ad_node(tape, n->R, err);
+	}
+	if (!*err) {
+	    k = ad_push(tape, n->t, a, b, err);
+	}
+	break;
+    default:
+#if AD_DEBUG
+	fprintf(stderr, "ad_node: unsupported node type %d (%s)\n",
+		n->t, getsymb(n->t));
+#endif
+	*err = E_NOTIMP;
+	break;
+    }
+
+    return *err ? -1 : k;
+}
+
+static double ad_apply (int op, double x)
+{
+    switch (op) {
+    case U_NEG:
+	return -x;
+    case F_ABS:
+	return fabs(x);
+    case F_SQRT:
+	return sqrt(x);
+    case F_EXP:
+	return exp(x);
+    case F_LOG:
+	return log(x);
+    case F_SIN:
+	return sin(x);
+    case F_COS:
+	return cos(x);
+    case F_ATAN:
+	return atan(x);
+    case F_CNORM:
+	return normal_cdf(x);
+    case F_DNORM:
+	return normal_pdf(x);
+    case F_LOGISTIC:
+	return logistic_cdf(x);
+    case F_LNGAMMA:
+	return lngamma(x);
+    default:
+	return NADBL;
+    }
+}
+
+static double ad_calc (int op, double x, double y)
+{
+    switch (op) {
+    case B_ADD:
+	return x + y;
+    case B_SUB:
+	return x - y;
+    case B_MUL:
+	/* as in genr, zero times anything is zero */
+	return (x == 0 || y == 0) ? 0 : x * y;
+    case B_DIV:
+	return x / y;
+    case B_POW:
+	return pow(x, y);
+    default:
+	return NADBL;
+    }
+}
+
+/* derivative of unary @op at @x, given value @v */
+
+static double ad_d1 (int op, double x, double v)
+{
+    switch (op) {
+    case U_NEG:
+	return -1.0;
+    case F_ABS:
+	return x > 0 ? 1.0 : x < 0 ? -1.0 : 0.0;
+    case F_SQRT:
+	return 0.5 / v;
+    case F_EXP:
+	return v;
+    case F_LOG:
+	return 1.0 / x;
+    case F_SIN:
+	return cos(x);
+    case F_COS:
+	return -sin(x);
+    case F_ATAN:
+	return 1.0 / (1.0 + x * x);
+    case F_CNORM:
+	return normal_pdf(x);
+    case F_DNORM:
+	return -x * v;
+    case F_LOGISTIC:
+	return v * (1.0 - v);
+    case F_LNGAMMA:
+	return digamma(x);
+    default:
+	return NADBL;
+    }
+}
+
+/* value of operation @o at observation @t */
+
+static double ad_op_value (const ad_tape *tape, const ad_op *o,
+			   const double *b, int t)
+{
+    const ad_op *A, *B;
+
+    switch (o->op) {
+    case AD_PARAM:
+	return b[o->id];
+    case AD_CONST:
+	return o->x;
+    case AD_SCALAR:
+	return user_var_get_scalar_value(o->uv);
+    case AD_SERIES:
+	return tape->dset->Z[o->id][tape->t1 + t];
+    default:
+	A = &tape->ops[o->a];
+	if (o->b < 0) {
+	    return ad_apply(o->op, ad_val(A, t));
+	}
+	B = &tape->ops[o->b];
+	return ad_calc(o->op, ad_val(A, t), ad_val(B, t));
+    }
+}
+
+#define ad_threaded(tape) (tape->mt && \
+			   libset_use_openmp((guint64) tape->T * tape->n_ops))
+
+/* Evaluate the tape at @b: if @all is zero, only the operations
+   that depend on the parameters are recomputed. The scalar
+   operations are done first, then the whole tape is run for each
+   observation in turn. If @sum is non-NULL it receives the sum of
+   the criterion over the sample.
+*/
+
+static int ad_forward (ad_tape *tape, const double *b, int all,
+		       double *sum)
+{
+    const ad_op *crit = &tape->ops[tape->crit];
+    double s = 0.0;
+    int i, t, bad = 0;
+
+    for (i=0; i<tape->n_ops; i++) {
+	ad_op *o = &tape->ops[i];
+
+	if (!o->vec && (all || o->active)) {
+	    o->val[0] = ad_op_value(tape, o, b, 0);
+	    if (!isfinite(o->val[0])) {
+		return E_NAN;
+	    }
+	}
+    }
+
+#if defined(_OPENMP)
+#pragma omp parallel for private(i) reduction(+:s) reduction(max:bad) \
+    if (ad_threaded(tape))
+#endif
+    for (t=0; t<tape->T; t++) {
+	for (i=0; i<tape->n_ops; i++) {
+	    ad_op *o = &tape->ops[i];
+
+	    if (o->vec && (all || o->active)) {
+		o->val[t] = ad_op_value(tape, o, b, t);
+		if (!isfinite(o->val[t])) {
+		    bad = 1;
+		}
+	    }
+	}
+	s += ad_val(crit, t);
+    }
+
+    if (bad) {
+	return E_NAN;
+    }
+
+    if (sum != NULL) {
+	*sum = s;
+    }
+
+    return 0;
+}
+
+/* The reverse sweep for observation @t: since every operation is
+   elementwise, seeding the criterion with ones at each observation
+   delivers observation-specific adjoints, i.e. the score matrix.
+*/
+
+static void ad_reverse_obs (ad_tape *tape, int t)
+{
+    ad_op *o, *A, *B;
+    double x, y, v, g;
+    int i;
+
+    for (i=0; i<=tape->crit; i++) {
+	if (tape->ops[i].active) {
+	    tape->ops[i].adj[t] = 0.0;
+	}
+    }
+
+    tape->ops[tape->crit].adj[t] = 1.0;
+
+    for (i=tape->crit; i>=0; i--) {
+	o = &tape->ops[i];
+	if (!o->active || o->op < 0) {
+	    continue;
+	}
+	g = o->adj[t];
+	if (g == 0) {
+	    continue;
+	}
+	A = &tape->ops[o->a];
+	x = ad_val(A, t);
+	v = ad_val(o, t);
+	if (o->b < 0) {
+	    A->adj[t] += g * ad_d1(o->op, x, v);
+	    continue;
+	}
+	B = &tape->ops[o->b];
+	y = ad_val(B, t);
+	switch (o->op) {
+	case B_ADD:
+	    if (A->active) A->adj[t] += g;
+	    if (B->active) B->adj[t] += g;
+	    break;
+	case B_SUB:
+	    if (A->active) A->adj[t] += g;
+	    if (B->active) B->adj[t] -= g;
+	    break;
+	case B_MUL:
+	    if (A->active) A->adj[t] += g * y;
+	    if (B->active) B->adj[t] += g * x;
+	    break;
+	case B_DIV:
+	    if (A->active) A->adj[t] += g / y;
+	    if (B->active) B->adj[t] -= g * v / y;
+	    break;
+	case B_POW:
+	    if (A->active) {
+		A->adj[t] += g * y * pow(x, y - 1);
+	    }
+	    if (B->active) {
+		B->adj[t] += (v == 0) ? 0 : g * v * log(x);
+	    }
+	    break;
+	default:
+	    break;
+	}
+    }
+}
+
+static void ad_backward (ad_tape *tape)
+{
+    int t;
+
+#if defined(_OPENMP)
+#pragma omp parallel for if (ad_threaded(tape))
+#endif
+    for (t=0; t<tape->T; t++) {
+	ad_reverse_obs(tape, t);
+    }
+}
+
+void ad_tape_destroy (ad_tape *tape)
+{
+    int i;
+
+    if (tape == NULL) {
+	return;
+    }
+
+    for (i=0; i<tape->n_ops; i++) {
+	free(tape->ops[i].val);
+	free(tape->ops[i].adj);
+    }
+
+    free(tape->ops);
+    free(tape->syms);
+    free(tape);
+}
+
+static int ad_tape_allocate (ad_tape *tape)
+{
+    int i;
+
+    for (i=0; i<tape->n_ops; i++) {
+	ad_op *o = &tape->ops[i];
+
+	o->val = malloc((o->vec ? tape->T : 1) * sizeof(double));
+	if (o->val == NULL) {
+	    return E_ALLOC;
+	}
+	if (o->op == F_LNGAMMA) {
+	    /* cephes error reporting is not thread-safe */
+	    tape->mt = 0;
+	}
+    }
+
+    return 0;
+}
+
+/* The adjoints are allocated only when derivatives are first
+   wanted, since the tape may be used just for evaluation.
+*/
+
+static int ad_tape_allocate_adj (ad_tape *tape)
+{
+    int i;
+
+    for (i=0; i<tape->n_ops; i++) {
+	ad_op *o = &tape->ops[i];
+
+	if (o->active && o->adj == NULL) {
+	    o->adj = malloc(tape->T * sizeof(double));
+	    if (o->adj == NULL) {
+		return E_ALLOC;
+	    }
+	}
+    }
+
+    return 0;
+}
+
+/* Check that the tape reproduces the criterion as last computed by
+   genr (at parameter values @b), over the estimation sample.
+*/
+
+static int ad_tape_verify (ad_tape *tape, int lhv)
+{
+    const double *z = tape->dset->Z[lhv] + tape->t1;
+    const ad_op *o = &tape->ops[tape->crit];
+    double d;
+    int t;
+
+    for (t=0; t<tape->T; t++) {
+	d = fabs(ad_val(o, t) - z[t]);
+	if (d > 1.0e-9 * (1.0 + fabs(z[t]))) {
+#if AD_DEBUG
+	    fprintf(stderr, "ad_tape_verify: t=%d, tape %.15g, genr %.15g\n",
+		    t, ad_val(o, t), z[t]);
+#endif
+	    return E_DATA;
+	}
+    }
+
+    return 0;
+}
+
+/**
+ * ad_tape_new:
+ * @genrs: array of compiled generators: @naux auxiliary statements
+ * followed by the criterion.
+ * @naux: number of auxiliary statements.
+ * @parnames: names of the (scalar) parameters.
+ * @np: number of parameters.
+ * @b: current parameter values, at which all the generators have
+ * just been executed.
+ * @dset: dataset.
+ * @t1: first observation of the estimation sample.
+ * @t2: last observation of the estimation sample.
+ * @err: location to receive error code.
+ *
+ * Builds a tape for compiled evaluation (see ad_tape_eval()) and
+ * reverse-mode differentiation of the criterion, which must be a
+ * series. On failure, @err is set to E_NOTIMP if
+ * the specification uses features that are not supported, or
+ * E_DATA if the tape fails to reproduce the criterion computed by
+ * genr.
+ *
+ * Returns: the tape, or NULL on failure.
+ */
+
+ad_tape *ad_tape_new (GENERATOR **genrs, int naux,
+		      const char **parnames, int np,
+		      const double *b, const DATASET *dset,
+		      int t1, int t2, int *err)
+{
+    ad_tape *tape;
+    int i, k, v, lhv = 0;
+
+    tape = calloc(1, sizeof *tape);
+    if (tape == NULL) {
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    tape->parnames = parnames;
+    tape->np = np;
+    tape->dset = dset;
+    tape->t1 = t1;
+    tape->t2 = t2;
+    tape->T = t2 - t1 + 1;
+    tape->crit = -1;
+    tape->mt = 1;
+
+    for (i=0; i<=naux && !*err; i++) {
+	GENERATOR *p = genrs[i];
+
+	if (p == NULL || p->tree == NULL || genr_no_assign(p) ||
+	    (p->flags & P_AUTOREG) || p->lh.expr != NULL ||
+	    p->op != B_ASN) {
+	    *err = E_NOTIMP;
+	    break;
+	}
+	k = ad_node(tape, p->tree, err);
+	if (*err) {
+	    break;
+	}
+	v = genr_get_output_varnum(p);
+	if (v > 0) {
+	    *err = ad_sym_add(tape, p->lh.name, v, k);
+	} else if (i < naux &&
+		   genr_get_output_type(p) == GRETL_TYPE_DOUBLE &&
+		   !tape->ops[k].vec && ad_param_index(tape, p->lh.name) < 0) {
+	    *err = ad_sym_add(tape, p->lh.name, 0, k);
+	} else {
+	    *err = E_NOTIMP;
+	}
+	if (!*err && i == naux) {
+	    tape->crit = k;
+	    lhv = v;
+	}
+    }
+
+    /* the names are needed only while building */
+    tape->parnames = NULL;
+
+    if (!*err && !tape->ops[tape->crit].active) {
+	/* the criterion doesn't depend on the parameters? */
+	*err = E_NOTIMP;
+    }
+
+    if (!*err) {
+	/* operations beyond the criterion are not needed */
+	tape->n_ops = tape->crit + 1;
+	*err = ad_tape_allocate(tape);
+    }
+
+    if (!*err) {
+	*err = ad_forward(tape, b, 1, NULL);
+    }
+
+    if (!*err) {
+	*err = ad_tape_verify(tape, lhv);
+    }
+
+#if AD_DEBUG
+    fprintf(stderr, "ad_tape_new: %d ops, err = %d\n", tape->n_ops, *err);
+#endif
+
+    if (*err) {
+	ad_tape_destroy(tape);
+	tape = NULL;
+    }
+
+    return tape;
+}
+
+/**
+ * ad_tape_score:
+ * @tape: tape as built by ad_tape_new().
+ * @b: parameter values.
+ * @G: T x np matrix to receive the per-observation score, or NULL.
+ * @g: array of length np to receive the gradient, or NULL.
+ *
+ * Evaluates the derivatives of the criterion with respect to the
+ * parameters at @b, by means of a forward and a reverse sweep of
+ * @tape.
+ *
+ * Returns: 0 on success, non-zero code on error.
+ */
+
+int ad_tape_score (ad_tape *tape, const double *b,
+		   gretl_matrix *G, double *g)
+{
+    int i, t, err;
+
+    err = ad_tape_allocate_adj(tape);
+    if (!err) {
+	err = ad_forward(tape, b, 0, NULL);
+    }
+    if (err) {
+	return err;
+    }
+
+    ad_backward(tape);
+
+    if (G != NULL) {
+	gretl_matrix_zero(G);
+    }
+    if (g != NULL) {
+	for (i=0; i<tape->np; i++) {
+	    g[i] = 0.0;
+	}
+    }
+
+    for (i=0; i<tape->n_ops; i++) {
+	ad_op *o = &tape->ops[i];
+	double *Gj;
+
+	if (o->op != AD_PARAM) {
+	    continue;
+	}
+	if (G != NULL) {
+	    Gj = G->val + o->id * G->rows;
+	    for (t=0; t<tape->T; t++) {
+		Gj[t] += o->adj[t];
+	    }
+	}
+	if (g != NULL) {
+	    for (t=0; t<tape->T; t++) {
+		g[o->id] += o->adj[t];
+	    }
+	}
+    }
+
+    if (g != NULL) {
+	for (i=0; i<tape->np; i++) {
+	    if (!isfinite(g[i])) {
+		return E_NAN;
+	    }
+	}
+    }
+
+    return 0;
+}
+
+/**
+ * ad_tape_eval:
+ * @tape: tape as built by ad_tape_new().
+ * @b: parameter values.
+ * @crit: location to receive the sum of the criterion over the
+ * sample.
+ * @f: array of length T to receive the per-observation values of
+ * the criterion, or NULL.
+ *
+ * Evaluates the criterion at @b by a forward sweep of @tape,
+ * bypassing genr. Note that the dataset and any user variables
+ * assigned by the auxiliary statements are not updated.
+ *
+ * Returns: 0 on success, E_NAN if a non-finite value is produced.
+ */
+
+int ad_tape_eval (ad_tape *tape, const double *b,
+		  double *crit, double *f)
+{
+    const ad_op *o = &tape->ops[tape->crit];
+    int t, err;
+
+    err = ad_forward(tape, b, 0, crit);
+
+    if (!err && f != NULL) {
+	for (t=0; t<tape->T; t++) {
+	    f[t] = ad_val(o, t);
+	}
+    }
+
+    return err;
+}
@@ -0,0 +1,41 @@
+/*
+ *  gretl -- Gnu Regression, Econometrics and Time-series Library
+ *  Copyright (C) 2001 Allin Cottrell and Riccardo "Jack" Lucchetti
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Private header for compiled evaluation and automatic
+   differentiation of nonlinear model criteria, used by nls.c */
+
+#ifndef NLAUTODIFF_H
+#define NLAUTODIFF_H
+
+typedef struct ad_tape_ ad_tape;
+
+ad_tape *ad_tape_new (GENERATOR **genrs, int naux,
+		      const char **parnames, int np,
+		      const double *b, const DATASET *dset,
+		      int t1, int t2, int *err);
+
+void ad_tape_destroy (ad_tape *tape);
+
+int ad_tape_score (ad_tape *tape, const double *b,
+		   gretl_matrix *G, double *g);
+
+int ad_tape_eval (ad_tape *tape, const double *b,
+		  double *crit, double *f);
+
+#endif /* NLAUTODIFF_H */
@@ -28,6 +28,7 @@
 #include "matrix_extra.h"
 #include "gretl_func.h"
 #include "nlspec.h"
+#include "nlautodiff.h"
 #include "cmd_private.h"
 #include "estim_private.h"
 #include "gretl_bfgs.h"
@@ -55,7 +56,8 @@ enum {
     NL_AUTOREG    = 1 << 1,
     NL_AHESS      = 1 << 2,
     NL_NEWTON     = 1 << 3,
-    NL_SMALLSTEP  = 1 << 4
+    NL_SMALLSTEP  = 1 << 4,
+    NL_AUTODIFF   = 1 << 5
 } nl_flags;
 
 struct parm_ {
@@ -79,6 +81,7 @@ struct parm_ {
 
 #define numeric_mode(s) (!(s->flags & NL_ANALYTICAL))
 #define analytic_mode(s) (s->flags & NL_ANALYTICAL)
+#define autodiff_mode(s) (s->flags & NL_AUTODIFF)
 
 #define scalar_loglik(s) (s->lhtype == GRETL_TYPE_DOUBLE)
 #define suppress_grad_check(s) (s->opt & OPT_S)
@@ -1077,6 +1080,14 @@ static double get_mle_ll (const double *b, void *p)
 
     update_coeff_values(b, s);
 
+    if (s->adtape != NULL) {
+	err = ad_tape_eval(s->adtape, b, &s->crit, NULL);
+	if (err) {
+	    s->crit = NADBL;
+	}
+	return s->crit;
+    }
+
     err = nl_calculate_fvec(s);
     if (err) {
 	return NADBL;
@@ -1140,6 +1151,21 @@ static int nl_function_calc (double *f, double *x, void *p)
     fprintf(stderr, "\n*** nl_function_calc called\n");
 #endif
 
+    if (s->adtape != NULL) {
+	/* compiled criterion: straight into @f */
+	err = ad_tape_eval(s->adtape, x, &s->crit, f);
+	if (err) {
+	    return err;
+	}
+	if (s->ci != MLE) {
+	    s->crit = 0.0;
+	    for (t=0; t<s->nobs; t++) {
+		s->crit += f[t] * f[t];
+	    }
+	}
+	goto done;
+    }
+
     /* calculate function given current parameter estimates */
     err = nl_calculate_fvec(s);
     if (err) {
@@ -1172,6 +1198,8 @@ static int nl_function_calc (double *f, double *x, void *p)
 	}
     }
 
+ done:
+
     s->iters += 1;
 
     if (s->ci == NLS && (s->opt & OPT_V)) {
@@ -1267,6 +1295,18 @@ static int get_nls_derivs (int T, double *g, DATASET *gdset, void *p)
     return err;
 }
 
+/* for use with automatic differentiation of the loglikelihood
+   in mle */
+
+static int get_mle_ad_gradient (double *b, double *g, int n,
+				BFGS_CRIT_FUNC llfunc,
+				void *p)
+{
+    nlspec *spec = (nlspec *) p;
+
+    return ad_tape_score(spec->adtape, b, NULL, g);
+}
+
 /* for use with analytical derivatives, at present only for mle */
 
 static int get_mle_gradient (double *b, double *g, int n,
@@ -1450,7 +1490,18 @@ static gretl_matrix *ml_gradient_matrix (nlspec *spec, int *err)
     int k = spec->ncoeff;
     int T = spec->nobs;
 
-    if (numeric_mode(spec)) {
+    if (autodiff_mode(spec)) {
+	G = gretl_matrix_alloc(T, k);
+	if (G == NULL) {
+	    *err = E_ALLOC;
+	} else {
+	    *err = ad_tape_score(spec->adtape, spec->coeff, G, NULL);
+	    if (*err) {
+		gretl_matrix_free(G);
+		G = NULL;
+	    }
+	}
+    } else if (numeric_mode(spec)) {
 	G = numerical_score_matrix(spec->coeff, T, k, mle_llt_callback,
 				   (void *) spec, err);
     } else {
@@ -2362,6 +2413,9 @@ static void clear_nlspec (nlspec *spec)
 
     free(spec->missmask);
     spec->missmask = NULL;
+
+    ad_tape_destroy(spec->adtape);
+    spec->adtape = NULL;
 }
 
 /*
@@ -2604,6 +2658,8 @@ static int mle_calculate (nlspec *s, PRN *prn)
     if (!err) {
 	if (analytic_mode(s)) {
 	    gradfunc = get_mle_gradient;
+	} else if (autodiff_mode(s)) {
+	    gradfunc = get_mle_ad_gradient;
 	}
 	if (s->hesscall != NULL) {
 	    hessfunc = get_mle_hessian;
@@ -2647,7 +2703,7 @@ static int mle_calculate (nlspec *s, PRN *prn)
 	       a scalar). But it seems the latter requirement,
 	       !scalar_loglik(s), is not really necessary.
 	    */
-	    if (analytic_mode(s)) {
+	    if (analytic_mode(s) || autodiff_mode(s)) {
 		s->Hinv = hessian_inverse_from_score(s->coeff, s->ncoeff,
 						     gradfunc, get_mle_ll,
 						     s, &err);
@@ -3325,6 +3381,57 @@ static void nls_run_GNR (MODEL *pmod, nlspec *spec, PRN *prn)
 /* static function providing the real content for the two public
    wrapper functions below: does NLS, MLE or GMM */
 
+/* Try compiling the criterion into a tape, which is then used in
+   place of genr to evaluate it. If automatic differentiation of the
+   loglikelihood was requested (@autodiff non-zero) the tape also
+   supplies the derivatives, and if the specification is not
+   supported we say so and fall back to numerical derivatives;
+   otherwise failure just means that we stay with genr.
+*/
+
+static void nl_tape_setup (nlspec *spec, int autodiff, PRN *prn)
+{
+    const char **names = NULL;
+    int i, err = 0;
+
+    if (spec->lhtype != GRETL_TYPE_SERIES || spec->nvec > 0 ||
+	spec->missmask != NULL || (spec->flags & NL_AUTOREG) ||
+	spec->nobs != spec->t2 - spec->t1 + 1) {
+	err = E_NOTIMP;
+    } else {
+	names = malloc(spec->nparam * sizeof *names);
+	if (names == NULL) {
+	    err = E_ALLOC;
+	}
+    }
+
+    if (!err) {
+	for (i=0; i<spec->nparam; i++) {
+	    names[i] = spec->params[i].name;
+	}
+	/* ensure that the genrs are evaluated at the current
+	   coefficients, for checking the tape */
+	update_coeff_values(spec->coeff, spec);
+	err = nl_calculate_fvec(spec);
+    }
+
+    if (!err) {
+	spec->adtape = ad_tape_new(spec->genrs, spec->naux,
+				   names, spec->nparam, spec->coeff,
+				   spec->dset, spec->t1, spec->t2,
+				   &err);
+    }
+
+    if (!err && autodiff) {
+	spec->flags |= NL_AUTODIFF;
+    } else if (err && autodiff && !(spec->opt & (OPT_Q | OPT_M))) {
+	pputs(prn, _("Warning: automatic differentiation is not supported "
+		     "for this likelihood\n"));
+    }
+
+    free(names);
+}
+
 static MODEL real_nl_model (nlspec *spec, DATASET *dset,
 			    gretlopt opt, PRN *prn)
 {
@@ -3429,10 +3536,21 @@ static MODEL real_nl_model (nlspec *spec, DATASET *dset,
 	spec->tol = libset_get_double(NLS_TOLER);
     }
 
+    if (spec->ci != GMM && numeric_mode(spec)) {
+	int autodiff = spec->ci == MLE && (spec->opt & OPT_D) &&
+	    !(spec->opt & OPT_N);
+
+	nl_tape_setup(spec, autodiff, prn);
+    }
+
     if (spec->ci != GMM && !(spec->opt & (OPT_Q | OPT_M))) {
-	pputs(prn, (numeric_mode(spec))?
-	      _("Using numerical derivatives\n") :
-	      _("Using analytical derivatives\n"));
+	if (autodiff_mode(spec)) {
+	    pputs(prn, _("Using automatic differentiation\n"));
+	} else {
+	    pputs(prn, (numeric_mode(spec))?
+		  _("Using numerical derivatives\n") :
+		  _("Using analytical derivatives\n"));
+	}
     }
 
     /* now start the actual calculations */
@@ -3458,6 +3576,13 @@ static MODEL real_nl_model (nlspec *spec, DATASET *dset,
 	gretl_iteration_pop();
     }
 
+    if (!err && spec->adtape != NULL) {
+	/* the tape bypasses genr: bring the dataset and any
+	   auxiliary variables into line with the estimates */
+	update_coeff_values(spec->coeff, spec);
+	err = nl_calculate_fvec(spec);
+    }
+
     if (!(spec->opt & (OPT_Q | OPT_M)) && !(spec->flags & NL_NEWTON)) {
 	pprintf(prn, _("Tolerance = %g\n"), spec->tol);
     }
@@ -3625,6 +3750,7 @@ nlspec *nlspec_new (int ci, const DATASET *dset)
 
     spec->oc = NULL;
     spec->missmask = NULL;
+    spec->adtape = NULL;
 
     return spec;
 }
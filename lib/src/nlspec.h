@@ -75,6 +75,7 @@ struct nlspec_ {
     PRN *prn;           /* printing aparatus */
     ocset *oc;          /* orthogonality info (GMM) */
     char *missmask;     /* mask for missing observations */
+    struct ad_tape_ *adtape; /* automatic differentiation (MLE) */
 };
 
 void nlspec_destroy_arrays (nlspec *s);
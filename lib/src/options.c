@@ -173,6 +173,7 @@ struct gretl_option gretl_opts[] = {
     { COINT,    OPT_V, "verbose", 0 },
     { COINT,    OPT_I, "silent", 0 },
     { COINT2,   OPT_A, "crt", 0 },
+    { COINT2,   OPT_B, "bootstrap", 0 },
     { COINT2,   OPT_D, "seasonals", 0 },
     { COINT2,   OPT_N, "nc", 0 },
     { COINT2,   OPT_R, "rc", 0 },
@@ -407,6 +408,7 @@ struct gretl_option gretl_opts[] = {
     { MLE,      OPT_S, "no-gradient-check", 0 },
     { MLE,      OPT_L, "lbfgs", 0 },
     { MLE,      OPT_N, "numerical", 0 },
+    { MLE,      OPT_D, "autodiff", 0 },
     { MLE,      OPT_R, "robust", 0 },
     { MLE,      OPT_C, "cluster", 1 },
     { MLE,      OPT_V, "verbose", 0 },
@@ -610,6 +612,7 @@ struct gretl_option gretl_opts[] = {
     { STORE,    OPT_I, "decimal-comma", 0 },
     { STORE,    OPT_L, "lcnames", 0 },
     { STORE,    OPT_O, "oldbinary", 0 },
+    { STORE,    OPT_P, "append", 0 },
     { SUMMARY,  OPT_B, "by", 2 },
     { SUMMARY,  OPT_S, "simple", 0 },
     { SUMMARY,  OPT_W, "weights", 2 },
@@ -23,6 +23,7 @@
 #include "matrix_extra.h"
 #include "libset.h"
 #include "gretl_panel.h"
+#include "gretl_cmatrix.h"
 #include "estim_private.h"
 
 #include "gretl_f2c.h"
@@ -337,23 +338,6 @@ static gretl_matrix *make_data_X (const MODEL *pmod,
     return X;
 }
 
-/* Calculate W(t)-transpose * W(t-lag) */
-
-static void wtw (gretl_matrix *wt, const gretl_matrix *H,
-		 int t, int lag)
-{
-    int i, j, s = t - lag;
-    double hti, htj;
-
-    for (i=0; i<H->cols; i++) {
-	hti = gretl_matrix_get(H, t, i);
-	for (j=0; j<H->cols; j++) {
-	    htj = gretl_matrix_get(H, s, j);
-	    gretl_matrix_set(wt, i, j, hti * htj);
-	}
-    }
-}
-
 /* special handling for quadratic spectral kernel */
 
 double qs_hac_weight (double bt, int i)
@@ -387,6 +371,191 @@ double hac_weight (int kern, int h, int i)
     return w;
 }
 
+/**
+ * HAC_kernel_weights:
+ * @kern: HAC kernel.
+ * @p: maximum lag.
+ * @bt: bandwidth, used only for the QS kernel.
+ * @err: location to receive error code.
+ *
+ * Returns: an array of length @p + 1 holding the kernel weights
+ * for lags 0 to @p, or NULL on failure.
+ */
+
+double *HAC_kernel_weights (int kern, int p, double bt, int *err)
+{
+    double *w = malloc((p + 1) * sizeof *w);
+    int i;
+
+    if (w == NULL) {
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    w[0] = 1.0;
+    for (i=1; i<=p; i++) {
+	if (kern == KERNEL_QS) {
+	    w[i] = qs_hac_weight(bt, i);
+	} else {
+	    w[i] = hac_weight(kern, p, i);
+	}
+    }
+
+    return w;
+}
+
+/* Put into @F the kernel-weighted sum of lags of @H,
+   F_t = sum_{i=1}^{p} w_i H_{t-i}, by direct convolution
+*/
+
+static void hac_filter_direct (const gretl_matrix *H, const double *w,
+			       int p, gretl_matrix *F)
+{
+    int T = H->rows;
+    int k = H->cols;
+    int i, j, t;
+
+#if defined(_OPENMP)
+#pragma omp parallel for private(i, j) \
+    if (libset_use_openmp((guint64) T * p * k))
+#endif
+    for (t=0; t<T; t++) {
+	int imax = t < p ? t : p;
+	const double *h;
+	double x;
+
+	for (j=0; j<k; j++) {
+	    h = H->val + j * T + t;
+	    x = 0.0;
+	    for (i=1; i<=imax; i++) {
+		x += w[i] * h[-i];
+	    }
+	    F->val[j * T + t] = x;
+	}
+    }
+}
+
+/* The same as hac_filter_direct(), via FFT: with zero-padding to
+   length T + p the circular convolution of each column of @H with
+   the weights agrees with the linear one at t = 0, ..., T-1.
+*/
+
+static int hac_filter_fft (const gretl_matrix *H, const double *w,
+			   int p, gretl_matrix *F)
+{
+    gretl_matrix *x, *fw, *fx, *fi;
+    int T = H->rows;
+    int N = T + p;
+    double ar, ai, br, bi;
+    int i, j, err = 0;
+
+    x = gretl_zero_matrix_new(N, 1);
+    if (x == NULL) {
+	return E_ALLOC;
+    }
+
+    for (i=1; i<=p; i++) {
+	x->val[i] = w[i];
+    }
+
+    fw = gretl_matrix_fft(x, 0, &err);
+    gretl_matrix_zero(x);
+
+    for (j=0; j<H->cols && !err; j++) {
+	memcpy(x->val, H->val + j * T, T * sizeof(double));
+	fx = gretl_matrix_fft(x, 0, &err);
+	if (err) {
+	    break;
+	}
+	for (i=0; i<N; i++) {
+	    ar = gretl_matrix_get(fx, i, 0);
+	    ai = gretl_matrix_get(fx, i, 1);
+	    br = gretl_matrix_get(fw, i, 0);
+	    bi = gretl_matrix_get(fw, i, 1);
+	    gretl_matrix_set(fx, i, 0, ar * br - ai * bi);
+	    gretl_matrix_set(fx, i, 1, ar * bi + ai * br);
+	}
+	fi = gretl_matrix_ffti(fx, &err);
+	if (!err) {
+	    memcpy(F->val + j * T, fi->val, T * sizeof(double));
+	}
+	gretl_matrix_free(fx);
+	gretl_matrix_free(fi);
+    }
+
+    gretl_matrix_free(x);
+    gretl_matrix_free(fw);
+
+    return err;
+}
+
+/**
+ * HAC_kernel_sum:
+ * @H: T x k matrix.
+ * @w: array of kernel weights, as from HAC_kernel_weights().
+ * @p: maximum lag.
+ * @F: T x k workspace, or NULL.
+ * @S: k x k matrix to receive the result.
+ *
+ * Computes the kernel-weighted sum of autocovariances of @H,
+ * Gamma(0) + sum_{i=1}^{p} w_i (Gamma(i) + Gamma(i)'), where
+ * Gamma(i) = sum_t H_t' H_{t-i}. Rather than forming the @p
+ * lagged cross-products one at a time we filter @H with the
+ * weights, giving F, and use sum_i w_i Gamma(i) = H'F, so that
+ * only two matrix products are needed. The filter is applied
+ * directly (in parallel if OpenMP is available) for moderate
+ * @p and by FFT for large @p, as with the QS kernel.
+ *
+ * Returns: 0 on success, non-zero code on error.
+ */
+
+int HAC_kernel_sum (const gretl_matrix *H, const double *w,
+		    int p, gretl_matrix *F, gretl_matrix *S)
+{
+    gretl_matrix *Fw = F;
+    int T = H->rows;
+    int err = 0;
+
+    if (p >= T) {
+	p = T - 1;
+    }
+
+    if (p > 0) {
+	if (Fw == NULL) {
+	    Fw = gretl_matrix_alloc(T, H->cols);
+	    if (Fw == NULL) {
+		return E_ALLOC;
+	    }
+	}
+	if (p > 16 * log2(T)) {
+	    err = hac_filter_fft(H, w, p, Fw);
+	} else {
+	    hac_filter_direct(H, w, p, Fw);
+	}
+	if (!err) {
+	    err = gretl_matrix_multiply_mod(H, GRETL_MOD_TRANSPOSE,
+					    Fw, GRETL_MOD_NONE,
+					    S, GRETL_MOD_NONE);
+	}
+	if (!err) {
+	    gretl_matrix_add_self_transpose(S);
+	}
+	if (Fw != F) {
+	    gretl_matrix_free(Fw);
+	}
+    } else {
+	gretl_matrix_zero(S);
+    }
+
+    if (!err) {
+	err = gretl_matrix_multiply_mod(H, GRETL_MOD_TRANSPOSE,
+					H, GRETL_MOD_NONE,
+					S, GRETL_MOD_CUMULATE);
+    }
+
+    return err;
+}
+
 #define NW_DEBUG 0
 
 /* Newey and West's parameter 'n' for truncation when
@@ -758,8 +927,6 @@ gretl_matrix *HAC_XOX (const gretl_matrix *X,
 		       int *err)
 {
     gretl_matrix *XOX = NULL;
-    gretl_matrix *Wtj = NULL;
-    gretl_matrix *Gj = NULL;
     gretl_matrix *H = NULL;
     gretl_matrix *A = NULL;
     gretl_matrix *w = NULL;
@@ -768,8 +935,9 @@ gretl_matrix *HAC_XOX (const gretl_matrix *X,
     int kern;
     int T = X->rows;
     int k = X->cols;
-    int p, j, t;
+    double *wts = NULL;
     double bt = 0;
+    int p;
 
     if (use_prior) {
 	kern = vi->vmin;
@@ -808,10 +976,8 @@ gretl_matrix *HAC_XOX (const gretl_matrix *X,
     }
 
     if (!*err) {
-	XOX = gretl_zero_matrix_new(k, k);
-	Wtj = gretl_matrix_alloc(k, k);
-	Gj = gretl_matrix_alloc(k, k);
-	if (XOX == NULL || Wtj == NULL || Gj == NULL) {
+	XOX = gretl_matrix_alloc(k, k);
+	if (XOX == NULL) {
 	    *err = E_ALLOC;
 	}
     }
@@ -837,27 +1003,13 @@ gretl_matrix *HAC_XOX (const gretl_matrix *X,
     }
 
     if (!*err) {
-	double wj;
-
-	for (j=0; j<=p; j++) {
-	    /* cumulate running sum of Gamma-hat terms */
-	    gretl_matrix_zero(Gj);
-	    for (t=j; t<T; t++) {
-		/* W(t)-transpose * W(t-j) */
-		wtw(Wtj, H, t, j);
-		gretl_matrix_add_to(Gj, Wtj);
-	    }
-	    if (j > 0) {
-		/* Gamma(j) = Gamma(j) + Gamma(j)-transpose */
-		gretl_matrix_add_self_transpose(Gj);
-		if (kern == KERNEL_QS) {
-		    wj = qs_hac_weight(bt, j);
-		} else {
-		    wj = hac_weight(kern, p, j);
-		}
-		gretl_matrix_multiply_by_scalar(Gj, wj);
-	    }
-	    gretl_matrix_add_to(XOX, Gj);
+	/* weighted sum of Gamma-hat terms */
+	wts = HAC_kernel_weights(kern, p, bt, err);
+	if (!*err) {
+	    *err = HAC_kernel_sum(H, wts, p, NULL, XOX);
+	}
+	if (*err) {
+	    goto bailout;
 	}
     }
 
@@ -882,10 +1034,9 @@ gretl_matrix *HAC_XOX (const gretl_matrix *X,
  bailout:
 
     gretl_matrix_free(H);
-    gretl_matrix_free(Wtj);
-    gretl_matrix_free(Gj);
     gretl_matrix_free(A);
     gretl_matrix_free(w);
+    free(wts);
 
     if (*err && XOX != NULL) {
 	gretl_matrix_free(XOX);
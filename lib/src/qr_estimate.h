@@ -38,6 +38,11 @@ double hac_weight (int kern, int h, int i);
 
 double qs_hac_weight (double bt, int i);
 
+double *HAC_kernel_weights (int kern, int p, double bt, int *err);
+
+int HAC_kernel_sum (const gretl_matrix *H, const double *w,
+		    int p, gretl_matrix *F, gretl_matrix *S);
+
 int maybe_limit_VAR_coeffs (gretl_matrix *A,
 			    gretl_matrix *Y,
 			    gretl_matrix *X,
@@ -247,6 +247,82 @@ unsigned int gretl_rand_get_seed (void)
     }
 }
 
+struct gretl_rand_state_ {
+    int dcmt;           /* DCMT in use? */
+    guint32 seed;       /* the seed as last set */
+    guint8 sfmt[sizeof(sfmt_t)]; /* SFMT state */
+    int mti;            /* DCMT position */
+    guint32 *mt;        /* DCMT state vector */
+};
+
+/**
+ * gretl_rand_state_save:
+ * @err: location to receive error code.
+ *
+ * Saves the full state of gretl's PRNG, including the record of
+ * its seed, so that it can be put back via
+ * gretl_rand_state_restore() after running code that may re-seed
+ * the PRNG.
+ *
+ * Returns: allocated state, or NULL on failure.
+ */
+
+gretl_rand_state *gretl_rand_state_save (int *err)
+{
+    gretl_rand_state *s = calloc(1, sizeof *s);
+
+    if (s == NULL) {
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    s->dcmt = use_dcmt;
+
+    if (use_dcmt) {
+	s->seed = dcmt_seed;
+	s->mti = dcmt->i;
+	s->mt = malloc(dcmt->nn * sizeof *s->mt);
+	if (s->mt == NULL) {
+	    free(s);
+	    *err = E_ALLOC;
+	    return NULL;
+	}
+	memcpy(s->mt, dcmt->state, dcmt->nn * sizeof *s->mt);
+    } else {
+	s->seed = sfmt_seed;
+	memcpy(s->sfmt, &gretl_sfmt, sizeof gretl_sfmt);
+    }
+
+    return s;
+}
+
+/**
+ * gretl_rand_state_restore:
+ * @s: state obtained via gretl_rand_state_save().
+ *
+ * Puts gretl's PRNG back into the state recorded in @s, then
+ * frees @s.
+ */
+
+void gretl_rand_state_restore (gretl_rand_state *s)
+{
+    if (s == NULL) {
+	return;
+    }
+
+    if (s->dcmt && use_dcmt) {
+	dcmt_seed = s->seed;
+	dcmt->i = s->mti;
+	memcpy(dcmt->state, s->mt, dcmt->nn * sizeof *s->mt);
+    } else if (!s->dcmt && !use_dcmt) {
+	sfmt_seed = s->seed;
+	memcpy(&gretl_sfmt, s->sfmt, sizeof gretl_sfmt);
+    }
+
+    free(s->mt);
+    free(s);
+}
+
 static void gretl_dcmt_set_seed (unsigned int seed)
 {
     dcmt_seed = seed;
@@ -104,6 +104,12 @@ gretl_matrix *inverse_wishart_sequence (const gretl_matrix *S,
 
 unsigned int gretl_rand_get_seed (void);
 
+typedef struct gretl_rand_state_ gretl_rand_state;
+
+gretl_rand_state *gretl_rand_state_save (int *err);
+
+void gretl_rand_state_restore (gretl_rand_state *s);
+
 int gretl_rand_set_dcmt (int s);
 
 int gretl_rand_get_dcmt (void);
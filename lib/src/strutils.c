@@ -372,10 +372,10 @@ int has_native_data_suffix (const char *fname)
 
     if (fname != NULL && (p = strrchr(fname, '.')) != NULL) {
 	p++;
-	if (!strcmp(p, "gdt") || !strcmp(p, "gdtb")) {
+	if (!strcmp(p, "gdt") || !strcmp(p, "gdtb") || !strcmp(p, "gdtc")) {
 	    return 1;
 	}
-	if (!strcmp(p, "GDT") || !strcmp(p, "GDTB")) {
+	if (!strcmp(p, "GDT") || !strcmp(p, "GDTB") || !strcmp(p, "GDTC")) {
 	    return 1;
 	}
     }
@@ -62,6 +62,19 @@ typedef enum {
 static DATASET *fullset;
 static DATASET *peerset;
 
+/*
+  When the dataset is sub-sampled by means of a mask we also keep a
+  row-index view of the restriction: @subrows[s] gives the row of
+  the full dataset corresponding to row s of the sub-sampled one.
+  This is built once per restriction, at a cost of O(n) in the mask,
+  and it allows data to be gathered into and scattered back out of
+  the sub-sample without testing the mask element by element for
+  each series. It is discarded along with @fullset.
+*/
+
+static int *subrows;
+static int n_subrows;
+
 #define SUBMASK_SENTINEL 127
 
 static int smpl_get_int (const char *s, DATASET *dset, int *err);
@@ -223,6 +236,47 @@ int submask_cmp (const char *m1, const char *m2)
     return 0;
 }
 
+static void free_row_index (void)
+{
+    free(subrows);
+    subrows = NULL;
+    n_subrows = 0;
+}
+
+/* Build the row-index view of @mask, which applies to a dataset
+   of length @n: note that panel padding rows (marked 'p') are
+   included, since they occupy rows in the sub-sample.
+*/
+
+static int make_row_index (const char *mask, int n)
+{
+    int s, t, ns = 0;
+
+    free_row_index();
+
+    for (t=0; t<n; t++) {
+	if (mask[t]) {
+	    ns++;
+	}
+    }
+
+    if (ns > 0) {
+	subrows = malloc(ns * sizeof *subrows);
+	if (subrows == NULL) {
+	    return E_ALLOC;
+	}
+	for (t=0, s=0; t<n; t++) {
+	    if (mask[t]) {
+		subrows[s++] = t;
+	    }
+	}
+    }
+
+    n_subrows = ns;
+
+    return 0;
+}
+
 /* all values apart from the sentinel are initialized to zero; once
    the mask is used, 1s will indicate included observations and
    0s will indicate excluded observations
@@ -294,6 +348,7 @@ void maybe_free_full_dataset (const DATASET *dset)
 	    free(fullset);
 	    fullset = NULL;
 	}
+	free_row_index();
 	peerset = NULL;
     }
 }
@@ -312,6 +367,7 @@ static void relink_to_full_dataset (DATASET *dset)
     free(fullset);
     fullset = NULL;
     peerset = NULL;
+    free_row_index();
 }
 
 /* sync malloced elements of the fullset struct that might
@@ -506,6 +562,7 @@ static int resample_sync_dataset (DATASET *dset)
 static void
 update_full_data_values (const DATASET *dset)
 {
+    const char *mask = dset->submask;
     int i, s, t;
 
 #if SUBDEBUG
@@ -513,12 +570,25 @@ update_full_data_values (const DATASET *dset)
 	    (void *) fullset->Z, (void *) dset->Z, (void *) dset);
 #endif
 
+    if (subrows != NULL && n_subrows == dset->n) {
+	/* scatter via the row index, skipping panel padding */
+	for (i=1; i<fullset->v && i<dset->v; i++) {
+	    for (s=0; s<n_subrows; s++) {
+		t = subrows[s];
+		if (mask[t] == 1) {
+		    fullset->Z[i][t] = dset->Z[i][s];
+		}
+	    }
+	}
+	return;
+    }
+
     for (i=1; i<fullset->v && i<dset->v; i++) {
 	s = 0;
 	for (t=0; t<fullset->n; t++) {
-	    if (dset->submask[t] == 1) {
+	    if (mask[t] == 1) {
 		fullset->Z[i][t] = dset->Z[i][s++];
-	    } else if (dset->submask[t] == 'p') {
+	    } else if (mask[t] == 'p') {
 		/* skip panel padding (?) */
 		s++;
 	    }
@@ -609,10 +679,19 @@ static int add_new_vars_to_full (DATASET *dset)
 #endif
 
     for (i=V0; i<dset->v; i++) {
-	s = 0;
-	for (t=0; t<N; t++) {
-	    fullset->Z[i][t] = (dset->submask[t])?
-		dset->Z[i][s++] : NADBL;
+	if (subrows != NULL && n_subrows == dset->n) {
+	    for (t=0; t<N; t++) {
+		fullset->Z[i][t] = NADBL;
+	    }
+	    for (s=0; s<n_subrows; s++) {
+		fullset->Z[i][subrows[s]] = dset->Z[i][s];
+	    }
+	} else {
+	    s = 0;
+	    for (t=0; t<N; t++) {
+		fullset->Z[i][t] = (dset->submask[t])?
+		    dset->Z[i][s++] : NADBL;
+	    }
 	}
     }
 
@@ -1229,6 +1308,7 @@ static void destroy_full_dataset (DATASET *dset)
     clear_datainfo(dset, CLEAR_SUBSAMPLE);
 
     peerset = NULL;
+    free_row_index();
 }
 
 int complex_subsampled (void)
@@ -1309,9 +1389,15 @@ static int mask_contiguous (const char *mask,
     return contig;
 }
 
+/* Copy data from @dset into @subset, which has been sized to
+   match @mask. If @rows is non-NULL it must be the row-index
+   view of @mask, and is used to gather the selected rows.
+*/
+
 static void
 copy_data_to_subsample (DATASET *subset, const DATASET *dset,
-			int maxv, const char *mask)
+			int maxv, const char *mask,
+			const int *rows)
 {
     int i, t, s;
 
@@ -1321,16 +1407,28 @@ copy_data_to_subsample (DATASET *subset, const DATASET *dset,
 #endif
 
     /* copy data values */
-    for (i=1; i<maxv; i++) {
-	s = 0;
-	for (t=0; t<dset->n; t++) {
-	    if (mask == NULL) {
-		subset->Z[i][s++] = dset->Z[i][t];
-	    } else if (mask[t] == 1) {
-		subset->Z[i][s++] = dset->Z[i][t];
-	    } else if (mask[t] == 'p') {
-		/* panel padding */
-		subset->Z[i][s++] = NADBL;
+    if (mask == NULL) {
+	for (i=1; i<maxv; i++) {
+	    memcpy(subset->Z[i], dset->Z[i], dset->n * sizeof **dset->Z);
+	}
+    } else if (rows != NULL) {
+	/* gather via the row index */
+	for (i=1; i<maxv; i++) {
+	    for (s=0; s<subset->n; s++) {
+		t = rows[s];
+		subset->Z[i][s] = (mask[t] == 'p')? NADBL : dset->Z[i][t];
+	    }
+	}
+    } else {
+	for (i=1; i<maxv; i++) {
+	    s = 0;
+	    for (t=0; t<dset->n; t++) {
+		if (mask[t] == 1) {
+		    subset->Z[i][s++] = dset->Z[i][t];
+		} else if (mask[t] == 'p') {
+		    /* panel padding */
+		    subset->Z[i][s++] = NADBL;
+		}
 	    }
 	}
     }
@@ -1846,8 +1944,16 @@ restrict_sample_from_mask (char *mask, DATASET *dset, gretlopt opt)
 	}
     }
 
+    /* build the row-index view of the restriction */
+    if (make_row_index(mask, dset->n)) {
+	dataset_destroy_obs_markers(subset);
+	free_Z(subset);
+	free(subset);
+	return E_ALLOC;
+    }
+
     /* copy across data (and case markers, if any) */
-    copy_data_to_subsample(subset, dset, dset->v, mask);
+    copy_data_to_subsample(subset, dset, dset->v, mask, subrows);
 
     if (opt & OPT_T) {
 	/* --permanent */
@@ -2407,6 +2513,7 @@ int perma_sample (DATASET *dset, gretlopt opt, PRN *prn,
 
     destroy_dataset(fullset);
     fullset = peerset = NULL;
+    free_row_index();
 
     return 0;
 }
@@ -2929,7 +3036,7 @@ int add_dataset_to_model (MODEL *pmod, const DATASET *dset,
     copy_series_info(pmod->dataset, srcset, maxv);
 
     /* copy across data */
-    copy_data_to_subsample(pmod->dataset, srcset, maxv, mask);
+    copy_data_to_subsample(pmod->dataset, srcset, maxv, mask, NULL);
 
     /* dataset characteristics such as pd: if we're rebuilding the
        full dataset copy these across; but if we're reconstructing a
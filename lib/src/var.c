@@ -2599,6 +2599,335 @@ GRETL_VAR *gretl_VAR (int order, int *laglist, int *list,
     return var;
 }
 
+/* Apparatus for rolling or recursive VAR estimation over a range of
+   lag orders. The columns of the regressor matrix are ordered as
+   constant, exogenous terms, then all variables at lag 1, at lag 2,
+   and so on, so that the regressors at lag order j are a leading
+   block of columns. Given the Cholesky factor L of X'X and
+   W = L^{-1} X'Y, the residual cross-product at order j is Y'Y minus
+   the sum of w_r w_r' over the leading rows of W, and a one-step
+   forecast is a cumulative sum in the same way, so one factorization
+   per window serves all the lag orders. The cross-products are
+   updated as the window moves, and recomputed from scratch every so
+   often to limit the accumulation of rounding error.
+*/
+
+static void varroll_regressors (const gretl_matrix *Y,
+				const gretl_matrix *X,
+				int p, int t, double *z)
+{
+    int T = Y->rows;
+    int i, l, k = 0;
+
+    z[k++] = 1.0;
+    if (X != NULL) {
+	for (i=0; i<X->cols; i++) {
+	    z[k++] = X->val[i * T + t];
+	}
+    }
+    for (l=1; l<=p; l++) {
+	for (i=0; i<Y->cols; i++) {
+	    z[k++] = Y->val[i * T + t - l];
+	}
+    }
+}
+
+/* add (@sgn = 1) or remove (@sgn = -1) observation @t: only the
+   lower triangles of the symmetric matrices are maintained */
+
+static void varroll_update (const gretl_matrix *Y,
+			    const gretl_matrix *X,
+			    int p, int t, double sgn, double *z,
+			    gretl_matrix *XTX, gretl_matrix *XTY,
+			    gretl_matrix *YTY)
+{
+    int K = XTX->rows;
+    int n = Y->cols;
+    int T = Y->rows;
+    double zi, yi;
+    int i, j;
+
+    varroll_regressors(Y, X, p, t, z);
+
+    for (j=0; j<K; j++) {
+	zi = sgn * z[j];
+	for (i=j; i<K; i++) {
+	    XTX->val[j * K + i] += zi * z[i];
+	}
+    }
+    for (j=0; j<n; j++) {
+	yi = sgn * Y->val[j * T + t];
+	for (i=0; i<K; i++) {
+	    XTY->val[j * K + i] += yi * z[i];
+	}
+	for (i=j; i<n; i++) {
+	    YTY->val[j * n + i] += yi * Y->val[i * T + t];
+	}
+    }
+}
+
+/* solve L x = b in place, for lower-triangular L */
+
+static void varroll_lsolve (const gretl_matrix *L, double *b)
+{
+    int K = L->rows;
+    int i, j;
+
+    for (i=0; i<K; i++) {
+	for (j=0; j<i; j++) {
+	    b[i] -= L->val[j * K + i] * b[j];
+	}
+	b[i] /= L->val[i * K + i];
+    }
+}
+
+/**
+ * VAR_rolling_bundle:
+ * @Y: T x n matrix holding the endogenous variables.
+ * @X: T x k matrix holding exogenous variables, or NULL.
+ * @p: maximum lag order.
+ * @w: number of observations in each estimation window.
+ * @recursive: if non-zero the windows have a common start and
+ * expand by one observation at a time, otherwise they roll
+ * forward with fixed length @w.
+ * @err: location to receive error code.
+ *
+ * Estimates VARs with a constant, the columns of @X and lag orders
+ * 1 to @p on a sequence of sample windows, using observations @p + 1
+ * onward of @Y (so that all lag orders are estimated on the same
+ * observations in any given window).
+ *
+ * Returns: a bundle holding, for each window (row) and lag order
+ * (column), the log-likelihood and the Akaike, Schwarz and
+ * Hannan-Quinn criteria, along with the orders selected by each
+ * criterion, the one-step-ahead forecasts for the observation
+ * following the window, and the window limits; or NULL on failure.
+ */
+
+gretl_bundle *VAR_rolling_bundle (const gretl_matrix *Y,
+				  const gretl_matrix *X,
+				  int p, int w, int recursive,
+				  int *err)
+{
+    gretl_bundle *b = NULL;
+    gretl_matrix_block *MB = NULL;
+    gretl_matrix *XTX, *XTY, *YTY;
+    gretl_matrix *L, *V, *S, *Sj;
+    gretl_matrix *ll = NULL, *crit[N_IVALS] = {NULL};
+    gretl_matrix *sel = NULL, *fc = NULL, *smpl = NULL;
+    const char *critnames[N_IVALS] = {"AIC", "BIC", "HQC"};
+    double *z = NULL, *fv = NULL;
+    double ldet, llj, cj, best[N_IVALS];
+    int T, n, kx, K, Tu, nwin;
+    int first, last, Tw, kj;
+    int c, i, j, r, s, iw;
+
+    if (gretl_is_null_matrix(Y)) {
+	*err = E_INVARG;
+	return NULL;
+    }
+
+    T = Y->rows;
+    n = Y->cols;
+    kx = gretl_is_null_matrix(X) ? 0 : X->cols;
+    K = 1 + kx + n * p;
+    Tu = T - p;
+
+    if (kx > 0 && X->rows != T) {
+	*err = E_NONCONF;
+    } else if (p < 1 || w <= K || w > Tu) {
+	gretl_errmsg_sprintf(_("Invalid window size: it must exceed the "
+			       "number of regressors (%d) and be at most %d"),
+			     K, Tu);
+	*err = E_INVARG;
+    } else if (gretl_matrix_na_check(Y) ||
+	       (kx > 0 && gretl_matrix_na_check(X))) {
+	*err = E_MISSDATA;
+    }
+
+    if (*err) {
+	return NULL;
+    }
+
+    if (kx == 0) {
+	X = NULL;
+    }
+
+    nwin = Tu - w + 1;
+
+    MB = gretl_matrix_block_new(&XTX, K, K, &XTY, K, n,
+				&YTY, n, n, &L, K, K,
+				&V, K, n, &S, n, n,
+				&Sj, n, n, NULL);
+    z = malloc(K * sizeof *z);
+    fv = malloc(n * sizeof *fv);
+    ll = gretl_matrix_alloc(nwin, p);
+    sel = gretl_matrix_alloc(nwin, N_IVALS);
+    fc = gretl_matrix_alloc(nwin, n * p);
+    smpl = gretl_matrix_alloc(nwin, 2);
+    for (c=0; c<N_IVALS; c++) {
+	crit[c] = gretl_matrix_alloc(nwin, p);
+	if (crit[c] == NULL) {
+	    *err = E_ALLOC;
+	}
+    }
+
+    if (*err || MB == NULL || z == NULL || fv == NULL || ll == NULL ||
+	sel == NULL || fc == NULL || smpl == NULL) {
+	*err = E_ALLOC;
+	goto bailout;
+    }
+
+    for (iw=0; iw<nwin; iw++) {
+	first = recursive ? 0 : iw;
+	last = w - 1 + iw;
+	Tw = last - first + 1;
+
+	if (iw == 0 || (!recursive && iw % w == 0)) {
+	    /* (re-)compute the cross-products from scratch */
+	    gretl_matrix_zero(XTX);
+	    gretl_matrix_zero(XTY);
+	    gretl_matrix_zero(YTY);
+	    for (s=first; s<=last; s++) {
+		varroll_update(Y, X, p, p + s, 1, z, XTX, XTY, YTY);
+	    }
+	} else {
+	    varroll_update(Y, X, p, p + last, 1, z, XTX, XTY, YTY);
+	    if (!recursive) {
+		varroll_update(Y, X, p, p + first - 1, -1, z,
+			       XTX, XTY, YTY);
+	    }
+	}
+
+	gretl_matrix_set(smpl, iw, 0, p + first + 1);
+	gretl_matrix_set(smpl, iw, 1, p + last + 1);
+
+	for (j=0; j<p; j++) {
+	    gretl_matrix_set(ll, iw, j, NADBL);
+	    for (c=0; c<N_IVALS; c++) {
+		gretl_matrix_set(crit[c], iw, j, NADBL);
+	    }
+	    for (i=0; i<n; i++) {
+		gretl_matrix_set(fc, iw, j * n + i, NADBL);
+	    }
+	}
+	for (c=0; c<N_IVALS; c++) {
+	    gretl_matrix_set(sel, iw, c, NADBL);
+	    best[c] = NADBL;
+	}
+
+	gretl_matrix_copy_values(L, XTX);
+	if (gretl_matrix_cholesky_decomp(L)) {
+	    /* collinear regressors in this window: skip it */
+	    continue;
+	}
+
+	/* W = L^{-1} X'Y, in V */
+	gretl_matrix_copy_values(V, XTY);
+	for (i=0; i<n; i++) {
+	    varroll_lsolve(L, V->val + i * K);
+	}
+
+	/* the forecast regressors, transformed likewise */
+	if (p + last + 1 < T) {
+	    varroll_regressors(Y, X, p, p + last + 1, z);
+	    varroll_lsolve(L, z);
+	    for (i=0; i<n; i++) {
+		fv[i] = 0.0;
+	    }
+	}
+
+	/* Y'Y, symmetrized */
+	for (j=0; j<n; j++) {
+	    for (i=j; i<n; i++) {
+		S->val[i * n + j] = S->val[j * n + i] = YTY->val[j * n + i];
+	    }
+	}
+
+	r = 0;
+	for (j=0; j<=p; j++) {
+	    /* number of regressors at lag order j */
+	    kj = 1 + kx + j * n;
+	    for ( ; r<kj; r++) {
+		for (i=0; i<n; i++) {
+		    for (s=0; s<n; s++) {
+			S->val[s * n + i] -= V->val[i * K + r] *
+			    V->val[s * K + r];
+		    }
+		    if (p + last + 1 < T) {
+			fv[i] += z[r] * V->val[i * K + r];
+		    }
+		}
+	    }
+	    if (j == 0) {
+		continue;
+	    }
+	    if (p + last + 1 < T) {
+		for (i=0; i<n; i++) {
+		    gretl_matrix_set(fc, iw, (j-1) * n + i, fv[i]);
+		}
+	    }
+	    gretl_matrix_copy_values(Sj, S);
+	    gretl_matrix_divide_by_scalar(Sj, Tw);
+	    ldet = gretl_vcv_log_determinant(Sj, err);
+	    if (*err) {
+		/* perfect fit or numerical trouble */
+		*err = 0;
+		continue;
+	    }
+	    llj = -(n * Tw / 2.0) * (LN_2_PI + 1) - (Tw / 2.0) * ldet;
+	    gretl_matrix_set(ll, iw, j-1, llj);
+	    for (c=0; c<N_IVALS; c++) {
+		if (c == 0) {
+		    cj = (-2.0 * llj + 2.0 * n * kj) / Tw;
+		} else if (c == 1) {
+		    cj = (-2.0 * llj + n * kj * log(Tw)) / Tw;
+		} else {
+		    cj = (-2.0 * llj + 2.0 * n * kj * log(log(Tw))) / Tw;
+		}
+		gretl_matrix_set(crit[c], iw, j-1, cj);
+		if (na(best[c]) || cj < best[c]) {
+		    best[c] = cj;
+		    gretl_matrix_set(sel, iw, c, j);
+		}
+	    }
+	}
+    }
+
+    b = gretl_bundle_new();
+    if (b == NULL) {
+	*err = E_ALLOC;
+    } else {
+	gretl_bundle_donate_data(b, "ll", ll, GRETL_TYPE_MATRIX, 0);
+	for (c=0; c<N_IVALS; c++) {
+	    gretl_bundle_donate_data(b, critnames[c], crit[c],
+				     GRETL_TYPE_MATRIX, 0);
+	    crit[c] = NULL;
+	}
+	gretl_bundle_donate_data(b, "order", sel, GRETL_TYPE_MATRIX, 0);
+	gretl_bundle_donate_data(b, "fcast", fc, GRETL_TYPE_MATRIX, 0);
+	gretl_bundle_donate_data(b, "sample", smpl, GRETL_TYPE_MATRIX, 0);
+	gretl_bundle_set_int(b, "maxlag", p);
+	gretl_bundle_set_int(b, "recursive", recursive != 0);
+	ll = sel = fc = smpl = NULL;
+    }
+
+ bailout:
+
+    gretl_matrix_block_destroy(MB);
+    gretl_matrix_free(ll);
+    gretl_matrix_free(sel);
+    gretl_matrix_free(fc);
+    gretl_matrix_free(smpl);
+    for (c=0; c<N_IVALS; c++) {
+	gretl_matrix_free(crit[c]);
+    }
+    free(z);
+    free(fv);
+
+    return b;
+}
+
 static void
 print_johansen_sigmas (const JohansenInfo *jv, PRN *prn)
 {
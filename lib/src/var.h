@@ -95,6 +95,11 @@ GRETL_VAR *gretl_VECM (int order, int rank, int *list,
 		       const DATASET *dset, gretlopt opt,
 		       PRN *prn, int *err);
 
+gretl_bundle *VAR_rolling_bundle (const gretl_matrix *Y,
+				  const gretl_matrix *X,
+				  int p, int w, int recursive,
+				  int *err);
+
 const gretl_matrix *
 gretl_VAR_get_forecast_matrix (GRETL_VAR *var, int t1, int t2,
 			       DATASET *dset, gretlopt opt,
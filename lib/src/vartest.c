@@ -724,6 +724,122 @@ static int lagsel_get_min_lag (int p, int *err)
     return m;
 }
 
+/* Lag selection from a single QR decomposition. The columns of
+   the maximum-order X matrix are rearranged so that the terms other
+   than lags of the endogenous variables come first, followed by the
+   lags in order (all variables at lag 1, then at lag 2, and so on);
+   the regressors for lag order j are then the first cols0 + j*n
+   columns. With X = QR and W = Q'Y, the residual cross-product at
+   order j equals that at the maximum order plus the sum of the
+   outer products of the rows of W that belong to lags j+1 to p, so
+   the log-determinants for all orders are obtained without any
+   further regressions, and without subtractive cancellation.
+   Returns non-zero if this is not applicable, in which case the
+   caller should estimate the models one at a time.
+*/
+
+static int lagsel_nested_ldets (GRETL_VAR *var, int minlag,
+				double *ldet)
+{
+    gretl_matrix *Q = NULL;
+    gretl_matrix *R = NULL;
+    gretl_matrix *W = NULL;
+    gretl_matrix *S = NULL;
+    gretl_matrix *Sj = NULL;
+    int p = var->order;
+    int n = var->neqns;
+    int T = var->T;
+    int K = var->X->cols;
+    int lag0 = var->ifc;
+    int cols0 = K - p * n;
+    double rmax = 0, *src;
+    int c, i, j, k, l, r;
+    int err = 0;
+
+    if (var->lags != NULL || cols0 < 0 || K > T) {
+	return E_NOTIMP;
+    }
+
+    Q = gretl_matrix_alloc(T, K);
+    R = gretl_matrix_alloc(K, K);
+    W = gretl_matrix_alloc(K, n);
+    S = gretl_matrix_alloc(n, n);
+    Sj = gretl_matrix_alloc(n, n);
+
+    if (Q == NULL || R == NULL || W == NULL || S == NULL || Sj == NULL) {
+	err = E_ALLOC;
+	goto bailout;
+    }
+
+    /* non-lag columns first, then lags in lag-major order */
+    c = 0;
+    for (k=0; k<K; k++) {
+	if (k < lag0 || k >= lag0 + n * p) {
+	    src = var->X->val + k * T;
+	    memcpy(Q->val + T * c++, src, T * sizeof *src);
+	}
+    }
+    for (l=0; l<p; l++) {
+	for (i=0; i<n; i++) {
+	    src = var->X->val + (lag0 + i * p + l) * T;
+	    memcpy(Q->val + T * c++, src, T * sizeof *src);
+	}
+    }
+
+    err = gretl_matrix_QR_decomp(Q, R);
+
+    if (!err) {
+	/* check for (near) rank deficiency */
+	for (k=0; k<K; k++) {
+	    if (fabs(R->val[k * K + k]) > rmax) {
+		rmax = fabs(R->val[k * K + k]);
+	    }
+	}
+	for (k=0; k<K && !err; k++) {
+	    if (fabs(R->val[k * K + k]) < 1.0e-9 * rmax) {
+		err = E_SINGULAR;
+	    }
+	}
+    }
+
+    if (!err) {
+	err = gretl_matrix_multiply_mod(Q, GRETL_MOD_TRANSPOSE,
+					var->Y, GRETL_MOD_NONE,
+					W, GRETL_MOD_NONE);
+    }
+
+    if (!err) {
+	err = gretl_matrix_multiply_mod(var->E, GRETL_MOD_TRANSPOSE,
+					var->E, GRETL_MOD_NONE,
+					S, GRETL_MOD_NONE);
+    }
+
+    for (j=p-1; j>=minlag && !err; j--) {
+	/* drop the lag-(j+1) terms */
+	for (r=cols0+j*n; r<cols0+(j+1)*n; r++) {
+	    for (i=0; i<n; i++) {
+		for (k=0; k<n; k++) {
+		    S->val[k * n + i] += gretl_matrix_get(W, r, i) *
+			gretl_matrix_get(W, r, k);
+		}
+	    }
+	}
+	gretl_matrix_copy_values(Sj, S);
+	gretl_matrix_divide_by_scalar(Sj, T);
+	ldet[j - minlag] = gretl_vcv_log_determinant(Sj, &err);
+    }
+
+ bailout:
+
+    gretl_matrix_free(Q);
+    gretl_matrix_free(R);
+    gretl_matrix_free(W);
+    gretl_matrix_free(S);
+    gretl_matrix_free(Sj);
+
+    return err;
+}
+
 /* apparatus for selecting the optimal lag length for a VAR */
 
 int VAR_do_lagsel (GRETL_VAR *var, const DATASET *dset,
@@ -732,6 +848,7 @@ int VAR_do_lagsel (GRETL_VAR *var, const DATASET *dset,
     gretl_matrix *crittab = NULL;
     gretl_matrix *lltab = NULL;
     gretl_matrix *E = NULL;
+    double *ldets = NULL;
     int p = var->order;
     int r = p - 1;
     int T = var->T;
@@ -776,10 +893,19 @@ int VAR_do_lagsel (GRETL_VAR *var, const DATASET *dset,
 	use_QR = 1;
     }
 
+    /* try getting all the log-determinants at once */
+    ldets = malloc((p - minlag) * sizeof *ldets);
+    if (ldets != NULL && lagsel_nested_ldets(var, minlag, ldets)) {
+	free(ldets);
+	ldets = NULL;
+    }
+
     for (j=minlag; j<p && !err; j++) {
 	int jxcols = cols0 + j * n;
 
-	if (jxcols == 0) {
+	if (ldets != NULL) {
+	    ldet = ldets[j - minlag];
+	} else if (jxcols == 0) {
 	    gretl_matrix_copy_values(E, var->Y);
 	} else {
 	    VAR_fill_X(var, j, dset);
@@ -796,7 +922,7 @@ int VAR_do_lagsel (GRETL_VAR *var, const DATASET *dset,
 	    }
 	}
 
-	if (!err) {
+	if (!err && ldets == NULL) {
 	    ldet = gretl_VAR_ldet(var, E, &err);
 	}
 
@@ -849,6 +975,7 @@ int VAR_do_lagsel (GRETL_VAR *var, const DATASET *dset,
     gretl_matrix_free(crittab);
     gretl_matrix_free(lltab);
     gretl_matrix_free(E);
+    free(ldets);
 
     return err;
 }
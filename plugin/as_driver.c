@@ -32,6 +32,7 @@ struct as_info {
     double toler;  /* tolerance for switching to fast iterations */
     double loglik;
     BFGS_CRIT_FUNC cfunc;
+    BFGS_reentrant *rt; /* for parallel derivatives, or NULL */
     int ma_check;
     int iupd; /* specific to AS 154 */
     int ncalls;
@@ -192,6 +193,63 @@ static void as_info_free (struct as_info *as)
     }
 }
 
+/* Support for computing numerical derivatives of the loglikelihood
+   in parallel (see BFGS_reentrant_crit): each thread gets its own
+   workspace, while sharing the read-only data in @as.
+*/
+
+static void as_info_clone_free (void *data)
+{
+    struct as_info *cp = data;
+
+    if (cp->y0 != NULL) {
+	/* @y is private to the copy, @y0 is shared */
+	free(cp->y);
+	cp->y0 = NULL;
+    }
+    cp->free_X = 0;
+    as_info_free(cp);
+    free(cp);
+}
+
+static void *as_info_clone (void *data, int *err)
+{
+    struct as_info *as = data;
+    struct as_info *cp = calloc(1, sizeof *cp);
+
+    if (cp == NULL) {
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    *err = as_info_init(cp, as->algo, as->ai, as->toler);
+
+    if (!*err) {
+	cp->cfunc = as->cfunc;
+	cp->ma_check = as->ma_check;
+	cp->iupd = as->iupd;
+	cp->X = as->X;
+	if (as->y0 != NULL) {
+	    /* as_fill_arrays() will write to y */
+	    cp->y = copyvec(as->y, as->n);
+	    if (cp->y == NULL) {
+		*err = E_ALLOC;
+	    } else {
+		cp->y0 = as->y0;
+	    }
+	} else {
+	    cp->y = as->y;
+	}
+    }
+
+    if (*err) {
+	as_info_clone_free(cp);
+	cp = NULL;
+    }
+
+    return cp;
+}
+
 static void as_write_big_phi (const double *b,
 			      struct as_info *as)
 {
@@ -637,8 +695,14 @@ static int as_arma_finish (MODEL *pmod,
 	gretl_matrix *Hinv;
 	double d = 0.0; /* adjust? */
 
-	Hinv = numerical_hessian_inverse(b, ainfo->nc, as->cfunc,
-					 as, d, &vcv_err);
+	if (as->rt != NULL) {
+	    Hinv = numerical_hessian_inverse(b, ainfo->nc,
+					     BFGS_reentrant_crit,
+					     as->rt, d, &vcv_err);
+	} else {
+	    Hinv = numerical_hessian_inverse(b, ainfo->nc, as->cfunc,
+					     as, d, &vcv_err);
+	}
 	if (!vcv_err) {
 	    if (QML) {
 		vcv_err = arma_QML_vcv(pmod, Hinv, as, as->algo, b, s2,
@@ -750,6 +814,9 @@ static int as_arma (const double *coeff,
     if (!err) {
 	/* maximize loglikelihood via BFGS */
 	gretlopt maxopt = opt | OPT_A;
+	BFGS_reentrant rt = {0};
+	BFGS_CRIT_FUNC cfunc;
+	void *cdata = &as;
 	int maxit;
 	double toler;
 
@@ -770,9 +837,21 @@ static int as_arma (const double *coeff,
 
 	BFGS_defaults(&maxit, &toler, ARMA);
 
+	cfunc = as.cfunc;
+	if (libset_use_openmp((guint64) as.n * as.r * ainfo->nc)) {
+	    /* numerical derivatives can be computed in parallel */
+	    rt.cfunc = as.cfunc;
+	    rt.data = &as;
+	    rt.dclone = as_info_clone;
+	    rt.dfree = as_info_clone_free;
+	    as.rt = &rt;
+	    cfunc = BFGS_reentrant_crit;
+	    cdata = &rt;
+	}
+
 	err = BFGS_max(b, ainfo->nc, maxit, toler,
 		       &ainfo->fncount, &ainfo->grcount,
-		       as.cfunc, C_LOGLIK, NULL, &as, NULL,
+		       cfunc, C_LOGLIK, NULL, cdata, NULL,
 		       maxopt, ainfo->prn);
 
 	if (!err) {
@@ -785,6 +864,7 @@ static int as_arma (const double *coeff,
 	    err = as_arma_finish(pmod, ainfo, dset, &as, b,
 				 opt, ainfo->prn);
 	}
+	as.rt = NULL;
     }
 
     if (err && !pmod->errcode) {
@@ -54,6 +54,10 @@ struct bp_container_ {
     gretl_vector *fitted1;   /* x_1'\beta */
     gretl_vector *fitted2;   /* x_2'\gamma */
 
+    double *pa, *pb;         /* signed indices for the joint probs */
+    double *P;               /* joint probs of the observed outcomes */
+    char *neg;               /* flags for negated correlation */
+
     gretl_vector *beta;	     /* first eq. parameters */
     gretl_vector *gama;      /* second eq. parameters */
     double arho;             /* atan(rho) */
@@ -93,6 +97,9 @@ static void bp_container_destroy (bp_container *bp)
     gretl_vector_free(bp->fitted1);
     gretl_vector_free(bp->fitted2);
 
+    free(bp->pa);
+    free(bp->neg);
+
     gretl_vector_free(bp->beta);
     gretl_vector_free(bp->gama);
     gretl_matrix_free(bp->vcv);
@@ -128,6 +135,8 @@ static bp_container *bp_container_new (const int *list)
     bp->reg2 = NULL;
     bp->fitted1 = NULL;
     bp->fitted2 = NULL;
+    bp->pa = bp->pb = bp->P = NULL;
+    bp->neg = NULL;
 
     bp->beta = NULL;
     bp->gama = NULL;
@@ -446,9 +455,16 @@ static int bp_container_fill (bp_container *bp, MODEL *olsmod,
 	bp->score = gretl_matrix_alloc(bp->nobs, bp->npar);
 	bp->sscore = gretl_vector_alloc(bp->npar);
 
+	bp->pa = malloc(3 * bp->nobs * sizeof *bp->pa);
+	bp->neg = malloc(bp->nobs);
+
 	if (bp->fitted1 == NULL || bp->fitted1 == NULL ||
-	    bp->score == NULL || bp->sscore == NULL) {
+	    bp->score == NULL || bp->sscore == NULL ||
+	    bp->pa == NULL || bp->neg == NULL) {
 	    err = E_ALLOC;
+	} else {
+	    bp->pb = bp->pa + bp->nobs;
+	    bp->P = bp->pb + bp->nobs;
 	}
     }
 
@@ -576,33 +592,49 @@ static int biprob_prelim (const double *theta, bp_container *bp)
     return err;
 }
 
+/* Fill bp->P with the joint probabilities of the observed
+   outcomes at the current parameter values, evaluating them
+   all in one pass so that the work depending on rho alone is
+   done only once (and the evaluations may be threaded).
+*/
+
+static int biprob_joint_probs (bp_container *bp)
+{
+    double a, b;
+    int i;
+
+    for (i=0; i<bp->nobs; i++) {
+	a = bp->fitted1->val[i];
+	b = bp->fitted2->val[i];
+	bp->pa[i] = bp->s1[i] ? a : -a;
+	bp->pb[i] = bp->s2[i] ? b : -b;
+	bp->neg[i] = (bp->s1[i] != bp->s2[i]);
+    }
+
+    return bvnorm_cdf_array(tanh(bp->arho), bp->pa, bp->pb,
+			    bp->neg, bp->P, bp->nobs);
+}
+
 static double biprob_loglik (const double *theta, void *ptr)
 {
     bp_container *bp = (bp_container *) ptr;
-    double rho, llt, a, b, P;
     double ll = NADBL;
-    int i, eqt, err;
+    int i, err;
 
     err = biprob_prelim(theta, bp);
 
+    if (!err) {
+	err = biprob_joint_probs(bp);
+    }
+
     if (err) {
 	return ll;
     }
 
     ll = 0.0;
-    rho = tanh(bp->arho);
-    
+
     for (i=0; i<bp->nobs; i++) {
-	a = gretl_vector_get(bp->fitted1, i);
-	b = gretl_vector_get(bp->fitted2, i);
-	
-	a = bp->s1[i] ? a : -a;
-	b = bp->s2[i] ? b : -b;
-	eqt = (bp->s1[i] == bp->s2[i]);
-	
-	P = bvnorm_cdf((eqt ? rho : -rho), a, b);
-	llt = log(P);
-	ll += llt;
+	ll += log(bp->P[i]);
     }
 
     bp->ll = ll;
@@ -621,6 +653,10 @@ static int biprob_score (double *theta, double *s, int npar, BFGS_CRIT_FUNC ll,
 
     err = biprob_prelim(theta, bp);
 
+    if (!err) {
+	err = biprob_joint_probs(bp);
+    }
+
     if (err) {
 	return err;
     }
@@ -630,15 +666,11 @@ static int biprob_score (double *theta, double *s, int npar, BFGS_CRIT_FUNC ll,
     gretl_matrix_zero(bp->sscore);
 
     for (i=0; i<bp->nobs; i++) {
-	a = gretl_vector_get(bp->fitted1, i);
-	b = gretl_vector_get(bp->fitted2, i);
-	
-	a = bp->s1[i] ? a : -a;
-	b = bp->s2[i] ? b : -b;
-	eqt = (bp->s1[i] == bp->s2[i]);
+	a = bp->pa[i];
+	b = bp->pb[i];
+	eqt = !bp->neg[i];
 	ssa = eqt ? sa : -sa;
-	
-	P = bvnorm_cdf(ssa/ca, a, b);
+	P = bp->P[i];
 	
 	/* score */
 	
@@ -701,7 +733,7 @@ int biprobit_hessian (double *theta, gretl_matrix *H, void *ptr)
 {
     bp_container *bp = (bp_container *) ptr;
     double a, b, P, f, d1, d2, da, tmp, u_ab, u_ba;
-    double ca, sa, ssa, rho, x;
+    double ca, sa, ssa, x;
     double h11 = 0;
     double h12 = 0;
     double h13 = 0;
@@ -715,6 +747,10 @@ int biprobit_hessian (double *theta, gretl_matrix *H, void *ptr)
 
     err = biprob_prelim(theta, bp);
 
+    if (!err) {
+	err = biprob_joint_probs(bp);
+    }
+
     if (!err) {
 	ca = cosh(bp->arho);
 	sa = sinh(bp->arho);
@@ -743,15 +779,11 @@ int biprobit_hessian (double *theta, gretl_matrix *H, void *ptr)
 	   perseverance.
 	*/
 
-	a = gretl_vector_get(bp->fitted1, t);
-	b = gretl_vector_get(bp->fitted2, t);
-	
-	a = bp->s1[t] ? a : -a;
-	b = bp->s2[t] ? b : -b;
-	eqt = (bp->s1[t] == bp->s2[t]);
+	a = bp->pa[t];
+	b = bp->pb[t];
+	eqt = !bp->neg[t];
 	ssa = eqt ? sa : -sa;
-	rho = ssa/ca;
-	P = bvnorm_cdf(rho, a, b);
+	P = bp->P[t];
 	
 	/* score (for atan(rho) we use the precomputed one) */
 	
@@ -0,0 +1,712 @@
+/*
+ *  gretl -- Gnu Regression, Econometrics and Time-series Library
+ *  Copyright (C) 2001 Allin Cottrell and Riccardo "Jack" Lucchetti
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "libgretl.h"
+#include "libset.h"
+#include "gretl_utils.h"
+#include "var.h"
+#include "johansen.h"
+#include "jprivate.h"
+
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
+/* Bootstrap p-values for the Johansen trace test and for homogeneous
+   restrictions on beta. We estimate the VECM under the null (beta
+   given, alpha and the short-run coefficients by OLS), re-generate
+   the levels of the endogenous variables recursively from their
+   observed initial values using resampled residuals, as is done in
+   compute_VECM_dataset() in irfboot.c, then recompute the test
+   statistic on the artificial data. See G. Cavaliere, A. Rahbek and
+   A. M. R. Taylor, "Bootstrap determination of the co-integration
+   rank in vector autoregressive models", Econometrica, 80 (2012),
+   pp. 1721-1740.
+
+   The resampling indices are drawn up front from the gretl RNG, so
+   the results do not depend on the number of threads used.
+*/
+
+#define JBDEBUG 0
+
+#define lag_wanted(v, i) (v->lags == NULL || in_gretl_list(v->lags, i))
+
+enum {
+    JB_TRACE,
+    JB_BETA
+};
+
+typedef struct jboot_ jboot;
+typedef struct jboot_ws_ jboot_ws;
+
+struct jboot_ {
+    const GRETL_VAR *jvar; /* the original VECM */
+    int job;               /* JB_TRACE or JB_BETA */
+    int n;                 /* number of endogenous variables */
+    int p1;                /* n plus number of restricted terms */
+    int T;                 /* sample length */
+    int k;                 /* number of columns in jvar->X */
+    int order;             /* number of lagged differences */
+    int B;                 /* number of replications */
+    int r;                 /* cointegrating rank under the null */
+    int *xvar;             /* per X column: variable for lagged diff, or -1 */
+    int *xlag;             /* per X column: lag for lagged diff */
+    const gretl_matrix *H; /* beta restriction, JB_BETA only */
+    gretl_matrix *YY;      /* T x (n + p1): dY, Y(-1), restricted terms */
+    gretl_matrix *PiT;     /* p1 x n: transpose of alpha*beta' under H0 */
+    gretl_matrix *G;       /* k x n: coefficients on X under H0 */
+    gretl_matrix *E;       /* T x n: centred residuals under H0 */
+    double *y0;            /* (order + 1) x n: initial levels */
+    int *S;                /* B x T: resampling indices */
+};
+
+struct jboot_ws_ {
+    gretl_matrix *YY;      /* artificial counterpart of jb->YY */
+    gretl_matrix *X;       /* artificial counterpart of jvar->X */
+    gretl_matrix *BB;      /* stage-1 coefficients */
+    gretl_matrix *RR;      /* stage-1 residuals */
+    gretl_matrix *R0;      /* residuals, VAR in differences */
+    gretl_matrix *R1;      /* residuals, second regressions */
+    gretl_matrix *R1H;     /* R1 * H, JB_BETA only */
+    gretl_matrix *ev0;     /* eigenvalues */
+    gretl_matrix *ev1;     /* restricted eigenvalues, JB_BETA only */
+    double *lev;           /* (T + order + 1) x n: levels */
+};
+
+static void jboot_destroy (jboot *jb)
+{
+    if (jb != NULL) {
+	free(jb->xvar);
+	free(jb->xlag);
+	gretl_matrix_free(jb->YY);
+	gretl_matrix_free(jb->PiT);
+	gretl_matrix_free(jb->G);
+	gretl_matrix_free(jb->E);
+	free(jb->y0);
+	free(jb->S);
+	free(jb);
+    }
+}
+
+/* Fill jb->YY as in VECM_fill_Y() in var.c, and record the initial
+   levels of the endogenous variables, along with the positions of
+   the lagged differences in jvar->X.
+*/
+
+static void jboot_fill_data (jboot *jb, const DATASET *dset)
+{
+    const GRETL_VAR *v = jb->jvar;
+    int n = jb->n;
+    int t0 = v->t1 - jb->order - 1;
+    const double *yi;
+    int i, j, k, m, s, t;
+
+    for (i=0; i<n; i++) {
+	yi = dset->Z[v->ylist[i+1]];
+	for (t=v->t1, s=0; t<=v->t2; t++, s++) {
+	    gretl_matrix_set(jb->YY, s, i, yi[t] - yi[t-1]);
+	    gretl_matrix_set(jb->YY, s, n + i, yi[t-1]);
+	}
+	for (m=0; m<=jb->order; m++) {
+	    jb->y0[m * n + i] = yi[t0 + m];
+	}
+    }
+
+    k = 2 * n;
+
+    if (auto_restr(v)) {
+	int trend = (v->jinfo->code == J_REST_TREND);
+
+	for (s=0; s<jb->T; s++) {
+	    gretl_matrix_set(jb->YY, s, k, trend ? (v->t1 + s) : 1);
+	}
+	k++;
+    }
+
+    if (v->rlist != NULL) {
+	for (i=1; i<=v->rlist[0]; i++) {
+	    yi = dset->Z[v->rlist[i]];
+	    for (t=v->t1, s=0; t<=v->t2; t++, s++) {
+		gretl_matrix_set(jb->YY, s, k, yi[t]);
+	    }
+	    k++;
+	}
+    }
+
+    /* column layout of X: see VAR_fill_X() */
+    for (k=0; k<jb->k; k++) {
+	jb->xvar[k] = -1;
+	jb->xlag[k] = 0;
+    }
+    k = (v->detflags & DET_CONST)? 1 : 0;
+    for (i=0; i<n; i++) {
+	for (j=1; j<=jb->order; j++) {
+	    if (lag_wanted(v, j)) {
+		jb->xvar[k] = i;
+		jb->xlag[k] = j;
+		k++;
+	    }
+	}
+    }
+}
+
+static jboot *jboot_new (const GRETL_VAR *jvar, const DATASET *dset,
+			 int job, int *err)
+{
+    jboot *jb = calloc(1, sizeof *jb);
+    int nT;
+
+    if (jb == NULL) {
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    jb->jvar = jvar;
+    jb->job = job;
+    jb->n = jvar->neqns;
+    jb->p1 = gretl_matrix_cols(jvar->jinfo->R1);
+    jb->T = jvar->T;
+    jb->k = gretl_matrix_cols(jvar->X);
+    jb->order = jvar->order;
+    jb->B = libset_get_int(BOOTREP);
+
+    if (jvar->t1 - jb->order - 1 < 0 || jb->B < 1) {
+	*err = E_DATA;
+	free(jb);
+	return NULL;
+    }
+
+    nT = jb->B * jb->T;
+
+    jb->YY = gretl_matrix_alloc(jb->T, jb->n + jb->p1);
+    jb->PiT = gretl_zero_matrix_new(jb->p1, jb->n);
+    jb->E = gretl_matrix_alloc(jb->T, jb->n);
+    jb->y0 = malloc((jb->order + 1) * jb->n * sizeof *jb->y0);
+    jb->S = malloc(nT * sizeof *jb->S);
+
+    if (jb->YY == NULL || jb->PiT == NULL || jb->E == NULL ||
+	jb->y0 == NULL || jb->S == NULL) {
+	*err = E_ALLOC;
+    }
+
+    if (!*err && jb->k > 0) {
+	jb->G = gretl_matrix_alloc(jb->k, jb->n);
+	jb->xvar = malloc(jb->k * sizeof *jb->xvar);
+	jb->xlag = malloc(jb->k * sizeof *jb->xlag);
+	if (jb->G == NULL || jb->xvar == NULL || jb->xlag == NULL) {
+	    *err = E_ALLOC;
+	}
+    }
+
+    if (*err) {
+	jboot_destroy(jb);
+	jb = NULL;
+    } else {
+	jboot_fill_data(jb, dset);
+    }
+
+    return jb;
+}
+
+/* Estimate the VECM under the null, given the T x r matrix of
+   cointegrating relations Z1 = Y(-1) * beta (or NULL if r = 0):
+   regress dY on Z1 and X by OLS, and store alpha*beta', the
+   coefficients on X and the centred residuals.
+*/
+
+static int jboot_H0 (jboot *jb, const gretl_matrix *beta)
+{
+    gretl_matrix *dY = NULL;
+    gretl_matrix *Y1 = NULL;
+    gretl_matrix *W = NULL;
+    gretl_matrix *C = NULL;
+    gretl_matrix *Cr = NULL;
+    int T = jb->T, n = jb->n;
+    int r = (beta != NULL)? beta->cols : 0;
+    int nw = r + jb->k;
+    double x;
+    int i, j, t;
+    int err = 0;
+
+    jb->r = r;
+    gretl_matrix_zero(jb->PiT);
+
+    if (nw == 0) {
+	memcpy(jb->E->val, jb->YY->val, T * n * sizeof(double));
+	goto centre;
+    }
+
+    dY = gretl_matrix_alloc(T, n);
+    W = gretl_matrix_alloc(T, nw);
+    C = gretl_matrix_alloc(nw, n);
+
+    if (dY == NULL || W == NULL || C == NULL) {
+	err = E_ALLOC;
+	goto bailout;
+    }
+
+    memcpy(dY->val, jb->YY->val, T * n * sizeof(double));
+
+    if (r > 0) {
+	Y1 = gretl_matrix_alloc(T, jb->p1);
+	Cr = gretl_matrix_alloc(r, n);
+	if (Y1 == NULL || Cr == NULL) {
+	    err = E_ALLOC;
+	    goto bailout;
+	}
+	memcpy(Y1->val, jb->YY->val + T * n, T * jb->p1 * sizeof(double));
+	gretl_matrix_reuse(W, T, r);
+	gretl_matrix_multiply(Y1, beta, W);
+	gretl_matrix_reuse(W, T, nw);
+    }
+
+    if (jb->k > 0) {
+	memcpy(W->val + T * r, jb->jvar->X->val,
+	       T * jb->k * sizeof(double));
+    }
+
+    err = gretl_matrix_multi_SVD_ols(dY, W, C, jb->E, NULL);
+
+    if (!err) {
+	for (j=0; j<n; j++) {
+	    for (i=0; i<r; i++) {
+		gretl_matrix_set(Cr, i, j, gretl_matrix_get(C, i, j));
+	    }
+	    for (i=0; i<jb->k; i++) {
+		x = gretl_matrix_get(C, r + i, j);
+		gretl_matrix_set(jb->G, i, j, x);
+	    }
+	}
+	if (r > 0) {
+	    err = gretl_matrix_multiply(beta, Cr, jb->PiT);
+	}
+    }
+
+ centre:
+
+    if (!err) {
+	for (j=0; j<n; j++) {
+	    double *ej = jb->E->val + j * T;
+
+	    x = 0.0;
+	    for (t=0; t<T; t++) {
+		x += ej[t];
+	    }
+	    x /= T;
+	    for (t=0; t<T; t++) {
+		ej[t] -= x;
+	    }
+	}
+    }
+
+ bailout:
+
+    gretl_matrix_free(dY);
+    gretl_matrix_free(Y1);
+    gretl_matrix_free(W);
+    gretl_matrix_free(C);
+    gretl_matrix_free(Cr);
+
+    return err;
+}
+
+static void jboot_ws_free (jboot_ws *ws)
+{
+    if (ws != NULL) {
+	gretl_matrix_free(ws->YY);
+	gretl_matrix_free(ws->X);
+	gretl_matrix_free(ws->BB);
+	gretl_matrix_free(ws->RR);
+	gretl_matrix_free(ws->R0);
+	gretl_matrix_free(ws->R1);
+	gretl_matrix_free(ws->R1H);
+	gretl_matrix_free(ws->ev0);
+	gretl_matrix_free(ws->ev1);
+	free(ws->lev);
+	free(ws);
+    }
+}
+
+/* per-thread workspace: the restricted terms in YY and the columns
+   of X other than the lagged differences are the same in each
+   replication, so they're copied once here
+*/
+
+static jboot_ws *jboot_ws_new (const jboot *jb)
+{
+    jboot_ws *ws = calloc(1, sizeof *ws);
+    int n = jb->n, T = jb->T;
+    int m = n + jb->p1;
+
+    if (ws == NULL) {
+	return NULL;
+    }
+
+    ws->YY = gretl_matrix_copy(jb->YY);
+    ws->R0 = gretl_matrix_alloc(T, n);
+    ws->R1 = gretl_matrix_alloc(T, jb->p1);
+    ws->ev0 = gretl_column_vector_alloc(n);
+    ws->lev = malloc((T + jb->order + 1) * n * sizeof *ws->lev);
+
+    if (jb->k > 0) {
+	ws->X = gretl_matrix_copy(jb->jvar->X);
+	ws->BB = gretl_matrix_alloc(jb->k, m);
+	ws->RR = gretl_matrix_alloc(T, m);
+    }
+
+    if (jb->job == JB_BETA) {
+	ws->R1H = gretl_matrix_alloc(T, jb->H->cols);
+	ws->ev1 = gretl_column_vector_alloc(n);
+    }
+
+    if (get_gretl_matrix_err() || ws->lev == NULL) {
+	jboot_ws_free(ws);
+	ws = NULL;
+    }
+
+    return ws;
+}
+
+/* Generate artificial levels for the endogenous variables using the
+   resampled residuals indexed by @S, and write the corresponding
+   differences and lagged levels into ws->YY, and the lagged
+   differences into ws->X.
+*/
+
+static void jboot_generate (const jboot *jb, jboot_ws *ws, const int *S)
+{
+    const gretl_matrix *YY = jb->YY;
+    int n = jb->n, p1 = jb->p1, k = jb->k;
+    int m0 = jb->order + 1;
+    double *lev = ws->lev;
+    const double *ylag;
+    double *ynew;
+    double x, dy;
+    int c, i, j, s, vi;
+
+    memcpy(lev, jb->y0, m0 * n * sizeof *lev);
+
+    for (s=0; s<jb->T; s++) {
+	ylag = lev + (m0 + s - 1) * n;
+	ynew = lev + (m0 + s) * n;
+
+	for (c=0; c<k; c++) {
+	    vi = jb->xvar[c];
+	    if (vi >= 0) {
+		j = jb->xlag[c];
+		x = lev[(m0 + s - j) * n + vi] - lev[(m0 + s - j - 1) * n + vi];
+		gretl_matrix_set(ws->X, s, c, x);
+	    }
+	}
+
+	for (i=0; i<n; i++) {
+	    dy = gretl_matrix_get(jb->E, S[s], i);
+	    if (jb->r > 0) {
+		for (j=0; j<n; j++) {
+		    dy += ylag[j] * gretl_matrix_get(jb->PiT, j, i);
+		}
+		for (j=n; j<p1; j++) {
+		    x = gretl_matrix_get(YY, s, n + j);
+		    dy += x * gretl_matrix_get(jb->PiT, j, i);
+		}
+	    }
+	    for (c=0; c<k; c++) {
+		x = gretl_matrix_get(ws->X, s, c);
+		dy += x * gretl_matrix_get(jb->G, c, i);
+	    }
+	    ynew[i] = ylag[i] + dy;
+	    gretl_matrix_set(ws->YY, s, i, dy);
+	    gretl_matrix_set(ws->YY, s, n + i, ylag[i]);
+	}
+    }
+}
+
+/* compute the test statistic for replication @iter, or NADBL on
+   failure */
+
+static double jboot_statistic (const jboot *jb, jboot_ws *ws, int iter)
+{
+    int T = jb->T, n = jb->n;
+    double x = NADBL;
+    int i, err = 0;
+
+    jboot_generate(jb, ws, jb->S + iter * T);
+
+    /* stage 1: concentrate out the short-run dynamics */
+    if (jb->k > 0) {
+	err = gretl_matrix_multi_SVD_ols(ws->YY, ws->X, ws->BB,
+					 ws->RR, NULL);
+	if (!err) {
+	    memcpy(ws->R0->val, ws->RR->val, T * n * sizeof(double));
+	    memcpy(ws->R1->val, ws->RR->val + T * n,
+		   T * jb->p1 * sizeof(double));
+	}
+    } else {
+	memcpy(ws->R0->val, ws->YY->val, T * n * sizeof(double));
+	memcpy(ws->R1->val, ws->YY->val + T * n,
+	       T * jb->p1 * sizeof(double));
+    }
+
+    if (err) {
+	return NADBL;
+    }
+
+    if (jb->job == JB_TRACE) {
+	err = gretl_matrix_SVD_johansen_solve(ws->R0, ws->R1, ws->ev0,
+					      NULL, NULL, 0);
+	if (!err) {
+	    x = 0.0;
+	    for (i=jb->r; i<n; i++) {
+		x -= T * log(1.0 - ws->ev0->val[i]);
+	    }
+	}
+    } else {
+	err = gretl_matrix_SVD_johansen_solve(ws->R0, ws->R1, ws->ev0,
+					      NULL, NULL, jb->r);
+	if (!err) {
+	    err = gretl_matrix_multiply(ws->R1, jb->H, ws->R1H);
+	}
+	if (!err) {
+	    err = gretl_matrix_SVD_johansen_solve(ws->R0, ws->R1H, ws->ev1,
+						  NULL, NULL, jb->r);
+	}
+	if (!err) {
+	    x = 0.0;
+	    for (i=0; i<jb->r; i++) {
+		x += T * (log(1.0 - ws->ev1->val[i]) -
+			  log(1.0 - ws->ev0->val[i]));
+	    }
+	}
+    }
+
+    return (err || !isfinite(x))? NADBL : x;
+}
+
+static int jboot_n_threads (const jboot *jb)
+{
+    int nt = 1;
+
+    /* note: on OS X the LAPACK workspace in gretl_matrix.c is
+       not thread-local */
+#if defined(_OPENMP) && !defined(OS_OSX)
+    if (jb->B > 1 &&
+	libset_use_openmp((guint64) jb->B * jb->T * (jb->n + jb->p1) *
+			  (jb->k + jb->p1))) {
+	nt = get_omp_n_threads();
+	if (nt > jb->B) {
+	    nt = jb->B;
+	}
+    }
+#endif
+
+    return nt;
+}
+
+/* Run the bootstrap under the null currently set in @jb, and write
+   into @pv the proportion of the replications in which the test
+   statistic is at least as large as @test.
+*/
+
+static int jboot_pvalue (jboot *jb, double test, double *pv)
+{
+    jboot_ws **ws = NULL;
+    double *stat = NULL;
+    int nT = jb->B * jb->T;
+    int nt = jboot_n_threads(jb);
+    int blas_nt = 0;
+    int i, iter, nok, nx;
+    int err = 0;
+
+    for (i=0; i<nT; i++) {
+	jb->S[i] = gretl_rand_int_max(jb->T);
+    }
+
+    stat = malloc(jb->B * sizeof *stat);
+    ws = calloc(nt, sizeof *ws);
+
+    if (stat == NULL || ws == NULL) {
+	err = E_ALLOC;
+	goto bailout;
+    }
+
+    for (i=0; i<nt && !err; i++) {
+	ws[i] = jboot_ws_new(jb);
+	if (ws[i] == NULL) {
+	    err = E_ALLOC;
+	}
+    }
+
+    if (err) {
+	goto bailout;
+    }
+
+    /* don't oversubscribe the cores via threaded BLAS */
+    if (nt > 1 && blas_is_openblas()) {
+	blas_nt = blas_get_num_threads();
+	if (blas_nt > 1) {
+	    blas_set_num_threads(1);
+	}
+    }
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nt) private(i) schedule(dynamic)
+#endif
+    for (iter=0; iter<jb->B; iter++) {
+	i = 0;
+#if defined(_OPENMP)
+	i = omp_get_thread_num();
+#endif
+	stat[iter] = jboot_statistic(jb, ws[i], iter);
+    }
+
+    if (blas_nt > 1) {
+	blas_set_num_threads(blas_nt);
+    }
+
+    nok = nx = 0;
+    for (iter=0; iter<jb->B; iter++) {
+	if (!na(stat[iter])) {
+	    nok++;
+	    if (stat[iter] >= test) {
+		nx++;
+	    }
+	}
+    }
+
+#if JBDEBUG
+    fprintf(stderr, "jboot_pvalue: r=%d, test=%g, B=%d, nok=%d, nx=%d\n",
+	    jb->r, test, jb->B, nok, nx);
+#endif
+
+    if (nok == 0) {
+	err = E_NOCONV;
+    } else {
+	*pv = nx / (double) nok;
+    }
+
+ bailout:
+
+    if (ws != NULL) {
+	for (i=0; i<nt; i++) {
+	    jboot_ws_free(ws[i]);
+	}
+    }
+    free(ws);
+    free(stat);
+
+    return err;
+}
+
+/* Bootstrap p-values for the sequence of trace tests: for each
+   rank r = 0, ..., n-1 the artificial data are generated under
+   H(r), using the first r columns of the unrestricted beta. The
+   trace statistics are in the first column of @tests, and the
+   p-values are written into @pv. On success @B receives the
+   number of replications.
+*/
+
+int johansen_boot_trace (const GRETL_VAR *jvar,
+			 const DATASET *dset,
+			 const gretl_matrix *tests,
+			 double *pv, int *B)
+{
+    const gretl_matrix *Beta = jvar->jinfo->Beta;
+    gretl_matrix *br = NULL;
+    jboot *jb;
+    int n = jvar->neqns;
+    int r, err = 0;
+
+    jb = jboot_new(jvar, dset, JB_TRACE, &err);
+    if (err) {
+	return err;
+    }
+
+    br = gretl_matrix_alloc(Beta->rows, n);
+    if (br == NULL) {
+	err = E_ALLOC;
+    }
+
+    for (r=0; r<n && !err; r++) {
+	if (r > 0) {
+	    gretl_matrix_reuse(br, -1, r);
+	    memcpy(br->val, Beta->val, Beta->rows * r * sizeof(double));
+	}
+	err = jboot_H0(jb, (r > 0)? br : NULL);
+	if (!err) {
+	    err = jboot_pvalue(jb, gretl_matrix_get(tests, r, 0), &pv[r]);
+	}
+    }
+
+    if (!err) {
+	*B = jb->B;
+    }
+
+    gretl_matrix_free(br);
+    jboot_destroy(jb);
+
+    return err;
+}
+
+/* Bootstrap p-value for the LR test of the homogeneous restriction
+   beta = H * phi, with @M holding the restricted eigenvectors (so
+   that the restricted estimate of beta is H * M) and @LR the
+   observed test statistic.
+*/
+
+int johansen_boot_beta_test (const GRETL_VAR *jvar,
+			     const DATASET *dset,
+			     const gretl_matrix *H,
+			     const gretl_matrix *M,
+			     double LR, double *pv,
+			     int *B)
+{
+    gretl_matrix *beta;
+    jboot *jb;
+    int r = jrank(jvar);
+    int err = 0;
+
+    beta = gretl_matrix_multiply_new(H, M, &err);
+    if (err) {
+	return err;
+    }
+
+    if (beta->cols > r) {
+	gretl_matrix_reuse(beta, -1, r);
+    }
+
+    jb = jboot_new(jvar, dset, JB_BETA, &err);
+
+    if (!err) {
+	jb->H = H;
+	err = jboot_H0(jb, beta);
+    }
+
+    if (!err) {
+	err = jboot_pvalue(jb, LR, pv);
+    }
+
+    if (!err) {
+	*B = jb->B;
+    }
+
+    gretl_matrix_free(beta);
+    jboot_destroy(jb);
+
+    return err;
+}
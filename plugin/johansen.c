@@ -1550,9 +1550,11 @@ compute_coint_test (GRETL_VAR *jvar, const DATASET *dset,
     int n = jvar->neqns;
     int nexo = 0, nrexo = 0;
     int partial = 0;
+    double *bpv = NULL;
     double llc, trace, lmax;
     double cumeig = 0.0;
-    int jcase, i;
+    int jcase, i, B = 0;
+    int err = 0;
 
     tests = gretl_matrix_alloc(n, 2);
     pvals = gretl_matrix_alloc(n, 2);
@@ -1571,6 +1573,21 @@ compute_coint_test (GRETL_VAR *jvar, const DATASET *dset,
 	gretl_matrix_set(tests, i, 1, lmax);
     }
 
+    if (opt & OPT_B) {
+	bpv = malloc(n * sizeof *bpv);
+	if (bpv == NULL) {
+	    err = E_ALLOC;
+	} else {
+	    err = johansen_boot_trace(jvar, dset, tests, bpv, &B);
+	}
+	if (err) {
+	    gretl_matrix_free(tests);
+	    gretl_matrix_free(pvals);
+	    free(bpv);
+	    return err;
+	}
+    }
+
     if (jvar->xlist != NULL) {
 	nexo = jvar->xlist[0];
     }
@@ -1663,6 +1680,19 @@ compute_coint_test (GRETL_VAR *jvar, const DATASET *dset,
 	}
     }
 
+    if (bpv != NULL) {
+	pputc(prn, '\n');
+	pprintf(prn, _("Bootstrap p-values (%d replications)"), B);
+	pprintf(prn, "\n%s %s %s\n", _("Rank"), _("Trace test"),
+		_("p-value"));
+	for (i=0; i<n; i++) {
+	    trace = gretl_matrix_get(tests, i, 0);
+	    pprintf(prn, "%4d%#11.5g [%6.4f]\n", i, trace, bpv[i]);
+	    gretl_matrix_set(pvals, i, 0, bpv[i]);
+	}
+	free(bpv);
+    }
+
     pputc(prn, '\n');
 
     if (nexo > 0 || nrexo > 0) {
@@ -1755,13 +1785,13 @@ int johansen_coint_test (GRETL_VAR *jvar, const DATASET *dset,
 	pputs(prn, _("Failed to find eigenvalues\n"));
     } else {
 	johansen_ll_calc(jvar, jvar->jinfo->evals);
-	compute_coint_test(jvar, dset, opt, prn);
+	err = compute_coint_test(jvar, dset, opt, prn);
+    }
 
-	if (!(opt & OPT_Q)) {
-	    print_beta_and_alpha(jvar, jvar->jinfo->evals, p,
-				 dset, prn);
-	    print_long_run_matrix(jvar, dset, prn);
-	}
+    if (!err && !(opt & OPT_Q)) {
+	print_beta_and_alpha(jvar, jvar->jinfo->evals, p,
+			     dset, prn);
+	print_long_run_matrix(jvar, dset, prn);
     }
 
     return err;
@@ -2556,6 +2586,41 @@ static int show_beta_alpha_etc (const GRETL_VAR *jvar,
     return err;
 }
 
+/* Bootstrap p-value for the test of a homogeneous restriction on
+   beta, with @evals and @M the restricted eigenvalues and vectors:
+   this replaces the asymptotic p-value in @rset.
+*/
+
+static int beta_test_bootstrap (const GRETL_VAR *jvar,
+				gretl_restriction *rset,
+				const gretl_matrix *H,
+				const gretl_matrix *M,
+				const gretl_matrix *evals,
+				const DATASET *dset,
+				PRN *prn)
+{
+    const gretl_matrix *ev0 = jvar->jinfo->evals;
+    double LR = 0.0, pv = NADBL;
+    int r = jrank(jvar);
+    int i, B = 0;
+    int err;
+
+    for (i=0; i<r; i++) {
+	LR += jvar->T * (log(1.0 - evals->val[i]) -
+			 log(1.0 - ev0->val[i]));
+    }
+
+    err = johansen_boot_beta_test(jvar, dset, H, M, LR, &pv, &B);
+
+    if (!err) {
+	pprintf(prn, _("Bootstrap p-value (%d replications) = %g\n"),
+		B, pv);
+	rset_set_pvalue(rset, pv);
+    }
+
+    return err;
+}
+
 /* test for a common, homogeneous restriction on beta (only) */
 
 static int vecm_beta_test (GRETL_VAR *jvar,
@@ -2630,6 +2695,10 @@ static int vecm_beta_test (GRETL_VAR *jvar,
 	    gretl_matrix_print_to_prn(M, "M", prn);
 	}
 	johansen_LR_calc(jvar, evals, H, rset, V_BETA, prn);
+	if (opt & OPT_B) {
+	    err = beta_test_bootstrap(jvar, rset, H, M, evals,
+				      dset, prn);
+	}
     }
 
     if (!err && verbose) {
@@ -2652,7 +2721,9 @@ static int vecm_beta_test (GRETL_VAR *jvar,
    VECM.  If the restrictions are "simple" (homogeneous and in common)
    we do the test using the eigen-system approach.  If they are
    "general" restrictions we hand off to the specialized machinery in
-   jrestrict.c.
+   jrestrict.c. Bootstrapping (OPT_B) is supported only for simple
+   restrictions on beta, in the absence of a prior restriction, and
+   only by resampling the residuals.
 */
 
 int vecm_test_restriction (GRETL_VAR *jvar,
@@ -2666,6 +2737,23 @@ int vecm_test_restriction (GRETL_VAR *jvar,
     PRN *vprn;
     int err = 0;
 
+    if ((opt & OPT_B) && (jvar->jinfo->lrdf > 0 ||
+			  !simple_beta_restriction(jvar, rset))) {
+	pputs(prn, "Sorry, the bootstrap option is not supported for this test");
+	pputc(prn, '\n');
+	return E_NOTIMP;
+    }
+
+    if (opt & OPT_B) {
+	const char *s = get_optval_string(RESTRICT, OPT_B);
+
+	if (s != NULL && strcmp(s, "residuals")) {
+	    gretl_errmsg_sprintf(_("VECM: the bootstrap method '%s' is "
+				   "not supported"), s);
+	    return E_BADOPT;
+	}
+    }
+
     B0 = gretl_matrix_copy(jvar->jinfo->Beta);
     A0 = gretl_matrix_copy(jvar->jinfo->Alpha);
 
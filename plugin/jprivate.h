@@ -32,6 +32,18 @@ johansen_LR_calc (const GRETL_VAR *jvar, const gretl_matrix *evals,
 		  const gretl_matrix *H, gretl_restriction *rset,
 		  int job, PRN *prn);
 
+int johansen_boot_trace (const GRETL_VAR *jvar,
+			 const DATASET *dset,
+			 const gretl_matrix *tests,
+			 double *pv, int *B);
+
+int johansen_boot_beta_test (const GRETL_VAR *jvar,
+			     const DATASET *dset,
+			     const gretl_matrix *H,
+			     const gretl_matrix *M,
+			     double LR, double *pv,
+			     int *B);
+
 void print_beta_alpha_Pi (const GRETL_VAR *jvar,
 			  const DATASET *dset,
 			  PRN *prn);
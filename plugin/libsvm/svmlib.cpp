@@ -2072,7 +2072,7 @@ static double svm_svr_probability(const svm_problem *prob,
 
     svm_parameter newparam = *param;
     newparam.probability = 0;
-    svm_cross_validation(prob, &newparam, nr_fold, ymv);
+    svm_cross_validation(prob, &newparam, nr_fold, ymv, 1);
     for (i=0; i<prob->l; i++) {
 	ymv[i]=prob->y[i]-ymv[i];
 	mae += fabs(ymv[i]);
@@ -2441,11 +2441,55 @@ svm_model *svm_train(const svm_problem *prob, const svm_parameter *param)
     return model;
 }
 
+// Train on the complement of a single cross-validation fold and
+// predict the observations in the fold
+
+static void xval_fold(const svm_problem *prob, const svm_parameter *param,
+		      const int *perm, int begin, int end, double *target)
+{
+    int l = prob->l;
+    int j, k;
+    struct svm_problem subprob;
+
+    subprob.l = l - (end-begin);
+    subprob.x = Malloc(struct svm_node*, subprob.l);
+    subprob.y = Malloc(double, subprob.l);
+
+    k = 0;
+    for (j=0; j<begin; j++) {
+	subprob.x[k] = prob->x[perm[j]];
+	subprob.y[k] = prob->y[perm[j]];
+	++k;
+    }
+    for (j=end; j<l; j++) {
+	subprob.x[k] = prob->x[perm[j]];
+	subprob.y[k] = prob->y[perm[j]];
+	++k;
+    }
+    struct svm_model *submodel = svm_train(&subprob, param);
+    if (param->probability &&
+	(param->svm_type == C_SVC || param->svm_type == NU_SVC)) {
+	double *prob_estimates = Malloc(double, svm_get_nr_class(submodel));
+	for (j=begin; j<end; j++)
+	    target[perm[j]] = svm_predict_probability(submodel, prob->x[perm[j]],
+						      prob_estimates);
+	free(prob_estimates);
+    } else {
+	for (j=begin; j<end; j++) {
+	    target[perm[j]] = svm_predict(submodel, prob->x[perm[j]]);
+	}
+    }
+    svm_free_and_destroy_model(&submodel);
+    free(subprob.x);
+    free(subprob.y);
+}
+
 // Stratified cross validation
 
 void svm_cross_validation (const svm_problem *prob,
 			   const svm_parameter *param,
-			   int nr_fold, double *target)
+			   int nr_fold, double *target,
+			   int nthreads)
 {
     int i;
     int *fold_start;
@@ -2518,44 +2562,24 @@ void svm_cross_validation (const svm_problem *prob,
 	}
     }
 
-    for (i=0; i<nr_fold; i++) {
-	int begin = fold_start[i];
-	int end = fold_start[i+1];
-	int j, k;
-	struct svm_problem subprob;
-
-	subprob.l = l - (end-begin);
-	subprob.x = Malloc(struct svm_node*, subprob.l);
-	subprob.y = Malloc(double, subprob.l);
-
-	k = 0;
-	for (j=0; j<begin; j++) {
-	    subprob.x[k] = prob->x[perm[j]];
-	    subprob.y[k] = prob->y[perm[j]];
-	    ++k;
-	}
-	for (j=end; j<l; j++) {
-	    subprob.x[k] = prob->x[perm[j]];
-	    subprob.y[k] = prob->y[perm[j]];
-	    ++k;
-	}
-	struct svm_model *submodel = svm_train(&subprob, param);
-	if (param->probability &&
-	    (param->svm_type == C_SVC || param->svm_type == NU_SVC)) {
-	    double *prob_estimates = Malloc(double, svm_get_nr_class(submodel));
-	    for (j=begin; j<end; j++)
-		target[perm[j]] = svm_predict_probability(submodel, prob->x[perm[j]],
-							  prob_estimates);
-	    free(prob_estimates);
-	} else {
-	    for (j=begin; j<end; j++) {
-		target[perm[j]] = svm_predict(submodel, prob->x[perm[j]]);
-	    }
-	}
-	svm_free_and_destroy_model(&submodel);
-	free(subprob.x);
-	free(subprob.y);
-    }
+#if defined(_OPENMP)
+    if (nthreads > nr_fold)
+	nthreads = nr_fold;
+    if (nthreads > 1 && !param->probability) {
+	// Train the folds concurrently. Probability estimation is
+	// excluded since it draws on the (shared) random generator.
+	// The kernel-cache budget is divided among the threads.
+	svm_parameter fparam = *param;
+
+	fparam.cache_size /= nthreads;
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic, 1)
+	for (i=0; i<nr_fold; i++)
+	    xval_fold(prob, &fparam, perm, fold_start[i], fold_start[i+1],
+		      target);
+    } else
+#endif
+    for (i=0; i<nr_fold; i++)
+	xval_fold(prob, param, perm, fold_start[i], fold_start[i+1], target);
 
     free(fold_start);
     free(perm);
@@ -2601,8 +2625,11 @@ double svm_get_svr_probability(const svm_model *model)
     }
 }
 
-double svm_predict_values(const svm_model *model, const svm_node *x,
-			  double *dec_values)
+// Compute the decision value(s) for an observation, given its kernel
+// values against each of the model's support vectors
+
+static double kvalue_decision(const svm_model *model, const double *kvalue,
+			      double *dec_values)
 {
     int i;
 
@@ -2613,11 +2640,8 @@ double svm_predict_values(const svm_model *model, const svm_node *x,
 	double *sv_coef = model->sv_coef[0];
 	double sum = 0;
 
-#if defined(_OPENMP)
-#pragma omp parallel for private(i) reduction(+:sum) schedule(guided)
-#endif
 	for (i=0; i<model->l; i++)
-	    sum += sv_coef[i] * Kernel::k_function(x, model->SV[i], model->param);
+	    sum += sv_coef[i] * kvalue[i];
 	sum -= model->rho[0];
 	*dec_values = sum;
 
@@ -2627,14 +2651,6 @@ double svm_predict_values(const svm_model *model, const svm_node *x,
 	    return sum;
     } else {
 	int nr_class = model->nr_class;
-	int l = model->l;
-
-	double *kvalue = Malloc(double, l);
-#if defined(_OPENMP)
-#pragma omp parallel for private(i) schedule(guided)
-#endif
-	for (i=0; i<l; i++)
-	    kvalue[i] = Kernel::k_function(x, model->SV[i], model->param);
 
 	int *start = Malloc(int, nr_class);
 	start[0] = 0;
@@ -2676,47 +2692,259 @@ double svm_predict_values(const svm_model *model, const svm_node *x,
 	    if (vote[i] > vote[vote_max_idx])
 		vote_max_idx = i;
 
-	free(kvalue);
 	free(start);
 	free(vote);
 	return model->label[vote_max_idx];
     }
 }
 
-double svm_predict(const svm_model *model, const svm_node *x)
+double svm_predict_values(const svm_model *model, const svm_node *x,
+			  double *dec_values)
 {
-    int nr_class = model->nr_class;
-    double *dec_values;
+    int i;
 
+    if (model->param.svm_type == ONE_CLASS ||
+	model->param.svm_type == EPSILON_SVR ||
+	model->param.svm_type == NU_SVR ||
+	model->param.svm_type == C_RNK) {
+	double *sv_coef = model->sv_coef[0];
+	double sum = 0;
+
+#if defined(_OPENMP)
+#pragma omp parallel for private(i) reduction(+:sum) schedule(guided)
+#endif
+	for (i=0; i<model->l; i++)
+	    sum += sv_coef[i] * Kernel::k_function(x, model->SV[i], model->param);
+	sum -= model->rho[0];
+	*dec_values = sum;
+
+	if (model->param.svm_type == ONE_CLASS)
+	    return (sum > 0)? 1 : -1;
+	else
+	    return sum;
+    } else {
+	int l = model->l;
+	double ret;
+
+	double *kvalue = Malloc(double, l);
+#if defined(_OPENMP)
+#pragma omp parallel for private(i) schedule(guided)
+#endif
+	for (i=0; i<l; i++)
+	    kvalue[i] = Kernel::k_function(x, model->SV[i], model->param);
+
+	ret = kvalue_decision(model, kvalue, dec_values);
+	free(kvalue);
+	return ret;
+    }
+}
+
+// Map a C_RNK decision value onto a rank
+
+static double rnk_result(const svm_model *model, double pred_result)
+{
+    // AC: Is this code (and its placement) OK??
+    for (int j=1; j<model->nr_class; j++) {
+	if (pred_result < model->rho[j]) {
+	    return j;
+	}
+    }
+    return model->nr_class;
+}
+
+static int n_dec_values(const svm_model *model)
+{
     if (model->param.svm_type == ONE_CLASS ||
 	model->param.svm_type == EPSILON_SVR ||
 	model->param.svm_type == NU_SVR ||
 	model->param.svm_type == C_RNK)
-	dec_values = Malloc(double, 1);
+	return 1;
     else
-	dec_values = Malloc(double, nr_class*(nr_class-1)/2);
+	return model->nr_class*(model->nr_class-1)/2;
+}
 
+double svm_predict(const svm_model *model, const svm_node *x)
+{
+    double *dec_values = Malloc(double, n_dec_values(model));
     double pred_result = svm_predict_values(model, x, dec_values);
 
     if (model->param.svm_type == C_RNK) {
-	// AC: Is this code (and its placement) OK??
-	int found = 0;
+	pred_result = rnk_result(model, pred_result);
+    }
 
-	for (int j=1; j<model->nr_class; j++) {
-	    if (pred_result < model->rho[j]) {
-		pred_result = j;
-		found = 1;
-		break;
-	    }
+    free(dec_values);
+
+    return pred_result;
+}
+
+// Batch prediction. Provided the support vectors are not too sparse
+// we unpack them into a contiguous row-major array, so that each
+// kernel evaluation becomes a simple (vectorizable) loop over doubles
+// rather than a merge of two sparse index lists; the observations to
+// be scored are then shared out among @nthreads threads.
+
+#define DENSE_SV_MAX (1 << 25)
+
+static double *dense_sv_array(const svm_model *model, int *pdim)
+{
+    double nnz = 0;
+    int dim = 0;
+    int i;
+
+    for (i=0; i<model->l; i++) {
+	for (const svm_node *p = model->SV[i]; p->index != -1; p++) {
+	    if (p->index < 1)
+		return NULL;
+	    if (p->index > dim)
+		dim = p->index;
+	    nnz += 1;
 	}
-	if (!found) {
-	    pred_result = model->nr_class;
+    }
+
+    if (dim == 0 || (double) model->l * dim > DENSE_SV_MAX ||
+	2 * nnz < (double) model->l * dim) {
+	// empty, too big, or too sparse to be worth it
+	return NULL;
+    }
+
+    double *v = (double *) calloc((size_t) model->l * dim, sizeof(double));
+
+    if (v != NULL) {
+	for (i=0; i<model->l; i++) {
+	    double *vi = v + (size_t) i * dim;
+	    for (const svm_node *p = model->SV[i]; p->index != -1; p++)
+		vi[p->index - 1] = p->value;
 	}
+	*pdim = dim;
     }
 
-    free(dec_values);
+    return v;
+}
 
-    return pred_result;
+// Dense counterpart to Kernel::k_function: @xsq and @xabs hold the
+// squared and absolute contributions from any elements of x whose
+// index exceeds @dim (and which therefore meet only zeros in sv)
+
+static double dense_k_function(const double *x, const double *sv, int dim,
+			       double xsq, double xabs,
+			       const svm_parameter &param)
+{
+    double s = 0;
+    int j;
+
+    switch(param.kernel_type) {
+    case LINEAR:
+    case POLY:
+    case SIGMOID:
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd reduction(+:s)
+#endif
+	for (j=0; j<dim; j++)
+	    s += x[j] * sv[j];
+	break;
+    case STUMP:
+    case LAPLACE:
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd reduction(+:s)
+#endif
+	for (j=0; j<dim; j++)
+	    s += fabs(x[j] - sv[j]);
+	s += xabs;
+	break;
+    default:
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd reduction(+:s)
+#endif
+	for (j=0; j<dim; j++) {
+	    double d = x[j] - sv[j];
+	    s += d * d;
+	}
+	s += xsq;
+	break;
+    }
+
+    switch(param.kernel_type) {
+    case LINEAR:
+	return s;
+    case POLY:
+	return powi(param.gamma*s+param.coef0, param.degree);
+    case RBF:
+	return exp(-param.gamma*s);
+    case SIGMOID:
+	return tanh(param.gamma*s+param.coef0);
+    case STUMP:
+	return -s + param.coef0;
+    case PERC:
+	return -sqrt(s) + param.coef0;
+    case LAPLACE:
+	return exp(-param.gamma*s);
+    case EXPO:
+	return exp(-param.gamma*sqrt(s));
+    default:
+	return 0;  // Unreachable
+    }
+}
+
+void svm_predict_batch(const svm_model *model, svm_node **x, int n,
+		       double *target, int nthreads)
+{
+    double *SVd = NULL;
+    int dim = 0;
+    int i;
+
+    if (nthreads < 1)
+	nthreads = 1;
+
+    SVd = dense_sv_array(model, &dim);
+
+    if (SVd == NULL) {
+	// sparse evaluation, parallel over observations
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) schedule(static)
+#endif
+	for (i=0; i<n; i++)
+	    target[i] = svm_predict(model, x[i]);
+	return;
+    }
+
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1) private(i)
+#endif
+    {
+	double *xd = Malloc(double, dim);
+	double *kvalue = Malloc(double, model->l);
+	double *dec_values = Malloc(double, n_dec_values(model));
+	int k;
+
+#if defined(_OPENMP)
+#pragma omp for schedule(static)
+#endif
+	for (i=0; i<n; i++) {
+	    double xsq = 0, xabs = 0;
+
+	    memset(xd, 0, dim * sizeof(double));
+	    for (const svm_node *p = x[i]; p->index != -1; p++) {
+		if (p->index >= 1 && p->index <= dim) {
+		    xd[p->index - 1] = p->value;
+		} else {
+		    xsq += p->value * p->value;
+		    xabs += fabs(p->value);
+		}
+	    }
+	    for (k=0; k<model->l; k++)
+		kvalue[k] = dense_k_function(xd, SVd + (size_t) k * dim, dim,
+					     xsq, xabs, model->param);
+	    target[i] = kvalue_decision(model, kvalue, dec_values);
+	    if (model->param.svm_type == C_RNK)
+		target[i] = rnk_result(model, target[i]);
+	}
+
+	free(xd);
+	free(kvalue);
+	free(dec_values);
+    }
+
+    free(SVd);
 }
 
 double svm_predict_probability(const svm_model *model, const svm_node *x,
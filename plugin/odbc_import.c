@@ -225,145 +225,280 @@ static double strval_to_double (const char *s, int r, int c, int *err)
     }
 }
 
-static int odbc_read_rows (ODBC_info *odinfo, SQLHSTMT stmt,
-			   int totcols, SQLLEN *colbytes, 
-			   long *grabint, double *grabx, 
-			   char **grabstr, double *xt, 
-			   int *nrows, int *obsgot,
-			   char **strvals)
+#define ODBC_STRSZ 16
+#define ODBC_BLOCKSIZE 4096
+
+/* Buffers for fetching a block of rows per call to SQLFetch,
+   using column-wise binding: for each column we have an array
+   of @nr elements of size width[i], plus an array of @nr
+   length/indicator values.
+*/
+
+typedef struct {
+    int nc;               /* number of columns */
+    int nr;               /* rows per block */
+    SQLSMALLINT *ctype;   /* C type bound to each column */
+    SQLLEN *width;        /* element size for each column */
+    char **buf;           /* data buffers */
+    SQLLEN **ind;         /* length/indicator buffers */
+    SQLUSMALLINT *status; /* row status array */
+    SQLULEN nfetched;     /* number of rows in current block */
+} odbc_block;
+
+static void odbc_block_free (odbc_block *b)
+{
+    int i;
+
+    if (b == NULL) {
+	return;
+    }
+
+    if (b->buf != NULL) {
+	for (i=0; i<b->nc; i++) {
+	    free(b->buf[i]);
+	    free(b->ind[i]);
+	}
+    }
+
+    free(b->ctype);
+    free(b->width);
+    free(b->buf);
+    free(b->ind);
+    free(b->status);
+    free(b);
+}
+
+static odbc_block *odbc_block_new (int nc, int nr, int *err)
+{
+    odbc_block *b = calloc(1, sizeof *b);
+
+    if (b == NULL) {
+	*err = E_ALLOC;
+	return NULL;
+    }
+
+    b->nc = nc;
+    b->nr = nr;
+    b->ctype = calloc(nc, sizeof *b->ctype);
+    b->width = calloc(nc, sizeof *b->width);
+    b->buf = calloc(nc, sizeof *b->buf);
+    b->ind = calloc(nc, sizeof *b->ind);
+    b->status = malloc(nr * sizeof *b->status);
+
+    if (b->ctype == NULL || b->width == NULL || b->buf == NULL ||
+	b->ind == NULL || b->status == NULL) {
+	odbc_block_free(b);
+	*err = E_ALLOC;
+	b = NULL;
+    }
+
+    return b;
+}
+
+/* bind column @i (0-based) of the result set to an array of
+   @b->nr elements of C type @ctype, each of size @width */
+
+static int odbc_block_bind (odbc_block *b, SQLHSTMT stmt, int i,
+			    SQLSMALLINT ctype, SQLLEN width)
 {
-    char obsbit[OBSLEN];
     SQLRETURN ret;
-    int i, j, k, p, v;
-    int t = 0, err = 0;
 
-    ret = SQLFetch(stmt);  
+    b->ctype[i] = ctype;
+    b->width[i] = width;
+    b->buf[i] = calloc(b->nr, width);
+    b->ind[i] = malloc(b->nr * sizeof(SQLLEN));
 
-    while (ret == SQL_SUCCESS && !err) {
-	j = k = p = v = 0;
-	fprintf(stderr, "SQLFetch, row %d bytes: ", t);
+    if (b->buf[i] == NULL || b->ind[i] == NULL) {
+	return E_ALLOC;
+    }
 
-	for (i=0; i<totcols && !err; i++) {
-	    if (i < odinfo->obscols) {
-		/* looking for obs identifier chunk(s) */
-		*obsbit = '\0';
-		if (colbytes[i] == SQL_NULL_DATA) {
-		    fprintf(stderr, " obs col %d: null data\n", i+1);
-		    continue; /* error? */
-		}
-		/* got a chunk */
-		fprintf(stderr, " col %d: %d bytes\n", i+1, (int) colbytes[i]);
-		if (odinfo->coltypes[i] == GRETL_TYPE_INT) {
-		    sprintf(obsbit, odinfo->fmts[i], (int) grabint[j++]);
-		} else if (odinfo->coltypes[i] == GRETL_TYPE_STRING ||
-			   odinfo->coltypes[i] == GRETL_TYPE_DATE) {
-		    sprintf(obsbit, odinfo->fmts[i], grabstr[k++]);
-		} else if (odinfo->coltypes[i] == GRETL_TYPE_DOUBLE) {
-		    sprintf(obsbit, odinfo->fmts[i], grabx[p++]);
-		}
-		if (odinfo->S != NULL && *obsbit != '\0') {
-		    if (strlen(odinfo->S[t]) + strlen(obsbit) > OBSLEN - 1) {
-			fprintf(stderr, "Overflow in observation string!\n");
-		    } else {
-			strcat(odinfo->S[t], obsbit);
-		    }
-		}
-	    } else {
-		if (i == odinfo->obscols && odinfo->S != NULL) {
-		    /* finished composing obs string, report it */
-		    fprintf(stderr, " obs = '%s'\n", odinfo->S[t]);
-		}
-		/* now looking for actual data */
-		if (colbytes[i] == SQL_NULL_DATA) {
-		    fprintf(stderr, " data col %d: no data\n", v+1);
-		    odinfo->X[v][t] = NADBL;
-		} else if (strvals != NULL && strvals[v] != NULL) {
-		    odinfo->X[v][t] = strval_to_double(strvals[v], t+1, v+1, &err);
-		} else {
-		    odinfo->X[v][t] = xt[v];
-		}
-		v++;
-	    }
-	    fprintf(stderr, "%d ", (int) colbytes[i]);
-	}
+    ret = SQLBindCol(stmt, i+1, ctype, b->buf[i], width, b->ind[i]);
+    if (OD_error(ret)) {
+	gretl_errmsg_set("Error in SQLBindCol");
+	return E_DATA;
+    }
 
-	fputc('\n', stderr);
+    return 0;
+}
 
-	t++;
+/* Ask the driver to deliver up to ODBC_BLOCKSIZE rows per fetch;
+   return the number it's actually willing to supply.
+*/
 
-	/* try getting next row */
-	ret = SQLFetch(stmt);
-	if (ret == SQL_SUCCESS && t >= *nrows) {
-	    err = expand_catchment(odinfo, nrows);
+static int odbc_set_block_size (SQLHSTMT stmt)
+{
+    SQLULEN nr = ODBC_BLOCKSIZE;
+    SQLRETURN ret;
+
+    SQLSetStmtAttr(stmt, SQL_ATTR_ROW_BIND_TYPE,
+		   (SQLPOINTER) SQL_BIND_BY_COLUMN, 0);
+    ret = SQLSetStmtAttr(stmt, SQL_ATTR_ROW_ARRAY_SIZE,
+			 (SQLPOINTER) nr, 0);
+    if (OD_error(ret)) {
+	nr = 1;
+    } else if (ret == SQL_SUCCESS_WITH_INFO) {
+	/* the driver may have substituted a smaller value */
+	if (OD_error(SQLGetStmtAttr(stmt, SQL_ATTR_ROW_ARRAY_SIZE,
+				    &nr, 0, NULL)) || nr < 1) {
+	    nr = 1;
 	}
     }
 
-    if (ret != SQL_SUCCESS && ret != SQL_NO_DATA && !err) {
-	err = E_DATA;
-    }
+    return (int) nr;
+}
 
-    *obsgot = t;
+static int odbc_block_set_status_ptrs (odbc_block *b, SQLHSTMT stmt)
+{
+    SQLRETURN ret;
 
-    return err;
+    ret = SQLSetStmtAttr(stmt, SQL_ATTR_ROWS_FETCHED_PTR,
+			 &b->nfetched, 0);
+    if (!OD_error(ret)) {
+	ret = SQLSetStmtAttr(stmt, SQL_ATTR_ROW_STATUS_PTR,
+			     b->status, 0);
+    }
+    if (OD_error(ret)) {
+	gretl_errmsg_set("Error in SQLSetStmtAttr");
+	return E_DATA;
+    }
+
+    return 0;
 }
 
-#define ODBC_STRSZ 16
+/* Compose the obs string for row @r of the current block and
+   append it to @S, working from the auxiliary columns.
+*/
 
-static char **allocate_string_grabbers (ODBC_info *odinfo, 
-					int *nstrs,
-					int *err)
+static void odbc_compose_obs (ODBC_info *odinfo, odbc_block *b,
+			      int r, char *S)
 {
-    char **G = NULL;
-    int i, n = 0;
+    char obsbit[OBSLEN];
+    char datestr[16];
+    int i;
 
     for (i=0; i<odinfo->obscols; i++) {
-	if (odinfo->coltypes[i] == GRETL_TYPE_STRING ||
-	    odinfo->coltypes[i] == GRETL_TYPE_DATE) {
-	    n++;
+	const char *src = b->buf[i] + r * b->width[i];
+
+	*obsbit = '\0';
+	if (b->ind[i][r] == SQL_NULL_DATA) {
+	    continue; /* error? */
 	}
-    }
+	if (odinfo->coltypes[i] == GRETL_TYPE_INT) {
+	    sprintf(obsbit, odinfo->fmts[i], (int) *(SQLINTEGER *) src);
+	} else if (odinfo->coltypes[i] == GRETL_TYPE_STRING) {
+	    sprintf(obsbit, odinfo->fmts[i], src);
+	} else if (odinfo->coltypes[i] == GRETL_TYPE_DATE) {
+	    const SQL_DATE_STRUCT *d = (const SQL_DATE_STRUCT *) src;
 
-    if (n > 0) {
-	G = strings_array_new_with_length(n, ODBC_STRSZ);
-	if (G == NULL) {
-	    *err = E_ALLOC;
-	} else {
-	    *nstrs = n;
+	    sprintf(datestr, "%04d-%02d-%02d", (int) d->year,
+		    (int) d->month, (int) d->day);
+	    sprintf(obsbit, odinfo->fmts[i], datestr);
+	} else if (odinfo->coltypes[i] == GRETL_TYPE_DOUBLE) {
+	    sprintf(obsbit, odinfo->fmts[i], *(double *) src);
+	}
+	if (*obsbit != '\0') {
+	    if (strlen(S) + strlen(obsbit) > OBSLEN - 1) {
+		fprintf(stderr, "Overflow in observation string!\n");
+	    } else {
+		strcat(S, obsbit);
+	    }
 	}
     }
-
-    return G;
 }
 
-/* Allocate a char *object of size @len to hold a
-   string value provided by ODBC. If the array to hold
-   such objects has not yet been allocated if must be
-   be created first.
+/* Transcribe the current block of rows into odinfo->X (and
+   odinfo->S if applicable), starting at row @t0, one column at
+   a time.
 */
 
-static char *get_bind_target (char ***pS, int len, int nv,
-			      int j, int *err)
+static int odbc_transcribe_block (ODBC_info *odinfo, odbc_block *b,
+				  int t0)
 {
-    char *ret = NULL;
-    
-    if (*pS == NULL) {
-	/* starting from scratch */
-	*pS = strings_array_new(nv);
-	if (*pS == NULL) {
-	    *err = E_ALLOC;
+    int n = (int) b->nfetched;
+    int i, r, v, err = 0;
+
+    for (r=0; r<n; r++) {
+	if (b->status[r] == SQL_ROW_ERROR) {
+	    gretl_errmsg_sprintf("ODBC: error fetching row %d", t0 + r + 1);
+	    return E_DATA;
+	}
+    }
+
+    if (odinfo->S != NULL) {
+	for (r=0; r<n; r++) {
+	    odbc_compose_obs(odinfo, b, r, odinfo->S[t0+r]);
 	}
     }
-    
-    if (*pS != NULL) {
-	(*pS)[j] = calloc(len + 1, 1);
-	if ((*pS)[j] == NULL) {
-	    *err = E_ALLOC;
+
+    for (v=0; v<odinfo->nvars && !err; v++) {
+	double *x = odinfo->X[v] + t0;
+	const SQLLEN *ind;
+
+	i = odinfo->obscols + v;
+	ind = b->ind[i];
+	if (b->ctype[i] == SQL_C_DOUBLE) {
+	    const double *src = (const double *) b->buf[i];
+
+	    for (r=0; r<n; r++) {
+		x[r] = (ind[r] == SQL_NULL_DATA)? NADBL : src[r];
+	    }
 	} else {
-	    ret = (*pS)[j];
+	    const char *src = b->buf[i];
+
+	    for (r=0; r<n && !err; r++) {
+		if (ind[r] == SQL_NULL_DATA) {
+		    x[r] = NADBL;
+		} else if (ind[r] == SQL_NO_TOTAL || ind[r] >= b->width[i]) {
+		    /* the value was truncated on fetching */
+		    gretl_errmsg_sprintf("ODBC: string too long in row %d, "
+					 "column %d", t0 + r + 1, v + 1);
+		    err = E_DATA;
+		} else {
+		    x[r] = strval_to_double(src + r * b->width[i],
+					    t0 + r + 1, v + 1, &err);
+		}
+	    }
 	}
     }
 
-    return ret;
+    return err;
+}
+
+static int odbc_read_rows (ODBC_info *odinfo, SQLHSTMT stmt,
+			   odbc_block *b, int *nrows, int *obsgot)
+{
+    SQLRETURN ret;
+    int t = 0, err = 0;
+
+    ret = SQLFetch(stmt);
+
+    /* note: SQL_SUCCESS_WITH_INFO may just signal truncation of
+       a string value, which is checked via the length indicators
+       in odbc_transcribe_block()
+    */
+    while (!OD_error(ret) && !err) {
+	int n = (int) b->nfetched;
+
+	while (t + n > *nrows && !err) {
+	    err = expand_catchment(odinfo, nrows);
+	}
+	if (!err) {
+	    err = odbc_transcribe_block(odinfo, b, t);
+	}
+	t += n;
+	if (!err) {
+	    /* try getting next block */
+	    ret = SQLFetch(stmt);
+	}
+    }
+
+    if (ret != SQL_NO_DATA && OD_error(ret) && !err) {
+	err = E_DATA;
+    }
+
+    *obsgot = t;
+
+    return err;
 }
 
 static const char *sql_datatype_name (SQLSMALLINT dt)
@@ -427,6 +562,10 @@ static SQLSMALLINT get_col_info (SQLHSTMT stmt, int colnum,
     return data_type;
 }
 
+/* maximum width for string-valued data columns, which we expect
+   to contain numeric values */
+#define ODBC_MAXSTR 256
+
 int gretl_odbc_get_data (ODBC_info *odinfo)
 {
     SQLHENV OD_env = NULL;    /* ODBC environment handle */
@@ -437,15 +576,10 @@ int gretl_odbc_get_data (ODBC_info *odinfo)
     unsigned char msg[512];
     SQLINTEGER OD_err;
     SQLSMALLINT mlen, ncols, dt;
-    double *xt = NULL;
-    SQLLEN *colbytes = NULL;
     SQLLEN sqlnrows;
-    long grabint[ODBC_OBSCOLS];
-    double grabx[ODBC_OBSCOLS];
-    char **grabstr = NULL;
-    char **strvals = NULL;
-    int totcols, nrows = 0, nstrs = 0;
-    int i, j, k, p;
+    odbc_block *block = NULL;
+    int totcols, nrows = 0;
+    int i, blocksize = 1;
     int T = 0, err = 0;
 
     odinfo->X = NULL;
@@ -456,29 +590,8 @@ int gretl_odbc_get_data (ODBC_info *odinfo)
        actual data columns */
     totcols = odinfo->obscols + odinfo->nvars;
 
-    xt = malloc(odinfo->nvars * sizeof *xt);
-    if (xt == NULL) {
-	return E_ALLOC;
-    }
-
-    colbytes = malloc(totcols * sizeof *colbytes);
-    if (colbytes == NULL) {
-	free(xt);
-	return E_ALLOC;
-    }  
-
-    grabstr = allocate_string_grabbers(odinfo, &nstrs, &err);
-    if (err) {
-	free(xt);
-	free(colbytes);
-	return err;
-    }
-
     dbc = gretl_odbc_connect_to_dsn(odinfo, &OD_env, &err);
     if (err) {
-	free(xt);
-	free(colbytes);
-	strings_array_free(grabstr, nstrs);
 	return err;
     }
 
@@ -493,25 +606,7 @@ int gretl_odbc_get_data (ODBC_info *odinfo)
 	goto bailout;
     }
 
-    j = k = p = 0;
-
-    /* bind auxiliary (obs) columns */
-    for (i=0; i<odinfo->obscols; i++) {
-	colbytes[i] = 0;
-	if (odinfo->coltypes[i] == GRETL_TYPE_INT) {
-	    SQLBindCol(stmt, i+1, SQL_C_LONG, &grabint[j++], 0, 
-		       &colbytes[i]);
-	} else if (odinfo->coltypes[i] == GRETL_TYPE_STRING) {
-	    SQLBindCol(stmt, i+1, SQL_C_CHAR, grabstr[k++], ODBC_STRSZ, 
-		       &colbytes[i]);
-	} else if (odinfo->coltypes[i] == GRETL_TYPE_DATE) {
-	    SQLBindCol(stmt, i+1, SQL_C_TYPE_DATE, grabstr[k++], 10, 
-		       &colbytes[i]);
-	} else if (odinfo->coltypes[i] == GRETL_TYPE_DOUBLE) {
-	    SQLBindCol(stmt, i+1, SQL_C_DOUBLE, &grabx[p++], sizeof(double), 
-		       &colbytes[i]);
-	}
-    }
+    blocksize = odbc_set_block_size(stmt);
 
     ret = SQLExecDirect(stmt, (SQLCHAR *) odinfo->query, SQL_NTS);   
     if (OD_error(ret)) {
@@ -542,30 +637,47 @@ int gretl_odbc_get_data (ODBC_info *odinfo)
 	err = E_DATA;
 	goto bailout;
     }
-    
+
+    block = odbc_block_new(totcols, blocksize, &err);
+    if (!err) {
+	err = odbc_block_set_status_ptrs(block, stmt);
+    }
+
     /* show and process column info */
     for (i=0; i<ncols && !err; i++) {
 	int len = 0;
 	
 	dt = get_col_info(stmt, i+1, &len, &err);
-	if (!err && i >= odinfo->obscols) {
+	if (err) {
+	    break;
+	} else if (i < odinfo->obscols) {
+	    /* bind auxiliary (obs) columns */
+	    if (odinfo->coltypes[i] == GRETL_TYPE_INT) {
+		err = odbc_block_bind(block, stmt, i, SQL_C_LONG,
+				      sizeof(SQLINTEGER));
+	    } else if (odinfo->coltypes[i] == GRETL_TYPE_STRING) {
+		err = odbc_block_bind(block, stmt, i, SQL_C_CHAR,
+				      ODBC_STRSZ);
+	    } else if (odinfo->coltypes[i] == GRETL_TYPE_DATE) {
+		err = odbc_block_bind(block, stmt, i, SQL_C_TYPE_DATE,
+				      sizeof(SQL_DATE_STRUCT));
+	    } else if (odinfo->coltypes[i] == GRETL_TYPE_DOUBLE) {
+		err = odbc_block_bind(block, stmt, i, SQL_C_DOUBLE,
+				      sizeof(double));
+	    }
+	} else if (IS_SQL_STRING_TYPE(dt)) {
 	    /* bind data columns */
-	    colbytes[i] = 0;
-	    j = i - odinfo->obscols;
-	    if (IS_SQL_STRING_TYPE(dt)) {
-		char *sval = get_bind_target(&strvals, len, odinfo->nvars, j, &err);
-
-		if (!err) {
-		    fprintf(stderr, " binding data col %d to strvals[%d] (len = %d)\n",
-			    i+1, j, len);
-		    SQLBindCol(stmt, i+1, SQL_C_CHAR, sval, len, &colbytes[i]);
-		}
-	    } else {
-		/* should be numerical data */
-		SQLBindCol(stmt, i+1, SQL_C_DOUBLE, &xt[j], sizeof(double), 
-			   &colbytes[i]);
+	    if (len <= 0 || len > ODBC_MAXSTR) {
+		len = ODBC_MAXSTR;
 	    }
-	}		
+	    fprintf(stderr, " binding data col %d as string (len = %d)\n",
+		    i+1, len);
+	    err = odbc_block_bind(block, stmt, i, SQL_C_CHAR, len + 1);
+	} else {
+	    /* should be numerical data */
+	    err = odbc_block_bind(block, stmt, i, SQL_C_DOUBLE,
+				  sizeof(double));
+	}
     }
 
     if (err) {
@@ -607,9 +719,7 @@ int gretl_odbc_get_data (ODBC_info *odinfo)
 
     if (!err) {
 	/* get the actual data */
-	err = odbc_read_rows(odinfo, stmt, totcols, colbytes,
-			     grabint, grabx, grabstr, xt, 
-			     &nrows, &T, strvals);
+	err = odbc_read_rows(odinfo, stmt, block, &nrows, &T);
     }
 
  bailout:
@@ -631,12 +741,7 @@ int gretl_odbc_get_data (ODBC_info *odinfo)
 	odinfo->nrows = T;
     }
 
-    free(xt);
-    free(colbytes);
-    strings_array_free(grabstr, nstrs);
-    if (strvals != NULL) {
-	strings_array_free(strvals, odinfo->nvars);
-    }
+    odbc_block_free(block);
 
     if (stmt != NULL) {
 	ret = SQLFreeHandle(SQL_HANDLE_STMT, stmt);
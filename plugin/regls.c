@@ -34,8 +34,13 @@
 
 #include "libgretl.h"
 #include "matrix_extra.h"
+#include "libset.h"
 #include "version.h"
 
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
 #ifdef HAVE_MPI
 # include "gretl_mpi.h"
 # include "gretl_foreign.h"
@@ -76,9 +81,22 @@ enum {
     LAMSCALE_FROB
 };
 
+/* Compressed sparse column representation of the design matrix,
+   for use with CCD when X is mostly zeros
+*/
+
+typedef struct csc_matrix_ {
+    int rows;    /* number of rows */
+    int cols;    /* number of columns */
+    int *p;      /* start of each column in @i and @x, plus end */
+    int *i;      /* row indices of the non-zero elements */
+    double *x;   /* values of the non-zero elements */
+} csc_matrix;
+
 typedef struct regls_info_ {
     gretl_bundle *b;
     gretl_matrix *X;
+    csc_matrix *S;
     gretl_matrix *y;
     gretl_matrix *lfrac;
     gretl_matrix *Xty;
@@ -93,6 +111,7 @@ typedef struct regls_info_ {
     gint8 xvalid;
     gint8 verbose;
     gint8 lamscale;
+    gint8 sparse;
 } regls_info;
 
 #ifdef HAVE_MPI
@@ -145,6 +164,232 @@ static void prepare_admm_params (regls_info *ri)
     admm_abstol *= sqrt(ri->X->cols);
 }
 
+/* Compressed sparse column support. The user supplies the non-zero
+   elements of X as a three-column matrix of triplets (row, column,
+   value), with 1-based indices; we convert this to CSC form, summing
+   any duplicate entries.
+*/
+
+static void csc_matrix_free (csc_matrix *S)
+{
+    if (S != NULL) {
+	free(S->p);
+	free(S->i);
+	free(S->x);
+	free(S);
+    }
+}
+
+static csc_matrix *csc_matrix_alloc (int rows, int cols, int nzmax)
+{
+    csc_matrix *S = malloc(sizeof *S);
+
+    if (S != NULL) {
+	S->rows = rows;
+	S->cols = cols;
+	S->p = calloc(cols + 1, sizeof *S->p);
+	S->i = malloc((nzmax > 0 ? nzmax : 1) * sizeof *S->i);
+	S->x = malloc((nzmax > 0 ? nzmax : 1) * sizeof *S->x);
+	if (S->p == NULL || S->i == NULL || S->x == NULL) {
+	    csc_matrix_free(S);
+	    S = NULL;
+	}
+    }
+
+    return S;
+}
+
+static int csc_nnz (const csc_matrix *S)
+{
+    return S->p[S->cols];
+}
+
+/* sum duplicated (row, column) entries and squeeze out zeros */
+
+static int csc_compact (csc_matrix *S)
+{
+    int *w = malloc(S->rows * sizeof *w);
+    int i, j, q, nz = 0;
+
+    if (w == NULL) {
+	return E_ALLOC;
+    }
+
+    for (i=0; i<S->rows; i++) {
+	w[i] = -1;
+    }
+
+    for (j=0; j<S->cols; j++) {
+	int start = nz;
+
+	for (q=S->p[j]; q<S->p[j+1]; q++) {
+	    i = S->i[q];
+	    if (w[i] >= start) {
+		S->x[w[i]] += S->x[q];
+	    } else {
+		w[i] = nz;
+		S->i[nz] = i;
+		S->x[nz++] = S->x[q];
+	    }
+	}
+	S->p[j] = start;
+    }
+    S->p[S->cols] = nz;
+
+    /* drop any entries that are exactly zero */
+    nz = 0;
+    for (j=0; j<S->cols; j++) {
+	q = S->p[j];
+	S->p[j] = nz;
+	for ( ; q<S->p[j+1]; q++) {
+	    if (S->x[q] != 0.0) {
+		S->i[nz] = S->i[q];
+		S->x[nz++] = S->x[q];
+	    }
+	}
+    }
+    S->p[S->cols] = nz;
+
+    free(w);
+
+    return 0;
+}
+
+static csc_matrix *csc_from_triplets (const gretl_matrix *T,
+				      int rows, int cols,
+				      int *err)
+{
+    csc_matrix *S = NULL;
+    int *cnt = NULL;
+    int nz = T->rows;
+    int i, j, q, t;
+
+    if (T->cols != 3) {
+	gretl_errmsg_set("regls: sparse X must be given as a matrix of "
+			 "triplets (row, column, value)");
+	*err = E_INVARG;
+	return NULL;
+    }
+
+    if (cols <= 0) {
+	/* infer the number of columns */
+	for (t=0; t<nz; t++) {
+	    j = (int) gretl_matrix_get(T, t, 1);
+	    if (j > cols) {
+		cols = j;
+	    }
+	}
+    }
+
+    for (t=0; t<nz && !*err; t++) {
+	i = (int) gretl_matrix_get(T, t, 0);
+	j = (int) gretl_matrix_get(T, t, 1);
+	if (i < 1 || i > rows || j < 1 || j > cols) {
+	    gretl_errmsg_sprintf("regls: sparse X: index (%d, %d) is "
+				 "out of bounds", i, j);
+	    *err = E_DATA;
+	}
+    }
+
+    if (!*err) {
+	S = csc_matrix_alloc(rows, cols, nz);
+	cnt = calloc(cols, sizeof *cnt);
+	if (S == NULL || cnt == NULL) {
+	    *err = E_ALLOC;
+	}
+    }
+
+    if (!*err) {
+	for (t=0; t<nz; t++) {
+	    cnt[(int) gretl_matrix_get(T, t, 1) - 1] += 1;
+	}
+	for (j=0; j<cols; j++) {
+	    S->p[j+1] = S->p[j] + cnt[j];
+	    cnt[j] = S->p[j];
+	}
+	for (t=0; t<nz; t++) {
+	    j = (int) gretl_matrix_get(T, t, 1) - 1;
+	    q = cnt[j]++;
+	    S->i[q] = (int) gretl_matrix_get(T, t, 0) - 1;
+	    S->x[q] = gretl_matrix_get(T, t, 2);
+	}
+	*err = csc_compact(S);
+    }
+
+    free(cnt);
+
+    if (*err) {
+	csc_matrix_free(S);
+	S = NULL;
+    }
+
+    return S;
+}
+
+/* X'v for sparse X */
+
+static void csc_tprod (const csc_matrix *S, const double *v,
+		       double *ret)
+{
+    int j, q;
+
+    for (j=0; j<S->cols; j++) {
+	ret[j] = 0.0;
+	for (q=S->p[j]; q<S->p[j+1]; q++) {
+	    ret[j] += S->x[q] * v[S->i[q]];
+	}
+    }
+}
+
+/* Xb for sparse X */
+
+static void csc_prod (const csc_matrix *S, const double *b,
+		      double *ret)
+{
+    int j, q;
+
+    for (q=0; q<S->rows; q++) {
+	ret[q] = 0.0;
+    }
+    for (j=0; j<S->cols; j++) {
+	if (b[j] != 0.0) {
+	    for (q=S->p[j]; q<S->p[j+1]; q++) {
+		ret[S->i[q]] += S->x[q] * b[j];
+	    }
+	}
+    }
+}
+
+/* Set up the CSC representation of X. At present this is supported
+   only for the LASSO via CCD, which never needs X in dense form.
+*/
+
+static int regls_set_sparse (regls_info *ri)
+{
+    int cols = 0;
+    int err = 0;
+
+    if (!ri->ccd || ri->ridge) {
+	gretl_errmsg_set("regls: sparse X is supported only for "
+			 "the LASSO via CCD");
+	return E_INVARG;
+    }
+
+    if (gretl_bundle_has_key(ri->b, "ncols")) {
+	cols = gretl_bundle_get_int(ri->b, "ncols", &err);
+    }
+
+    if (!err) {
+	ri->S = csc_from_triplets(ri->X, ri->y->rows, cols, &err);
+    }
+    if (!err) {
+	/* we won't be using the triplets again */
+	ri->X = NULL;
+    }
+
+    return err;
+}
+
 regls_info *regls_info_new (gretl_matrix *X,
 			    gretl_matrix *y,
 			    gretl_bundle *b,
@@ -163,15 +408,26 @@ regls_info *regls_info_new (gretl_matrix *X,
 	ri->verbose = gretl_bundle_get_bool(b, "verbosity", 1);
 	ri->ridge =   gretl_bundle_get_bool(b, "ridge", 0);
 	ri->ccd =     gretl_bundle_get_bool(b, "ccd", 0);
+	ri->sparse =  gretl_bundle_get_bool(b, "sparse", 0);
 	ri->lfrac =   gretl_bundle_get_matrix(b, "lfrac", err);
+	ri->S = NULL;
+    }
+
+    if (ri != NULL && !*err && ri->sparse) {
+	*err = regls_set_sparse(ri);
     }
 
     if (*err) {
 	free(ri);
 	ri = NULL;
     } else {
-	ri->n = ri->X->rows;
-	ri->k = ri->X->cols;
+	if (ri->S != NULL) {
+	    ri->n = ri->S->rows;
+	    ri->k = ri->S->cols;
+	} else {
+	    ri->n = ri->X->rows;
+	    ri->k = ri->X->cols;
+	}
 	ri->nlam = gretl_vector_get_length(ri->lfrac);
 	ri->rho = 8.0;
 	ri->infnorm = 0.0;
@@ -190,6 +446,14 @@ regls_info *regls_info_new (gretl_matrix *X,
     return ri;
 }
 
+static void regls_info_destroy (regls_info *ri)
+{
+    if (ri != NULL) {
+	csc_matrix_free(ri->S);
+	free(ri);
+    }
+}
+
 static double vector_infnorm (const gretl_vector *z)
 {
     const int n = gretl_vector_get_length(z);
@@ -210,13 +474,17 @@ static int regls_set_Xty (regls_info *ri)
 {
     int err = 0;
 
-    ri->Xty = gretl_matrix_alloc(ri->X->cols, 1);
+    ri->Xty = gretl_matrix_alloc(ri->k, 1);
     if (ri->Xty == NULL) {
 	err = E_ALLOC;
     } else {
-	gretl_matrix_multiply_mod(ri->X, GRETL_MOD_TRANSPOSE,
-				  ri->y, GRETL_MOD_NONE,
-				  ri->Xty, GRETL_MOD_NONE);
+	if (ri->S != NULL) {
+	    csc_tprod(ri->S, ri->y->val, ri->Xty->val);
+	} else {
+	    gretl_matrix_multiply_mod(ri->X, GRETL_MOD_TRANSPOSE,
+				      ri->y, GRETL_MOD_NONE,
+				      ri->Xty, GRETL_MOD_NONE);
+	}
 	ri->infnorm = vector_infnorm(ri->Xty);
     }
 
@@ -234,6 +502,57 @@ static const char *crit_string (int crit)
     }
 }
 
+/* Sparse counterpart of randomize_rows(), below: apply the same
+   sequence of row swaps to @y while tracking where each row ends
+   up, then relabel the row indices of @S.
+*/
+
+static int csc_randomize_rows (csc_matrix *S, gretl_matrix *y)
+{
+    gretl_vector *vp;
+    int *pos, *inv;
+    double tmp;
+    int i, q, src, itmp;
+
+    vp = gretl_matrix_alloc(S->rows, 1);
+    pos = malloc(2 * S->rows * sizeof *pos);
+    if (vp == NULL || pos == NULL) {
+	gretl_matrix_free(vp);
+	free(pos);
+	return E_ALLOC;
+    }
+
+    inv = pos + S->rows;
+    fill_permutation_vector(vp, S->rows);
+
+    for (i=0; i<S->rows; i++) {
+	pos[i] = i;
+    }
+    for (i=0; i<S->rows; i++) {
+	src = vp->val[i] - 1;
+	if (src == i) {
+	    continue;
+	}
+	itmp = pos[i];
+	pos[i] = pos[src];
+	pos[src] = itmp;
+	tmp = y->val[i];
+	y->val[i] = y->val[src];
+	y->val[src] = tmp;
+    }
+    for (i=0; i<S->rows; i++) {
+	inv[pos[i]] = i;
+    }
+    for (q=0; q<csc_nnz(S); q++) {
+	S->i[q] = inv[S->i[q]];
+    }
+
+    gretl_matrix_free(vp);
+    free(pos);
+
+    return 0;
+}
+
 static int randomize_rows (gretl_matrix *X, gretl_matrix *y)
 {
     gretl_vector *vp;
@@ -684,6 +1003,67 @@ static int ccd_scale (gretl_matrix *x, double *y,
     return 0;
 }
 
+/* sparse variant of ccd_scale() */
+
+static int csc_ccd_scale (csc_matrix *S, double *y,
+			  double *xty, double *xv)
+{
+    int i, j, q, n = S->rows;
+    double v = sqrt(1.0/n);
+
+    for (i=0; i<n; i++) {
+	y[i] *= v;
+    }
+    for (q=0; q<csc_nnz(S); q++) {
+	S->x[q] *= v;
+    }
+    for (j=0; j<S->cols; j++) {
+	if (xv != NULL) {
+	    xv[j] = 0.0;
+	    for (q=S->p[j]; q<S->p[j+1]; q++) {
+		xv[j] += S->x[q] * S->x[q];
+	    }
+	}
+	if (xty != NULL) {
+	    xty[j] = 0.0;
+	    for (q=S->p[j]; q<S->p[j+1]; q++) {
+		xty[j] += S->x[q] * y[S->i[q]];
+	    }
+	}
+    }
+
+    return 0;
+}
+
+/* Scatter column @k of @S into the dense n-vector @w (@set = 1)
+   or restore @w to zero (@set = 0). While column k is scattered,
+   csc_dot_scattered() gives the cross-product of column j with
+   column k at a cost proportional to the non-zeros in column j.
+*/
+
+static void csc_scatter (const csc_matrix *S, int k, double *w,
+			 int set)
+{
+    int q;
+
+    for (q=S->p[k]; q<S->p[k+1]; q++) {
+	w[S->i[q]] = set ? S->x[q] : 0.0;
+    }
+}
+
+static double csc_dot_scattered (const csc_matrix *S, int j,
+				 const double *w)
+{
+    double ret = 0.0;
+    int q;
+
+    for (q=S->p[j]; q<S->p[j+1]; q++) {
+	ret += S->x[q] * w[S->i[q]];
+    }
+
+    return ret;
+}
+
 static void finalize_ccd_coeffs (gretl_matrix *B,
 				 double *a, int nx,
 				 int *ia)
@@ -707,7 +1087,45 @@ static void finalize_ccd_coeffs (gretl_matrix *B,
     }
 }
 
-static int ccd_iteration (double alpha, const gretl_matrix *X, double *g,
+/* Initial number of columns for the covariance cache in
+   ccd_iteration(): this is grown as needed, since only the
+   active set ever requires a column.
+*/
+#define CCD_CBLOCK 32
+
+/* Strong-rule screening (Tibshirani et al, "Strong rules for
+   discarding predictors in lasso-type problems", JRSS B, 2012):
+   at lambda_m, predictors with |g_j| < 2*lambda_m - lambda_{m-1}
+   are skipped in the full passes, subject to a check of the KKT
+   conditions at convergence. Returns 1 if any screened predictor
+   turns out to violate the KKT conditions, in which case it is
+   restored to the strong set.
+*/
+
+static int ccd_kkt_violation (const double *g, gint8 *strong,
+			      double ab, int nx)
+{
+    int k, ret = 0;
+
+    for (k=0; k<nx; k++) {
+	if (!strong[k] && fabs(g[k]) > ab) {
+	    strong[k] = 1;
+	    ret = 1;
+	}
+    }
+
+    return ret;
+}
+
+/* Note: just one of @X (dense) and @S (sparse) should be non-NULL.
+   The "covariance" algorithm touches X only when a predictor enters
+   the active set, to compute its cross-products with the other
+   predictors; in the sparse case this costs one pass over the
+   non-zero elements.
+*/
+
+static int ccd_iteration (double alpha, const gretl_matrix *X,
+			  const csc_matrix *S, double *g,
 			  int nlam, const double *ulam, double thr,
 			  int maxit, const double *xv, int *lmu,
 			  gretl_matrix *B, int *ia, int *kin,
@@ -716,19 +1134,26 @@ static int ccd_iteration (double alpha, const gretl_matrix *X, double *g,
     gretl_matrix *C;
     double alm, u, v, rsq = 0;
     double ak, del, dlx, cij;
-    double omb, dem, ab;
-    double *a, *da;
+    double omb, dem, ab, abprev;
+    double *a, *da, *w = NULL;
+    gint8 *strong;
     int *mm, nin, jz, iz = 0;
     int j, k, l, m, nlp = 0;
-    int nx = X->cols;
+    int nx = S != NULL ? S->cols : X->cols;
     int err = 0;
 
-    C = gretl_matrix_alloc(nx, nx);
+    C = gretl_matrix_alloc(nx, nx < CCD_CBLOCK ? nx : CCD_CBLOCK);
     a = malloc(nx * sizeof *a);
     da = malloc(nx * sizeof *da);
     mm = malloc(nx * sizeof *mm);
-    if (C == NULL || a == NULL || da == NULL || mm == NULL) {
-	return E_ALLOC;
+    strong = malloc(nx * sizeof *strong);
+    if (S != NULL) {
+	w = calloc(S->rows, sizeof *w);
+    }
+    if (C == NULL || a == NULL || da == NULL || mm == NULL ||
+	strong == NULL || (S != NULL && w == NULL)) {
+	err = E_ALLOC;
+	goto getout;
     }
     /* "zero" @a and @mm */
     for (j=0; j<nx; j++) {
@@ -742,12 +1167,19 @@ static int ccd_iteration (double alpha, const gretl_matrix *X, double *g,
 	alm = ulam[m];
 	dem = alm*omb;
 	ab = alm*alpha;
+	abprev = m > 0 ? ulam[m-1]*alpha : ab;
+	for (k=0; k<nx; k++) {
+	    strong[k] = mm[k] >= 0 || fabs(g[k]) >= 2*ab - abprev;
+	}
 	jz = 1;
     maybe_restart:
 	if (iz*jz == 0) {
             nlp++;
             dlx = 0.0;
 	    for (k=0; k<nx; k++) {
+		if (!strong[k]) {
+		    continue;
+		}
 		ak = a[k];
 		u = g[k] + ak*xv[k];
 		v = fabs(u) - ab;
@@ -755,17 +1187,36 @@ static int ccd_iteration (double alpha, const gretl_matrix *X, double *g,
 		if (a[k] != ak) {
 		    if (mm[k] < 0) {
 			if (nin >= nx) goto check_conv;
+			if (nin == C->cols) {
+			    /* enlarge the covariance cache */
+			    int nc = 2 * C->cols;
+
+			    err = gretl_matrix_realloc(C, nx, nc < nx ? nc : nx);
+			    if (err) {
+				goto getout;
+			    }
+			}
+			if (S != NULL) {
+			    csc_scatter(S, k, w, 1);
+			}
 			for (j=0; j<nx; j++) {
 			    if (mm[j] >= 0) {
 				cij = gretl_matrix_get(C, k, mm[j]);
 				gretl_matrix_set(C, j, nin, cij);
 			    } else if (j != k) {
-				cij = dot_prod_jk(X, j, k, X->rows);
+				if (S != NULL) {
+				    cij = csc_dot_scattered(S, j, w);
+				} else {
+				    cij = dot_prod_jk(X, j, k, X->rows);
+				}
 				gretl_matrix_set(C, j, nin, cij);
 			    } else {
 				gretl_matrix_set(C, j, nin, xv[j]);
 			    }
 			}
+			if (S != NULL) {
+			    csc_scatter(S, k, w, 0);
+			}
 			mm[k] = nin;
 			ia[nin] = k;
 			nin++;
@@ -780,7 +1231,12 @@ static int ccd_iteration (double alpha, const gretl_matrix *X, double *g,
 		}
             }
 	check_conv:
-	    if (dlx < thr || nin > nx) {
+	    if (dlx < thr && nin <= nx &&
+		ccd_kkt_violation(g, strong, ab, nx)) {
+		/* go round again with the enlarged strong set */
+		jz = 0;
+		goto maybe_restart;
+	    } else if (dlx < thr || nin > nx) {
 		goto m_finish;
 	    } else if (nlp > maxit) {
 		fprintf(stderr, "ccd: max iters reached\n");
@@ -853,11 +1309,205 @@ static int ccd_iteration (double alpha, const gretl_matrix *X, double *g,
     free(a);
     free(mm);
     free(da);
+    free(strong);
+    free(w);
     gretl_matrix_free(C);
 
     return err;
 }
 
+/* For wide problems CCD switches from the "covariance" algorithm
+   above to the "naive" one, as glmnet does: the covariance cache
+   would need a column of length nx for each active predictor,
+   while the naive algorithm just maintains the residual vector.
+*/
+#define CCD_NAIVE_MIN 500
+
+static int ccd_use_naive (int n, int nx)
+{
+    return nx >= CCD_NAIVE_MIN || nx > n;
+}
+
+/* x_k'r for column @k of X (dense or sparse) */
+
+static double ccd_col_dot (const gretl_matrix *X,
+			   const csc_matrix *S,
+			   int k, const double *r)
+{
+    if (S != NULL) {
+	return csc_dot_scattered(S, k, r);
+    } else {
+	return dot_product(X->val + X->rows * k, r, X->rows);
+    }
+}
+
+/* r -= d * x_k for column @k of X (dense or sparse) */
+
+static void ccd_col_update (const gretl_matrix *X,
+			    const csc_matrix *S,
+			    int k, double d, double *r)
+{
+    int q;
+
+    if (S != NULL) {
+	for (q=S->p[k]; q<S->p[k+1]; q++) {
+	    r[S->i[q]] -= d * S->x[q];
+	}
+    } else {
+	const double *xk = X->val + X->rows * k;
+
+	for (q=0; q<X->rows; q++) {
+	    r[q] -= d * xk[q];
+	}
+    }
+}
+
+/* The "naive" CCD algorithm, with the same inputs and outputs as
+   ccd_iteration() plus the (scaled) dependent variable @y. For
+   each lambda we sweep the strong set, then cycle on the active
+   set until convergence, and finally check the KKT conditions for
+   the predictors that were screened out; each sweep costs O(n) per
+   predictor visited, or O(nnz) in the sparse case.
+*/
+
+static int ccd_naive_iteration (double alpha, const gretl_matrix *X,
+				const csc_matrix *S, const double *y,
+				double *g, int nlam, const double *ulam,
+				double thr, int maxit, const double *xv,
+				int *lmu, gretl_matrix *B, int *ia,
+				int *kin, double *Rsq, int *pnlp)
+{
+    double omb, dem, ab, abprev;
+    double ak, gk, u, v, del, dlx;
+    double rsq = 0;
+    double *a, *r;
+    gint8 *strong;
+    int *mm, nin = 0;
+    int j, k, l, m, nlp = 0;
+    int nx = S != NULL ? S->cols : X->cols;
+    int n = S != NULL ? S->rows : X->rows;
+    int sweep_all;
+    int err = 0;
+
+    a = calloc(nx, sizeof *a);
+    r = malloc(n * sizeof *r);
+    mm = malloc(nx * sizeof *mm);
+    strong = malloc(nx * sizeof *strong);
+    if (a == NULL || r == NULL || mm == NULL || strong == NULL) {
+	err = E_ALLOC;
+	goto getout;
+    }
+
+    memcpy(r, y, n * sizeof *r);
+    for (j=0; j<nx; j++) {
+	mm[j] = -1;
+    }
+    omb = 1.0 - alpha;
+
+    for (m=0; m<nlam && !err; m++) {
+	dem = ulam[m] * omb;
+	ab = ulam[m] * alpha;
+	abprev = m > 0 ? ulam[m-1] * alpha : ab;
+	for (k=0; k<nx; k++) {
+	    strong[k] = mm[k] >= 0 || fabs(g[k]) >= 2*ab - abprev;
+	}
+	sweep_all = 1;
+	while (!err) {
+	    nlp++;
+	    dlx = 0.0;
+	    for (l=0; l<(sweep_all ? nx : nin); l++) {
+		k = sweep_all ? l : ia[l];
+		if (!strong[k]) {
+		    continue;
+		}
+		gk = ccd_col_dot(X, S, k, r);
+		ak = a[k];
+		u = gk + ak*xv[k];
+		v = fabs(u) - ab;
+		a[k] = v > 0.0 ? sign(v,u) / (xv[k]+dem) : 0.0;
+		if (a[k] != ak) {
+		    if (mm[k] < 0) {
+			mm[k] = nin;
+			ia[nin++] = k;
+		    }
+		    del = a[k] - ak;
+		    rsq += del * (2*gk - del*xv[k]);
+		    dlx = max(xv[k]*del*del, dlx);
+		    ccd_col_update(X, S, k, del, r);
+		}
+	    }
+	    if (nlp > maxit) {
+		fprintf(stderr, "ccd: max iters reached\n");
+		err = E_NOCONV;
+	    } else if (dlx >= thr) {
+		/* keep going on the active set */
+		sweep_all = 0;
+	    } else if (!sweep_all) {
+		/* converged on the active set: sweep the strong set */
+		sweep_all = 1;
+	    } else {
+		/* converged on the strong set: refresh the gradient
+		   and check the predictors that were screened out */
+		for (k=0; k<nx; k++) {
+		    g[k] = ccd_col_dot(X, S, k, r);
+		}
+		if (!ccd_kkt_violation(g, strong, ab, nx)) {
+		    break;
+		}
+	    }
+	}
+	if (!err) {
+	    if (nin > 0) {
+		fill_coeff_column(B, nx, m, a, ia, nin);
+	    }
+	    kin[m] = nin;
+	    if (Rsq != NULL) {
+		Rsq[m] = rsq;
+	    }
+	    *lmu = m + 1;
+	}
+    }
+
+    if (!err) {
+	finalize_ccd_coeffs(B, a, nx, ia);
+    }
+
+ getout:
+
+    *pnlp = nlp;
+    free(a);
+    free(r);
+    free(mm);
+    free(strong);
+
+    return err;
+}
+
+/* run CCD along the lambda path, using whichever of the
+   covariance and naive algorithms is better suited to the
+   shape of X */
+
+static int ccd_path (double alpha, const gretl_matrix *X,
+		     const csc_matrix *S, const double *y,
+		     double *g, int nlam, const double *ulam,
+		     double thr, int maxit, const double *xv,
+		     int *lmu, gretl_matrix *B, int *ia,
+		     int *kin, double *Rsq, int *pnlp)
+{
+    int n = S != NULL ? S->rows : X->rows;
+    int nx = S != NULL ? S->cols : X->cols;
+
+    if (ccd_use_naive(n, nx)) {
+	return ccd_naive_iteration(alpha, X, S, y, g, nlam, ulam,
+				   thr, maxit, xv, lmu, B, ia, kin,
+				   Rsq, pnlp);
+    } else {
+	return ccd_iteration(alpha, X, S, g, nlam, ulam, thr,
+			     maxit, xv, lmu, B, ia, kin, Rsq,
+			     pnlp);
+    }
+}
+
 static int ccd_get_crit (const gretl_matrix *B,
 		         const gretl_matrix *lam,
 		         const gretl_matrix *R2,
@@ -1078,25 +1728,36 @@ static double lasso_objective (const gretl_matrix *X,
 
 /* calculate the cross validation criterion */
 
-static double xv_score (const gretl_matrix *X,
-			const gretl_vector *y,
-			const gretl_vector *b,
-			gretl_vector *Xb,
-			int crit_type)
+/* given fitted values @Xb, compute the out-of-sample criterion */
+
+static double xv_resid_score (const gretl_vector *y,
+			      gretl_vector *Xb,
+			      int crit_type)
 {
+    int n = gretl_vector_get_length(Xb);
     double sum = 0;
 
-    /* get fitted values */
-    gretl_matrix_multiply(X, b, Xb);
     /* compute and process residuals */
-    vector_subtract_from(Xb, y, X->rows);
+    vector_subtract_from(Xb, y, n);
     if (crit_type == CRIT_MSE) {
 	sum = gretl_vector_dot_product(Xb, Xb, NULL);
     } else {
 	sum = abs_sum(Xb);
     }
 
-    return sum / X->rows;
+    return sum / n;
+}
+
+static double xv_score (const gretl_matrix *X,
+			const gretl_vector *y,
+			const gretl_vector *b,
+			gretl_vector *Xb,
+			int crit_type)
+{
+    /* get fitted values */
+    gretl_matrix_multiply(X, b, Xb);
+
+    return xv_resid_score(y, Xb, crit_type);
 }
 
 static void soft_threshold (gretl_vector *v, double lambda,
@@ -1361,7 +2022,11 @@ static int ccd_regls (regls_info *ri, PRN *prn)
     }
 
     /* scale data by sqrt(1/n) */
-    ccd_scale(ri->X, ri->y->val, Xty->val, xv->val);
+    if (ri->S != NULL) {
+	csc_ccd_scale(ri->S, ri->y->val, Xty->val, xv->val);
+    } else {
+	ccd_scale(ri->X, ri->y->val, Xty->val, xv->val);
+    }
 
     /* and compute lambda sequence */
     lmax = vector_infnorm(Xty);
@@ -1386,9 +2051,9 @@ static int ccd_regls (regls_info *ri, PRN *prn)
 	}
     }
 
-    err = ccd_iteration(alpha, ri->X, Xty->val, nlam, lam->val,
-			ccd_toler, maxit, xv->val, &lmu, B,
-			ia, nnz, Rsq, &nlp);
+    err = ccd_path(alpha, ri->X, ri->S, ri->y->val, Xty->val,
+		   nlam, lam->val, ccd_toler, maxit, xv->val, &lmu,
+		   B, ia, nnz, Rsq, &nlp);
 #if 0
     fprintf(stderr, "ccd: err=%d, nlp=%d, lmu=%d\n", err, nlp, lmu);
 #endif
@@ -1909,6 +2574,9 @@ static int admm_do_fold (const gretl_matrix *X,
     static gretl_vector *r, *bprev, *bdiff;
     static gretl_vector *q, *Xty, *n1, *L;
     static gretl_matrix_block *MB;
+#if defined(_OPENMP)
+#pragma omp threadprivate(v, u, b, r, bprev, bdiff, q, Xty, n1, L, MB)
+#endif
     double rho = rho0;
     int ldim, nlam;
     int n, k, j;
@@ -1936,9 +2604,15 @@ static int admm_do_fold (const gretl_matrix *X,
 	if (MB == NULL) {
 	    return E_ALLOC;
 	}
-	gretl_matrix_block_zero(MB);
     }
 
+    /* Start each fold from zero, then warm-start along the lambda
+       path: this way the result for a given fold does not depend
+       on which folds (if any) were previously handled using the
+       same workspace.
+    */
+    gretl_matrix_block_zero(MB);
+
     /* compute X'y for the estimation sample */
     gretl_matrix_multiply_mod(X, GRETL_MOD_TRANSPOSE,
 			      y, GRETL_MOD_NONE,
@@ -1967,10 +2641,16 @@ static int admm_do_fold (const gretl_matrix *X,
     return err;
 }
 
+/* Note: in the sparse case @X and @X_out are NULL and the
+   estimation and prediction data are in @S and @S_out.
+*/
+
 static int ccd_do_fold (gretl_matrix *X,
 			gretl_matrix *y,
 			gretl_matrix *X_out,
 			gretl_matrix *y_out,
+			csc_matrix *S,
+			csc_matrix *S_out,
 			const gretl_matrix *lam,
 			gretl_matrix *XVC,
 			int fold, int crit_type,
@@ -1982,13 +2662,16 @@ static int ccd_do_fold (gretl_matrix *X,
     static gretl_matrix *u;
     static gretl_matrix *b;
     static int *ia, *nnz;
+#if defined(_OPENMP)
+#pragma omp threadprivate(MB, Xty, xv, B, u, b, ia, nnz)
+#endif
     int maxit = CCD_MAX_ITER;
     int nlp = 0, lmu = 0;
     int nlam, nout;
     int k, j;
     int err = 0;
 
-    if (X == NULL) {
+    if (X == NULL && S == NULL) {
 	/* cleanup signal */
 	gretl_matrix_block_destroy(MB);
 	MB = NULL;
@@ -1999,8 +2682,8 @@ static int ccd_do_fold (gretl_matrix *X,
 
     /* dimensions */
     nlam = gretl_vector_get_length(lam);
-    nout = X_out->rows;
-    k = X->cols;
+    nout = S_out != NULL ? S_out->rows : X_out->rows;
+    k = S != NULL ? S->cols : X->cols;
 
     if (MB == NULL) {
 	MB = gretl_matrix_block_new(&xv, k, 1, &Xty, k, 1,
@@ -2015,11 +2698,15 @@ static int ccd_do_fold (gretl_matrix *X,
     gretl_matrix_zero(B);
 
     /* scale the estimation subset by sqrt(1/n) */
-    ccd_scale(X, y->val, Xty->val, xv->val);
+    if (S != NULL) {
+	csc_ccd_scale(S, y->val, Xty->val, xv->val);
+    } else {
+	ccd_scale(X, y->val, Xty->val, xv->val);
+    }
 
-    err = ccd_iteration(alpha, X, Xty->val, nlam, lam->val,
-			ccd_toler, maxit, xv->val, &lmu, B,
-			ia, nnz, NULL, &nlp);
+    err = ccd_path(alpha, X, S, y->val, Xty->val, nlam, lam->val,
+		   ccd_toler, maxit, xv->val, &lmu, B,
+		   ia, nnz, NULL, &nlp);
 #if 0
     fprintf(stderr, "ccd: err=%d, nlp=%d, lmu=%d\n", err, nlp, lmu);
 #endif
@@ -2031,7 +2718,12 @@ static int ccd_do_fold (gretl_matrix *X,
 
 	for (j=0; j<nlam; j++) {
 	    memcpy(b->val, B->val + j*k, bsize);
-	    score = xv_score(X_out, y_out, b, u, crit_type);
+	    if (S_out != NULL) {
+		csc_prod(S_out, b->val, u->val);
+		score = xv_resid_score(y_out, u, crit_type);
+	    } else {
+		score = xv_score(X_out, y_out, b, u, crit_type);
+	    }
 	    gretl_matrix_set(XVC, j, fold, score);
 	}
     }
@@ -2052,6 +2744,9 @@ static int svd_do_fold (gretl_matrix *X,
     static gretl_matrix *B;
     static gretl_matrix *u;
     static gretl_matrix *b;
+#if defined(_OPENMP)
+#pragma omp threadprivate(MB, B, u, b)
+#endif
     int nlam, nout;
     int k, j;
     int err = 0;
@@ -2333,7 +3028,8 @@ static int get_xvalidation_details (regls_info *ri,
 static void xv_cleanup (regls_info *ri)
 {
     if (ri->ccd) {
-	ccd_do_fold(NULL, NULL, NULL, NULL, NULL, NULL, 0, 0, 0);
+	ccd_do_fold(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+		    0, 0, 0);
     } else if (ri->ridge) {
 	svd_do_fold(NULL, NULL, NULL, NULL, NULL, NULL, 0, 0, 0);
     } else {
@@ -2363,22 +3059,242 @@ static gretl_matrix *make_xv_lambda (regls_info *ri,
     return lam;
 }
 
+/* Sparse counterpart of prepare_xv_data(): rows i with
+   i/fsize == f form the prediction subset, and other rows
+   below nf*fsize the estimation subset.
+*/
+
+static void csc_prepare_xv_data (const csc_matrix *S,
+				 const gretl_matrix *y,
+				 csc_matrix *Se,
+				 gretl_matrix *ye,
+				 csc_matrix *Sf,
+				 gretl_matrix *yf,
+				 int f)
+{
+    int fsize = Sf->rows;
+    int r0 = f * fsize;
+    int r1 = r0 + fsize;
+    int rmax = Se->rows + fsize;
+    int i, j, q, ne = 0, nf = 0;
+
+    for (j=0; j<S->cols; j++) {
+	Se->p[j] = ne;
+	Sf->p[j] = nf;
+	for (q=S->p[j]; q<S->p[j+1]; q++) {
+	    i = S->i[q];
+	    if (i >= r0 && i < r1) {
+		Sf->i[nf] = i - r0;
+		Sf->x[nf++] = S->x[q];
+	    } else if (i < r0) {
+		Se->i[ne] = i;
+		Se->x[ne++] = S->x[q];
+	    } else if (i < rmax) {
+		Se->i[ne] = i - fsize;
+		Se->x[ne++] = S->x[q];
+	    }
+	}
+    }
+    Se->p[S->cols] = ne;
+    Sf->p[S->cols] = nf;
+
+    for (i=0; i<y->rows; i++) {
+	if (i >= r0 && i < r1) {
+	    yf->val[i-r0] = y->val[i];
+	} else if (i < r0) {
+	    ye->val[i] = y->val[i];
+	} else if (i < rmax) {
+	    ye->val[i-fsize] = y->val[i];
+	}
+    }
+}
+
+/* workspace holding the estimation and prediction subsets
+   for a given fold */
+
+typedef struct xv_fold_ {
+    gretl_matrix_block *XY;
+    gretl_matrix *Xe, *Xf;
+    gretl_matrix *ye, *yf;
+    csc_matrix *Se, *Sf;
+} xv_fold;
+
+static void xv_fold_clear (xv_fold *xf)
+{
+    gretl_matrix_block_destroy(xf->XY);
+    csc_matrix_free(xf->Se);
+    csc_matrix_free(xf->Sf);
+}
+
+/* note: on failure @xf is left in a state suitable for
+   xv_fold_clear() */
+
+static int xv_fold_init (xv_fold *xf, regls_info *ri,
+			 int esize, int fsize)
+{
+    xf->XY = NULL;
+    xf->Xe = xf->Xf = NULL;
+    xf->Se = xf->Sf = NULL;
+
+    if (ri->S != NULL) {
+	int nz = csc_nnz(ri->S);
+
+	xf->XY = gretl_matrix_block_new(&xf->ye, esize, 1,
+					&xf->yf, fsize, 1, NULL);
+	xf->Se = csc_matrix_alloc(esize, ri->k, nz);
+	xf->Sf = csc_matrix_alloc(fsize, ri->k, nz);
+	if (xf->XY == NULL || xf->Se == NULL || xf->Sf == NULL) {
+	    return E_ALLOC;
+	}
+    } else {
+	xf->XY = gretl_matrix_block_new(&xf->Xe, esize, ri->k,
+					&xf->Xf, fsize, ri->k,
+					&xf->ye, esize, 1,
+					&xf->yf, fsize, 1, NULL);
+	if (xf->XY == NULL) {
+	    return E_ALLOC;
+	}
+    }
+
+    return 0;
+}
+
+/* fill the workspace for fold @f, run the algorithm in use on the
+   estimation subset and record the out-of-sample criteria in @XVC */
+
+static int xv_do_fold (regls_info *ri, xv_fold *xf,
+		       const gretl_matrix *lam,
+		       gretl_matrix *XVC,
+		       double lmax, double alpha,
+		       int f, int crit_type)
+{
+    if (ri->S != NULL) {
+	csc_prepare_xv_data(ri->S, ri->y, xf->Se, xf->ye,
+			    xf->Sf, xf->yf, f);
+    } else {
+	prepare_xv_data(ri->X, ri->y, xf->Xe, xf->ye,
+			xf->Xf, xf->yf, f);
+    }
+
+    if (ri->ccd) {
+	return ccd_do_fold(xf->Xe, xf->ye, xf->Xf, xf->yf,
+			   xf->Se, xf->Sf, lam, XVC, f,
+			   crit_type, alpha);
+    } else if (ri->ridge) {
+	return svd_do_fold(xf->Xe, xf->ye, xf->Xf, xf->yf,
+			   lam, XVC, f, crit_type, ri->lamscale);
+    } else {
+	return admm_do_fold(xf->Xe, xf->ye, xf->Xf, xf->yf,
+			    ri->lfrac, XVC, lmax, ri->rho, f,
+			    crit_type);
+    }
+}
+
+static int xv_folds_serial (regls_info *ri,
+			    const gretl_matrix *lam,
+			    gretl_matrix *XVC,
+			    double lmax, double alpha,
+			    int fsize, int esize,
+			    int crit_type)
+{
+    xv_fold xf;
+    int f, err;
+
+    err = xv_fold_init(&xf, ri, esize, fsize);
+
+    for (f=0; f<XVC->cols && !err; f++) {
+	err = xv_do_fold(ri, &xf, lam, XVC, lmax, alpha,
+			 f, crit_type);
+    }
+
+    /* send deallocation signal */
+    xv_cleanup(ri);
+    xv_fold_clear(&xf);
+
+    return err;
+}
+
+#if defined(_OPENMP)
+
+/* Threaded variant of xv_folds_serial(): each thread has its own
+   copy of the fold data and its own (threadprivate) workspace in
+   the *_do_fold() functions. Folds are handed out one at a time
+   since the time taken per fold can vary a lot, depending on how
+   hard the algorithm has to work along the lambda path.
+*/
+
+static int xv_folds_omp (regls_info *ri,
+			 const gretl_matrix *lam,
+			 gretl_matrix *XVC,
+			 double lmax, double alpha,
+			 int fsize, int esize,
+			 int crit_type)
+{
+    int nf = XVC->cols;
+    int nt = get_omp_n_threads();
+    int save_nt = 0;
+    int f, err = 0;
+
+    if (nt > nf) {
+	nt = nf;
+    }
+
+    /* don't oversubscribe the cores via threaded BLAS */
+    if (blas_is_openblas()) {
+	save_nt = blas_get_num_threads();
+	if (save_nt > 1) {
+	    blas_set_num_threads(1);
+	}
+    }
+
+#pragma omp parallel private(f) num_threads(nt)
+    {
+	xv_fold xf;
+	int ferr;
+
+	ferr = xv_fold_init(&xf, ri, esize, fsize);
+
+#pragma omp for schedule(dynamic, 1)
+	for (f=0; f<nf; f++) {
+	    if (!ferr) {
+		ferr = xv_do_fold(ri, &xf, lam, XVC, lmax, alpha,
+				  f, crit_type);
+	    }
+	}
+
+	/* free this thread's workspace */
+	xv_cleanup(ri);
+	xv_fold_clear(&xf);
+
+	if (ferr) {
+#pragma omp critical
+	    err = ferr;
+	}
+    }
+
+    if (blas_is_openblas() && save_nt > 1) {
+	blas_set_num_threads(save_nt);
+    }
+
+    return err;
+}
+
+#endif /* _OPENMP */
+
 /* unified cross validation function, employed when we're
    not doing MPI
 */
 
 static int regls_xv (regls_info *ri, PRN *prn)
 {
-    gretl_matrix_block *XY;
-    gretl_matrix *Xe, *Xf;
-    gretl_matrix *ye, *yf;
     gretl_matrix *lam = NULL;
     gretl_matrix *XVC = NULL;
     double lmax, alpha;
     int fsize, esize;
     int randfolds = 0;
     int crit_type = 0;
-    int f, nf;
+    int threaded = 0;
+    int nf;
     int err;
 
     err = get_xvalidation_details(ri, &nf, &randfolds, &crit_type);
@@ -2390,21 +3306,17 @@ static int regls_xv (regls_info *ri, PRN *prn)
     esize = (nf - 1) * fsize;
     alpha = ri->ridge ? 0.0 : 1.0;
 
+#if defined(_OPENMP)
+    threaded = libset_use_openmp((guint64) esize * ri->k * ri->nlam);
+#endif
+
     if (ri->verbose) {
 	pprintf(prn, "regls_xv: nf=%d, fsize=%d, randfolds=%d, crit=%s, "
-		"ridge=%d, ccd=%d\n", nf, fsize, randfolds,
-		crit_string(crit_type), ri->ridge, ri->ccd);
+		"ridge=%d, ccd=%d, threaded=%d\n", nf, fsize, randfolds,
+		crit_string(crit_type), ri->ridge, ri->ccd, threaded);
 	gretl_flush(prn);
     }
 
-    XY = gretl_matrix_block_new(&Xe, esize, ri->k,
-				&Xf, fsize, ri->k,
-				&ye, esize, 1,
-				&yf, fsize, 1, NULL);
-    if (XY == NULL) {
-	return E_ALLOC;
-    }
-
     lmax = get_xvalidation_lmax(ri, esize, alpha);
     if (ri->verbose) {
 	pprintf(prn, "cross-validation lmax = %g\n\n", lmax);
@@ -2417,7 +3329,11 @@ static int regls_xv (regls_info *ri, PRN *prn)
 
     if (!err && randfolds) {
 	/* scramble the row order of X and y */
-	randomize_rows(ri->X, ri->y);
+	if (ri->S != NULL) {
+	    err = csc_randomize_rows(ri->S, ri->y);
+	} else {
+	    randomize_rows(ri->X, ri->y);
+	}
     }
 
     if (!err) {
@@ -2427,23 +3343,21 @@ static int regls_xv (regls_info *ri, PRN *prn)
 	}
     }
 
-    for (f=0; f<nf && !err; f++) {
-	prepare_xv_data(ri->X, ri->y, Xe, ye, Xf, yf, f);
-	if (ri->ccd) {
-	    err = ccd_do_fold(Xe, ye, Xf, yf, lam, XVC, f,
-			      crit_type, alpha);
-	} else if (ri->ridge) {
-	    err = svd_do_fold(Xe, ye, Xf, yf, lam, XVC, f,
-			      crit_type, ri->lamscale);
+    if (!err) {
+#if defined(_OPENMP)
+	if (threaded) {
+	    err = xv_folds_omp(ri, lam, XVC, lmax, alpha,
+			       fsize, esize, crit_type);
 	} else {
-	    err = admm_do_fold(Xe, ye, Xf, yf, ri->lfrac, XVC,
-			       lmax, ri->rho, f, crit_type);
+	    err = xv_folds_serial(ri, lam, XVC, lmax, alpha,
+				  fsize, esize, crit_type);
 	}
+#else
+	err = xv_folds_serial(ri, lam, XVC, lmax, alpha,
+			      fsize, esize, crit_type);
+#endif
     }
 
-    /* send deallocation signal */
-    xv_cleanup(ri);
-
     if (!err) {
 	PRN *myprn = ri->verbose ? prn : NULL;
 
@@ -2462,7 +3376,6 @@ static int regls_xv (regls_info *ri, PRN *prn)
 
     gretl_matrix_free(lam);
     gretl_matrix_free(XVC);
-    gretl_matrix_block_destroy(XY);
 
     return err;
 }
@@ -2565,8 +3478,8 @@ static int real_regls_xv_mpi (regls_info *ri, PRN *prn)
 		pprintf(prn, "rank %d: taking fold %d\n", rank, f+1);
 	    }
 	    if (ri->ccd) {
-		err = ccd_do_fold(Xe, ye, Xf, yf, lam, XVC, my_f++,
-				  crit_type, alpha);
+		err = ccd_do_fold(Xe, ye, Xf, yf, NULL, NULL, lam, XVC,
+				  my_f++, crit_type, alpha);
 	    } else if (ri->ridge) {
 		err = svd_do_fold(Xe, ye, Xf, yf, lam, XVC, my_f++,
 				  crit_type, ri->lamscale);
@@ -2676,7 +3589,7 @@ int gretl_regls (gretl_matrix *X,
 	err = regfunc(ri, prn);
     }
 
-    free(ri);
+    regls_info_destroy(ri);
 
     return err;
 }
@@ -2723,7 +3636,7 @@ int regls_xv_mpi (PRN *prn)
     gretl_matrix_free(X);
     gretl_matrix_free(y);
     gretl_bundle_destroy(bun);
-    free(ri);
+    regls_info_destroy(ri);
 
     return err;
 }
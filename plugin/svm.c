@@ -1378,6 +1378,22 @@ static gretl_matrix *get_probs_matrix (sv_wrapper *w,
     return *targ;
 }
 
+/* Number of threads to use in cross validation or batch prediction,
+   given a rough measure of the work involved. When we're running
+   under MPI the processes are already sharing out the work, so
+   we stick to a single thread.
+*/
+
+static int svm_n_threads (const sv_wrapper *w, guint64 work)
+{
+#if defined(_OPENMP)
+    if (w->nproc < 2 && libset_use_openmp(work)) {
+	return get_omp_n_threads();
+    }
+#endif
+    return 1;
+}
+
 static int real_svm_predict (double *yhat,
 			     sv_data *prob,
 			     sv_wrapper *w,
@@ -1400,7 +1416,7 @@ static int real_svm_predict (double *yhat,
     int misses = 0;
     double dev, yhi, yi;
     double *pi = NULL;
-    sv_cell *x;
+    double *pred = NULL;
     int i, j, err = 0;
 
     if (model->param.svm_type == EPSILON_SVR ||
@@ -1441,14 +1457,27 @@ static int real_svm_predict (double *yhat,
 
     if (w->do_probs) {
 	maybe_set_svm_seed(w);
+    } else {
+	pred = malloc(prob->l * sizeof *pred);
+	if (pred == NULL) {
+	    free(pi);
+	    free(ls);
+	    return E_ALLOC;
+	}
     }
 
     pprintf(prn, "Calling prediction function (this may take a while)\n");
     gretl_flush(prn);
+    if (pred != NULL) {
+	/* score all the observations in one go */
+	guint64 work = (guint64) prob->l * model->l;
+
+	svm_predict_batch(model, prob->x, prob->l, pred,
+			  svm_n_threads(w, work));
+    }
     for (i=0; i<prob->l; i++) {
-	x = prob->x[i];
 	if (w->do_probs) {
-	    yhi = svm_predict_probability(model, x, pi);
+	    yhi = svm_predict_probability(model, prob->x[i], pi);
 	    for (j=0; j<nr_class; j++) {
 		/* transcribe probability estimates */
 		if (ls != NULL) {
@@ -1459,7 +1488,7 @@ static int real_svm_predict (double *yhat,
 		}
 	    }
 	} else {
-	    yhi = svm_predict(model, x);
+	    yhi = pred[i];
 	}
 	yi = prob->y[i];
 	if (!regression) {
@@ -1487,6 +1516,8 @@ static int real_svm_predict (double *yhat,
 	}
     }
 
+    free(pred);
+
     if (pi != NULL) {
 	free(pi);
 	free(ls);
@@ -1574,72 +1605,119 @@ static int *get_fold_sizes (const sv_data *data,
     return ret;
 }
 
-/* Carry out cross validation in the case where the user has provided
-   a series to specify the "folds", or has specified a given number of
-   consecutive blocks, as opposed to the default random subsetting.
+/* Train on all but fold @i (0-based) and predict the observations
+   in fold @i, for custom_xvalidate() below.
 */
 
-static void custom_xvalidate (const sv_data *prob,
-			      const sv_parm *parm,
-			      const sv_wrapper *w,
-			      double *targ)
+static void custom_xvalidate_fold (const sv_data *prob,
+				   const sv_parm *parm,
+				   const sv_wrapper *w,
+				   double *targ,
+				   int i)
 {
-    int i, vi, ni;
+    struct svm_problem subprob;
+    struct svm_model *submodel;
+    int vi = i + 1;
+    int ni = w->fsize[vi];
+    int jmin = 0, jmax = 0;
+    int j, k, useobs;
 
-    for (i=0; i<w->nfold; i++) {
-	struct svm_problem subprob;
-	struct svm_model *submodel;
-	int jmin = 0, jmax = 0;
-	int j, k, useobs;
+    subprob.l = prob->l - ni;
+    subprob.x = malloc(subprob.l * sizeof *subprob.x);
+    subprob.y = malloc(subprob.l * sizeof *subprob.y);
 
-	vi = i + 1;
-	ni = w->fsize[vi];
-	subprob.l = prob->l - ni;
-	subprob.x = malloc(subprob.l * sizeof *subprob.x);
-	subprob.y = malloc(subprob.l * sizeof *subprob.y);
+    if (w->flags & W_CONSEC) {
+	/* find start and end points for fold */
+	jmin = i * w->fsize[1];
+	jmax = jmin + ni;
+    }
 
+    /* set the training subsample, excluding fold i */
+    k = 0;
+    for (j=0; j<prob->l; j++) {
 	if (w->flags & W_CONSEC) {
-	    /* find start and end points for fold */
-	    jmin = i * w->fsize[1];
-	    jmax = jmin + ni;
+	    useobs = j < jmin || j >= jmax;
+	} else {
+	    useobs = w->flist[j+1] != vi;
+	}
+	if (useobs) {
+	    subprob.x[k] = prob->x[j];
+	    subprob.y[k] = prob->y[j];
+	    k++;
 	}
+    }
+
+    /* train on the given subsample */
+    submodel = svm_train(&subprob, parm);
 
-	/* set the training subsample, excluding fold i */
-	k = 0;
+    /* predict on the complementary subsample (fold i only) */
+    if (w->flags & W_CONSEC) {
+	/* we don't have to scan the whole prob->x array */
+	for (j=jmin; j<jmax; j++) {
+	    targ[j] = svm_predict(submodel, prob->x[j]);
+	}
+    } else {
+	/* the values we want may be interspersed */
 	for (j=0; j<prob->l; j++) {
-	    if (w->flags & W_CONSEC) {
-		useobs = j < jmin || j >= jmax;
-	    } else {
-		useobs = w->flist[j+1] != vi;
-	    }
-	    if (useobs) {
-		subprob.x[k] = prob->x[j];
-		subprob.y[k] = prob->y[j];
-		k++;
+	    if (w->flist[j+1] == vi) {
+		targ[j] = svm_predict(submodel, prob->x[j]);
 	    }
 	}
+    }
 
-	/* train on the given subsample */
-	submodel = svm_train(&subprob, parm);
+    svm_free_and_destroy_model(&submodel);
+    free(subprob.x);
+    free(subprob.y);
+}
 
-	/* predict on the complementary subsample (fold i only) */
-	if (w->flags & W_CONSEC) {
-	    /* we don't have to scan the whole prob->x array */
-	    for (j=jmin; j<jmax; j++) {
-		targ[j] = svm_predict(submodel, prob->x[j]);
-	    }
-	} else {
-	    /* the values we want may be interspersed */
-	    for (j=0; j<prob->l; j++) {
-		if (w->flist[j+1] == vi) {
-		    targ[j] = svm_predict(submodel, prob->x[j]);
-		}
-	    }
+/* Carry out cross validation in the case where the user has provided
+   a series to specify the "folds", or has specified a given number of
+   consecutive blocks, as opposed to the default random subsetting.
+   The folds are independent, so when @nt > 1 we train them in
+   parallel, dividing the kernel cache allowance among the threads.
+*/
+
+static void custom_xvalidate (const sv_data *prob,
+			      const sv_parm *parm,
+			      const sv_wrapper *w,
+			      double *targ,
+			      int nt)
+{
+    int i;
+
+#if defined(_OPENMP)
+    if (nt > w->nfold) {
+	nt = w->nfold;
+    }
+    if (nt > 1 && !parm->probability) {
+	sv_parm fparm = *parm;
+
+	fparm.cache_size /= nt;
+#pragma omp parallel for num_threads(nt) schedule(dynamic, 1)
+	for (i=0; i<w->nfold; i++) {
+	    custom_xvalidate_fold(prob, &fparm, w, targ, i);
 	}
+	return;
+    }
+#endif
+
+    for (i=0; i<w->nfold; i++) {
+	custom_xvalidate_fold(prob, parm, w, targ, i);
+    }
+}
 
-	svm_free_and_destroy_model(&submodel);
-	free(subprob.x);
-	free(subprob.y);
+static void maybe_hush (sv_wrapper *w)
+{
+    if (!(w->flags & W_QUIET)) {
+	/* cut out excessive verbosity */
+	svm_set_print_string_function(gretl_libsvm_noprint);
+    }
+}
+
+static void maybe_resume_printing (sv_wrapper *w)
+{
+    if (!(w->flags & W_QUIET)) {
+	svm_set_print_string_function(gretl_libsvm_print);
     }
 }
 
@@ -1654,12 +1732,26 @@ static int xvalidate_once (sv_data *prob,
 			   PRN *prn)
 {
     int i, n = prob->l;
+    int nt = svm_n_threads(w, (guint64) n * n);
+    /* libsvm's progress output is not thread-safe: silence it
+       if the folds are to be run concurrently (in the grid-search
+       case it's already silenced)
+    */
+    int hush = (nt > 1 && iter < 0);
+
+    if (hush) {
+	maybe_hush(w);
+    }
 
     if (w->fsize != NULL) {
-	custom_xvalidate(prob, parm, w, targ);
+	custom_xvalidate(prob, parm, w, targ, nt);
     } else {
 	maybe_set_svm_seed(w);
-	svm_cross_validation(prob, parm, w->nfold, targ);
+	svm_cross_validation(prob, parm, w->nfold, targ, nt);
+    }
+
+    if (hush) {
+	maybe_resume_printing(w);
     }
 
     if (doing_regression(parm)) {
@@ -2005,21 +2097,6 @@ static int do_search_prep (sv_data *data,
     return err;
 }
 
-static void maybe_hush (sv_wrapper *w)
-{
-    if (!(w->flags & W_QUIET)) {
-	/* cut out excessive verbosity */
-	svm_set_print_string_function(gretl_libsvm_noprint);
-    }
-}
-
-static void maybe_resume_printing (sv_wrapper *w)
-{
-    if (!(w->flags & W_QUIET)) {
-	svm_set_print_string_function(gretl_libsvm_print);
-    }
-}
-
 static int can_write_plot (sv_wrapper *w)
 {
     /* for now we handle only the case of a 2D grid
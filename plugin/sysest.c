@@ -958,6 +958,173 @@ static int ols_data_to_sys (equation_system *sys, int mk)
     return err;
 }
 
+/* number of observations per chunk when cumulating the
+   cross-products in sys_cross_products() */
+#define SYS_XPROD_CHUNK 2048
+
+/* For the multi-equation estimators (SUR, 3SLS) the blocks of the
+   stacked system, X_i'X_j and X_i'y_l, do not depend on sigma, so
+   we compute them just once, in @XX (mk x mk) and @XY (mk x m);
+   each (iterated) round of estimation then just reweights them.
+   The data are processed in chunks of observations, each chunk
+   giving a rank update of the full set of cross-products across
+   all pairs of equations at once.
+*/
+
+static int sys_cross_products (equation_system *sys, DATASET *dset,
+			       int mk, gretl_matrix **pXX,
+			       gretl_matrix **pXY)
+{
+    const double **xcol;
+    const double **ycol;
+    gretl_matrix *XX, *XY;
+    gretl_matrix *Zc, *Yc;
+    int m = sys->neqns;
+    int T = sys->T;
+    int tc = T < SYS_XPROD_CHUNK ? T : SYS_XPROD_CHUNK;
+    int i, j, c, n, t0;
+    int err = 0;
+
+    xcol = malloc(mk * sizeof *xcol);
+    ycol = malloc(m * sizeof *ycol);
+    XX = gretl_zero_matrix_new(mk, mk);
+    XY = gretl_zero_matrix_new(mk, m);
+    Zc = gretl_matrix_alloc(tc, mk);
+    Yc = gretl_matrix_alloc(tc, m);
+
+    if (xcol == NULL || ycol == NULL || XX == NULL ||
+	XY == NULL || Zc == NULL || Yc == NULL) {
+	err = E_ALLOC;
+	goto bailout;
+    }
+
+    /* pointers to the columns of the per-equation X blocks,
+       as in make_sys_X_block() */
+    c = 0;
+    for (i=0; i<m && !err; i++) {
+	const MODEL *pmod = sys->models[i];
+
+	for (j=0; j<pmod->ncoeff; j++) {
+	    if (sys->method == SYS_METHOD_3SLS ||
+		sys->method == SYS_METHOD_FIML) {
+		xcol[c] = model_get_Xi(pmod, dset, j);
+	    } else {
+		xcol[c] = dset->Z[pmod->list[j+2]];
+	    }
+	    if (xcol[c++] == NULL) {
+		err = E_DATA;
+		break;
+	    }
+	}
+	ycol[i] = dset->Z[system_get_depvar(sys, i)];
+    }
+
+    for (t0=0; t0<T && !err; t0+=tc) {
+	n = T - t0 < tc ? T - t0 : tc;
+	Zc->rows = Yc->rows = n;
+#if defined(_OPENMP)
+#pragma omp parallel for if (libset_use_openmp((guint64) n * mk))
+#endif
+	for (c=0; c<mk; c++) {
+	    memcpy(Zc->val + c * n, xcol[c] + sys->t1 + t0,
+		   n * sizeof(double));
+	}
+	for (i=0; i<m; i++) {
+	    memcpy(Yc->val + i * n, ycol[i] + sys->t1 + t0,
+		   n * sizeof(double));
+	}
+	err = gretl_matrix_multiply_mod(Zc, GRETL_MOD_TRANSPOSE,
+					Zc, GRETL_MOD_NONE,
+					XX, GRETL_MOD_CUMULATE);
+	if (!err) {
+	    err = gretl_matrix_multiply_mod(Zc, GRETL_MOD_TRANSPOSE,
+					    Yc, GRETL_MOD_NONE,
+					    XY, GRETL_MOD_CUMULATE);
+	}
+    }
+
+ bailout:
+
+    free(xcol);
+    free(ycol);
+    gretl_matrix_free(Zc);
+    gretl_matrix_free(Yc);
+
+    if (err) {
+	gretl_matrix_free(XX);
+	gretl_matrix_free(XY);
+    } else {
+	*pXX = XX;
+	*pXY = XY;
+    }
+
+    return err;
+}
+
+/* Form the stacked X matrix and y vector from the cross-products
+   computed by sys_cross_products(), weighting block (i,j) by
+   element (i,j) of sigma-inverse -- or, if @rsingle is non-zero,
+   just picking out the diagonal blocks.
+*/
+
+static int sys_weight_cross_products (equation_system *sys,
+				      const gretl_matrix *XX,
+				      const gretl_matrix *XY,
+				      gretl_matrix *X,
+				      gretl_matrix *y,
+				      int rsingle)
+{
+    int m = sys->neqns;
+    int mk = XX->rows;
+    int *eq;
+    int i, j, l, r, c;
+    double sij, yr;
+
+    /* the equation to which each row of the system belongs */
+    eq = malloc(mk * sizeof *eq);
+    if (eq == NULL) {
+	return E_ALLOC;
+    }
+
+    r = 0;
+    for (i=0; i<m; i++) {
+	for (j=0; j<sys->models[i]->ncoeff; j++) {
+	    eq[r++] = i;
+	}
+    }
+
+    for (c=0; c<mk; c++) {
+	j = eq[c];
+	for (r=0; r<mk; r++) {
+	    i = eq[r];
+	    if (rsingle) {
+		sij = (i == j) ? 1.0 : 0.0;
+	    } else {
+		sij = gretl_matrix_get(sys->S, i, j);
+	    }
+	    gretl_matrix_set(X, r, c, sij * gretl_matrix_get(XX, r, c));
+	}
+    }
+
+    for (r=0; r<mk; r++) {
+	i = eq[r];
+	if (rsingle) {
+	    yr = gretl_matrix_get(XY, r, i);
+	} else {
+	    yr = 0.0;
+	    for (l=0; l<m; l++) {
+		yr += gretl_matrix_get(sys->S, i, l) *
+		    gretl_matrix_get(XY, r, l);
+	    }
+	}
+	gretl_vector_set(y, r, yr);
+    }
+
+    free(eq);
+
+    return 0;
+}
+
 /* general function that forms the basis for all specific system
    estimators */
 
@@ -973,6 +1140,8 @@ int system_estimate (equation_system *sys, DATASET *dset,
     gretl_matrix *Xi = NULL;
     gretl_matrix *Xj = NULL;
     gretl_matrix *M = NULL;
+    gretl_matrix *XX = NULL;
+    gretl_matrix *XY = NULL;
     gretl_matrix **pX = NULL;
     gretl_matrix **py = NULL;
     MODEL **models = NULL;
@@ -983,6 +1152,7 @@ int system_estimate (equation_system *sys, DATASET *dset,
     int plain_ols = 0;
     int rsingle = 0;
     int do_diag = 0;
+    int use_xprod = 0;
     int err = 0;
 
     sys->iters = 0;
@@ -998,6 +1168,12 @@ int system_estimate (equation_system *sys, DATASET *dset,
 	single_equation = 1;
     }
 
+    if (method == SYS_METHOD_SUR || method == SYS_METHOD_3SLS ||
+	method == SYS_METHOD_FIML) {
+	/* re-use the cross-products of the data */
+	use_xprod = 1;
+    }
+
     if (method == SYS_METHOD_OLS && nr == 0) {
 	plain_ols = 1;
     } else {
@@ -1152,6 +1328,17 @@ int system_estimate (equation_system *sys, DATASET *dset,
     fprintf(stderr, "system_estimate: on invert, err=%d\n", err);
 #endif
 
+    if (!err && use_xprod) {
+	if (XX == NULL) {
+	    err = sys_cross_products(sys, dset, mk, &XX, &XY);
+	}
+	if (!err) {
+	    err = sys_weight_cross_products(sys, XX, XY, X, y, rsingle);
+	}
+	if (err) goto cleanup;
+	goto restrictions;
+    }
+
     if (!err && Xi == NULL) {
 	/* the test against NULL here allows for the possibility
 	   that we're iterating
@@ -1214,11 +1401,6 @@ int system_estimate (equation_system *sys, DATASET *dset,
 	goto cleanup;
     }
 
-    if (nr > 0) {
-	/* there are restrictions to be imposed */
-	augment_X_with_restrictions(X, mk, sys);
-    }
-
     if (!do_iteration && !rsingle) {
 	/* we're not coming back this way, so free some storage */
 	gretl_matrix_free(Xj);
@@ -1275,8 +1457,11 @@ int system_estimate (equation_system *sys, DATASET *dset,
 	}
     }
 
+ restrictions:
+
     if (nr > 0) {
-	/* there are restrictions */
+	/* there are restrictions to be imposed */
+	augment_X_with_restrictions(X, mk, sys);
 	augment_y_with_restrictions(y, mk, nr, sys);
     }
 
@@ -1332,6 +1517,8 @@ int system_estimate (equation_system *sys, DATASET *dset,
     gretl_matrix_free(Xi);
     gretl_matrix_free(Xj);
     gretl_matrix_free(M);
+    gretl_matrix_free(XX);
+    gretl_matrix_free(XY);
     gretl_matrix_free(X);
     gretl_matrix_free(y);
 